@@ -4,7 +4,6 @@
 #include "gui/MainGui.h"
 #include "rfg/PackfileVFS.h"
 #include "render/camera/Camera.h"
-#include "WorkerThread.h"
 #include "Log.h"
 #include "gui/util/WinUtil.h"
 #include "common/string/String.h"
@@ -13,8 +12,10 @@
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_win32.h>
 #include <imgui/backends/imgui_impl_dx11.h>
+#include <windowsx.h>
 #include <filesystem>
 #include <future>
+#include <optional>
 #include <variant>
 
 //Callback that handles windows messages such as keypresses
@@ -43,6 +44,13 @@ void Application::Run()
     RunStage2();
 }
 
+Application::~Application()
+{
+    //Stop terrain pipelines so shutdown doesn't wait for territories nobody will see to finish loading
+    territories_.CancelTerrainLoads();
+    tasks_.WaitAll();
+}
+
 void Application::Init()
 {
     //Init logger
@@ -107,13 +115,26 @@ void Application::InitStage2()
     packfileVFS_.Init(std::get<string>(dataPath->Value), &project_);
     xtblManager_.Init(&packfileVFS_);
     localization_.Init(&packfileVFS_, &config_);
+    territories_.Init(&packfileVFS_, &tasks_);
 
     //Setup main gui
-    gui_.Init(&fontManager_, &packfileVFS_, &renderer_, &project_, &xtblManager_, &config_, &localization_);
+    gui_.Init(&fontManager_, &packfileVFS_, &renderer_, &project_, &xtblManager_, &config_, &localization_, &tasks_, &territories_);
     gui_.HandleResize(windowWidth_, windowHeight_);
 
-    //Start worker thread to load packfile metadata in the background
-    workerFuture_ = std::async(std::launch::async, &WorkerThread, &gui_.State);
+    //Queue background loading tasks. Other code that needs packfile or localization data adds tasks with these as prerequisites
+    GuiState* state = &gui_.State;
+    state->PackfileScanTask = tasks_.AddTask("Scan packfiles", [this, state]()
+    {
+        state->SetStatus(ICON_FA_SYNC " Scanning packfiles", Working);
+        packfileVFS_.ScanPackfilesAndLoadCache();
+        Log->info("Loaded {} packfiles", packfileVFS_.packfiles_.size());
+        state->ClearStatus();
+    });
+    state->LocalizationLoadTask = tasks_.AddTask("Load localization", [this]()
+    {
+        //Load localization strings from rfglocatext files
+        localization_.LoadLocalizationData();
+    }, { state->PackfileScanTask });
 }
 
 void Application::RunStage2()
@@ -195,8 +216,55 @@ void Application::HandleResize()
 
 void Application::HandleCameraInput(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+    //Map window messages to camera input
+    std::optional<CameraKey> key = {};
+    switch (wParam)
+    {
+    case 0x57: //w
+        key = CameraKey::Forward;
+        break;
+    case 0x41: //a
+        key = CameraKey::Left;
+        break;
+    case 0x53: //s
+        key = CameraKey::Backward;
+        break;
+    case 0x44: //d
+        key = CameraKey::Right;
+        break;
+    case 0x51: //q
+        key = CameraKey::Up;
+        break;
+    case 0x45: //e
+        key = CameraKey::Down;
+        break;
+    case VK_SHIFT:
+        key = CameraKey::Sprint;
+        break;
+    }
+
     for (auto& scene : renderer_.Scenes)
-        scene->Cam.HandleInput(hwnd, msg, wParam, lParam);
+    {
+        Camera& camera = scene->Cam;
+        switch (msg)
+        {
+        case WM_KEYDOWN:
+        case WM_KEYUP:
+            if (key)
+                camera.SetKeyDown(key.value(), msg == WM_KEYDOWN);
+            break;
+        case WM_RBUTTONDOWN:
+        case WM_RBUTTONUP:
+            camera.SetLookActive(msg == WM_RBUTTONDOWN);
+            break;
+        case WM_MOUSEWHEEL:
+            camera.HandleMouseWheel((f32)GET_WHEEL_DELTA_WPARAM(wParam));
+            break;
+        case WM_MOUSEMOVE:
+            camera.HandleMouseMove((f32)GET_X_LPARAM(lParam), (f32)GET_Y_LPARAM(lParam));
+            break;
+        }
+    }
 }
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
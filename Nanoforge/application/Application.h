@@ -7,10 +7,12 @@
 #include "rfg/PackfileVFS.h"
 #include "rfg/xtbl/XtblManager.h"
 #include "rfg/Localization.h"
+#include "rfg/TerritoryRegistry.h"
 #include "gui/MainGui.h"
 #include "gui/misc/WelcomeGui.h"
 #include "project/Project.h"
 #include "application/Config.h"
+#include "util/TaskGraph.h"
 #include <ext/WindowsWrapper.h>
 #include <chrono>
 #include <spdlog/spdlog.h>
@@ -20,6 +22,7 @@ class Application
 {
 public:
     Application(HINSTANCE hInstance) : hInstance_(hInstance) {}
+    ~Application();
 
     void Run();
     void HandleResize();
@@ -59,6 +62,7 @@ private:
     XtblManager xtblManager_;
     Project project_;
     Localization localization_;
+    TerritoryRegistry territories_;
     Config config_;
     WelcomeGui welcomeGui_;
     MainGui gui_;
@@ -80,6 +84,6 @@ private:
 
     std::vector<spdlog::sink_ptr> logSinks_ = {};
 
-    //Future for worker thread. Need to store it for std::async to actually run it asynchronously
-    std::future<void> workerFuture_;
+    //Runs background loading tasks. Declared last so it's destroyed first, waiting for tasks that use the members above
+    TaskGraph tasks_;
 };
\ No newline at end of file
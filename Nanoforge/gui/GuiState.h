@@ -2,10 +2,13 @@
 #include "render/imgui/ImGuiFontManager.h"
 #include "rfg/PackfileVFS.h"
 #include "rfg/Territory.h"
+#include "rfg/TerritoryView.h"
 #include "render/camera/Camera.h"
 #include "documents/IDocument.h"
 #include "common/string/String.h"
 #include "rfg/xtbl/XtblManager.h"
+#include "util/TaskGraph.h"
+#include "rfg/TerritoryRegistry.h"
 #include <memory>
 
 class DX11Renderer;
@@ -38,9 +41,18 @@ public:
     XtblManager* Xtbls = nullptr;
     Config* Config = nullptr;
     Localization* Localization = nullptr;
+    TaskGraph* Tasks = nullptr;
+    //Shared territory data. Documents viewing the same territory share one instance
+    TerritoryRegistry* Territories = nullptr;
+
+    //Background loading tasks. Use these as prerequisites for tasks that need packfile or localization data
+    Handle<Task> PackfileScanTask = nullptr;
+    Handle<Task> LocalizationLoadTask = nullptr;
 
     //Most recently selected territory. If you have multiple territories open this is the most recently selected window
     Territory* CurrentTerritory = nullptr;
+    //Zone and class filters of the most recently selected territory window. Null until its zones are loaded
+    TerritoryView* CurrentTerritoryView = nullptr;
     bool CurrentTerritoryUpdateDebugDraw = true;
     
     //Todo: This would be better handled via an event system
@@ -93,15 +105,7 @@ public:
     }
     void SetTerritory(const string& newTerritory, bool firstLoad = false)
     {
-        string terr = newTerritory;
-        if (terr == "terr01")
-            terr = "zonescript_terr01";
-        if (terr == "dlc01")
-            terr = "zonescript_dlc01";
-
-        terr += ".vpp_pc";
-        
-        CurrentTerritoryName = terr;
+        CurrentTerritoryName = Territory::GetTerritoryFilename(newTerritory);
         CurrentTerritoryShortname = newTerritory;
     }
     //Create and init a document
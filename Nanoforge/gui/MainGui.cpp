@@ -23,6 +23,7 @@
 #include <imgui_internal.h>
 #include <spdlog/fmt/fmt.h>
 #include "gui/documents/LocalizationDocument.h"
+#include "gui/documents/ObjectQueryDocument.h"
 
 //Used in MainGui::DrawMainMenuBar()
 std::vector<const char*> TerritoryList =
@@ -81,10 +82,10 @@ std::vector<const char*> TerritoryList =
     "wcdlc9"
 };
 
-void MainGui::Init(ImGuiFontManager* fontManager, PackfileVFS* packfileVFS, DX11Renderer* renderer, Project* project, XtblManager* xtblManager, Config* config, Localization* localization)
+void MainGui::Init(ImGuiFontManager* fontManager, PackfileVFS* packfileVFS, DX11Renderer* renderer, Project* project, XtblManager* xtblManager, Config* config, Localization* localization, TaskGraph* tasks, TerritoryRegistry* territories)
 {
     TRACE();
-    State = GuiState{ fontManager, packfileVFS, renderer, project, xtblManager, config, localization };
+    State = GuiState{ fontManager, packfileVFS, renderer, project, xtblManager, config, localization, tasks, territories };
 
     //Ensure that values used by the UI exist
     State.Config->EnsureVariableExists("Show FPS", ConfigType::Bool);
@@ -187,6 +188,9 @@ void MainGui::Update(f32 deltaTime)
         counter++;
     }
 
+    //Free cached territories that closed documents no longer need
+    State.Territories->Update();
+
     //Draw mod packaging modal
     if (State.CurrentProject->WorkerRunning)
         ImGui::OpenPopup("Packaging mod");
@@ -332,6 +336,11 @@ void MainGui::DrawMainMenuBar()
                 }
                 ImGui::EndMenu();
             }
+            if (ImGui::MenuItem("Query objects"))
+            {
+                std::vector<string> territories(TerritoryList.begin(), TerritoryList.end());
+                State.CreateDocument("Object query", CreateHandle<ObjectQueryDocument>(&State, territories));
+            }
             if (ImGui::BeginMenu("Localization"))
             {
                 if (ImGui::MenuItem("View localized strings"))
@@ -14,12 +14,13 @@ class DX11Renderer;
 class Project;
 class Config;
 class Localization;
+class TaskGraph;
 
 //Todo: Split the gui out into multiple files and/or classes. Will be a mess if it's all in one file
 class MainGui
 {
 public:
-    void Init(ImGuiFontManager* fontManager, PackfileVFS* packfileVFS, DX11Renderer* renderer, Project* project, XtblManager* xtblManager, Config* config, Localization* localization);
+    void Init(ImGuiFontManager* fontManager, PackfileVFS* packfileVFS, DX11Renderer* renderer, Project* project, XtblManager* xtblManager, Config* config, Localization* localization, TaskGraph* tasks, TerritoryRegistry* territories);
     void Update(f32 deltaTime);
     void HandleResize(u32 width, u32 height);
     void AddPanel(string menuPos, bool open, Handle<IGuiPanel> panel);
@@ -0,0 +1,119 @@
+#include "ObjectQueryDocument.h"
+#include "render/imgui/imgui_ext.h"
+#include "gui/GuiState.h"
+#include "Log.h"
+
+ObjectQueryDocument::ObjectQueryDocument(GuiState* state, const std::vector<string>& territories)
+    : territories_(territories)
+{
+    engine_.Init(state->PackfileVFS);
+}
+
+ObjectQueryDocument::~ObjectQueryDocument()
+{
+    //Wait for worker task to exit since it references this document
+    if (queryTask_)
+        queryTask_->Wait();
+}
+
+void ObjectQueryDocument::Update(GuiState* state)
+{
+    if (!ImGui::Begin(Title.c_str(), &open_))
+    {
+        ImGui::End();
+        return;
+    }
+
+    state->FontManager->FontL.Push();
+    ImGui::Text(ICON_FA_SEARCH " Object query");
+    state->FontManager->FontL.Pop();
+    ImGui::Separator();
+
+    ImGui::TextWrapped("Search zone objects in every territory. E.g. class == \"rfg_mover\" && gameplay_props ~= \"bridge\". "
+                       "Fields: class, handle, num, zone, territory, or any property name. Ops: ==, !=, <, <=, >, >=, ~= (contains), &&, ||, !");
+
+    bool running = queryTask_ && !queryTask_->Completed();
+    bool submit = ImGui::InputText("Query", &queryText_, ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    submit |= ImGui::Button("Run");
+    if (submit && !running)
+        RunQuery(state);
+
+    if (queryError_ != "")
+        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), ICON_FA_EXCLAMATION_CIRCLE " %s", queryError_.c_str());
+
+    if (!queryTask_)
+    {
+        ImGui::End();
+        return;
+    }
+    if (!queryTask_->Completed())
+    {
+        ImGui::Text(ICON_FA_SYNC " Searched %d/%d territories...", engine_.TerritoriesSearched.load(), engine_.NumTerritories.load());
+        ImGui::End();
+        return;
+    }
+    if (queryTask_->Failed())
+    {
+        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), ICON_FA_EXCLAMATION_CIRCLE " Query failed. Check the log for more details.");
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("%d results", (u32)results_.size());
+    if (engine_.TerritoriesFailed > 0)
+    {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "(%d territories failed to load. Check the log for more details)", engine_.TerritoriesFailed.load());
+    }
+
+    if (ImGui::BeginTable("Object query results", 5, ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Territory", ImGuiTableColumnFlags_None);
+        ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_None);
+        ImGui::TableSetupColumn("Class", ImGuiTableColumnFlags_None);
+        ImGui::TableSetupColumn("Handle", ImGuiTableColumnFlags_None);
+        ImGui::TableSetupColumn("Num", ImGuiTableColumnFlags_None);
+        ImGui::TableHeadersRow();
+
+        //Only draw visible rows. Broad queries can match hundreds of thousands of objects
+        ImGuiListClipper clipper;
+        clipper.Begin((int)results_.size());
+        while (clipper.Step())
+        {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+            {
+                const ObjectQueryResult& result = results_[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(result.Territory.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(result.Zone.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(result.Classname.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%X", result.Handle);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", result.Num);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void ObjectQueryDocument::RunQuery(GuiState* state)
+{
+    queryError_ = "";
+    if (!query_.Parse(queryText_, queryError_))
+        return;
+
+    results_.clear();
+    queryTask_ = state->Tasks->AddTask("Object query", [this, queryText = queryText_]()
+    {
+        results_ = engine_.Run(query_, territories_);
+        Log->info("Object query \"{}\" found {} objects", queryText, results_.size());
+    }, { state->PackfileScanTask });
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "IDocument.h"
+#include "rfg/ObjectQueryEngine.h"
+#include "util/TaskGraph.h"
+#include <vector>
+
+//Search zone objects across many territories at once with ObjectQueryEngine. Territories aren't opened in the viewport
+class ObjectQueryDocument : public IDocument
+{
+public:
+    ObjectQueryDocument(GuiState* state, const std::vector<string>& territories);
+    ~ObjectQueryDocument();
+
+    void Update(GuiState* state) override;
+
+private:
+    //Parse the query and start searching in a background task
+    void RunQuery(GuiState* state);
+
+    //Short names of the territories to search
+    std::vector<string> territories_ = {};
+    string queryText_ = "";
+    string queryError_ = "";
+    ObjectQuery query_;
+    ObjectQueryEngine engine_;
+    Handle<Task> queryTask_ = nullptr;
+    //Only written by queryTask_. Don't read until it's completed
+    std::vector<ObjectQueryResult> results_ = {};
+};
@@ -159,6 +159,20 @@ namespace PegHelpers
             THROW_EXCEPTION("Unknown or unsupported peg format \"{}\"", input);
     }
 
+    RenderTextureFormat PegFormatToRenderTextureFormat(PegFormat input)
+    {
+        if (input == PegFormat::PC_DXT1)
+            return RenderTextureFormat::BC1; //DXT1
+        else if (input == PegFormat::PC_DXT3)
+            return RenderTextureFormat::BC2; //DXT2/3
+        else if (input == PegFormat::PC_DXT5)
+            return RenderTextureFormat::BC3; //DXT4/5
+        else if (input == PegFormat::PC_8888)
+            return RenderTextureFormat::RGBA8;
+        else
+            THROW_EXCEPTION("Unknown or unsupported peg format \"{}\"", input);
+    }
+
     PegFormat DxgiFormatToPegFormat(DXGI_FORMAT input)
     {
         if (input == DXGI_FORMAT_BC1_UNORM) //DXT1
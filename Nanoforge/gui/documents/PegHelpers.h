@@ -1,6 +1,7 @@
 #pragma once
 #include "common/Typedefs.h"
 #include "RfgTools++/formats/textures/PegFile10.h"
+#include "render/backend/RenderDevice.h"
 #include <dxgiformat.h>
 
 //Todo: Move this into RfgTools++. Not done yet since we're relying on DirectXTex for some image import/export work
@@ -23,6 +24,8 @@ namespace PegHelpers
     void ImportTexture(PegFile10& peg, u32 targetIndex, const string& importFilePath);
     //Convert peg format to dxgi format
     DXGI_FORMAT PegFormatToDxgiFormat(PegFormat input);
+    //Convert peg format to the render device texture format
+    RenderTextureFormat PegFormatToRenderTextureFormat(PegFormat input);
     //Convert dxgi format to peg format
     PegFormat DxgiFormatToPegFormat(DXGI_FORMAT input);
     //Convert PegFormat enum to string
@@ -411,68 +411,68 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
     {
         Scene->SetVertexLayout
         ({
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0,  DXGI_FORMAT_R16G16_SINT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+            { "NORMAL", 0, RenderVertexFormat::UByte4Norm, 12 },
+            { "TEXCOORD", 0, RenderVertexFormat::Short2, 16 },
             });
     }
     else if (format == VertexFormat::Pixlit1UvNmap)
     {
         Scene->SetVertexLayout
         ({
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TANGENT", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0,  DXGI_FORMAT_R16G16_SINT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+            { "NORMAL", 0, RenderVertexFormat::UByte4Norm, 12 },
+            { "TANGENT", 0, RenderVertexFormat::UByte4Norm, 16 },
+            { "TEXCOORD", 0, RenderVertexFormat::Short2, 20 },
             });
     }
     else if (format == VertexFormat::Pixlit1UvNmapCa)
     {
         Scene->SetVertexLayout
         ({
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TANGENT", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "BLENDWEIGHT", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "BLENDINDEX", 0,  DXGI_FORMAT_R8G8B8A8_UINT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0,  DXGI_FORMAT_R16G16_SINT, 0, 28, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+            { "NORMAL", 0, RenderVertexFormat::UByte4Norm, 12 },
+            { "TANGENT", 0, RenderVertexFormat::UByte4Norm, 16 },
+            { "BLENDWEIGHT", 0, RenderVertexFormat::UByte4Norm, 20 },
+            { "BLENDINDEX", 0, RenderVertexFormat::UByte4, 24 },
+            { "TEXCOORD", 0, RenderVertexFormat::Short2, 28 },
             });
     }
     else if (format == VertexFormat::Pixlit2UvNmap)
     {
         Scene->SetVertexLayout
         ({
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TANGENT", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0,  DXGI_FORMAT_R16G16_SINT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 1,  DXGI_FORMAT_R16G16_SINT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+            { "NORMAL", 0, RenderVertexFormat::UByte4Norm, 12 },
+            { "TANGENT", 0, RenderVertexFormat::UByte4Norm, 16 },
+            { "TEXCOORD", 0, RenderVertexFormat::Short2, 20 },
+            { "TEXCOORD", 1, RenderVertexFormat::Short2, 24 },
             });
     }
     else if (format == VertexFormat::Pixlit3UvNmap)
     {
         Scene->SetVertexLayout
         ({
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TANGENT", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0,  DXGI_FORMAT_R16G16_SINT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 1,  DXGI_FORMAT_R16G16_SINT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 2,  DXGI_FORMAT_R16G16_SINT, 0, 28, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+            { "NORMAL", 0, RenderVertexFormat::UByte4Norm, 12 },
+            { "TANGENT", 0, RenderVertexFormat::UByte4Norm, 16 },
+            { "TEXCOORD", 0, RenderVertexFormat::Short2, 20 },
+            { "TEXCOORD", 1, RenderVertexFormat::Short2, 24 },
+            { "TEXCOORD", 2, RenderVertexFormat::Short2, 28 },
             });
     }
     else if (format == VertexFormat::Pixlit3UvNmapCa)
     {
         Scene->SetVertexLayout
         ({
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "NORMAL", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TANGENT", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "BLENDWEIGHT", 0,  DXGI_FORMAT_R8G8B8A8_UNORM, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "BLENDINDEX", 0,  DXGI_FORMAT_R8G8B8A8_UINT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 0,  DXGI_FORMAT_R16G16_SINT, 0, 28, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 1,  DXGI_FORMAT_R16G16_SINT, 0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            { "TEXCOORD", 2,  DXGI_FORMAT_R16G16_SINT, 0, 36, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+            { "NORMAL", 0, RenderVertexFormat::UByte4Norm, 12 },
+            { "TANGENT", 0, RenderVertexFormat::UByte4Norm, 16 },
+            { "BLENDWEIGHT", 0, RenderVertexFormat::UByte4Norm, 20 },
+            { "BLENDINDEX", 0, RenderVertexFormat::UByte4, 24 },
+            { "TEXCOORD", 0, RenderVertexFormat::Short2, 28 },
+            { "TEXCOORD", 1, RenderVertexFormat::Short2, 32 },
+            { "TEXCOORD", 2, RenderVertexFormat::Short2, 36 },
             });
     }
     state->Renderer->ContextMutex.unlock();
@@ -506,8 +506,8 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
         auto& renderObject = Scene->Objects.emplace_back();
         RenderObjectIndices.push_back(Scene->Objects.size() - 1);
         Mesh mesh;
-        mesh.Create(Scene->d3d11Device_, Scene->d3d11Context_, meshData.VertexBuffer, meshData.IndexBuffer,
-            StaticMesh.VertexBufferConfig.NumVerts, DXGI_FORMAT_R16_UINT, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        mesh.Create(Scene->Device.get(), meshData.VertexBuffer, meshData.IndexBuffer,
+            StaticMesh.VertexBufferConfig.NumVerts, RenderIndexFormat::U16, RenderTopology::TriangleStrip);
         renderObject.Create(mesh, Vec3{ 0.0f, 0.0f, 0.0f });
         renderObject.SetScale(25.0f);
         if (hideLowLodMeshes && i > 0)
@@ -548,9 +548,9 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
                 if (texture)
                 {
                     if (notInCache)
-                        Log->info("Found diffuse texture {} for {}", texture->Texture.Name, Filename);
+                        Log->info("Found diffuse texture {} for {}", texture->Name, Filename);
                     else
-                        Log->info("Using cached copy of {} for {}", texture->Texture.Name, Filename);
+                        Log->info("Using cached copy of {} for {}", texture->Name, Filename);
 
                     std::lock_guard<std::mutex> lock(state->Renderer->ContextMutex);
                     renderObject.UseTextures = true;
@@ -561,7 +561,7 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
                     if (DiffuseMapPegPath == "")
                     {
                         DiffuseMapPegPath = texture.value().CpuFilePath;
-                        DiffuseTextureName = texture.value().Texture.Name;
+                        DiffuseTextureName = texture.value().Name;
                     }
 
                     if (foundTextures.find(textureNameLower) == foundTextures.end())
@@ -585,9 +585,9 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
                 if (texture)
                 {
                     if (notInCache)
-                        Log->info("Found normal map {} for {}", texture->Texture.Name, Filename);
+                        Log->info("Found normal map {} for {}", texture->Name, Filename);
                     else
-                        Log->info("Using cached copy of {} for {}", texture->Texture.Name, Filename);
+                        Log->info("Using cached copy of {} for {}", texture->Name, Filename);
 
                     std::lock_guard<std::mutex> lock(state->Renderer->ContextMutex);
                     renderObject.UseTextures = true;
@@ -598,7 +598,7 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
                     if (NormalMapPegPath == "")
                     {
                         NormalMapPegPath = texture.value().CpuFilePath;
-                        NormalTextureName = texture.value().Texture.Name;
+                        NormalTextureName = texture.value().Name;
                     }
 
                     if (foundTextures.find(textureNameLower) == foundTextures.end())
@@ -622,9 +622,9 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
                 if (texture)
                 {
                     if (notInCache)
-                        Log->info("Found specular map {} for {}", texture->Texture.Name, Filename);
+                        Log->info("Found specular map {} for {}", texture->Name, Filename);
                     else
-                        Log->info("Using cached copy of {} for {}", texture->Texture.Name, Filename);
+                        Log->info("Using cached copy of {} for {}", texture->Name, Filename);
 
                     std::lock_guard<std::mutex> lock(state->Renderer->ContextMutex);
                     renderObject.UseTextures = true;
@@ -635,7 +635,7 @@ void StaticMeshDocument::WorkerThread(GuiState* state)
                     if (SpecularMapPegPath == "")
                     {
                         SpecularMapPegPath = texture.value().CpuFilePath;
-                        SpecularTextureName = texture.value().Texture.Name;
+                        SpecularTextureName = texture.value().Name;
                     }
 
                     if (foundTextures.find(textureNameLower) == foundTextures.end())
@@ -725,7 +725,7 @@ std::optional<Texture2D_Ext> StaticMeshDocument::GetTexture(GuiState* state, con
     return GetTextureFromPackfile(state, state->PackfileVFS->GetPackfile("terr01_l1.vpp_pc"), textureName);
 }
 
-//Tries to find a cpeg with a subtexture with the provided name and create a Texture2D from it. Searches all cpeg/cvbm files in packfile. First checks pegs then searches in str2s
+//Tries to find a cpeg with a subtexture with the provided name and create a texture from it. Searches all cpeg/cvbm files in packfile. First checks pegs then searches in str2s
 std::optional<Texture2D_Ext> StaticMeshDocument::GetTextureFromPackfile(GuiState* state, Packfile3* packfile, const string& textureName, bool isStr2)
 {
     if (!packfile)
@@ -786,7 +786,7 @@ std::optional<Texture2D_Ext> StaticMeshDocument::GetTextureFromPackfile(GuiState
     return {};
 }
 
-//Tries to open a cpeg/cvbm pegName in the provided packfile and create a Texture2D from a sub-texture with the name textureName
+//Tries to open a cpeg/cvbm pegName in the provided packfile and create a texture from a sub-texture with the name textureName
 std::optional<Texture2D_Ext> StaticMeshDocument::GetTextureFromPeg(GuiState* state,
     const string& parentName, //If inContainer == true this is the name of str2_pc the peg is in. Else it is the same as VppName
     const string& pegName, //Name of the cpeg_pc or cvbm_pc file that holds the target texture
@@ -818,7 +818,7 @@ std::optional<Texture2D_Ext> StaticMeshDocument::GetTextureFromPeg(GuiState* sta
     PegFile10 peg;
     peg.Read(cpuFileReader, gpuFileReader);
 
-    //See if target texture is in peg. If so extract it and create a Texture2D from it
+    //See if target texture is in peg. If so extract it and create a texture from it
     for (auto& entry : peg.Entries)
     {
         if (String::EqualIgnoreCase(entry.Name, textureName))
@@ -826,22 +826,12 @@ std::optional<Texture2D_Ext> StaticMeshDocument::GetTextureFromPeg(GuiState* sta
             peg.ReadTextureData(gpuFileReader, entry);
             std::span<u8> textureData = entry.RawData;
 
-            //Create and setup texture2d
-            Texture2D texture2d;
-            texture2d.Name = textureName;
-            DXGI_FORMAT dxgiFormat = PegHelpers::PegFormatToDxgiFormat(entry.BitmapFormat);
-            D3D11_SUBRESOURCE_DATA textureSubresourceData;
-            textureSubresourceData.pSysMem = textureData.data();
-            textureSubresourceData.SysMemSlicePitch = 0;
-            textureSubresourceData.SysMemPitch = PegHelpers::CalcRowPitch(dxgiFormat, entry.Width, entry.Height);
-
-            state->Renderer->ContextMutex.lock(); //Lock ID3D11DeviceContext mutex. Only one thread allowed to access it at once
-            texture2d.Create(Scene->d3d11Device_, entry.Width, entry.Height, dxgiFormat, D3D11_BIND_SHADER_RESOURCE, &textureSubresourceData);
-            texture2d.CreateShaderResourceView(); //Need shader resource view to use it in shader
-            texture2d.CreateSampler(); //Need sampler too
-            state->Renderer->ContextMutex.unlock();
-
-            out = Texture2D_Ext{ .Texture = texture2d, .CpuFilePath = cpuFilePath };
+            //Create texture on the scene device
+            RenderTextureFormat format = PegHelpers::PegFormatToRenderTextureFormat(entry.BitmapFormat);
+            RenderTextureMip mip = { entry.Width, entry.Height, textureData };
+            TextureHandle texture = Scene->Device->CreateTexture(textureName, format, std::span<const RenderTextureMip>(&mip, 1));
+
+            out = Texture2D_Ext{ .Texture = texture, .Name = textureName, .CpuFilePath = cpuFilePath };
             break;
         }
     }
@@ -7,11 +7,13 @@
 #include <future>
 #include <vector>
 
-//Extension of Texture2D used by StaticMeshDocument for texture file searches
+//Texture found by StaticMeshDocument texture file searches
 struct Texture2D_Ext
 {
-    //The texture
-    Texture2D Texture;
+    //The texture. Owned by the documents scene device
+    TextureHandle Texture = NullRenderHandle;
+    //Name of the texture in its peg
+    string Name;
     //Cpu file path in the global cache
     string CpuFilePath;
 };
@@ -2,10 +2,17 @@
 #include "render/backend/DX11Renderer.h"
 #include "common/filesystem/Path.h"
 #include "util/MeshUtil.h"
-#include <RfgTools++\formats\zones\properties\primitive\StringProperty.h>
+#include "util/HashUtil.h"
+#include "rfg/TerrainLoader.h"
 #include <RfgTools++\formats\textures\PegFile10.h>
 #include "gui/documents/PegHelpers.h"
+#include "gui/panels/property_panel/PropertyPanelContent.h"
+#include "gui/util/WinUtil.h"
+#include "render/imgui/imgui_ext.h"
 #include "Log.h"
+#include <RfgTools++/formats/zones/properties/primitive/StringProperty.h>
+#include <functional>
+#include <optional>
 #include <span>
 
 TerritoryDocument::TerritoryDocument(GuiState* state, string territoryName, string territoryShortname)
@@ -22,30 +29,47 @@ TerritoryDocument::TerritoryDocument(GuiState* state, string territoryName, stri
     Scene->SetShader(terrainShaderPath_);
     Scene->SetVertexLayout
     ({
-        { "POSITION", 0,  DXGI_FORMAT_R16G16B16A16_SINT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "NORMAL", 0,  DXGI_FORMAT_R32G32B32_FLOAT, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+        { "POSITION", 0, RenderVertexFormat::Short4, 0 },
+        { "NORMAL", 0, RenderVertexFormat::Float3, 8 }
         });
     Scene->perFrameStagingBuffer_.DiffuseIntensity = 1.2f;
 
-    //Create worker thread to load terrain meshes in background
-    WorkerFuture = std::async(std::launch::async, &TerritoryDocument::WorkerThread, this, state);
+    //Get shared territory data. It's loaded in a background task once packfiles are scanned unless it's already open in another document or cached.
+    //Zone loading overlaps with other startup tasks like localization loading.
+    state->SetStatus(ICON_FA_SYNC " Loading zones for " + TerritoryName, Working);
+    Handle<Task> territoryLoadTask = nullptr;
+    Territory = state->Territories->Acquire(TerritoryName, TerritoryShortname, state->PackfileScanTask, territoryLoadTask);
+    //Terrain is loaded once zone data is loaded. Also shared with other documents viewing the territory
+    Terrain = state->Territories->AcquireTerrain(TerritoryName);
+
+    //Queue background task to setup the view once zone data is loaded
+    SetupViewTask = state->Tasks->AddTask("Setup view for " + TerritoryName, [this, state]() { WorkerThread_SetupView(state); }, { territoryLoadTask });
 }
 
 TerritoryDocument::~TerritoryDocument()
 {
-    //Wait for worker thread to exit
+    //Wait for worker tasks to exit. Terrain loading is stopped by TerritoryRegistry once no document uses it
     open_ = false;
-    WorkerFuture.wait();
-    WorkerThread_ClearData();
+    SetupViewTask->Wait();
+    if (TerrainExportTask)
+    {
+        TerrainExport.Cancel();
+        TerrainExportTask->Wait();
+    }
+    TerrainTextures.Stop();
 
-    if (state_->CurrentTerritory == &Territory)
+    if (state_->CurrentTerritoryView == &View)
+        state_->CurrentTerritoryView = nullptr;
+    if (state_->CurrentTerritory == Territory.get())
     {
         state_->CurrentTerritory = nullptr;
         state_->SetSelectedZoneObject(nullptr);
     }
 
-    //Free territory data
-    Territory.ResetTerritoryData();
+    //Release territory data. TerritoryRegistry keeps it cached for a while in case it's reopened
+    TerrainLods.clear();
+    Terrain = nullptr;
+    Territory = nullptr;
 
     //Delete scene and free its resources
     state_->Renderer->DeleteScene(Scene);
@@ -61,66 +85,32 @@ void TerritoryDocument::Update(GuiState* state)
 
     //Only redraw scene if window is focused
     Scene->NeedsRedraw = ImGui::IsWindowFocused();
-    if (WorkerDone) //Once worker thread is done clear its temporary data
+    //Create render objects for terrain as it's loaded
+    AddNewTerrainTiles();
+    if (TerrainStatusShown && Terrain->LoadTask->Completed())
     {
-        if (!WorkerResourcesFreed && !NewTerrainInstanceAdded)
-        {
-            WorkerThread_ClearData();
-            WorkerResourcesFreed = true;
-        }
+        TerrainStatusShown = false;
+        state->ClearStatus();
     }
-    //Create dx11 resources for terrain meshes as they're loaded
-    if (NewTerrainInstanceAdded)
+
+    //Filters start from the class defaults once zone data is loaded
+    if (!View.Initialized() && SetupViewTask->Succeeded())
     {
-        std::lock_guard<std::mutex> lock(ResourceLock);
-        //Create terrain index & vertex buffers
-        for (auto& instance : TerrainInstances)
+        View.Init(*Territory);
+        //Terrain may already be loaded by another document viewing the territory
+        if (!Terrain->LoadTask->Completed())
         {
-            //Skip already-initialized terrain instances
-            if (instance.RenderDataInitialized)
-                continue;
-
-            for (u32 i = 0; i < 9; i++)
-            {
-                auto& renderObject = Scene->Objects.emplace_back();
-                Mesh mesh;
-                mesh.Create(Scene->d3d11Device_, Scene->d3d11Context_, ToByteSpan(instance.Vertices[i]), ToByteSpan(instance.Indices[i]),
-                    instance.Vertices[i].size(), DXGI_FORMAT_R16_UINT, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-                renderObject.Create(mesh, instance.Position);
-
-                if (instance.HasBlendTexture)
-                {
-                    //Create and setup texture2d
-                    Texture2D texture2d;
-                    texture2d.Name = Path::GetFileNameNoExtension(instance.Name) + "_alpha00.cvbm_pc";
-                    DXGI_FORMAT dxgiFormat = DXGI_FORMAT_BC1_UNORM;
-                    D3D11_SUBRESOURCE_DATA textureSubresourceData;
-                    textureSubresourceData.pSysMem = instance.BlendTextureBytes.data();
-                    textureSubresourceData.SysMemSlicePitch = 0;
-                    textureSubresourceData.SysMemPitch = PegHelpers::CalcRowPitch(dxgiFormat, instance.BlendTextureWidth, instance.BlendTextureHeight);
-                    state->Renderer->ContextMutex.lock(); //Lock ID3D11DeviceContext mutex. Only one thread allowed to access it at once
-                    texture2d.Create(Scene->d3d11Device_, instance.BlendTextureWidth, instance.BlendTextureHeight, dxgiFormat, D3D11_BIND_SHADER_RESOURCE, &textureSubresourceData);
-                    texture2d.CreateShaderResourceView(); //Need shader resource view to use it in shader
-                    texture2d.CreateSampler(); //Need sampler too
-                    state->Renderer->ContextMutex.unlock();
-
-                    renderObject.UseTextures = true;
-                    renderObject.DiffuseTexture = texture2d;
-                }
-            }
-
-            //Set bool so the instance isn't initialized more than once
-            instance.RenderDataInitialized = true;
+            state->SetStatus(ICON_FA_SYNC " Loading terrain meshes for " + Title, Working);
+            TerrainStatusShown = true;
         }
-        Scene->NeedsRedraw = true; //Redraw scene if new terrain meshes added
-        NewTerrainInstanceAdded = false;
     }
 
     //Set current territory to most recently focused territory window
     if (ImGui::IsWindowFocused())
     {
         state->SetTerritory(TerritoryName);
-        state->CurrentTerritory = &Territory;
+        state->CurrentTerritory = Territory.get();
+        state->CurrentTerritoryView = View.Initialized() ? &View : nullptr;
         Scene->Cam.InputActive = true;
     }
     else
@@ -128,8 +118,13 @@ void TerritoryDocument::Update(GuiState* state)
         Scene->Cam.InputActive = false;
     }
 
+    //Share camera position with terrain loading threads so the terrain nearest to it is loaded first
+    Terrain->SetStreamingFocus(Scene->Cam.Position());
+    UpdateTerrainLod();
+    UpdateTerrainTextures(state);
+
     //Move camera if triggered by another gui panel
-    if (state->CurrentTerritoryCamPosNeedsUpdate && &Territory == state->CurrentTerritory)
+    if (state->CurrentTerritoryCamPosNeedsUpdate && Territory.get() == state->CurrentTerritory)
     {
         Vec3 newPos = state->CurrentTerritoryNewCamPos;
         Scene->Cam.SetPosition(newPos.x, newPos.y, newPos.z);
@@ -138,8 +133,8 @@ void TerritoryDocument::Update(GuiState* state)
         state->CurrentTerritoryCamPosNeedsUpdate = false;
     }
     //Update debug draw regardless of focus state since we'll never be focused when using the other panels which control debug draw
-    state->CurrentTerritoryUpdateDebugDraw = true; //Now set to true permanently to support time based coloring. Quick hack, probably should remove this variable later.
-    if (Territory.ZoneFiles.size() != 0 && state->CurrentTerritoryUpdateDebugDraw && TerritoryDataLoaded)
+    //Only checks visibility and the selected object each frame. Bounding box geometry is retained by the scene
+    if (View.Initialized() && Territory->ZoneFiles.size() != 0)
     {
         UpdateDebugDraw(state);
         PrimitivesNeedRedraw = false;
@@ -159,6 +154,21 @@ void TerritoryDocument::Update(GuiState* state)
     ImGui::Image(Scene->GetView(), ImVec2(static_cast<f32>(Scene->Width()), static_cast<f32>(Scene->Height())));
     ImGui::PopStyleColor();
 
+    //Draw object labels over the scene
+    if (View.Initialized() && Territory->ZoneFiles.size() != 0)
+    {
+        UpdateObjectLabels();
+        DrawObjectLabels(ImGui::GetItemRectMin());
+    }
+
+    //Select objects by clicking them in the viewport
+    if (ImGui::IsItemClicked(ImGuiMouseButton_Left) && View.Initialized())
+    {
+        ImVec2 mousePos = ImGui::GetMousePos();
+        ImVec2 imageMin = ImGui::GetItemRectMin();
+        PickObject(state, { mousePos.x - imageMin.x, mousePos.y - imageMin.y });
+    }
+
     //Set cursor pos to top left corner to draw buttons over scene texture
     ImVec2 adjustedPos = initialPos;
     adjustedPos.x += 10.0f;
@@ -170,6 +180,294 @@ void TerritoryDocument::Update(GuiState* state)
     ImGui::End();
 }
 
+void TerritoryDocument::AddNewTerrainTiles()
+{
+    if (Terrain->NumTiles() == TerrainLods.size())
+        return;
+
+    for (Handle<const TerrainTile>& tile : Terrain->GetTiles((u32)TerrainLods.size()))
+    {
+        TerrainLodInstance& lod = TerrainLods.emplace_back();
+        lod.Tile = tile;
+
+        //Blend texture mips are streamed in by UpdateTerrainTextures() and shared by every patch of the tile
+        if (tile->HasBlendTexture)
+            lod.TextureId = TerrainTextures.Add(tile->BlendTexture);
+
+        //Create a render object for each LOD patch. UpdateTerrainLod() decides which ones are visible
+        const TerrainLodTree& tree = tile->Lod;
+        Aabb& bounds = TerrainTileBounds.emplace_back();
+        if (tree.Nodes.size() > 0)
+        {
+            //The root patch covers the whole tile
+            const Aabb& root = tree.Nodes[0].Bounds;
+            bounds.Min = { root.Min.x + tile->Position.x, root.Min.y + tile->Position.y, root.Min.z + tile->Position.z };
+            bounds.Max = { root.Max.x + tile->Position.x, root.Max.y + tile->Position.y, root.Max.z + tile->Position.z };
+        }
+        lod.FirstRenderObject = (u32)Scene->Objects.size();
+        for (const TerrainLodNode& node : tree.Nodes)
+        {
+            auto& renderObject = Scene->Objects.emplace_back();
+            Mesh mesh;
+            std::span<const LowLodTerrainVertex> vertices(tree.Vertices.data() + node.FirstVertex, node.NumVertices);
+            std::span<const u16> indices(tree.Indices.data() + node.FirstIndex, node.NumIndices);
+            mesh.Create(Scene->Device.get(), ToByteSpan(vertices), ToByteSpan(indices),
+                node.NumVertices, RenderIndexFormat::U16, RenderTopology::TriangleList);
+            renderObject.Create(mesh, tile->Position);
+            renderObject.Bounds = node.Bounds;
+            renderObject.Visible = false;
+        }
+    }
+    Scene->NeedsRedraw = true; //Redraw scene if new terrain meshes added
+}
+
+void TerritoryDocument::UpdateTerrainLod()
+{
+    Vec3 camPos = Scene->Cam.Position();
+    const f32 errorToPixels = TerrainLodTree::ErrorToPixels(Scene->Cam.GetFovRadians(), (f32)Scene->Height());
+    std::vector<u32> selected = {};
+    //selectedMask[i] is 1 if node i of the current tile is selected. Avoids searching selected for every node
+    std::vector<u8> selectedMask = {};
+    u32 verticesSelected = 0;
+    bool changed = false;
+    for (TerrainLodInstance& lod : TerrainLods)
+    {
+        //Selection is done relative to the tile since node bounds are in zone space
+        const TerrainLodTree& tree = lod.Tile->Lod;
+        const Vec3& position = lod.Tile->Position;
+        Vec3 cameraPosition = { camPos.x - position.x, camPos.y - position.y, camPos.z - position.z };
+        selected.clear();
+        tree.Select(cameraPosition, errorToPixels, TerrainMaxScreenError, selected);
+        selectedMask.assign(tree.Nodes.size(), 0);
+        for (u32 node : selected)
+            selectedMask[node] = 1;
+
+        for (u32 i = 0; i < tree.Nodes.size(); i++)
+        {
+            RenderObject& renderObject = Scene->Objects[lod.FirstRenderObject + i];
+            bool visible = selectedMask[i] != 0;
+            changed |= renderObject.Visible != visible;
+            renderObject.Visible = visible;
+        }
+        for (u32 node : selected)
+            verticesSelected += tree.Nodes[node].NumVertices;
+    }
+
+    TerrainVerticesSelected = verticesSelected;
+    if (changed)
+        Scene->NeedsRedraw = true;
+}
+
+void TerritoryDocument::UpdateTerrainTextures(GuiState* state)
+{
+    //Only tiles in view request mips. Tiles outside of it keep theirs until the budget needs the space
+    Frustum frustum = Frustum::FromViewProjection(Scene->Cam.GetViewProjMatrix().Data());
+    Vec3 cameraPosition = Scene->Cam.Position();
+    std::vector<u32> visibleTiles = {};
+    TerrainTileCuller.SetBounds(TerrainTileBounds);
+    TerrainTileCuller.Cull(frustum, cameraPosition, Scene->MaxDrawDistance, visibleTiles);
+
+    std::vector<u32> visible = {};
+    for (u32 tile : visibleTiles)
+        if (TerrainLods[tile].TextureId != TextureStreamer::InvalidId)
+            visible.push_back(TerrainLods[tile].TextureId);
+
+    TerrainTextures.Update(cameraPosition, TerrainLodTree::ErrorToPixels(Scene->Cam.GetFovRadians(), (f32)Scene->Height()), visible);
+
+    //Upload decoded mips and release evicted textures
+    for (StreamedTextureUpdate& update : TerrainTextures.TakeUpdates())
+    {
+        auto lod = std::find_if(TerrainLods.begin(), TerrainLods.end(), [&](const TerrainLodInstance& lod) { return lod.TextureId == update.Id; });
+        if (lod == TerrainLods.end())
+            continue;
+
+        TextureHandle texture = NullRenderHandle;
+        bool resident = update.Mips.size() > 0;
+        if (resident)
+        {
+            std::vector<RenderTextureMip> mips = {};
+            for (StreamedMip& mip : update.Mips)
+                mips.push_back({ mip.Width, mip.Height, mip.Data });
+
+            texture = Scene->Device->CreateTexture(lod->Tile->Name, RenderTextureFormat::BC1, mips);
+        }
+
+        //Every patch of the tile shares one texture. Free the old mips before replacing it
+        TextureHandle previous = Scene->Objects[lod->FirstRenderObject].DiffuseTexture;
+        if (previous != NullRenderHandle)
+            Scene->Device->DestroyTexture(previous);
+
+        for (u32 i = 0; i < lod->Tile->Lod.Nodes.size(); i++)
+        {
+            RenderObject& renderObject = Scene->Objects[lod->FirstRenderObject + i];
+            renderObject.UseTextures = resident;
+            renderObject.DiffuseTexture = texture;
+        }
+        Scene->NeedsRedraw = true;
+    }
+}
+
+std::optional<f32> TerritoryDocument::GetTerrainHeight(f32 x, f32 z)
+{
+    for (TerrainLodInstance& lod : TerrainLods)
+        if (std::optional<f32> height = lod.Tile->Heights.SampleHeight(x, z))
+            return height;
+
+    return {};
+}
+
+std::optional<f32> TerritoryDocument::RaycastTerrain(const Ray& ray, f32 maxDistance)
+{
+    std::optional<f32> closest = {};
+    for (TerrainLodInstance& lod : TerrainLods)
+    {
+        if (std::optional<f32> distance = lod.Tile->Heights.Raycast(ray, maxDistance))
+        {
+            maxDistance = distance.value();
+            closest = distance;
+        }
+    }
+    return closest;
+}
+
+//Get the label text of a zone object. Uses the first name or type property it has, in the same order as the zone objects list
+static string GetObjectLabelName(ZoneObject36& object)
+{
+    static const char* nameProperties[] =
+    {
+        "display_name", "chunk_name", "animation_type", "activity_type", "raid_type", "courier_type", "spawn_set",
+        "item_type", "dummy_type", "weapon_type", "region_kill_type", "delivery_type", "squad_def", "mission_info"
+    };
+
+    for (const char* propertyName : nameProperties)
+    {
+        auto* property = object.GetProperty<StringProperty>(propertyName);
+        if (property)
+            return property->Data;
+    }
+    return "";
+}
+
+//Find the hierarchy node of a zone object
+static ZoneObjectNode36* FindObjectNode(std::vector<ZoneObjectNode36>& nodes, ZoneObject36* object)
+{
+    for (auto& node : nodes)
+    {
+        if (node.Self == object)
+            return &node;
+        if (ZoneObjectNode36* child = FindObjectNode(node.Children, object))
+            return child;
+    }
+    return nullptr;
+}
+
+void TerritoryDocument::UpdateObjectLabels()
+{
+    //Only rebuild candidates when objects move or the zone/class filters change
+    u64 key = HashUtil::Fnv1a64Value(Territory->ObjectBoundsVersion);
+    for (const ObjectClassView& classView : View.Classes)
+        key = HashUtil::Fnv1a64Value((u8)(classView.Show && classView.ShowLabel), key);
+    for (u8 zoneVisible : View.ZoneMask())
+        key = HashUtil::Fnv1a64Value(zoneVisible, key);
+
+    if (key != ObjectLabelsKey)
+    {
+        ObjectLabelsKey = key;
+        const ZoneObjectTable& table = Territory->ObjectTable;
+        std::vector<LabelCandidate> candidates = {};
+        ObjectLabelText.clear();
+        for (u32 row = 0; row < table.Size(); row++)
+        {
+            if (!View.ObjectVisible(table.Zone[row], table.ClassIndex[row]) || !View.Classes[table.ClassIndex[row]].ShowLabel)
+                continue;
+
+            ZoneData& zone = Territory->ZoneFiles[table.Zone[row]];
+            const ZoneObjectClass& objectClass = Territory->ZoneObjectClasses[table.ClassIndex[row]];
+
+            //Labels sit on top of the objects bounding box
+            Vec3 size = { table.MaxX[row] - table.MinX[row], table.MaxY[row] - table.MinY[row], table.MaxZ[row] - table.MinZ[row] };
+            string displayName = GetObjectLabelName(zone.Zone.Objects[table.Object[row]]);
+            const string& text = ObjectLabelText.emplace_back(displayName.empty() ? objectClass.Name : displayName);
+            ImVec2 textSize = ImGui::CalcTextSize(text.c_str());
+
+            LabelCandidate& candidate = candidates.emplace_back();
+            candidate.Position = { (table.MinX[row] + table.MaxX[row]) * 0.5f, table.MaxY[row], (table.MinZ[row] + table.MaxZ[row]) * 0.5f };
+            candidate.Radius = 0.5f * sqrtf(size.x * size.x + size.y * size.y + size.z * size.z);
+            candidate.Width = textSize.x + 2.0f * ObjectLabelMargin;
+            candidate.Height = textSize.y + 2.0f * ObjectLabelMargin;
+        }
+        ObjectLabels.SetCandidates(std::move(candidates));
+    }
+    if (ObjectLabels.NumCandidates() == 0)
+        return;
+
+    LabelView view;
+    memcpy(view.ViewProjection.data(), Scene->Cam.GetViewProjMatrix().Data(), sizeof(f32) * 16);
+    view.Position = Scene->Cam.Position();
+    view.Forward = Mat4::Normalize(Scene->Cam.camForward);
+    view.FovRadians = Scene->Cam.GetFovRadians();
+    view.Width = (f32)Scene->Width();
+    view.Height = (f32)Scene->Height();
+    ObjectLabels.Update(view);
+}
+
+void TerritoryDocument::DrawObjectLabels(ImVec2 imageMin)
+{
+    const std::vector<PlacedLabel>& labels = ObjectLabels.Labels();
+    if (labels.size() == 0)
+        return;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->PushClipRect(imageMin, { imageMin.x + (f32)Scene->Width(), imageMin.y + (f32)Scene->Height() }, true);
+    for (const PlacedLabel& label : labels)
+    {
+        const string& text = ObjectLabelText[label.Candidate];
+        ImVec2 min = { imageMin.x + label.X, imageMin.y + label.Y };
+        ImVec2 textSize = ImGui::CalcTextSize(text.c_str());
+        drawList->AddRectFilled(min, { min.x + textSize.x + 2.0f * ObjectLabelMargin, min.y + textSize.y + 2.0f * ObjectLabelMargin }, IM_COL32(0, 0, 0, 160), 2.0f);
+        drawList->AddText({ min.x + ObjectLabelMargin, min.y + ObjectLabelMargin }, IM_COL32(255, 255, 255, 255), text.c_str());
+    }
+    drawList->PopClipRect();
+}
+
+void TerritoryDocument::PickObject(GuiState* state, ImVec2 mousePos)
+{
+    using namespace DirectX;
+
+    //Unproject the mouse position at the near and far planes to get a world space ray
+    const f32 width = (f32)Scene->Width();
+    const f32 height = (f32)Scene->Height();
+    XMMATRIX projection = XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(Scene->Cam.camProjection.Data()));
+    XMMATRIX view = XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(Scene->Cam.camView.Data()));
+    XMVECTOR nearPoint = XMVector3Unproject({ mousePos.x, mousePos.y, 0.0f }, 0.0f, 0.0f, width, height, 0.0f, 1.0f, projection, view, XMMatrixIdentity());
+    XMVECTOR farPoint = XMVector3Unproject({ mousePos.x, mousePos.y, 1.0f }, 0.0f, 0.0f, width, height, 0.0f, 1.0f, projection, view, XMMatrixIdentity());
+    XMVECTOR direction = XMVector3Normalize(farPoint - nearPoint);
+
+    Ray ray;
+    ray.Origin = { XMVectorGetX(nearPoint), XMVectorGetY(nearPoint), XMVectorGetZ(nearPoint) };
+    ray.Direction = { XMVectorGetX(direction), XMVectorGetY(direction), XMVectorGetZ(direction) };
+
+    //Objects behind terrain can't be picked
+    f32 maxDistance = XMVectorGetX(XMVector3Length(farPoint - nearPoint));
+    if (std::optional<f32> terrainDistance = RaycastTerrain(ray, maxDistance))
+        maxDistance = terrainDistance.value();
+
+    std::optional<ZoneObjectRef> hit = Territory->RaycastObjects(ray, View, maxDistance);
+    if (!hit)
+        return;
+
+    ZoneData& zone = Territory->ZoneFiles[hit.value().Zone];
+    ZoneObject36* object = &zone.Zone.Objects[hit.value().Object];
+    ZoneObjectNode36* node = FindObjectNode(zone.Zone.ObjectsHierarchical, object);
+    if (!node)
+        return;
+
+    state->ZoneObjectList_SelectedObject = object;
+    state->SetSelectedZoneObject(node);
+    state->PropertyPanelContentFuncPtr = &PropertyPanel_ZoneObject;
+    Scene->NeedsRedraw = true;
+}
+
 void TerritoryDocument::DrawOverlayButtons(GuiState* state)
 {
     state->FontManager->FontL.Push();
@@ -221,6 +519,14 @@ void TerritoryDocument::DrawOverlayButtons(GuiState* state)
         {
             Scene->Cam.UpdateViewMatrix();
         }
+        if (ImGui::Button("Snap to ground"))
+        {
+            Vec3 camPos = Scene->Cam.Position();
+            f32 x = camPos.x;
+            f32 z = camPos.z;
+            if (std::optional<f32> height = GetTerrainHeight(x, z))
+                Scene->Cam.SetPosition(x, height.value() + CameraGroundHeight, z);
+        }
 
         gui::LabelAndValue("Pitch:", std::to_string(Scene->Cam.GetPitchDegrees()));
         gui::LabelAndValue("Yaw:", std::to_string(Scene->Cam.GetYawDegrees()));
@@ -264,403 +570,231 @@ void TerritoryDocument::DrawOverlayButtons(GuiState* state)
             ImGui::SliderFloat("Diffuse intensity", &Scene->perFrameStagingBuffer_.DiffuseIntensity, 0.0f, 2.0f);
         }
 
-        ImGui::EndPopup();
-    }
-}
-
-void TerritoryDocument::UpdateDebugDraw(GuiState* state)
-{
-    //Reset primitives first to ensure old primitives get cleared
-    Scene->ResetPrimitives();
+        ImGui::Separator();
+        ImGui::SliderFloat("Terrain max error (pixels)", &TerrainMaxScreenError, 0.5f, 16.0f);
+        gui::LabelAndValue("Terrain vertices:", std::to_string(TerrainVerticesSelected));
+        gui::LabelAndValue("Terrain textures:", fmt::format("{:.1f}/{:.1f} MB", TerrainTextures.BytesUsed() / 1048576.0f, TerrainTextures.Budget() / 1048576.0f));
 
-    //Draw bounding boxes
-    for (const auto& zone : Territory.ZoneFiles)
-    {
-        if (!zone.RenderBoundingBoxes)
-            continue;
+        //Max draw distance of 0 means no limit
+        ImGui::Separator();
+        if (ImGui::Checkbox("Frustum culling", &Scene->CullObjects))
+            Scene->NeedsRedraw = true;
+        if (ImGui::SliderFloat("Max draw distance", &Scene->MaxDrawDistance, 0.0f, 10000.0f))
+            Scene->NeedsRedraw = true;
+        gui::LabelAndValue("Objects drawn:", fmt::format("{} ({} culled)", Scene->NumObjectsDrawn, Scene->NumObjectsCulled));
 
-        for (const auto& object : zone.Zone.Objects)
+        //Label settings. Changing them invalidates the cached layout
+        ImGui::Separator();
+        bool labelSettingsChanged = false;
+        labelSettingsChanged |= ImGui::SliderFloat("Label distance", &ObjectLabels.MaxDistance, 0.0f, 5000.0f);
+        labelSettingsChanged |= ImGui::SliderFloat("Min labeled object size (pixels)", &ObjectLabels.MinScreenSize, 0.0f, 64.0f);
+        i32 maxLabels = (i32)ObjectLabels.MaxLabels;
+        if (ImGui::SliderInt("Max labels", &maxLabels, 0, 1000))
         {
-            auto objectClass = Territory.GetObjectClass(object.ClassnameHash);
-            if (!objectClass.Show)
-                continue;
-
-            //If object is selected in zone object list panel use different drawing method for visibilty
-            bool selectedInZoneObjectList = &object == state->ZoneObjectList_SelectedObject;
-            if (selectedInZoneObjectList)
-            {
-                //Calculate color that changes with time
-                Vec3 color = objectClass.Color;
-                f32 colorMagnitude = objectClass.Color.Magnitude();
-                //Negative values used for brighter colors so they get darkened instead of lightened//Otherwise doesn't work on objects with white debug color
-                f32 multiplier = colorMagnitude > 0.85f ? -1.0f : 1.0f;
-                color.x = objectClass.Color.x + powf(sin(Scene->TotalTime * 2.0f), 2.0f) * multiplier;
-                color.y = objectClass.Color.y + powf(sin(Scene->TotalTime), 2.0f) * multiplier;
-                color.z = objectClass.Color.z + powf(sin(Scene->TotalTime), 2.0f) * multiplier;
-
-                //Keep color in a certain range so it stays visible against the terrain
-                f32 magnitudeMin = 0.20f;
-                f32 colorMin = 0.20f;
-                if (color.Magnitude() < magnitudeMin)
-                {
-                    color.x = std::max(color.x, colorMin);
-                    color.y = std::max(color.y, colorMin);
-                    color.z = std::max(color.z, colorMin);
-                }
-
-                //Calculate bottom center of box so we can draw a line from the bottom of the box into the sky
-                Vec3 lineStart;
-                lineStart.x = (object.Bmin.x + object.Bmax.x) / 2.0f;
-                lineStart.y = object.Bmin.y;
-                lineStart.z = (object.Bmin.z + object.Bmax.z) / 2.0f;
-                Vec3 lineEnd = lineStart;
-                lineEnd.y += 300.0f;
-
-                //Draw object bounding box and line from it's bottom into the sky
-                Scene->DrawBox(object.Bmin, object.Bmax, color);
-                Scene->DrawLine(lineStart, lineEnd, color);
-            }
-            else //If not selected just draw bounding box with static color
-            {
-                Scene->DrawBox(object.Bmin, object.Bmax, objectClass.Color);
-            }
+            ObjectLabels.MaxLabels = (u32)maxLabels;
+            labelSettingsChanged = true;
         }
-    }
-
-    Scene->NeedsRedraw = true;
-    state->CurrentTerritoryUpdateDebugDraw = false;
-}
-
-void TerritoryDocument::WorkerThread(GuiState* state)
-{
-    //Read all zones from zonescript_terr01.vpp_pc
-    state->SetStatus(ICON_FA_SYNC " Loading zones for " + Title, Working);
-    Territory.Init(state->PackfileVFS, TerritoryName, TerritoryShortname);
-    Territory.LoadZoneData();
-    state->CurrentTerritoryUpdateDebugDraw = true;
-    TerritoryDataLoaded = true;
+        if (labelSettingsChanged)
+            ObjectLabels.Invalidate();
+        gui::LabelAndValue("Labels:", fmt::format("{}/{}", ObjectLabels.Labels().size(), ObjectLabels.NumCandidates()));
 
-    std::vector<ZoneData>& zoneFiles = Territory.ZoneFiles;
-    Log->info("Loaded {} zones for {}", zoneFiles.size(), Title);
-
-    //Move camera close to zone with the most objects by default. Convenient as some territories have origins distant from each other
-    if (zoneFiles.size() > 0 && zoneFiles[0].Zone.Objects.size() > 0)
-    {
-        //Tell camera to move to near the first object in the zone
-        state->CurrentTerritoryNewCamPos = zoneFiles[0].Zone.Objects[0].Bmin + Vec3(250.0f, 500.0f, 250.0f);
-        state->CurrentTerritoryCamPosNeedsUpdate = true;
+        ImGui::EndPopup();
     }
 
-    //End worker thread early if document is closed
-    if (!open_)
+    ImGui::SameLine();
+    state->FontManager->FontL.Push();
+    if (ImGui::Button(ICON_FA_FILE_EXPORT))
+        ImGui::OpenPopup("##TerrainExportPopup");
+    state->FontManager->FontL.Pop();
+    if (ImGui::BeginPopup("##TerrainExportPopup"))
     {
-        state->ClearStatus();
-        return;
-    }
-
-    //Load terrain meshes and extract their index + vertex data
-    WorkerThread_LoadTerrainMeshes(state);
-    state->ClearStatus();
-    WorkerDone = true;
-}
+        state->FontManager->FontL.Push();
+        ImGui::Text("Export terrain");
+        state->FontManager->FontL.Pop();
+        ImGui::Separator();
 
-void TerritoryDocument::WorkerThread_ClearData()
-{
-    Log->info("Temporary data cleared for {} terrain worker threads", Title);
-    for (auto& instance : TerrainInstances)
-    {
-        //Free vertex and index buffer memory
-        //Note: Assumes same amount of vertex and index buffers
-        for (u32 i = 0; i < instance.Indices.size(); i++)
+        bool exporting = TerrainExportTask && !TerrainExportTask->Completed();
+        ImGui::InputText("Output folder", &ExportOptions.OutputFolder);
+        ImGui::SameLine();
+        if (ImGui::Button("..."))
         {
-            if(instance.Indices[i].data())
-                delete instance.Indices[i].data();
-            if(instance.Vertices[i].data())
-                delete instance.Vertices[i].data();
+            std::optional<string> output = OpenFolder("Select a folder to export terrain to");
+            if (output)
+                ExportOptions.OutputFolder = output.value();
         }
-        //Clear vectors
-        instance.Indices.clear();
-        instance.Vertices.clear();
-        instance.Meshes.clear();
+        ImGui::Checkbox("Heightmap (16 bit pgm)", &ExportOptions.Heightmap);
+        ImGui::Checkbox("Mesh (obj)", &ExportOptions.Obj);
+        ImGui::InputScalar("Heightmap pixels per zone", ImGuiDataType_U32, &ExportOptions.HeightmapSamplesPerZone);
 
-        //Clear blend texture data
-        if (instance.HasBlendTexture)
+        if (exporting)
         {
-            //Cleanup peg texture data
-            instance.BlendPeg.Cleanup();
-            //Set to nullptr and 0. Don't have to delete this since it's really referencing the data owned by BlendPeg
-            instance.BlendTextureBytes = std::span<u8>((u8*)nullptr, 0);
+            ImGui::Text(ICON_FA_SYNC " Exported %d/%d tiles", TerrainExport.TilesExported.load(), TerrainExport.NumTiles.load());
+            if (ImGui::Button("Cancel"))
+                TerrainExport.Cancel();
+        }
+        else if (ImGui::Button("Export") && Territory->Ready() && ExportOptions.OutputFolder != "")
+        {
+            ExportOptions.Name = TerritoryShortname;
+            TerrainExportTask = state->Tasks->AddTask("Export terrain for " + TerritoryName, [this, state, options = ExportOptions]()
+            {
+                TerrainExport.Export(*Territory, state->PackfileVFS, options);
+            }, { SetupViewTask });
         }
-    }
-    //Clear instance list
-    TerrainInstances.clear();
-}
-
-void TerritoryDocument::WorkerThread_LoadTerrainMeshes(GuiState* state)
-{
-    state->SetStatus(ICON_FA_SYNC " Loading terrain meshes for " + Title, Working);
-
-    //Must store futures for std::async to run functions asynchronously
-    std::vector<std::future<void>> futures;
-
-    //Find terrain meshes and load them
-    for (auto& zone : Territory.ZoneFiles)
-    {
-        //Exit early if document closes
-        if (!open_)
-            break;
-
-        //Get obj_zone object with a terrain_file_name property
-        auto* objZoneObject = zone.Zone.GetSingleObject("obj_zone");
-        if (!objZoneObject)
-            continue;
-        auto* terrainFilenameProperty = objZoneObject->GetProperty<StringProperty>("terrain_file_name");
-        if (!terrainFilenameProperty)
-            continue;
-
-        //Remove extra null terminators that RFG so loves to have in it's files
-        string filename = terrainFilenameProperty->Data;
-        if (filename.ends_with('\0'))
-            filename.pop_back();
-
-        //Exit early if document closes
-        if (!open_)
-            break;
 
-        filename += ".cterrain_pc";
-        Vec3 position = objZoneObject->Bmin + ((objZoneObject->Bmax - objZoneObject->Bmin) / 2.0f);
-        auto terrainMeshHandleCpu = state->PackfileVFS->GetFiles(filename, true, true);
-        if (terrainMeshHandleCpu.size() > 0)
-            futures.push_back(std::async(std::launch::async, &TerritoryDocument::WorkerThread_LoadTerrainMesh, this, terrainMeshHandleCpu[0], position, state));
+        ImGui::EndPopup();
     }
-
-    //Wait for all threads to exit
-    for (auto& future : futures)
-        future.wait();
-
-    Log->info("Done loading terrain meshes for {}", Title);
 }
 
-void TerritoryDocument::WorkerThread_LoadTerrainMesh(FileHandle terrainMesh, Vec3 position, GuiState* state)
+void TerritoryDocument::UpdateDebugDraw(GuiState* state)
 {
-    //Get packfile that holds terrain meshes
-    auto* container = terrainMesh.GetContainer();
-    if (!container)
-        THROW_EXCEPTION("Failed to get container pointer for a terrain mesh.");
-
-    //Todo: This does a full extract twice on the container due to the way single file extracts work. Fix this
-    //Get mesh file byte arrays
-    auto cpuFileBytes = container->ExtractSingleFile(terrainMesh.Filename(), true);
-    auto gpuFileBytes = container->ExtractSingleFile(Path::GetFileNameNoExtension(terrainMesh.Filename()) + ".gterrain_pc", true);
-
-    //Ensure the mesh files were extracted
-    if (!cpuFileBytes)
-        THROW_EXCEPTION("Failed to extract terrain mesh cpu file.");
-    if (!gpuFileBytes)
-        THROW_EXCEPTION("Failed to extract terrain mesh gpu file.");
-
-    BinaryReader cpuFile(cpuFileBytes.value());
-    BinaryReader gpuFile(gpuFileBytes.value());
-
-    //Create new instance
-    TerrainInstance terrain;
-    terrain.Position = position;
-
-    //Get vertex data. Each terrain file is made up of 9 meshes which are stitched together
-    u32 cpuFileIndex = 0;
-    u32* cpuFileAsUintArray = (u32*)cpuFileBytes.value().data();
-    for (u32 i = 0; i < 9; i++)
+    //Box geometry only changes when objects are loaded or moved
+    if (ObjectBoxesVersion != Territory->ObjectBoundsVersion)
+        BuildObjectBoxes();
+
+    //Only visibility and color are checked each frame. A batch is rewritten if its class color was edited
+    for (u32 i = 0; i < ObjectBoxBatches.size(); i++)
     {
-        //Exit early if document closes
-        if (!open_)
-            break;
-
-        //Get mesh crc from gpu file. Will use this to find the mesh description data section of the cpu file which starts and ends with this value
-        //In while loop since a mesh file pair can have multiple meshes inside
-        u32 meshCrc = gpuFile.ReadUint32();
-        if (meshCrc == 0)
-            THROW_EXCEPTION("Failed to read next mesh data block hash in terrain mesh gpu file.");
-
-        //Find next mesh data block in cpu file
-        while (true)
+        ObjectBoxBatch& batch = ObjectBoxBatches[i];
+        const ObjectClassView& classView = View.Classes[batch.ClassIndex];
+        Scene->SetLineBatchVisible(i, View.ObjectVisible(batch.Zone, batch.ClassIndex));
+        if (batch.Color.x != classView.Color.x || batch.Color.y != classView.Color.y || batch.Color.z != classView.Color.z)
         {
-            //This is done instead of using BinaryReader::ReadUint32() because that method was incredibly slow (+ several minutes slow)
-            if (cpuFileAsUintArray[cpuFileIndex] == meshCrc)
-                break;
-
-            cpuFileIndex++;
+            batch.Color = classView.Color;
+            Scene->UpdateLineBatch(i, GetObjectBoxLines(batch));
         }
-        u64 meshDataBlockStart = (cpuFileIndex * 4) - 4;
-        cpuFile.SeekBeg(meshDataBlockStart);
-
-        //Read mesh data block. Contains info on vertex + index layout + size + format
-        MeshDataBlock meshData;
-        meshData.Read(cpuFile);
-        cpuFileIndex += static_cast<u32>(cpuFile.Position() - meshDataBlockStart) / 4;
-        terrain.Meshes.push_back(meshData);
-
-        //Read index data
-        gpuFile.Align(16); //Indices always start here
-        u32 indicesSize = meshData.NumIndices * meshData.IndexSize;
-        u8* indexBuffer = new u8[indicesSize];
-        gpuFile.ReadToMemory(indexBuffer, indicesSize);
-        terrain.Indices.push_back(std::span<u16>{ (u16*)indexBuffer, indicesSize / meshData.IndexSize });
-
-        //Read vertex data
-        gpuFile.Align(16);
-        u32 verticesSize = meshData.NumVertices * meshData.VertexStride0;
-        u8* vertexBuffer = new u8[verticesSize];
-        gpuFile.ReadToMemory(vertexBuffer, verticesSize);
-
-        //Exit early if document closes
-        if (!open_)
-            break;
-
-        std::span<LowLodTerrainVertex> verticesWithNormals = WorkerThread_GenerateTerrainNormals
-        (
-            std::span<ShortVec4>{ (ShortVec4*)vertexBuffer, verticesSize / meshData.VertexStride0},
-            std::span<u16>{ (u16*)indexBuffer, indicesSize / meshData.IndexSize }
-        );
-        terrain.Vertices.push_back(verticesWithNormals);
-
-        //Free vertex buffer, no longer need this copy. verticesWithNormals copied the data it needed from this one
-        delete[] vertexBuffer;
-
-        u32 endMeshCrc = gpuFile.ReadUint32();
-        if (meshCrc != endMeshCrc)
-            THROW_EXCEPTION("Verification hashes at the start and end of terrain gpu file don't match.");
     }
 
-    //Clear resources
-    delete container;
-    delete[] cpuFileBytes.value().data();
-    delete[] gpuFileBytes.value().data();
+    //Find the object selected in the zone object list panel if it's in a visible zone and has a visible class
+    const ZoneObject36* selected = state->ZoneObjectList_SelectedObject;
+    const ObjectClassView* selectedClass = nullptr;
+    for (u32 zoneIndex = 0; zoneIndex < Territory->ZoneFiles.size(); zoneIndex++)
+    {
+        ZoneData& zone = Territory->ZoneFiles[zoneIndex];
+        if (!selected || zone.Zone.Objects.size() == 0 || selected < zone.Zone.Objects.data() || selected >= zone.Zone.Objects.data() + zone.Zone.Objects.size())
+            continue;
 
-    //Exit early if document closes
-    if (!open_)
-        return;
+        u32 classIndex = zone.ObjectClassIndices[Territory->GetObjectIndex(zone, selected)];
+        if (View.ObjectVisible(zoneIndex, classIndex))
+            selectedClass = &View.Classes[classIndex];
+        break;
+    }
 
-    //Todo: Use + "_alpha00" here to get the blend weights texture, load high res textures, and apply those. Will make terrain texture higher res and have specular + normal maps
-    //Todo: Remember to also change the DXGI_FORMAT for the Texture2D to DXGI_FORMAT_R8G8B8A8_UNORM since that's what the _alpha00 textures used instead of DXT1
-    //Get terrain blending texture
-    string blendTextureName = Path::GetFileNameNoExtension(terrainMesh.Filename()) + "comb.cvbm_pc";
-    auto blendTextureHandlesCpu = state->PackfileVFS->GetFiles(blendTextureName, true, true);
-    if (blendTextureHandlesCpu.size() > 0)
+    //The highlight color changes over time so it's the only thing drawn each frame
+    bool drawHighlight = selectedClass != nullptr;
+    if (drawHighlight || ObjectHighlightDrawn)
+        Scene->ResetPrimitives();
+    if (drawHighlight)
     {
-        FileHandle& blendTextureHandle = blendTextureHandlesCpu[0];
-        auto* containerBlend = blendTextureHandle.GetContainer();
-        if (!containerBlend)
-            THROW_EXCEPTION("Failed to get container pointer for a terrain mesh.");
-
-        //Get mesh file byte arrays
-        auto cpuFileBytesBlend = containerBlend->ExtractSingleFile(blendTextureName, true);
-        auto gpuFileBytesBlend = containerBlend->ExtractSingleFile(Path::GetFileNameNoExtension(blendTextureName) + ".gvbm_pc", true);
-
-        //Ensure the texture files were extracted
-        if (!cpuFileBytesBlend)
-            THROW_EXCEPTION("Failed to extract terrain mesh cpu file.");
-        if (!gpuFileBytesBlend)
-            THROW_EXCEPTION("Failed to extract terrain mesh gpu file.");
-
-        BinaryReader cpuFileBlend(cpuFileBytesBlend.value());
-        BinaryReader gpuFileBlend(gpuFileBytesBlend.value());
-
-        terrain.BlendPeg.Read(cpuFileBlend, gpuFileBlend);
-        terrain.BlendPeg.ReadTextureData(gpuFileBlend, terrain.BlendPeg.Entries[0]);
-        auto maybeBlendTexturePixelData = terrain.BlendPeg.GetTextureData(0);
-        if (maybeBlendTexturePixelData)
-        {
-            terrain.HasBlendTexture = true;
-            terrain.BlendTextureBytes = maybeBlendTexturePixelData.value();
-            terrain.BlendTextureWidth = terrain.BlendPeg.Entries[0].Width;
-            terrain.BlendTextureHeight = terrain.BlendPeg.Entries[0].Height;
-        }
-        else
+        const auto& object = *selected;
+        const ObjectClassView& objectClass = *selectedClass;
+
+        //Calculate color that changes with time
+        Vec3 color = objectClass.Color;
+        f32 colorMagnitude = objectClass.Color.Magnitude();
+        //Negative values used for brighter colors so they get darkened instead of lightened//Otherwise doesn't work on objects with white debug color
+        f32 multiplier = colorMagnitude > 0.85f ? -1.0f : 1.0f;
+        color.x = objectClass.Color.x + powf(sin(Scene->TotalTime * 2.0f), 2.0f) * multiplier;
+        color.y = objectClass.Color.y + powf(sin(Scene->TotalTime), 2.0f) * multiplier;
+        color.z = objectClass.Color.z + powf(sin(Scene->TotalTime), 2.0f) * multiplier;
+
+        //Keep color in a certain range so it stays visible against the terrain
+        f32 magnitudeMin = 0.20f;
+        f32 colorMin = 0.20f;
+        if (color.Magnitude() < magnitudeMin)
         {
-            Log->warn("Failed to extract pixel data for terrain blend texture {}", blendTextureName);
+            color.x = std::max(color.x, colorMin);
+            color.y = std::max(color.y, colorMin);
+            color.z = std::max(color.z, colorMin);
         }
 
-        delete containerBlend;
-        delete[] cpuFileBytesBlend.value().data();
-        delete[] gpuFileBytesBlend.value().data();
-    }
-    else
-    {
-        Log->warn("Couldn't find blend texture for {}.", terrainMesh.Filename());
+        //Calculate bottom center of box so we can draw a line from the bottom of the box into the sky
+        Vec3 lineStart;
+        lineStart.x = (object.Bmin.x + object.Bmax.x) / 2.0f;
+        lineStart.y = object.Bmin.y;
+        lineStart.z = (object.Bmin.z + object.Bmax.z) / 2.0f;
+        Vec3 lineEnd = lineStart;
+        lineEnd.y += 300.0f;
+
+        //Draw object bounding box and line from it's bottom into the sky. Drawn over its retained box
+        Scene->DrawBox(object.Bmin, object.Bmax, color);
+        Scene->DrawLine(lineStart, lineEnd, color);
+        Scene->NeedsRedraw = true;
     }
-
-    //Acquire resource lock before writing terrain instance data to the instance list
-    std::lock_guard<std::mutex> lock(ResourceLock);
-    TerrainInstances.push_back(terrain);
-    NewTerrainInstanceAdded = true;
+    ObjectHighlightDrawn = drawHighlight;
+    state->CurrentTerritoryUpdateDebugDraw = false;
 }
 
-std::span<LowLodTerrainVertex> TerritoryDocument::WorkerThread_GenerateTerrainNormals(std::span<ShortVec4> vertices, std::span<u16> indices)
+void TerritoryDocument::BuildObjectBoxes()
 {
-    struct Face
+    //Sort rows by zone then class. Rows are already ordered by zone so this keeps each zones batches next to each other, which lets the scene merge their draw calls
+    const ZoneObjectTable& table = Territory->ObjectTable;
+    ObjectBoxRows.resize(table.Size());
+    for (u32 row = 0; row < table.Size(); row++)
+        ObjectBoxRows[row] = row;
+    std::stable_sort(ObjectBoxRows.begin(), ObjectBoxRows.end(), [&](u32 a, u32 b)
     {
-        u32 verts[3];
-    };
-
-    //Generate list of faces and face normals
-    std::vector<Face> faces = {};
-    for (u32 i = 0; i < indices.size() - 3; i++)
+        return table.Zone[a] != table.Zone[b] ? table.Zone[a] < table.Zone[b] : table.ClassIndex[a] < table.ClassIndex[b];
+    });
+
+    //Split rows into batches and write their lines
+    ObjectBoxBatches.clear();
+    std::vector<Scene::ColoredVertex> vertices = {};
+    std::vector<Scene::LineBatch> lineBatches = {};
+    vertices.reserve((size_t)table.Size() * 24);
+    for (u32 i = 0; i < ObjectBoxRows.size(); i++)
     {
-        u32 index0 = indices[i];
-        u32 index1 = indices[i + 1];
-        u32 index2 = indices[i + 2];
+        u32 row = ObjectBoxRows[i];
+        if (ObjectBoxBatches.size() == 0 || ObjectBoxBatches.back().Zone != table.Zone[row] || ObjectBoxBatches.back().ClassIndex != table.ClassIndex[row])
+        {
+            ObjectBoxBatch& batch = ObjectBoxBatches.emplace_back();
+            batch.Zone = table.Zone[row];
+            batch.ClassIndex = table.ClassIndex[row];
+            batch.FirstRow = i;
+            batch.Color = View.Classes[batch.ClassIndex].Color;
+            lineBatches.push_back({ (u32)vertices.size(), 0, false });
+        }
 
-        faces.emplace_back(Face{ .verts = {index0, index1, index2} });
+        ObjectBoxBatch& batch = ObjectBoxBatches.back();
+        batch.NumRows++;
+        Scene::AppendBoxLines(vertices, { table.MinX[row], table.MinY[row], table.MinZ[row] }, { table.MaxX[row], table.MaxY[row], table.MaxZ[row] }, batch.Color);
+        lineBatches.back().NumVertices = (u32)vertices.size() - lineBatches.back().FirstVertex;
     }
 
-    //Exit early if document closes
-    if (!open_)
-        return std::span<LowLodTerrainVertex>();
+    Scene->SetRetainedLines(std::move(vertices), std::move(lineBatches));
+    ObjectBoxesVersion = Territory->ObjectBoundsVersion;
+    Log->info("Built {} bounding box batches for {}", ObjectBoxBatches.size(), Title);
+}
 
-    //Generate list of vertices with position and normal data
-    u8* vertBuffer = new u8[vertices.size() * sizeof(LowLodTerrainVertex)];
-    std::span<LowLodTerrainVertex> outVerts((LowLodTerrainVertex*)vertBuffer, vertices.size());
-    for (u32 i = 0; i < vertices.size(); i++)
+std::vector<Scene::ColoredVertex> TerritoryDocument::GetObjectBoxLines(const ObjectBoxBatch& batch) const
+{
+    const ZoneObjectTable& table = Territory->ObjectTable;
+    std::vector<Scene::ColoredVertex> vertices = {};
+    vertices.reserve((size_t)batch.NumRows * 24);
+    for (u32 i = batch.FirstRow; i < batch.FirstRow + batch.NumRows; i++)
     {
-        outVerts[i].x = vertices[i].x;
-        outVerts[i].y = vertices[i].y;
-        outVerts[i].z = vertices[i].z;
-        outVerts[i].w = vertices[i].w;
-        outVerts[i].normal = { 0.0f, 0.0f, 0.0f };
+        u32 row = ObjectBoxRows[i];
+        Scene::AppendBoxLines(vertices, { table.MinX[row], table.MinY[row], table.MinZ[row] }, { table.MaxX[row], table.MaxY[row], table.MaxZ[row] }, batch.Color);
     }
-    for (auto& face : faces)
-    {
-        //Exit early if document closes
-        if (!open_)
-            return outVerts;
-
-        const u32 ia = face.verts[0];
-        const u32 ib = face.verts[1];
-        const u32 ic = face.verts[2];
+    return vertices;
+}
 
-        Vec3 vert0 = { (f32)vertices[ia].x, (f32)vertices[ia].y, (f32)vertices[ia].z };
-        Vec3 vert1 = { (f32)vertices[ib].x, (f32)vertices[ib].y, (f32)vertices[ib].z };
-        Vec3 vert2 = { (f32)vertices[ic].x, (f32)vertices[ic].y, (f32)vertices[ic].z };
+void TerritoryDocument::WorkerThread_SetupView(GuiState* state)
+{
+    //Zone data is loaded by TerritoryRegistry before this runs. Might be shared with other documents
+    state->CurrentTerritoryUpdateDebugDraw = true;
 
-        Vec3 e1 = vert1 - vert0;
-        Vec3 e2 = vert2 - vert1;
-        Vec3 normal = e1.Cross(e2);
+    std::vector<ZoneData>& zoneFiles = Territory->ZoneFiles;
+    Log->info("Loaded {} zones for {}", zoneFiles.size(), Title);
 
-        //Todo: Make sure this isn't subtly wrong
-        //Attempt to flip normal if it's pointing in wrong direction. Seems to result in correct normals
-        if (normal.y < 0.0f)
-        {
-            normal.x *= -1.0f;
-            normal.y *= -1.0f;
-            normal.z *= -1.0f;
-        }
-        outVerts[ia].normal += normal;
-        outVerts[ib].normal += normal;
-        outVerts[ic].normal += normal;
-    }
-    for (u32 i = 0; i < vertices.size(); i++)
+    //Move camera close to zone with the most objects by default. Convenient as some territories have origins distant from each other
+    if (zoneFiles.size() > 0 && zoneFiles[0].Zone.Objects.size() > 0)
     {
-        outVerts[i].normal = outVerts[i].normal.Normalize();
+        //Tell camera to move to near the first object in the zone
+        state->CurrentTerritoryNewCamPos = zoneFiles[0].Zone.Objects[0].Bmin + Vec3(250.0f, 500.0f, 250.0f);
+        state->CurrentTerritoryCamPosNeedsUpdate = true;
+        //Start terrain loading near the cameras new position. The camera only moves once this document is focused
+        Terrain->SetStreamingFocus(state->CurrentTerritoryNewCamPos);
     }
-    return outVerts;
-}
\ No newline at end of file
+
+    state->ClearStatus();
+}
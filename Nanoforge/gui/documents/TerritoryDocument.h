@@ -3,22 +3,34 @@
 #include "IDocument.h"
 #include "gui/GuiState.h"
 #include "rfg/Territory.h"
-#include "rfg/TerrainHelpers.h"
+#include "rfg/TerritoryView.h"
+#include "rfg/TerritoryTerrain.h"
+#include "rfg/TerrainLoader.h"
+#include "rfg/TerrainExporter.h"
 #include "render/resources/Scene.h"
+#include "util/LabelLayout.h"
 #include <future>
 
-//Used internally by TerritoryDocument
-struct ShortVec4
+//Render objects of a terrain tiles LOD patches. The tile is shared with other documents viewing the territory
+struct TerrainLodInstance
 {
-    i16 x = 0;
-    i16 y = 0;
-    i16 z = 0;
-    i16 w = 0;
-
-    ShortVec4 operator-(const ShortVec4& B)
-    {
-        return ShortVec4{ x - B.x, y - B.y, z - B.z, w - B.w };
-    }
+    Handle<const TerrainTile> Tile = nullptr;
+    //Scene->Objects index of the render object for node 0. Node i is FirstRenderObject + i
+    u32 FirstRenderObject = 0;
+    //TerrainTextures id of the tiles blend texture
+    u32 TextureId = TextureStreamer::InvalidId;
+};
+
+//Retained bounding box lines for the objects of one class in one zone. ObjectBoxBatches[i] is line batch i of the scene
+struct ObjectBoxBatch
+{
+    u32 Zone = 0;
+    u32 ClassIndex = 0;
+    //Range of TerritoryDocument::ObjectBoxRows
+    u32 FirstRow = 0;
+    u32 NumRows = 0;
+    //Color the lines were last written with
+    Vec3 Color;
 };
 
 class TerritoryDocument : public IDocument
@@ -29,29 +41,80 @@ public:
 
     void Update(GuiState* state) override;
 
+    //Terrain height at a world position. Returns std::nullopt if no loaded terrain tile covers it
+    std::optional<f32> GetTerrainHeight(f32 x, f32 z);
+    //Distance along the ray to the closest terrain hit. Returns std::nullopt if it misses all loaded terrain within maxDistance
+    std::optional<f32> RaycastTerrain(const Ray& ray, f32 maxDistance = std::numeric_limits<f32>::max());
+
 private:
     void DrawOverlayButtons(GuiState* state);
     void UpdateDebugDraw(GuiState* state);
-    void WorkerThread(GuiState* state);
-    //Clear temporary data created by the worker thread. Called once the worker thread is done working and the renderer is done using the worker data
-    void WorkerThread_ClearData();
-    //Loads vertex and index data of each zones terrain mesh
-    void WorkerThread_LoadTerrainMeshes(GuiState* state);
-    void WorkerThread_LoadTerrainMesh(FileHandle terrainMesh, Vec3 position, GuiState* state);
-    std::span<LowLodTerrainVertex> WorkerThread_GenerateTerrainNormals(std::span<ShortVec4> vertices, std::span<u16> indices);
+    //Group zone objects by zone and class and upload their bounding boxes as retained line batches
+    void BuildObjectBoxes();
+    //Bounding box lines of every object in a batch
+    std::vector<Scene::ColoredVertex> GetObjectBoxLines(const ObjectBoxBatch& batch) const;
+    //Rebuild label candidates if label filters changed and lay them out for the current camera
+    void UpdateObjectLabels();
+    //Draw the labels placed by UpdateObjectLabels() over the scene view. imageMin is the top left corner of the scene view in screen space
+    void DrawObjectLabels(ImVec2 imageMin);
+    //Select the zone object under the mouse cursor. mousePos is relative to the top left of the scene view
+    void PickObject(GuiState* state, ImVec2 mousePos);
+    //Select the terrain patches to draw for the current camera position and hide the rest
+    void UpdateTerrainLod();
+    //Request terrain texture mips for the current camera position and upload the ones that finished decoding
+    void UpdateTerrainTextures(GuiState* state);
+    //Create render objects for terrain tiles loaded since the last call
+    void AddNewTerrainTiles();
+    //Setup the view once the territory zone data is loaded. Run as a task once TerritoryRegistry finishes loading the territory
+    void WorkerThread_SetupView(GuiState* state);
 
     string TerritoryName;
     string TerritoryShortname;
-    Territory Territory;
+    //Shared with other documents viewing the same territory. View state such as the scene and terrain render objects belongs to each document
+    Handle<Territory> Territory = nullptr;
+    Handle<TerritoryTerrain> Terrain = nullptr;
+    //Zone and class filters of this document. Initialized once zone data is loaded
+    TerritoryView View;
     Handle<Scene> Scene = nullptr;
-    std::vector<TerrainInstance> TerrainInstances = {};
-    std::future<void> WorkerFuture;
-    std::mutex ResourceLock;
-    bool WorkerDone = false;
-    bool WorkerResourcesFreed = false;
-    bool NewTerrainInstanceAdded = false;
+    //TerrainLods[i] draws tile i of Terrain
+    std::vector<TerrainLodInstance> TerrainLods = {};
+    //Max projected error in pixels before a terrain patch is replaced with its children
+    f32 TerrainMaxScreenError = 2.0f;
+    //Vertices in the terrain patches selected last frame
+    u32 TerrainVerticesSelected = 0;
+    //Keeps terrain texture mips resident by camera distance
+    TextureStreamer TerrainTextures = { TerrainTextureBudget, TerrainTextureDecodeThreads };
+    //World space bounds of each tile in TerrainLods. Only tiles in view request texture mips
+    std::vector<Aabb> TerrainTileBounds = {};
+    VisibilityCuller TerrainTileCuller;
+    TerrainExporter TerrainExport;
+    TerrainExportOptions ExportOptions;
+    Handle<Task> TerrainExportTask = nullptr;
+    Handle<Task> SetupViewTask = nullptr;
+    //True if the status bar is showing terrain loading progress. Cleared once the shared terrain is loaded
+    bool TerrainStatusShown = false;
     bool PrimitivesNeedRedraw = true;
-    bool TerritoryDataLoaded = false;
+    //Object bounding box batches. Rebuilt when Territory::ObjectBoundsVersion changes
+    std::vector<ObjectBoxBatch> ObjectBoxBatches = {};
+    //ObjectTable rows sorted by batch
+    std::vector<u32> ObjectBoxRows = {};
+    u32 ObjectBoxesVersion = 0;
+    //True if the selected object highlight was drawn last frame
+    bool ObjectHighlightDrawn = false;
+    //Labels of objects in visible zones whose class has ShowLabel set. ObjectLabelText[i] is the text of candidate i
+    LabelLayout ObjectLabels;
+    std::vector<string> ObjectLabelText = {};
+    //Hash of the object bounds version and the zone + class filters the candidates were built with
+    u64 ObjectLabelsKey = 0;
 
     GuiState* state_ = nullptr;
+
+    //Height above the ground the camera is placed at by the snap to ground button
+    static constexpr f32 CameraGroundHeight = 2.0f;
+    //Max bytes of terrain texture mips resident at once
+    static constexpr u64 TerrainTextureBudget = 64 * 1024 * 1024;
+    //Space in pixels between label text and the edge of its background
+    static constexpr f32 ObjectLabelMargin = 3.0f;
+    //Decoding is a read from the terrain cache file so one thread is plenty
+    static constexpr u32 TerrainTextureDecodeThreads = 1;
 };
\ No newline at end of file
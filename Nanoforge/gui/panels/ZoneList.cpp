@@ -23,7 +23,7 @@ void ZoneList::Update(GuiState* state, bool* open)
     }
 
     //Can't draw territory data if no territory is selected/open
-    if (!state->CurrentTerritory)
+    if (!state->CurrentTerritory || !state->CurrentTerritoryView)
     {
         ImGui::TextWrapped("%s Open a territory view \"Tools > Open territory\" to see its zones.", ICON_FA_EXCLAMATION_CIRCLE);
 
@@ -60,22 +60,14 @@ void ZoneList::Update(GuiState* state, bool* open)
 
     if (ImGui::Button("Show all"))
     {
-        for (auto& zone : state->CurrentTerritory->ZoneFiles)
-        {
-            zone.RenderBoundingBoxes = true;
-        }
+        state->CurrentTerritoryView->SetAllZonesVisible(true);
         state->CurrentTerritoryUpdateDebugDraw = true;
-        state->CurrentTerritory->UpdateObjectClassInstanceCounts();
     }
     ImGui::SameLine();
     if (ImGui::Button("Hide all"))
     {
-        for (auto& zone : state->CurrentTerritory->ZoneFiles)
-        {
-            zone.RenderBoundingBoxes = false;
-        }
+        state->CurrentTerritoryView->SetAllZonesVisible(false);
         state->CurrentTerritoryUpdateDebugDraw = true;
-        state->CurrentTerritory->UpdateObjectClassInstanceCounts();
     }
 
     ImGui::Separator();
@@ -100,7 +92,10 @@ void ZoneList::Update(GuiState* state, bool* open)
         {
             //Skip zones that don't meet search term or filter requirements
             if (searchTerm_ != "" && zone.Name.find(searchTerm_) == string::npos)
+            {
+                i++;
                 continue;
+            }
             if (hideEmptyZones && zone.Zone.Header.NumObjects == 0 || !(hideObjectBelowObjectThreshold ? zone.Zone.Objects.size() >= minObjectsToShowZone : true))
             {
                 i++;
@@ -119,10 +114,11 @@ void ZoneList::Update(GuiState* state, bool* open)
 
             //Controls
             ImGui::TableNextColumn();
-            if (ImGui::Checkbox((string("Draw##") + zone.Name).c_str(), &zone.RenderBoundingBoxes))
+            bool visible = state->CurrentTerritoryView->ZoneVisible(i);
+            if (ImGui::Checkbox((string("Draw##") + zone.Name).c_str(), &visible))
             {
+                state->CurrentTerritoryView->SetZoneVisible(i, visible);
                 state->CurrentTerritoryUpdateDebugDraw = true;
-                state->CurrentTerritory->UpdateObjectClassInstanceCounts();
             }
             ImGui::SameLine();
             if (ImGui::Button((string(ICON_FA_MAP_MARKER "##") + zone.Name).c_str()))
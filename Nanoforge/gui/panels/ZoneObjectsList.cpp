@@ -22,7 +22,7 @@ void ZoneObjectsList::Update(GuiState* state, bool* open)
         return;
     }
 
-    if (!state->CurrentTerritory || !state->CurrentTerritory->Ready())
+    if (!state->CurrentTerritory || !state->CurrentTerritory->Ready() || !state->CurrentTerritoryView)
     {
         ImGui::TextWrapped("%s Zone data still loading or no territory has been opened (Tools > Open Territory > Terr01 for main campaign). ", ICON_FA_EXCLAMATION_CIRCLE);
     }
@@ -38,7 +38,7 @@ void ZoneObjectsList::Update(GuiState* state, bool* open)
         {
             if (ImGui::Button("Show all types"))
             {
-                for (auto& objectClass : state->CurrentTerritory->ZoneObjectClasses)
+                for (auto& objectClass : state->CurrentTerritoryView->Classes)
                 {
                     objectClass.Show = true;
                 }
@@ -47,7 +47,7 @@ void ZoneObjectsList::Update(GuiState* state, bool* open)
             ImGui::SameLine();
             if (ImGui::Button("Hide all types"))
             {
-                for (auto& objectClass : state->CurrentTerritory->ZoneObjectClasses)
+                for (auto& objectClass : state->CurrentTerritoryView->Classes)
                 {
                     objectClass.Show = false;
                 }
@@ -60,20 +60,27 @@ void ZoneObjectsList::Update(GuiState* state, bool* open)
             {
                 ImGui::Text(" " ICON_FA_EYE);
                 gui::TooltipOnPrevious("Toggles whether bounding boxes are drawn for the object class", nullptr);
+                ImGui::SameLine();
+                ImGui::Text(" " ICON_FA_TAG);
+                gui::TooltipOnPrevious("Toggles whether names are drawn over objects of the class in the viewport", nullptr);
 
-                for (auto& objectClass : state->CurrentTerritory->ZoneObjectClasses)
+                for (u32 classIndex : state->CurrentTerritoryView->ClassDisplayOrder)
                 {
-                    if (ImGui::Checkbox((string("##showBB") + objectClass.Name).c_str(), &objectClass.Show))
+                    auto& objectClass = state->CurrentTerritory->ZoneObjectClasses[classIndex];
+                    auto& classView = state->CurrentTerritoryView->Classes[classIndex];
+                    if (ImGui::Checkbox((string("##showBB") + objectClass.Name).c_str(), &classView.Show))
                         state->CurrentTerritoryUpdateDebugDraw = true;
+                    ImGui::SameLine();
+                    ImGui::Checkbox((string("##showLabel") + objectClass.Name).c_str(), &classView.ShowLabel);
 
                     ImGui::SameLine();
                     ImGui::Text(objectClass.Name);
                     ImGui::SameLine();
-                    ImGui::TextColored(gui::SecondaryTextColor, "|  %d objects", objectClass.NumInstances);
+                    ImGui::TextColored(gui::SecondaryTextColor, "|  %d objects", classView.NumInstances);
                     ImGui::SameLine();
 
                     //Todo: Use a proper string formatting lib here
-                    if (ImGui::ColorEdit3(string("##" + objectClass.Name).c_str(), (f32*)&objectClass.Color, ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoLabel))
+                    if (ImGui::ColorEdit3(string("##" + objectClass.Name).c_str(), (f32*)&classView.Color, ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoLabel))
                         state->CurrentTerritoryUpdateDebugDraw = true;
                 }
                 ImGui::EndChild();
@@ -91,11 +98,13 @@ void ZoneObjectsList::Update(GuiState* state, bool* open)
 
             ImGui::PushStyleVar(ImGuiStyleVar_IndentSpacing, ImGui::GetFontSize() * 0.75f); //Increase spacing to differentiate leaves from expanded contents.
             //Loop through visible zones
-            for (auto& zone : state->CurrentTerritory->ZoneFiles)
+            for (u32 zoneIndex = 0; zoneIndex < state->CurrentTerritory->ZoneFiles.size(); zoneIndex++)
             {
-                if (!zone.RenderBoundingBoxes)
+                if (!state->CurrentTerritoryView->ZoneVisible(zoneIndex))
                     continue;
 
+                ZoneData& zone = state->CurrentTerritory->ZoneFiles[zoneIndex];
+
                 //Close zone node if none of it's child objects a visible (based on object type filters)
                 bool anyChildrenVisible = ZoneAnyChildObjectsVisible(state, zone);
                 if (ImGui::TreeNodeEx(zone.Name.c_str(), ImGuiTreeNodeFlags_SpanAvailWidth |
@@ -103,7 +112,7 @@ void ZoneObjectsList::Update(GuiState* state, bool* open)
                 {
                     for (auto& object : zone.Zone.ObjectsHierarchical)
                     {
-                        DrawObjectNode(state, object);
+                        DrawObjectNode(state, zone, object);
                     }
                     ImGui::TreePop();
                 }
@@ -117,13 +126,13 @@ void ZoneObjectsList::Update(GuiState* state, bool* open)
     ImGui::End();
 }
 
-void ZoneObjectsList::DrawObjectNode(GuiState* state, ZoneObjectNode36& object)
+void ZoneObjectsList::DrawObjectNode(GuiState* state, ZoneData& zone, ZoneObjectNode36& object)
 {
     //Don't show node if it and it's children object types are being hidden
-    if (!ShowObjectOrChildren(state, object))
+    if (!ShowObjectOrChildren(state, zone, object))
         return;
 
-    auto& objectClass = state->CurrentTerritory->GetObjectClass(object.Self->ClassnameHash);
+    auto& objectClass = state->CurrentTerritory->GetObjectClass(zone, state->CurrentTerritory->GetObjectIndex(zone, object.Self));
 
     //Update node index and selection state
     objectIndex_++; //Incremented for each node so they all have a unique id within dear imgui
@@ -201,7 +210,7 @@ void ZoneObjectsList::DrawObjectNode(GuiState* state, ZoneObjectNode36& object)
         //Draw child nodes
         for (auto& childObject : object.Children)
         {
-            DrawObjectNode(state, childObject);
+            DrawObjectNode(state, zone, childObject);
         }
         ImGui::TreePop();
     }
@@ -219,21 +228,21 @@ bool ZoneObjectsList::ZoneAnyChildObjectsVisible(GuiState* state, ZoneData& zone
 {
     for (auto& object : zone.Zone.ObjectsHierarchical)
     {
-        if (ShowObjectOrChildren(state, object))
+        if (ShowObjectOrChildren(state, zone, object))
             return true;
     }
     return false;
 }
 
-bool ZoneObjectsList::ShowObjectOrChildren(GuiState* state, ZoneObjectNode36& object)
+bool ZoneObjectsList::ShowObjectOrChildren(GuiState* state, ZoneData& zone, ZoneObjectNode36& object)
 {
-    auto& objectClass = state->CurrentTerritory->GetObjectClass(object.Self->ClassnameHash);
-    if (objectClass.Show)
+    u32 classIndex = zone.ObjectClassIndices[state->CurrentTerritory->GetObjectIndex(zone, object.Self)];
+    if (state->CurrentTerritoryView->Classes[classIndex].Show)
         return true;
 
     for (auto& child : object.Children)
     {
-        if (ShowObjectOrChildren(state, child))
+        if (ShowObjectOrChildren(state, zone, child))
             return true;
     }
 
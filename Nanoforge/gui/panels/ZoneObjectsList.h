@@ -12,11 +12,11 @@ public:
 
 private:
     //Draw tree node for zone object and recursively draw child objects
-    void DrawObjectNode(GuiState* state, ZoneObjectNode36& object);
+    void DrawObjectNode(GuiState* state, ZoneData& zone, ZoneObjectNode36& object);
     //Returns true if any objects in the zone are visible
     bool ZoneAnyChildObjectsVisible(GuiState* state, ZoneData& zone);
     //Returns true if the object or any of it's children are visible
-    bool ShowObjectOrChildren(GuiState* state, ZoneObjectNode36& object);
+    bool ShowObjectOrChildren(GuiState* state, ZoneData& zone, ZoneObjectNode36& object);
 
     string searchTerm_ = "";
     u32 objectIndex_ = 0;
@@ -5,6 +5,7 @@
 #include "gui/documents/XtblDocument.h"
 #include "gui/documents/AsmDocument.h"
 #include "gui/documents/LocalizationDocument.h"
+#include "rfg/ThumbnailGenerator.h"
 #include "render/imgui/imgui_ext.h"
 #include "common/string/String.h"
 #include <regex>
@@ -40,6 +41,11 @@ void FileExplorer::Update(GuiState* state, bool* open)
     if (FileTreeNeedsRegen)
         GenerateFileTree(state);
 
+    //Upload thumbnails generated since the last frame
+    if (!thumbnails_)
+        thumbnails_ = CreateHandle<ThumbnailService>(state->PackfileVFS);
+    thumbnails_->Update(state->Renderer);
+
     //Options
     if (ImGui::CollapsingHeader("Options"))
     {
@@ -49,6 +55,7 @@ void FileExplorer::Update(GuiState* state, bool* open)
             SearchChanged = true;
         if (ImGui::Checkbox("Case sensitive", &CaseSensitive))
             SearchChanged = true;
+        ImGui::Checkbox("Show thumbnails", &ShowThumbnails);
     }
 
     //Search bar
@@ -263,6 +270,12 @@ void FileExplorer::DrawFileNode(GuiState* state, FileExplorerNode& node)
         //Highlight the node if it's the currently selected node (the last node that was clicked)
         | (&node == state->FileExplorer_SelectedNode ? ImGuiTreeNodeFlags_Selected : 0));
 
+    //Only request thumbnails for nodes on screen so large folders aren't queued all at once
+    ThumbnailView thumbnail = {};
+    bool nodeHovered = ImGui::IsItemHovered();
+    if (ShowThumbnails && node.Type == Primitive && ImGui::IsItemVisible() && ThumbnailGenerator::Supported(Path::GetExtension(node.Filename)))
+        thumbnail = thumbnails_->Get(VppName, node.ParentName, node.Filename, node.InContainer);
+
     //Check if the node was clicked and detect double clicks
     if (ImGui::IsItemClicked())
     {
@@ -282,11 +295,26 @@ void FileExplorer::DrawFileNode(GuiState* state, FileExplorerNode& node)
         clickTimer.Reset();
     }
 
-    //Draw node icon
+    //Draw node icon. Replaced by the thumbnail once it's ready
     ImGui::PushStyleColor(ImGuiCol_Text, GetNodeColor(node));
     ImGui::SameLine();
     ImGui::SetCursorPosX(nodeXPos + 22.0f);
-    ImGui::Text(GetNodeIcon(node).c_str());
+    if (thumbnail.Texture)
+    {
+        f32 iconSize = ImGui::GetFontSize();
+        f32 scale = iconSize / (f32)std::max(thumbnail.Width, thumbnail.Height);
+        ImGui::Image(thumbnail.Texture, ImVec2((f32)thumbnail.Width * scale, (f32)thumbnail.Height * scale));
+        if (nodeHovered)
+        {
+            ImGui::BeginTooltip();
+            ImGui::Image(thumbnail.Texture, ImVec2((f32)thumbnail.Width, (f32)thumbnail.Height));
+            ImGui::EndTooltip();
+        }
+    }
+    else
+    {
+        ImGui::Text(GetNodeIcon(node).c_str());
+    }
     ImGui::PopStyleColor();
 
     //If the node is open draw it's child nodes
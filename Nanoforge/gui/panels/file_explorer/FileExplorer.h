@@ -6,6 +6,7 @@
 #include "Log.h"
 #include "common/timing/Timer.h"
 #include "FileExplorerNode.h"
+#include "ThumbnailService.h"
 #include <vector>
 #include <regex>
 #include <future>
@@ -64,6 +65,8 @@ private:
     };
     FileSearchType SearchType = FileSearchType::Match;
     bool HideUnsupportedFormats = false;
+    //Show previews of textures and meshes in place of their icons. Hovering a node shows a larger preview
+    bool ShowThumbnails = true;
     bool RegexSearch = false;
     bool CaseSensitive = false;
     std::regex SearchRegex {""};
@@ -80,4 +83,7 @@ private:
     std::future<void> searchThreadFuture_;
     bool runningSearchThread_ = false;
     bool searchThreadForceStop_ = false;
+
+    //Generates thumbnails for visible nodes in the background. Created once packfiles are loaded
+    Handle<ThumbnailService> thumbnails_ = nullptr;
 };
\ No newline at end of file
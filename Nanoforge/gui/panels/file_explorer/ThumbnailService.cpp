@@ -0,0 +1,189 @@
+#include "ThumbnailService.h"
+#include "rfg/ThumbnailGenerator.h"
+#include "rfg/PackfileVFS.h"
+#include "render/backend/DX11Renderer.h"
+#include "util/MappedFile.h"
+#include "util/RfgUtil.h"
+#include "Log.h"
+#include <algorithm>
+
+ThumbnailService::ThumbnailService(PackfileVFS* packfileVFS) : packfileVFS_(packfileVFS)
+{
+    worker_ = std::async(std::launch::async, [this]() { WorkerThread(); });
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    Stop();
+
+    //Release DX11 resource views
+    for (auto& [key, thumbnail] : thumbnails_)
+        if (thumbnail.Texture)
+            ((ID3D11ShaderResourceView*)thumbnail.Texture)->Release();
+}
+
+ThumbnailView ThumbnailService::Get(const string& vppName, const string& parentName, const string& filename, bool inContainer)
+{
+    string cpuFilename = ThumbnailGenerator::GetCpuFilename(filename);
+    string key = vppName + "/" + (inContainer ? parentName + "/" : "") + cpuFilename;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    auto search = thumbnails_.find(key);
+    if (search == thumbnails_.end())
+    {
+        ThumbnailEntry& entry = thumbnails_[key];
+        entry.VppName = vppName;
+        entry.ParentName = parentName;
+        entry.CpuFilename = cpuFilename;
+        entry.InContainer = inContainer;
+        entry.LastRequestedFrame = frame_;
+        queue_.push_back(key);
+        queueChanged_.notify_one();
+        return {};
+    }
+
+    ThumbnailEntry& entry = search->second;
+    entry.LastRequestedFrame = frame_;
+    if (entry.State != ThumbnailState::Ready)
+        return {};
+
+    return { entry.Texture, entry.Image.Width, entry.Image.Height };
+}
+
+void ThumbnailService::Update(DX11Renderer* renderer)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    frame_++;
+
+    for (auto& [key, thumbnail] : thumbnails_)
+    {
+        if (thumbnail.State != ThumbnailState::Generated)
+            continue;
+
+        //Only the size is needed after uploading
+        thumbnail.Texture = renderer->TextureDataToHandle(thumbnail.Image.Pixels, DXGI_FORMAT_R8G8B8A8_UNORM, thumbnail.Image.Width, thumbnail.Image.Height);
+        thumbnail.Image.Pixels = {};
+        if (thumbnail.Texture)
+        {
+            thumbnail.State = ThumbnailState::Ready;
+            numResident_++;
+        }
+        else
+        {
+            Log->error("Failed to create thumbnail texture for {}", key);
+            thumbnail.State = ThumbnailState::Failed;
+        }
+    }
+
+    if (numResident_ > MaxResidentThumbnails)
+        EvictThumbnails();
+}
+
+void ThumbnailService::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+        queueChanged_.notify_all();
+    }
+    if (worker_.valid())
+        worker_.wait();
+}
+
+void ThumbnailService::WorkerThread()
+{
+    while (true)
+    {
+        //Take the newest request. The entry is copied so the thumbnail can be made without holding the lock
+        string key;
+        ThumbnailEntry request;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            queueChanged_.wait(lock, [this]() { return stop_ || queue_.size() > 0; });
+            if (stop_)
+                return;
+
+            key = queue_.back();
+            queue_.pop_back();
+            ThumbnailEntry& entry = thumbnails_[key];
+
+            //Drop requests that weren't repeated last frame. Get() queues them again if they come back into view
+            if (entry.LastRequestedFrame + 1 < frame_)
+            {
+                thumbnails_.erase(key);
+                continue;
+            }
+
+            entry.State = ThumbnailState::Generating;
+            request = entry;
+        }
+
+        Thumbnail thumbnail;
+        bool succeeded = LoadThumbnail(request, thumbnail);
+
+        //Entries are only erased by this thread and by EvictThumbnails() which skips those being generated, so it still exists
+        std::lock_guard<std::mutex> lock(lock_);
+        ThumbnailEntry& entry = thumbnails_[key];
+        entry.State = succeeded ? ThumbnailState::Generated : ThumbnailState::Failed;
+        entry.Image = std::move(thumbnail);
+    }
+}
+
+bool ThumbnailService::LoadThumbnail(const ThumbnailEntry& request, Thumbnail& out)
+{
+    string gpuFilename = RfgUtil::CpuFilenameToGpuFilename(request.CpuFilename);
+    auto maybeCpuFilePath = request.InContainer ?
+        packfileVFS_->GetFilePath(request.VppName, request.ParentName, request.CpuFilename) :
+        packfileVFS_->GetFilePath(request.VppName, request.CpuFilename);
+    auto maybeGpuFilePath = request.InContainer ?
+        packfileVFS_->GetFilePath(request.VppName, request.ParentName, gpuFilename) :
+        packfileVFS_->GetFilePath(request.VppName, gpuFilename);
+    if (!maybeCpuFilePath || !maybeGpuFilePath)
+    {
+        Log->warn("Failed to find files for thumbnail of \"{}\" in \"{}\"", request.CpuFilename, request.InContainer ? request.VppName + "/" + request.ParentName : request.VppName);
+        return false;
+    }
+
+    //Map the files so they can be hashed and parsed without copying them
+    MappedFile cpuFile;
+    MappedFile gpuFile;
+    if (!cpuFile.Open(maybeCpuFilePath.value()) || !gpuFile.Open(maybeGpuFilePath.value()))
+    {
+        Log->warn("Failed to open files for thumbnail of \"{}\"", request.CpuFilename);
+        return false;
+    }
+
+    u64 key = ThumbnailCache::GetKey(cpuFile.Data(), gpuFile.Data());
+    if (ThumbnailCache::Read(key, out))
+        return true;
+
+    try
+    {
+        out = ThumbnailGenerator::Generate(request.CpuFilename, cpuFile.Data(), gpuFile.Data());
+    }
+    catch (std::exception& ex)
+    {
+        Log->warn("Failed to generate thumbnail for \"{}\". Error: {}", request.CpuFilename, ex.what());
+        return false;
+    }
+
+    ThumbnailCache::Write(key, out);
+    return true;
+}
+
+void ThumbnailService::EvictThumbnails()
+{
+    std::vector<std::pair<u64, string>> resident = {};
+    for (auto& [key, thumbnail] : thumbnails_)
+        if (thumbnail.State == ThumbnailState::Ready)
+            resident.push_back({ thumbnail.LastRequestedFrame, key });
+
+    std::sort(resident.begin(), resident.end());
+    for (u32 i = 0; i < resident.size() && numResident_ > MaxResidentThumbnails; i++)
+    {
+        ThumbnailEntry& thumbnail = thumbnails_[resident[i].second];
+        ((ID3D11ShaderResourceView*)thumbnail.Texture)->Release();
+        thumbnails_.erase(resident[i].second);
+        numResident_--;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "rfg/ThumbnailCache.h"
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class PackfileVFS;
+class DX11Renderer;
+using ImTextureID = void*;
+
+//Thumbnail texture for the gui. Texture is nullptr if the thumbnail isn't ready yet or couldn't be generated
+struct ThumbnailView
+{
+    ImTextureID Texture = nullptr;
+    u32 Width = 0;
+    u32 Height = 0;
+};
+
+//Provides thumbnails of textures and static meshes for the file explorer so users can browse assets without opening them.
+//Thumbnails are loaded from ThumbnailCache or made by ThumbnailGenerator on a background thread, then uploaded on the main thread by Update().
+//Only files that are requested each frame are generated. The newest requests are handled first and requests that stop being repeated (e.g. rows scrolled out of view) are dropped.
+class ThumbnailService
+{
+public:
+    //Max number of thumbnail textures kept on the GPU. The least recently requested are released past this. They're quick to reload from the disk cache
+    static constexpr u32 MaxResidentThumbnails = 2048;
+
+    ThumbnailService(PackfileVFS* packfileVFS);
+    ~ThumbnailService();
+
+    //Get the thumbnail of a file. Queues it if it hasn't been requested yet. Call each frame the file is visible. Accepts cpu or gpu filenames
+    ThumbnailView Get(const string& vppName, const string& parentName, const string& filename, bool inContainer);
+    //Upload thumbnails finished by the worker thread and release old ones. Must be called once per frame on the main thread
+    void Update(DX11Renderer* renderer);
+    //Stop generating thumbnails. Blocks until the worker thread exits. Called by the destructor
+    void Stop();
+
+private:
+    enum class ThumbnailState
+    {
+        Queued,
+        Generating,
+        Generated, //Pixels are ready to be uploaded by Update()
+        Ready,
+        Failed
+    };
+    struct ThumbnailEntry
+    {
+        ThumbnailState State = ThumbnailState::Queued;
+        string VppName;
+        string ParentName;
+        string CpuFilename;
+        bool InContainer = false;
+        u64 LastRequestedFrame = 0;
+        Thumbnail Image;
+        ImTextureID Texture = nullptr;
+    };
+
+    void WorkerThread();
+    //Load a thumbnail from the disk cache or generate it. Doesn't access any shared state. Returns false on failure
+    bool LoadThumbnail(const ThumbnailEntry& request, Thumbnail& out);
+    //Release textures of the least recently requested thumbnails until MaxResidentThumbnails fit. lock_ must be held
+    void EvictThumbnails();
+
+    PackfileVFS* packfileVFS_ = nullptr;
+    //Keyed by "vpp/parent/cpu filename"
+    std::unordered_map<string, ThumbnailEntry> thumbnails_ = {};
+    //Keys of queued thumbnails in the order they were requested
+    std::vector<string> queue_ = {};
+    u32 numResident_ = 0;
+    u64 frame_ = 0;
+    bool stop_ = false;
+    std::mutex lock_;
+    std::condition_variable queueChanged_;
+    //Must store futures for std::async to run functions asynchronously
+    std::future<void> worker_;
+};
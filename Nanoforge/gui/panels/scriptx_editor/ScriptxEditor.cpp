@@ -210,11 +210,8 @@ void ScriptxEditor::LoadScriptxFile(const string& name, GuiState* state)
     ScriptxEditor_Cleanup(state);
 
     //Wait for packfileVFS to be ready for use
-    //Todo: Either move packfileVFS init out of worker thread or move this onto a thread so this doesn't lock the entire program while packfileVFS init is pending
-    while (!state->PackfileVFS->Ready())
-    {
-        Sleep(100);
-    }
+    //Todo: Move this onto a task so this doesn't lock the entire program while the packfile scan is pending
+    state->PackfileScanTask->Wait();
 
     //Find target file
     auto handles = state->PackfileVFS->GetFiles(name, false, true);
@@ -0,0 +1,431 @@
+#include "DX11RenderDevice.h"
+#include "render/util/DX11Helpers.h"
+#include "Log.h"
+#include <algorithm>
+
+//Todo: Stick this in a debug namespace
+static void SetDebugName(ID3D11DeviceChild* child, const std::string& name)
+{
+    if (child != nullptr)
+        child->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<u32>(name.size()), name.c_str());
+}
+
+static DXGI_FORMAT ToDxgiFormat(RenderVertexFormat format)
+{
+    switch (format)
+    {
+    case RenderVertexFormat::Float3:
+        return DXGI_FORMAT_R32G32B32_FLOAT;
+    case RenderVertexFormat::Short2:
+        return DXGI_FORMAT_R16G16_SINT;
+    case RenderVertexFormat::Short4:
+        return DXGI_FORMAT_R16G16B16A16_SINT;
+    case RenderVertexFormat::UByte4:
+        return DXGI_FORMAT_R8G8B8A8_UINT;
+    case RenderVertexFormat::UByte4Norm:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    default:
+        THROW_EXCEPTION("Unsupported vertex format {}", (u32)format);
+    }
+}
+
+static DXGI_FORMAT ToDxgiFormat(RenderTextureFormat format)
+{
+    switch (format)
+    {
+    case RenderTextureFormat::RGBA8:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case RenderTextureFormat::BC1:
+        return DXGI_FORMAT_BC1_UNORM;
+    case RenderTextureFormat::BC2:
+        return DXGI_FORMAT_BC2_UNORM;
+    case RenderTextureFormat::BC3:
+        return DXGI_FORMAT_BC3_UNORM;
+    default:
+        THROW_EXCEPTION("Unsupported texture format {}", (u32)format);
+    }
+}
+
+static D3D11_PRIMITIVE_TOPOLOGY ToD3D11Topology(RenderTopology topology)
+{
+    switch (topology)
+    {
+    case RenderTopology::TriangleList:
+        return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    case RenderTopology::TriangleStrip:
+        return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+    case RenderTopology::LineList:
+        return D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+    default:
+        THROW_EXCEPTION("Unsupported primitive topology {}", (u32)topology);
+    }
+}
+
+//Bytes per row of a mip. Block compressed formats store rows of 4x4 pixel blocks
+static u32 RowPitch(RenderTextureFormat format, u32 width)
+{
+    u32 blocksWide = std::max(1u, (width + 3) / 4);
+    switch (format)
+    {
+    case RenderTextureFormat::BC1:
+        return blocksWide * 8;
+    case RenderTextureFormat::BC2:
+    case RenderTextureFormat::BC3:
+        return blocksWide * 16;
+    case RenderTextureFormat::RGBA8:
+    default:
+        return width * 4;
+    }
+}
+
+//Find a free slot or add one. Slots are reused so handles stay small
+template<typename T>
+static u32 AllocateSlot(std::vector<T>& slots)
+{
+    for (u32 i = 1; i < slots.size(); i++)
+        if (!slots[i].Alive)
+            return i;
+
+    slots.emplace_back();
+    return (u32)slots.size() - 1;
+}
+
+DX11RenderDevice::DX11RenderDevice(ComPtr<ID3D11Device> d3d11Device, ComPtr<ID3D11DeviceContext> d3d11Context)
+    : d3d11Device_(d3d11Device), d3d11Context_(d3d11Context)
+{
+
+}
+
+template<typename T>
+T& DX11RenderDevice::GetSlot(std::vector<T>& slots, u32 handle, const char* resourceType)
+{
+    if (handle >= slots.size() || !slots[handle].Alive)
+        THROW_EXCEPTION("Invalid {} handle {} passed to DX11RenderDevice.", resourceType, handle);
+
+    return slots[handle];
+}
+
+BufferHandle DX11RenderDevice::CreateBuffer(RenderBufferType type, u32 size, const void* data, bool dynamic)
+{
+    if (size == 0)
+        THROW_EXCEPTION("Tried to create an empty buffer.");
+
+    u32 bindFlags = D3D11_BIND_VERTEX_BUFFER;
+    if (type == RenderBufferType::Index)
+        bindFlags = D3D11_BIND_INDEX_BUFFER;
+    else if (type == RenderBufferType::Constant)
+        bindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+    //Create the buffer before taking the lock. Only the device is used which is thread safe
+    Buffer buffer;
+    if (dynamic)
+        buffer.Create(d3d11Device_, size, bindFlags, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE, 0, data);
+    else
+        buffer.Create(d3d11Device_, size, bindFlags, D3D11_USAGE_DEFAULT, 0, 0, data);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(buffers_);
+    BufferSlot& slot = buffers_[handle];
+    slot.Alive = true;
+    slot.Resource = buffer;
+    slot.Type = type;
+    slot.Dynamic = dynamic;
+    stats_.NumBuffers++;
+    stats_.BufferBytes += size;
+    if (data)
+        stats_.BytesUploaded += size;
+
+    return handle;
+}
+
+void DX11RenderDevice::UpdateBuffer(BufferHandle buffer, const void* data, u32 offset, u32 size)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    BufferSlot& slot = GetSlot(buffers_, buffer, "buffer");
+    if ((u64)offset + size > slot.Resource.Size())
+        THROW_EXCEPTION("Buffer update of {} bytes at offset {} doesn't fit in buffer {} ({} bytes).", size, offset, buffer, slot.Resource.Size());
+
+    if (slot.Dynamic)
+    {
+        if (offset != 0)
+            THROW_EXCEPTION("Dynamic buffers must be updated starting at offset 0. Buffer {}", buffer);
+
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        ZeroMemory(&mappedResource, sizeof(D3D11_MAPPED_SUBRESOURCE));
+        DxCheck(d3d11Context_->Map(slot.Resource.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource), "Failed to map dynamic buffer.");
+        memcpy(mappedResource.pData, data, size);
+        d3d11Context_->Unmap(slot.Resource.Get(), 0);
+    }
+    else if (offset == 0 && size == slot.Resource.Size())
+    {
+        //Constant buffers can't be partially updated with a box
+        slot.Resource.SetData(d3d11Context_, const_cast<void*>(data));
+    }
+    else
+    {
+        if (slot.Type == RenderBufferType::Constant)
+            THROW_EXCEPTION("Constant buffers must be updated all at once. Buffer {}", buffer);
+
+        slot.Resource.SetData(d3d11Context_, data, offset, size);
+    }
+    stats_.BytesUploaded += size;
+}
+
+void DX11RenderDevice::DestroyBuffer(BufferHandle buffer)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    BufferSlot& slot = GetSlot(buffers_, buffer, "buffer");
+    stats_.NumBuffers--;
+    stats_.BufferBytes -= slot.Resource.Size();
+    slot = {};
+}
+
+TextureHandle DX11RenderDevice::CreateTexture(const string& name, RenderTextureFormat format, std::span<const RenderTextureMip> mips)
+{
+    if (mips.size() == 0)
+        THROW_EXCEPTION("Tried to create texture {} without any mips.", name);
+
+    u64 size = 0;
+    std::vector<D3D11_SUBRESOURCE_DATA> mipData = {};
+    for (const RenderTextureMip& mip : mips)
+    {
+        u64 mipSize = MipSize(format, mip.Width, mip.Height);
+        if (mip.Data.size() < mipSize)
+            THROW_EXCEPTION("Mip data of texture {} is too small. Expected {} bytes, got {}.", name, mipSize, mip.Data.size());
+
+        D3D11_SUBRESOURCE_DATA& data = mipData.emplace_back();
+        data.pSysMem = mip.Data.data();
+        data.SysMemPitch = RowPitch(format, mip.Width);
+        data.SysMemSlicePitch = 0;
+        size += mipSize;
+    }
+
+    //Create the texture before taking the lock. Only the device is used which is thread safe
+    Texture2D texture;
+    texture.Name = name;
+    texture.Create(d3d11Device_, mips[0].Width, mips[0].Height, ToDxgiFormat(format), D3D11_BIND_SHADER_RESOURCE, mipData.data(), (u32)mipData.size());
+    texture.CreateShaderResourceView(); //Need shader resource view to use it in shader
+    texture.CreateSampler(); //Need sampler too
+#ifdef DEBUG_BUILD
+    SetDebugName(texture.Get(), name);
+#endif
+
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(textures_);
+    TextureSlot& slot = textures_[handle];
+    slot.Alive = true;
+    slot.Texture = texture;
+    slot.Size = size;
+    stats_.NumTextures++;
+    stats_.TextureBytes += size;
+    stats_.BytesUploaded += size;
+    return handle;
+}
+
+void DX11RenderDevice::DestroyTexture(TextureHandle texture)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    TextureSlot& slot = GetSlot(textures_, texture, "texture");
+    stats_.NumTextures--;
+    stats_.TextureBytes -= slot.Size;
+    slot = {};
+}
+
+PipelineHandle DX11RenderDevice::CreatePipeline(const RenderPipelineDesc& desc)
+{
+    if (desc.Layout.size() == 0)
+        THROW_EXCEPTION("Pipeline for {} has no vertex layout.", desc.ShaderPath);
+
+    PipelineSlot pipeline;
+    pipeline.Alive = true;
+    pipeline.Program.Load(desc.ShaderPath, d3d11Device_, desc.UseGeometryShader);
+    ComPtr<ID3DBlob> pVSBlob = pipeline.Program.GetVertexShaderBytes();
+    if (!pVSBlob)
+        THROW_EXCEPTION("Failed to load shader {} for pipeline.", desc.ShaderPath);
+
+    //Create the input layout
+    std::vector<D3D11_INPUT_ELEMENT_DESC> layout = {};
+    for (const RenderVertexAttribute& attribute : desc.Layout)
+        layout.push_back({ attribute.Semantic.c_str(), attribute.SemanticIndex, ToDxgiFormat(attribute.Format), 0, attribute.Offset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+
+    if (FAILED(d3d11Device_->CreateInputLayout(layout.data(), (u32)layout.size(), pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), pipeline.Layout.GetAddressOf())))
+        THROW_EXCEPTION("Failed to create vertex layout for {}.", desc.ShaderPath);
+
+    //Setup rasterizer state
+    D3D11_RASTERIZER_DESC rasterizerDesc;
+    ZeroMemory(&rasterizerDesc, sizeof(rasterizerDesc));
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = desc.CullMode == RenderCullMode::Back ? D3D11_CULL_BACK : D3D11_CULL_NONE;
+    rasterizerDesc.FrontCounterClockwise = false;
+    rasterizerDesc.DepthBias = false;
+    rasterizerDesc.DepthBiasClamp = 0;
+    rasterizerDesc.SlopeScaledDepthBias = 0;
+    rasterizerDesc.DepthClipEnable = true;
+    rasterizerDesc.ScissorEnable = false;
+    rasterizerDesc.MultisampleEnable = false;
+    rasterizerDesc.AntialiasedLineEnable = false;
+    DxCheck(d3d11Device_->CreateRasterizerState(&rasterizerDesc, pipeline.RasterizerState.GetAddressOf()), "Pipeline rasterizer state creation failed!");
+
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(pipelines_);
+    pipelines_[handle] = pipeline;
+    return handle;
+}
+
+void DX11RenderDevice::DestroyPipeline(PipelineHandle pipeline)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    GetSlot(pipelines_, pipeline, "pipeline") = {};
+}
+
+RenderTargetHandle DX11RenderDevice::CreateRenderTarget(u32 width, u32 height)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(renderTargets_);
+    RenderTargetSlot& target = renderTargets_[handle];
+    target.Alive = true;
+    CreateRenderTargetResources(target, width, height);
+    return handle;
+}
+
+void DX11RenderDevice::ResizeRenderTarget(RenderTargetHandle target, u32 width, u32 height)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    CreateRenderTargetResources(GetSlot(renderTargets_, target, "render target"), width, height);
+}
+
+void DX11RenderDevice::DestroyRenderTarget(RenderTargetHandle target)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    GetSlot(renderTargets_, target, "render target") = {};
+}
+
+void* DX11RenderDevice::GetRenderTargetView(RenderTargetHandle target)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return GetSlot(renderTargets_, target, "render target").Color.GetShaderResourceView();
+}
+
+void DX11RenderDevice::CreateRenderTargetResources(RenderTargetSlot& target, u32 width, u32 height)
+{
+    //Create texture and map a render target and shader resource view to it
+    target.Color.Create(d3d11Device_, width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, (D3D11_BIND_FLAG)(D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE));
+    target.Color.CreateRenderTargetView(); //Allows us to use texture as a render target
+    target.Color.CreateShaderResourceView(); //Lets shaders view texture. Used by dear imgui to draw textures in gui
+#ifdef DEBUG_BUILD
+    SetDebugName(target.Color.Get(), "sceneViewTexture_");
+#endif
+
+    //Create depth buffer texture and view
+    target.Depth.Create(d3d11Device_, width, height, DXGI_FORMAT_D24_UNORM_S8_UINT, D3D11_BIND_DEPTH_STENCIL);
+    target.Depth.CreateDepthStencilView();
+
+    target.Viewport.TopLeftX = 0.0f;
+    target.Viewport.TopLeftY = 0.0f;
+    target.Viewport.Width = static_cast<f32>(width);
+    target.Viewport.Height = static_cast<f32>(height);
+    target.Viewport.MinDepth = 0.0f;
+    target.Viewport.MaxDepth = 1.0f;
+}
+
+void DX11RenderDevice::BeginPass(RenderTargetHandle target, const f32 clearColor[4])
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    RenderTargetSlot& slot = GetSlot(renderTargets_, target, "render target");
+    d3d11Context_->ClearRenderTargetView(slot.Color.GetRenderTargetView(), clearColor);
+    d3d11Context_->ClearDepthStencilView(slot.Depth.GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+    d3d11Context_->OMSetRenderTargets(1, slot.Color.GetRenderTargetViewPP(), slot.Depth.GetDepthStencilView());
+    d3d11Context_->RSSetViewports(1, &slot.Viewport);
+
+    stats_.DrawCalls = 0;
+    stats_.VerticesDrawn = 0;
+    stats_.IndicesDrawn = 0;
+    stats_.StateChanges = 0;
+    stats_.BytesUploaded = 0;
+}
+
+void DX11RenderDevice::EndPass()
+{
+
+}
+
+void DX11RenderDevice::SetPipeline(PipelineHandle pipeline)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    PipelineSlot& slot = GetSlot(pipelines_, pipeline, "pipeline");
+
+    //Reload shaders if necessary
+    slot.Program.TryReload();
+    slot.Program.Bind(d3d11Context_);
+    d3d11Context_->IASetInputLayout(slot.Layout.Get());
+    d3d11Context_->RSSetState(slot.RasterizerState.Get());
+    stats_.StateChanges++;
+}
+
+void DX11RenderDevice::SetTopology(RenderTopology topology)
+{
+    d3d11Context_->IASetPrimitiveTopology(ToD3D11Topology(topology));
+    std::lock_guard<std::mutex> lock(lock_);
+    stats_.StateChanges++;
+}
+
+void DX11RenderDevice::SetVertexBuffer(BufferHandle buffer, u32 stride)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 vertexOffset = 0;
+    d3d11Context_->IASetVertexBuffers(0, 1, GetSlot(buffers_, buffer, "vertex buffer").Resource.GetAddressOf(), &stride, &vertexOffset);
+    stats_.StateChanges++;
+}
+
+void DX11RenderDevice::SetIndexBuffer(BufferHandle buffer, RenderIndexFormat format)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    DXGI_FORMAT dxgiFormat = format == RenderIndexFormat::U16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    d3d11Context_->IASetIndexBuffer(GetSlot(buffers_, buffer, "index buffer").Resource.Get(), dxgiFormat, 0);
+    stats_.StateChanges++;
+}
+
+void DX11RenderDevice::SetConstantBuffer(u32 stages, u32 slot, BufferHandle buffer)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    ID3D11Buffer** d3d11Buffer = GetSlot(buffers_, buffer, "constant buffer").Resource.GetAddressOf();
+    if (stages & ShaderStageVertex)
+        d3d11Context_->VSSetConstantBuffers(slot, 1, d3d11Buffer);
+    if (stages & ShaderStageGeometry)
+        d3d11Context_->GSSetConstantBuffers(slot, 1, d3d11Buffer);
+    if (stages & ShaderStagePixel)
+        d3d11Context_->PSSetConstantBuffers(slot, 1, d3d11Buffer);
+
+    stats_.StateChanges++;
+}
+
+void DX11RenderDevice::SetTexture(u32 slot, TextureHandle texture)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (texture == NullRenderHandle)
+    {
+        ID3D11ShaderResourceView* nullView = nullptr;
+        d3d11Context_->PSSetShaderResources(slot, 1, &nullView);
+    }
+    else
+    {
+        GetSlot(textures_, texture, "texture").Texture.Bind(d3d11Context_, slot);
+    }
+    stats_.StateChanges++;
+}
+
+void DX11RenderDevice::Draw(u32 numVertices, u32 firstVertex)
+{
+    d3d11Context_->Draw(numVertices, firstVertex);
+    std::lock_guard<std::mutex> lock(lock_);
+    stats_.DrawCalls++;
+    stats_.VerticesDrawn += numVertices;
+}
+
+void DX11RenderDevice::DrawIndexed(u32 numIndices, u32 firstIndex)
+{
+    d3d11Context_->DrawIndexed(numIndices, firstIndex, 0);
+    std::lock_guard<std::mutex> lock(lock_);
+    stats_.DrawCalls++;
+    stats_.IndicesDrawn += numIndices;
+}
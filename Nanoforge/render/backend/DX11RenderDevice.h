@@ -0,0 +1,87 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "render/backend/RenderDevice.h"
+#include "render/resources/Buffer.h"
+#include "render/resources/Texture2D.h"
+#include "render/resources/Shader.h"
+#include <d3d11.h>
+#include <vector>
+#include <wrl.h>
+using Microsoft::WRL::ComPtr;
+
+//RenderDevice implemented with D3D11. Command functions use the immediate context so DX11Renderer::ContextMutex must be locked while calling them.
+class DX11RenderDevice : public RenderDevice
+{
+public:
+    DX11RenderDevice(ComPtr<ID3D11Device> d3d11Device, ComPtr<ID3D11DeviceContext> d3d11Context);
+
+    BufferHandle CreateBuffer(RenderBufferType type, u32 size, const void* data = nullptr, bool dynamic = false) override;
+    void UpdateBuffer(BufferHandle buffer, const void* data, u32 offset, u32 size) override;
+    void DestroyBuffer(BufferHandle buffer) override;
+
+    TextureHandle CreateTexture(const string& name, RenderTextureFormat format, std::span<const RenderTextureMip> mips) override;
+    void DestroyTexture(TextureHandle texture) override;
+
+    PipelineHandle CreatePipeline(const RenderPipelineDesc& desc) override;
+    void DestroyPipeline(PipelineHandle pipeline) override;
+
+    RenderTargetHandle CreateRenderTarget(u32 width, u32 height) override;
+    void ResizeRenderTarget(RenderTargetHandle target, u32 width, u32 height) override;
+    void DestroyRenderTarget(RenderTargetHandle target) override;
+    void* GetRenderTargetView(RenderTargetHandle target) override;
+
+    void BeginPass(RenderTargetHandle target, const f32 clearColor[4]) override;
+    void EndPass() override;
+    void SetPipeline(PipelineHandle pipeline) override;
+    void SetTopology(RenderTopology topology) override;
+    void SetVertexBuffer(BufferHandle buffer, u32 stride) override;
+    void SetIndexBuffer(BufferHandle buffer, RenderIndexFormat format) override;
+    void SetConstantBuffer(u32 stages, u32 slot, BufferHandle buffer) override;
+    void SetTexture(u32 slot, TextureHandle texture) override;
+    void Draw(u32 numVertices, u32 firstVertex) override;
+    void DrawIndexed(u32 numIndices, u32 firstIndex) override;
+
+private:
+    struct BufferSlot
+    {
+        bool Alive = false;
+        Buffer Resource;
+        RenderBufferType Type = RenderBufferType::Vertex;
+        bool Dynamic = false;
+    };
+    struct TextureSlot
+    {
+        bool Alive = false;
+        Texture2D Texture;
+        u64 Size = 0;
+    };
+    struct PipelineSlot
+    {
+        bool Alive = false;
+        Shader Program;
+        ComPtr<ID3D11InputLayout> Layout = nullptr;
+        ComPtr<ID3D11RasterizerState> RasterizerState = nullptr;
+    };
+    struct RenderTargetSlot
+    {
+        bool Alive = false;
+        Texture2D Color;
+        Texture2D Depth;
+        D3D11_VIEWPORT Viewport;
+    };
+
+    //Get the slot a handle refers to. Throws if the handle is invalid. lock_ must be held
+    template<typename T>
+    T& GetSlot(std::vector<T>& slots, u32 handle, const char* resourceType);
+    //Create color and depth textures for a render target. lock_ must be held
+    void CreateRenderTargetResources(RenderTargetSlot& target, u32 width, u32 height);
+
+    ComPtr<ID3D11Device> d3d11Device_ = nullptr;
+    ComPtr<ID3D11DeviceContext> d3d11Context_ = nullptr;
+
+    //Index 0 is reserved so NullRenderHandle is never valid
+    std::vector<BufferSlot> buffers_ = { {} };
+    std::vector<TextureSlot> textures_ = { {} };
+    std::vector<PipelineSlot> pipelines_ = { {} };
+    std::vector<RenderTargetSlot> renderTargets_ = { {} };
+};
@@ -40,6 +40,7 @@ void DX11Renderer::Init(HINSTANCE hInstance, WNDPROC wndProc, u32 WindowWidth, u
     UpdateWindowDimensions();
     if (!InitDx11())
         THROW_EXCEPTION("Failed to initialize DX11.");
+    renderDevice_ = CreateHandle<DX11RenderDevice>(d3d11Device_, d3d11Context_);
     if (!InitImGui())
         THROW_EXCEPTION("Failed to initialize dear imgui.");
 
@@ -64,6 +65,9 @@ DX11Renderer::~DX11Renderer()
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
 
+    //Scenes free their resources through the render device
+    Scenes.clear();
+    renderDevice_.reset();
     ReleaseCOM(swapChain_);
     d3d11Device_.Reset();
     d3d11Context_.Reset();
@@ -165,7 +169,7 @@ ImTextureID DX11Renderer::TextureDataToHandle(std::span<u8> data, DXGI_FORMAT fo
 Handle<Scene> DX11Renderer::CreateScene()
 {
     auto& scene = Scenes.emplace_back(new Scene);
-    scene->Init(d3d11Device_, d3d11Context_, config_);
+    scene->Init(renderDevice_, config_);
     return scene;
 }
 
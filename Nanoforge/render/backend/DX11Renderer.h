@@ -2,6 +2,7 @@
 #include "common/Typedefs.h"
 #include "rfg/TerrainHelpers.h"
 #include "render/resources/Scene.h"
+#include "render/backend/DX11RenderDevice.h"
 #include <ext/WindowsWrapper.h>
 #include <DirectXMath.h>
 #include <d3d11.h>
@@ -69,6 +70,8 @@ private:
     IDXGIFactory* dxgiFactory_ = nullptr;
     ComPtr<ID3D11Device> d3d11Device_ = nullptr;
     ComPtr<ID3D11DeviceContext> d3d11Context_ = nullptr;
+    //Used by scenes to create resources and draw. Shared with each scene so it outlives them
+    Handle<DX11RenderDevice> renderDevice_ = nullptr;
     IDXGISwapChain* swapChain_ = nullptr;
     ID3D11RenderTargetView* renderTargetView_ = nullptr;
 
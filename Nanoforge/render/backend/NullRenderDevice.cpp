@@ -0,0 +1,293 @@
+#include "NullRenderDevice.h"
+#include "Log.h"
+
+//Find a free slot or add one. Slots are reused so handles stay small
+template<typename T>
+static u32 AllocateSlot(std::vector<T>& resources)
+{
+    for (u32 i = 1; i < resources.size(); i++)
+        if (!resources[i].Alive)
+            return i;
+
+    resources.emplace_back();
+    return (u32)resources.size() - 1;
+}
+
+static u32 AllocateSlot(std::vector<u8>& resources)
+{
+    for (u32 i = 1; i < resources.size(); i++)
+        if (!resources[i])
+            return i;
+
+    resources.push_back(0);
+    return (u32)resources.size() - 1;
+}
+
+template<typename T>
+void NullRenderDevice::Validate(const std::vector<T>& resources, u32 handle, const char* resourceType, bool allowNull) const
+{
+    if (handle == NullRenderHandle && allowNull)
+        return;
+
+    bool alive = false;
+    if constexpr (std::is_same_v<T, u8>)
+        alive = handle < resources.size() && resources[handle] != 0;
+    else
+        alive = handle < resources.size() && resources[handle].Alive;
+
+    if (!alive)
+        THROW_EXCEPTION("Invalid {} handle {} passed to NullRenderDevice.", resourceType, handle);
+}
+
+BufferHandle NullRenderDevice::CreateBuffer(RenderBufferType type, u32 size, const void* data, bool dynamic)
+{
+    if (size == 0)
+        THROW_EXCEPTION("Tried to create an empty buffer.");
+
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(buffers_);
+    buffers_[handle] = { true, type, size, dynamic };
+    stats_.NumBuffers++;
+    stats_.BufferBytes += size;
+    if (data)
+        stats_.BytesUploaded += size;
+
+    return handle;
+}
+
+void NullRenderDevice::UpdateBuffer(BufferHandle buffer, const void* data, u32 offset, u32 size)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(buffers_, buffer, "buffer");
+    const BufferInfo& info = buffers_[buffer];
+    if ((u64)offset + size > info.Size)
+        THROW_EXCEPTION("Buffer update of {} bytes at offset {} doesn't fit in buffer {} ({} bytes).", size, offset, buffer, info.Size);
+    if (info.Type == RenderBufferType::Constant && (offset != 0 || size != info.Size))
+        THROW_EXCEPTION("Constant buffers must be updated all at once. Buffer {}", buffer);
+    if (info.Dynamic && offset != 0)
+        THROW_EXCEPTION("Dynamic buffers must be updated starting at offset 0. Buffer {}", buffer);
+
+    stats_.BytesUploaded += size;
+    Record(RenderCommandType::UpdateBuffer, buffer, offset, size);
+}
+
+void NullRenderDevice::DestroyBuffer(BufferHandle buffer)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(buffers_, buffer, "buffer");
+    stats_.NumBuffers--;
+    stats_.BufferBytes -= buffers_[buffer].Size;
+    buffers_[buffer] = {};
+}
+
+TextureHandle NullRenderDevice::CreateTexture(const string& name, RenderTextureFormat format, std::span<const RenderTextureMip> mips)
+{
+    if (mips.size() == 0)
+        THROW_EXCEPTION("Tried to create texture {} without any mips.", name);
+
+    u64 size = 0;
+    for (const RenderTextureMip& mip : mips)
+    {
+        u64 mipSize = MipSize(format, mip.Width, mip.Height);
+        if (mip.Data.size() < mipSize)
+            THROW_EXCEPTION("Mip data of texture {} is too small. Expected {} bytes, got {}.", name, mipSize, mip.Data.size());
+
+        size += mipSize;
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(textures_);
+    textures_[handle] = { true, size };
+    stats_.NumTextures++;
+    stats_.TextureBytes += size;
+    stats_.BytesUploaded += size;
+    return handle;
+}
+
+void NullRenderDevice::DestroyTexture(TextureHandle texture)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(textures_, texture, "texture");
+    stats_.NumTextures--;
+    stats_.TextureBytes -= textures_[texture].Size;
+    textures_[texture] = {};
+}
+
+PipelineHandle NullRenderDevice::CreatePipeline(const RenderPipelineDesc& desc)
+{
+    if (desc.Layout.size() == 0)
+        THROW_EXCEPTION("Pipeline for {} has no vertex layout.", desc.ShaderPath);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(pipelines_);
+    pipelines_[handle] = 1;
+    return handle;
+}
+
+void NullRenderDevice::DestroyPipeline(PipelineHandle pipeline)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(pipelines_, pipeline, "pipeline");
+    pipelines_[pipeline] = 0;
+}
+
+RenderTargetHandle NullRenderDevice::CreateRenderTarget(u32 width, u32 height)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    u32 handle = AllocateSlot(renderTargets_);
+    renderTargets_[handle] = 1;
+    return handle;
+}
+
+void NullRenderDevice::ResizeRenderTarget(RenderTargetHandle target, u32 width, u32 height)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(renderTargets_, target, "render target");
+}
+
+void NullRenderDevice::DestroyRenderTarget(RenderTargetHandle target)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(renderTargets_, target, "render target");
+    renderTargets_[target] = 0;
+}
+
+void NullRenderDevice::BeginPass(RenderTargetHandle target, const f32 clearColor[4])
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(renderTargets_, target, "render target");
+    if (inPass_)
+        THROW_EXCEPTION("BeginPass() called before the previous pass ended.");
+
+    inPass_ = true;
+    vertexBuffer_ = NullRenderHandle;
+    indexBuffer_ = NullRenderHandle;
+    pipeline_ = NullRenderHandle;
+    stats_.DrawCalls = 0;
+    stats_.VerticesDrawn = 0;
+    stats_.IndicesDrawn = 0;
+    stats_.StateChanges = 0;
+    stats_.BytesUploaded = 0;
+    Record(RenderCommandType::BeginPass, target);
+}
+
+void NullRenderDevice::EndPass()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!inPass_)
+        THROW_EXCEPTION("EndPass() called without a matching BeginPass().");
+
+    inPass_ = false;
+    Record(RenderCommandType::EndPass);
+}
+
+void NullRenderDevice::SetPipeline(PipelineHandle pipeline)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(pipelines_, pipeline, "pipeline");
+    pipeline_ = pipeline;
+    stats_.StateChanges++;
+    Record(RenderCommandType::SetPipeline, pipeline);
+}
+
+void NullRenderDevice::SetTopology(RenderTopology topology)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    stats_.StateChanges++;
+    Record(RenderCommandType::SetTopology, (u32)topology);
+}
+
+void NullRenderDevice::SetVertexBuffer(BufferHandle buffer, u32 stride)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(buffers_, buffer, "vertex buffer");
+    vertexBuffer_ = buffer;
+    stats_.StateChanges++;
+    Record(RenderCommandType::SetVertexBuffer, buffer, stride);
+}
+
+void NullRenderDevice::SetIndexBuffer(BufferHandle buffer, RenderIndexFormat format)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(buffers_, buffer, "index buffer");
+    indexBuffer_ = buffer;
+    stats_.StateChanges++;
+    Record(RenderCommandType::SetIndexBuffer, buffer, (u32)format);
+}
+
+void NullRenderDevice::SetConstantBuffer(u32 stages, u32 slot, BufferHandle buffer)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(buffers_, buffer, "constant buffer");
+    stats_.StateChanges++;
+    Record(RenderCommandType::SetConstantBuffer, stages, slot, buffer);
+}
+
+void NullRenderDevice::SetTexture(u32 slot, TextureHandle texture)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Validate(textures_, texture, "texture", true);
+    stats_.StateChanges++;
+    Record(RenderCommandType::SetTexture, slot, texture);
+}
+
+void NullRenderDevice::Draw(u32 numVertices, u32 firstVertex)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!inPass_ || pipeline_ == NullRenderHandle || vertexBuffer_ == NullRenderHandle)
+        THROW_EXCEPTION("Draw() called without an active pass, pipeline, and vertex buffer.");
+
+    stats_.DrawCalls++;
+    stats_.VerticesDrawn += numVertices;
+    Record(RenderCommandType::Draw, numVertices, firstVertex);
+}
+
+void NullRenderDevice::DrawIndexed(u32 numIndices, u32 firstIndex)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!inPass_ || pipeline_ == NullRenderHandle || vertexBuffer_ == NullRenderHandle || indexBuffer_ == NullRenderHandle)
+        THROW_EXCEPTION("DrawIndexed() called without an active pass, pipeline, vertex buffer, and index buffer.");
+
+    stats_.DrawCalls++;
+    stats_.IndicesDrawn += numIndices;
+    Record(RenderCommandType::DrawIndexed, numIndices, firstIndex);
+}
+
+const char* NullRenderDevice::ToString(RenderCommandType type)
+{
+    switch (type)
+    {
+    case RenderCommandType::BeginPass:
+        return "BeginPass";
+    case RenderCommandType::EndPass:
+        return "EndPass";
+    case RenderCommandType::SetPipeline:
+        return "SetPipeline";
+    case RenderCommandType::SetTopology:
+        return "SetTopology";
+    case RenderCommandType::SetVertexBuffer:
+        return "SetVertexBuffer";
+    case RenderCommandType::SetIndexBuffer:
+        return "SetIndexBuffer";
+    case RenderCommandType::SetConstantBuffer:
+        return "SetConstantBuffer";
+    case RenderCommandType::SetTexture:
+        return "SetTexture";
+    case RenderCommandType::Draw:
+        return "Draw";
+    case RenderCommandType::DrawIndexed:
+        return "DrawIndexed";
+    case RenderCommandType::UpdateBuffer:
+        return "UpdateBuffer";
+    default:
+        return "Unknown";
+    }
+}
+
+void NullRenderDevice::Record(RenderCommandType type, u32 arg0, u32 arg1, u32 arg2)
+{
+    if (LogCommands)
+        Log->info("{}({}, {}, {})", ToString(type), arg0, arg1, arg2);
+    if (RecordCommands)
+        commands_.push_back({ type, { arg0, arg1, arg2 } });
+}
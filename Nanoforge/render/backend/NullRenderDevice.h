@@ -0,0 +1,99 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "render/backend/RenderDevice.h"
+#include <vector>
+
+enum class RenderCommandType
+{
+    BeginPass,
+    EndPass,
+    SetPipeline,
+    SetTopology,
+    SetVertexBuffer,
+    SetIndexBuffer,
+    SetConstantBuffer,
+    SetTexture,
+    Draw,
+    DrawIndexed,
+    UpdateBuffer
+};
+
+//Command recorded by NullRenderDevice. Meaning of the args depends on the type. They match the order of the RenderDevice function arguments (handles, counts, offsets)
+struct RenderCommand
+{
+    RenderCommandType Type;
+    u32 Args[3] = { 0, 0, 0 };
+};
+
+//Render device that doesn't draw anything. Used to run scenes without a GPU, e.g. to benchmark or test scene code on any platform.
+//Tracks resources like a real backend and throws if a command uses a handle that doesn't exist, so resource lifetime bugs show up without a GPU.
+//Commands can be recorded to check what a scene submits, and logged for debugging.
+class NullRenderDevice : public RenderDevice
+{
+public:
+    BufferHandle CreateBuffer(RenderBufferType type, u32 size, const void* data = nullptr, bool dynamic = false) override;
+    void UpdateBuffer(BufferHandle buffer, const void* data, u32 offset, u32 size) override;
+    void DestroyBuffer(BufferHandle buffer) override;
+
+    TextureHandle CreateTexture(const string& name, RenderTextureFormat format, std::span<const RenderTextureMip> mips) override;
+    void DestroyTexture(TextureHandle texture) override;
+
+    PipelineHandle CreatePipeline(const RenderPipelineDesc& desc) override;
+    void DestroyPipeline(PipelineHandle pipeline) override;
+
+    RenderTargetHandle CreateRenderTarget(u32 width, u32 height) override;
+    void ResizeRenderTarget(RenderTargetHandle target, u32 width, u32 height) override;
+    void DestroyRenderTarget(RenderTargetHandle target) override;
+    void* GetRenderTargetView(RenderTargetHandle target) override { return nullptr; }
+
+    void BeginPass(RenderTargetHandle target, const f32 clearColor[4]) override;
+    void EndPass() override;
+    void SetPipeline(PipelineHandle pipeline) override;
+    void SetTopology(RenderTopology topology) override;
+    void SetVertexBuffer(BufferHandle buffer, u32 stride) override;
+    void SetIndexBuffer(BufferHandle buffer, RenderIndexFormat format) override;
+    void SetConstantBuffer(u32 stages, u32 slot, BufferHandle buffer) override;
+    void SetTexture(u32 slot, TextureHandle texture) override;
+    void Draw(u32 numVertices, u32 firstVertex) override;
+    void DrawIndexed(u32 numIndices, u32 firstIndex) override;
+
+    //Commands since the last call to ClearCommands(). Only filled if RecordCommands is true
+    const std::vector<RenderCommand>& Commands() const { return commands_; }
+    void ClearCommands() { commands_.clear(); }
+    static const char* ToString(RenderCommandType type);
+
+    bool RecordCommands = true;
+    //Log each command as it's submitted. Very slow, only meant for debugging
+    bool LogCommands = false;
+
+private:
+    struct BufferInfo
+    {
+        bool Alive = false;
+        RenderBufferType Type = RenderBufferType::Vertex;
+        u32 Size = 0;
+        bool Dynamic = false;
+    };
+    struct TextureInfo
+    {
+        bool Alive = false;
+        u64 Size = 0;
+    };
+
+    void Record(RenderCommandType type, u32 arg0 = 0, u32 arg1 = 0, u32 arg2 = 0);
+    //Throw if a handle doesn't refer to a live resource. NullRenderHandle is allowed where allowNull is true
+    template<typename T>
+    void Validate(const std::vector<T>& resources, u32 handle, const char* resourceType, bool allowNull = false) const;
+
+    //Index 0 is reserved so NullRenderHandle is never valid
+    std::vector<BufferInfo> buffers_ = { {} };
+    std::vector<TextureInfo> textures_ = { {} };
+    std::vector<u8> pipelines_ = { 0 };
+    std::vector<u8> renderTargets_ = { 0 };
+    std::vector<RenderCommand> commands_ = {};
+    bool inPass_ = false;
+    //Buffers bound for the next draw. Used to catch draws without the buffers they need
+    BufferHandle vertexBuffer_ = NullRenderHandle;
+    BufferHandle indexBuffer_ = NullRenderHandle;
+    PipelineHandle pipeline_ = NullRenderHandle;
+};
@@ -0,0 +1,181 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <algorithm>
+#include <mutex>
+#include <span>
+#include <vector>
+
+//Handles to resources owned by a RenderDevice. NullRenderHandle is never a valid resource
+using BufferHandle = u32;
+using TextureHandle = u32;
+using PipelineHandle = u32;
+using RenderTargetHandle = u32;
+constexpr u32 NullRenderHandle = 0;
+
+enum class RenderBufferType
+{
+    Vertex,
+    Index,
+    Constant
+};
+
+enum class RenderTopology
+{
+    TriangleList,
+    TriangleStrip,
+    LineList
+};
+
+enum class RenderIndexFormat
+{
+    U16,
+    U32
+};
+
+//Vertex attribute formats. Only includes formats used by existing vertex layouts
+enum class RenderVertexFormat
+{
+    Float3,      //3x f32
+    Short2,      //2x i16
+    Short4,      //4x i16
+    UByte4,      //4x u8
+    UByte4Norm   //4x u8 normalized to [0, 1]
+};
+
+enum class RenderTextureFormat
+{
+    RGBA8,
+    BC1,
+    BC2,
+    BC3
+};
+
+enum class RenderCullMode
+{
+    None,
+    Back
+};
+
+//Shader stages a constant buffer is bound to. Can be combined
+enum RenderShaderStage : u32
+{
+    ShaderStageVertex = 1,
+    ShaderStageGeometry = 2,
+    ShaderStagePixel = 4
+};
+
+struct RenderVertexAttribute
+{
+    string Semantic;
+    u32 SemanticIndex = 0;
+    RenderVertexFormat Format = RenderVertexFormat::Float3;
+    //Offset in bytes from the start of the vertex
+    u32 Offset = 0;
+};
+
+//Shaders, vertex layout, and rasterizer state used by a group of draws
+struct RenderPipelineDesc
+{
+    //Shader source file. Must have VS and PS entry points. GS is used if UseGeometryShader is true and it's present
+    string ShaderPath;
+    std::vector<RenderVertexAttribute> Layout = {};
+    RenderCullMode CullMode = RenderCullMode::Back;
+    bool UseGeometryShader = false;
+};
+
+struct RenderTextureMip
+{
+    u32 Width = 0;
+    u32 Height = 0;
+    std::span<const u8> Data = {};
+};
+
+//Work done by the last pass and resources alive on the device
+struct RenderDeviceStats
+{
+    //Reset by BeginPass()
+    u32 DrawCalls = 0;
+    u64 VerticesDrawn = 0;
+    u64 IndicesDrawn = 0;
+    u32 StateChanges = 0;
+    u64 BytesUploaded = 0;
+
+    u32 NumBuffers = 0;
+    u32 NumTextures = 0;
+    u64 BufferBytes = 0;
+    u64 TextureBytes = 0;
+};
+
+//Thin layer between the scene code and the graphics API so scenes can be built and drawn without a GPU. See DX11RenderDevice and NullRenderDevice.
+//Resource creation and destruction can be called from any thread. Commands must be called from one thread at a time between BeginPass() and EndPass().
+class RenderDevice
+{
+public:
+    virtual ~RenderDevice() = default;
+
+    //Create a buffer. data is optional and must be size bytes if provided. Dynamic buffers are meant to be rewritten every frame with UpdateBuffer()
+    virtual BufferHandle CreateBuffer(RenderBufferType type, u32 size, const void* data = nullptr, bool dynamic = false) = 0;
+    //Overwrite size bytes of a buffer starting at offset. Constant buffers must be written all at once.
+    //Dynamic buffers must be written from offset 0 and lose any contents past size
+    virtual void UpdateBuffer(BufferHandle buffer, const void* data, u32 offset, u32 size) = 0;
+    virtual void DestroyBuffer(BufferHandle buffer) = 0;
+
+    //Create a texture with a mip chain, largest mip first
+    virtual TextureHandle CreateTexture(const string& name, RenderTextureFormat format, std::span<const RenderTextureMip> mips) = 0;
+    virtual void DestroyTexture(TextureHandle texture) = 0;
+
+    virtual PipelineHandle CreatePipeline(const RenderPipelineDesc& desc) = 0;
+    virtual void DestroyPipeline(PipelineHandle pipeline) = 0;
+
+    //Color + depth target that a pass draws to
+    virtual RenderTargetHandle CreateRenderTarget(u32 width, u32 height) = 0;
+    virtual void ResizeRenderTarget(RenderTargetHandle target, u32 width, u32 height) = 0;
+    virtual void DestroyRenderTarget(RenderTargetHandle target) = 0;
+    //Get a texture id that UI code can use to draw a render target. An ImTextureID for backends with a UI, nullptr otherwise
+    virtual void* GetRenderTargetView(RenderTargetHandle target) = 0;
+
+    //Clear a render target and start drawing to it
+    virtual void BeginPass(RenderTargetHandle target, const f32 clearColor[4]) = 0;
+    virtual void EndPass() = 0;
+    virtual void SetPipeline(PipelineHandle pipeline) = 0;
+    virtual void SetTopology(RenderTopology topology) = 0;
+    virtual void SetVertexBuffer(BufferHandle buffer, u32 stride) = 0;
+    virtual void SetIndexBuffer(BufferHandle buffer, RenderIndexFormat format) = 0;
+    //Bind a constant buffer to a slot of each shader stage in stages (see RenderShaderStage)
+    virtual void SetConstantBuffer(u32 stages, u32 slot, BufferHandle buffer) = 0;
+    //Bind a texture and its sampler to a pixel shader slot
+    virtual void SetTexture(u32 slot, TextureHandle texture) = 0;
+    virtual void Draw(u32 numVertices, u32 firstVertex) = 0;
+    virtual void DrawIndexed(u32 numIndices, u32 firstIndex) = 0;
+
+    RenderDeviceStats Stats() const
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        return stats_;
+    }
+
+    //Size in bytes of one index or one mip level
+    static u32 IndexSize(RenderIndexFormat format) { return format == RenderIndexFormat::U16 ? 2 : 4; }
+    static u64 MipSize(RenderTextureFormat format, u32 width, u32 height)
+    {
+        //Block compressed formats store 4x4 pixel blocks
+        u64 blocksWide = std::max(1u, (width + 3) / 4);
+        u64 blocksHigh = std::max(1u, (height + 3) / 4);
+        switch (format)
+        {
+        case RenderTextureFormat::BC1:
+            return blocksWide * blocksHigh * 8;
+        case RenderTextureFormat::BC2:
+        case RenderTextureFormat::BC3:
+            return blocksWide * blocksHigh * 16;
+        case RenderTextureFormat::RGBA8:
+        default:
+            return (u64)width * height * 4;
+        }
+    }
+
+protected:
+    //Guards resource tables and stats_ since resources can be created and destroyed from worker threads
+    mutable std::mutex lock_;
+    RenderDeviceStats stats_;
+};
@@ -1,8 +1,12 @@
 #include "Camera.h"
-#include <DirectXMath.h>
-#include <windowsx.h>
+#include <cmath>
 
-void Camera::Init(const DirectX::XMVECTOR& initialPos, f32 initialFovDegrees, const DirectX::XMFLOAT2& screenDimensions, f32 nearPlane, f32 farPlane)
+static Vec3 Scale(const Vec3& v, f32 scale)
+{
+    return { v.x * scale, v.y * scale, v.z * scale };
+}
+
+void Camera::Init(const Vec3& initialPos, f32 initialFovDegrees, const Vec2& screenDimensions, f32 nearPlane, f32 farPlane)
 {
     camPosition = initialPos;
     fovRadians_ = ToRadians(initialFovDegrees);
@@ -12,8 +16,8 @@ void Camera::Init(const DirectX::XMVECTOR& initialPos, f32 initialFovDegrees, co
     farPlane_ = farPlane;
 
     //Calculate initial pitch and yaw values
-    DirectX::XMVECTOR forwardVec = DirectX::XMVector3Normalize(DirectX::XMVectorSubtract({ 0.0f, 0.0f, 0.0f }, initialPos));
-    pitchRadians_ = asin(-forwardVec.m128_f32[1]);
+    Vec3 forwardVec = Mat4::Normalize({ -initialPos.x, -initialPos.y, -initialPos.z });
+    pitchRadians_ = asin(-forwardVec.y);
     yawRadians_ = 0.0f;
 
     //Set matrices
@@ -40,115 +44,109 @@ void Camera::DoFrame(f32 deltaTime)
         Translate(down, shiftDown);
 }
 
-void Camera::HandleResize(const DirectX::XMFLOAT2& screenDimensions)
+void Camera::HandleResize(const Vec2& screenDimensions)
 {
     //Set the Projection matrix
     screenDimensions_ = screenDimensions;
     UpdateProjectionMatrix();
 }
 
-void Camera::HandleInput(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+void Camera::SetKeyDown(CameraKey key, bool down)
 {
     if (!InputActive)
         return;
 
-    switch (msg)
+    switch (key)
     {
-    case WM_KEYDOWN: //Key down
-        if (wParam == 0x57) //w
-            wDown = true;
-        if (wParam == 0x41) //a
-            aDown = true;
-        if (wParam == 0x53) //s
-            sDown = true;
-        if (wParam == 0x44) //d
-            dDown = true;
-        if (wParam == 0x51) //q
-            qDown = true;
-        if (wParam == 0x45) //e
-            eDown = true;
-        if (wParam == VK_SHIFT)
-            shiftDown = true;
-
+    case CameraKey::Forward:
+        wDown = down;
         break;
-    case WM_KEYUP:
-        if (wParam == 0x57) //w
-            wDown = false;
-        if (wParam == 0x41) //a
-            aDown = false;
-        if (wParam == 0x53) //s
-            sDown = false;
-        if (wParam == 0x44) //d
-            dDown = false;
-        if (wParam == 0x51) //q
-            qDown = false;
-        if (wParam == 0x45) //e
-            eDown = false;
-        if (wParam == VK_SHIFT)
-            shiftDown = false;
-
+    case CameraKey::Left:
+        aDown = down;
         break;
-    case WM_RBUTTONDOWN:
-        rightMouseButtonDown = true;
+    case CameraKey::Backward:
+        sDown = down;
         break;
-    case WM_RBUTTONUP:
-        rightMouseButtonDown = false;
+    case CameraKey::Right:
+        dDown = down;
         break;
-    case WM_MOUSEWHEEL:
-        {
-            f32 scrollDelta = (f32)GET_WHEEL_DELTA_WPARAM(wParam) / 1000.0f;
-            Speed += scrollDelta;
-            if (Speed < MinSpeed)
-                Speed = MinSpeed;
-            if (Speed > MaxSpeed)
-                Speed = MaxSpeed;
-        }
+    case CameraKey::Up:
+        qDown = down;
         break;
-    case WM_MOUSEMOVE:
-        f32 mouseX = (f32)GET_X_LPARAM(lParam);
-        f32 mouseY = (f32)GET_Y_LPARAM(lParam);
-        lastMouseXDelta = mouseX - lastMouseXPos;
-        lastMouseYDelta = mouseY - lastMouseYPos;
-        lastMouseXPos = mouseX;
-        lastMouseYPos = mouseY;
-        if (rightMouseButtonDown)
-            UpdateRotationFromMouse((f32)lastMouseXDelta / screenDimensions_.x, (f32)lastMouseYDelta / screenDimensions_.y);
-
+    case CameraKey::Down:
+        eDown = down;
+        break;
+    case CameraKey::Sprint:
+        shiftDown = down;
         break;
     }
 }
 
+void Camera::SetLookActive(bool active)
+{
+    if (!InputActive)
+        return;
+
+    rightMouseButtonDown = active;
+}
+
+void Camera::HandleMouseMove(f32 mouseX, f32 mouseY)
+{
+    if (!InputActive)
+        return;
+
+    lastMouseXDelta = mouseX - lastMouseXPos;
+    lastMouseYDelta = mouseY - lastMouseYPos;
+    lastMouseXPos = mouseX;
+    lastMouseYPos = mouseY;
+    if (rightMouseButtonDown)
+        UpdateRotationFromMouse((f32)lastMouseXDelta / screenDimensions_.x, (f32)lastMouseYDelta / screenDimensions_.y);
+}
+
+void Camera::HandleMouseWheel(f32 wheelDelta)
+{
+    if (!InputActive)
+        return;
+
+    f32 scrollDelta = wheelDelta / 1000.0f;
+    Speed += scrollDelta;
+    if (Speed < MinSpeed)
+        Speed = MinSpeed;
+    if (Speed > MaxSpeed)
+        Speed = MaxSpeed;
+}
+
 void Camera::UpdateProjectionMatrix()
 {
-    camProjection = DirectX::XMMatrixPerspectiveFovLH(fovRadians_, screenDimensions_.x / screenDimensions_.y, nearPlane_, farPlane_);
+    camProjection = Mat4::PerspectiveFovLH(fovRadians_, screenDimensions_.x / screenDimensions_.y, nearPlane_, farPlane_);
 }
 
 void Camera::UpdateViewMatrix()
 {
     //Recalculate target
-    camRotationMatrix = DirectX::XMMatrixRotationRollPitchYaw(pitchRadians_, yawRadians_, ToRadians(180.0f));
-    camTarget = DirectX::XMVector3TransformCoord(DefaultForward, camRotationMatrix);
-    camTarget = DirectX::XMVector3Normalize(camTarget);
+    camRotationMatrix = Mat4::RotationRollPitchYaw(pitchRadians_, yawRadians_, ToRadians(180.0f));
+    camTarget = camRotationMatrix.TransformCoord(DefaultForward);
+    camTarget = Mat4::Normalize(camTarget);
 
     //Recalculate right, forward, and up vectors
-    camRight = DirectX::XMVector3TransformCoord(DefaultRight, camRotationMatrix);
-    camForward = DirectX::XMVector3TransformCoord(DefaultForward, camRotationMatrix);
-    camUp = DirectX::XMVector3Cross(camForward, camRight);
-    camUp = DirectX::XMVectorMultiply(camUp, { -1.0f, -1.0f, -1.0f });
+    camRight = camRotationMatrix.TransformCoord(DefaultRight);
+    camForward = camRotationMatrix.TransformCoord(DefaultForward);
+    camUp = Mat4::Cross(camForward, camRight);
+    camUp = Scale(camUp, -1.0f);
 
     //Recalculate view matrix
-    camTarget = DirectX::XMVectorAdd(camPosition, camTarget);
-    camView = DirectX::XMMatrixLookAtLH(camPosition, camTarget, camUp);
+    camTarget = { camPosition.x + camTarget.x, camPosition.y + camTarget.y, camPosition.z + camTarget.z };
+    camView = Mat4::LookAtLH(camPosition, camTarget, camUp);
 }
 
-DirectX::XMMATRIX Camera::GetViewProjMatrix()
+Mat4 Camera::GetViewProjMatrix()
 {
     return camView * camProjection;
 }
 
-void Camera::Translate(const DirectX::XMVECTOR& translation)
+void Camera::Translate(const Vec3& translation)
 {
-    camPosition = DirectX::XMVectorAdd(camPosition, translation);
+    camPosition = { camPosition.x + translation.x, camPosition.y + translation.y, camPosition.z + translation.z };
     UpdateViewMatrix();
 }
 
@@ -157,50 +155,48 @@ void Camera::Translate(CameraDirection moveDirection, bool sprint)
     switch (moveDirection)
     {
     case up:
-        Translate(sprint ? DirectX::XMVectorScale(camUp, SprintSpeed) : DirectX::XMVectorScale(camUp, Speed));
+        Translate(sprint ? Scale(camUp, SprintSpeed) : Scale(camUp, Speed));
         break;
     case down:
-        Translate(sprint ? DirectX::XMVectorScale(camUp, -SprintSpeed) : DirectX::XMVectorScale(camUp, -Speed));
+        Translate(sprint ? Scale(camUp, -SprintSpeed) : Scale(camUp, -Speed));
         break;
     case left:
-        Translate(sprint ? DirectX::XMVectorScale(Left(), SprintSpeed) : DirectX::XMVectorScale(Left(), Speed));
+        Translate(sprint ? Scale(Left(), SprintSpeed) : Scale(Left(), Speed));
         break;
     case right:
-        Translate(sprint ? DirectX::XMVectorScale(Right(), SprintSpeed) : DirectX::XMVectorScale(Right(), Speed));
+        Translate(sprint ? Scale(Right(), SprintSpeed) : Scale(Right(), Speed));
         break;
     case forward:
-        Translate(sprint ? DirectX::XMVectorScale(Forward(), SprintSpeed) : DirectX::XMVectorScale(Forward(), Speed));
+        Translate(sprint ? Scale(Forward(), SprintSpeed) : Scale(Forward(), Speed));
         break;
     case backward:
-        Translate(sprint ? DirectX::XMVectorScale(Backward(), SprintSpeed) : DirectX::XMVectorScale(Backward(), Speed));
+        Translate(sprint ? Scale(Backward(), SprintSpeed) : Scale(Backward(), Speed));
         break;
     default:
         break;
     }
 }
 
-void Camera::LookAt(const DirectX::XMVECTOR& target)
+void Camera::LookAt(const Vec3& target)
 {
     //Recalculate target
-    camRotationMatrix = DirectX::XMMatrixRotationRollPitchYaw(pitchRadians_, yawRadians_, ToRadians(180.0f));
-    camTarget = DirectX::XMVector3TransformCoord(DefaultForward, camRotationMatrix);
-    camTarget = DirectX::XMVector3Normalize(camTarget);
+    camRotationMatrix = Mat4::RotationRollPitchYaw(pitchRadians_, yawRadians_, ToRadians(180.0f));
+    camTarget = camRotationMatrix.TransformCoord(DefaultForward);
+    camTarget = Mat4::Normalize(camTarget);
 
     //Recalculate right, forward, and up vectors
-    camRight = DirectX::XMVector3TransformCoord(DefaultRight, camRotationMatrix);
-    camForward = DirectX::XMVector3TransformCoord(DefaultForward, camRotationMatrix);
-    camUp = DirectX::XMVector3Cross(camForward, camRight);
+    camRight = camRotationMatrix.TransformCoord(DefaultRight);
+    camForward = camRotationMatrix.TransformCoord(DefaultForward);
+    camUp = Mat4::Cross(camForward, camRight);
 
     //Recalculate view matrix
     camTarget = target;
-    camView = DirectX::XMMatrixLookAtLH(camPosition, camTarget, camUp);
+    camView = Mat4::LookAtLH(camPosition, camTarget, camUp);
 
     //Recalculate pitch and yaw
-    DirectX::XMMATRIX mInvView = XMMatrixInverse(nullptr, camView);
-    //The axis basis vectors and camera position are stored inside the position matrix in the 4 rows of the camera's world matrix.
-    //To figure out the yaw/pitch of the camera, we just need the Z basis vector
-    DirectX::XMFLOAT3 zBasis;
-    DirectX::XMStoreFloat3(&zBasis, mInvView.r[2]);
+    //The axis basis vectors and camera position are stored in the 4 rows of the camera's world matrix (the inverse of the view matrix).
+    //To figure out the yaw/pitch of the camera, we just need the Z basis vector. The view matrix rotation is orthonormal so it's the third column of the view matrix
+    Vec3 zBasis = { camView.m[0][2], camView.m[1][2], camView.m[2][2] };
 
     yawRadians_ = atan2f(zBasis.x, zBasis.z);
     float fLen = sqrtf(zBasis.z * zBasis.z + zBasis.x * zBasis.x);
@@ -209,37 +205,37 @@ void Camera::LookAt(const DirectX::XMVECTOR& target)
     UpdateViewMatrix();
 }
 
-DirectX::XMVECTOR Camera::Up() const
+Vec3 Camera::Up() const
 {
     return camUp;
 }
 
-DirectX::XMVECTOR Camera::Down() const
+Vec3 Camera::Down() const
 {
-    return DirectX::XMVectorScale(Up(), -1.0f);
+    return Scale(Up(), -1.0f);
 }
 
-DirectX::XMVECTOR Camera::Right() const
+Vec3 Camera::Right() const
 {
-    return DirectX::XMVectorSet(camView.r[0].m128_f32[0], camView.r[1].m128_f32[0], camView.r[2].m128_f32[0], 1.0f);
+    return { camView.m[0][0], camView.m[1][0], camView.m[2][0] };
 }
 
-DirectX::XMVECTOR Camera::Left() const
+Vec3 Camera::Left() const
 {
-    return DirectX::XMVectorScale(Right(), -1.0f);
+    return Scale(Right(), -1.0f);
 }
 
-DirectX::XMVECTOR Camera::Forward() const
+Vec3 Camera::Forward() const
 {
-    return DirectX::XMVectorSet(camView.r[0].m128_f32[2], camView.r[1].m128_f32[2], camView.r[2].m128_f32[2], 1.0f);
+    return { camView.m[0][2], camView.m[1][2], camView.m[2][2] };
 }
 
-DirectX::XMVECTOR Camera::Backward() const
+Vec3 Camera::Backward() const
 {
-    return DirectX::XMVectorScale(Forward(), -1.0f);
+    return Scale(Forward(), -1.0f);
 }
 
-DirectX::XMVECTOR Camera::Position() const
+Vec3 Camera::Position() const
 {
     return camPosition;
 }
@@ -261,6 +257,6 @@ void Camera::UpdateRotationFromMouse(f32 xDelta, f32 yDelta)
 
 void Camera::SetPosition(f32 x, f32 y, f32 z)
 {
-    camPosition = DirectX::XMVectorSet(x, y, z, 1.0f);
+    camPosition = { x, y, z };
     UpdateViewMatrix();
 }
\ No newline at end of file
@@ -1,53 +1,63 @@
 #pragma once
-#include <Common/Typedefs.h>
-#include <ext/WindowsWrapper.h>
+#include "common/Typedefs.h"
 #include "util/MathUtil.h"
-#include <DirectXMath.h>
+#include "util/Matrix.h"
+#include "RfgTools++/types/Vec2.h"
+#include "RfgTools++/types/Vec3.h"
 
 enum CameraDirection { up, down, left, right, forward, backward };
+//Keys the camera responds to. Platform input code maps its key codes to these
+enum class CameraKey { Forward, Backward, Left, Right, Up, Down, Sprint };
 
 //3D perspective camera used by renderer and scenes. All angles are stored in radians internally but exposed publically in degrees.
+//Doesn't depend on the platform or graphics API. Window messages are translated into the input functions below by the application
 class Camera
 {
 public:
-    void Init(const DirectX::XMVECTOR& initialPos, f32 initialFovDegrees, const DirectX::XMFLOAT2& screenDimensions, f32 nearPlane, f32 farPlane);
+    void Init(const Vec3& initialPos, f32 initialFovDegrees, const Vec2& screenDimensions, f32 nearPlane, f32 farPlane);
 
     void DoFrame(f32 deltaTime);
-    void HandleResize(const DirectX::XMFLOAT2& screenDimensions);
+    void HandleResize(const Vec2& screenDimensions);
     //Todo: Make an InputManager class which provides callbacks to input handlers and tracks key state
-    void HandleInput(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    void SetKeyDown(CameraKey key, bool down);
+    //The camera only rotates with the mouse while looking is active (e.g. right mouse button held)
+    void SetLookActive(bool active);
+    //Mouse position in window pixels
+    void HandleMouseMove(f32 mouseX, f32 mouseY);
+    //Raw wheel delta. Adjusts camera speed
+    void HandleMouseWheel(f32 wheelDelta);
 
     void UpdateProjectionMatrix();
     void UpdateViewMatrix();
-    DirectX::XMMATRIX GetViewProjMatrix();
+    Mat4 GetViewProjMatrix();
 
-    void Translate(const DirectX::XMVECTOR& translation);
+    void Translate(const Vec3& translation);
     void Translate(CameraDirection moveDirection, bool sprint = false);
-    void LookAt(const DirectX::XMVECTOR& target);
+    void LookAt(const Vec3& target);
 
-    [[nodiscard]] DirectX::XMVECTOR Up() const;
-    [[nodiscard]] DirectX::XMVECTOR Down() const;
-    [[nodiscard]] DirectX::XMVECTOR Right() const;
-    [[nodiscard]] DirectX::XMVECTOR Left() const;
-    [[nodiscard]] DirectX::XMVECTOR Forward() const;
-    [[nodiscard]] DirectX::XMVECTOR Backward() const;
-    [[nodiscard]] DirectX::XMVECTOR Position() const;
+    [[nodiscard]] Vec3 Up() const;
+    [[nodiscard]] Vec3 Down() const;
+    [[nodiscard]] Vec3 Right() const;
+    [[nodiscard]] Vec3 Left() const;
+    [[nodiscard]] Vec3 Forward() const;
+    [[nodiscard]] Vec3 Backward() const;
+    [[nodiscard]] Vec3 Position() const;
 
     void UpdateRotationFromMouse(f32 mouseXDelta, f32 mouseYDelta);
 
-    DirectX::XMMATRIX camView;
-    DirectX::XMMATRIX camProjection;
+    Mat4 camView;
+    Mat4 camProjection;
 
-    DirectX::XMVECTOR camPosition;
-    DirectX::XMVECTOR camTarget;
-    DirectX::XMVECTOR camUp;
+    Vec3 camPosition;
+    Vec3 camTarget;
+    Vec3 camUp;
 
-    DirectX::XMVECTOR DefaultForward = DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-    DirectX::XMVECTOR DefaultRight = DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
-    DirectX::XMVECTOR camForward = DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-    DirectX::XMVECTOR camRight = DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+    Vec3 DefaultForward = { 0.0f, 0.0f, 1.0f };
+    Vec3 DefaultRight = { 1.0f, 0.0f, 0.0f };
+    Vec3 camForward = { 0.0f, 0.0f, 1.0f };
+    Vec3 camRight = { 1.0f, 0.0f, 0.0f };
 
-    DirectX::XMMATRIX camRotationMatrix;
+    Mat4 camRotationMatrix;
 
     [[nodiscard]] f32 GetFovDegrees() const { return ToDegrees(fovRadians_); }
     [[nodiscard]] f32 GetFovRadians() const { return fovRadians_; }
@@ -77,7 +87,7 @@ private:
     f32 aspectRatio_ = 1.0f;
     f32 nearPlane_ = 1.0f;
     f32 farPlane_ = 100.0f;
-    DirectX::XMFLOAT2 screenDimensions_ = {};
+    Vec2 screenDimensions_ = {};
 
     f32 yawRadians_ = 0.0f;
     f32 pitchRadians_ = 0.0f;
@@ -1,7 +1,7 @@
 #include "Buffer.h"
 #include "Log.h"
 
-void Buffer::Create(ComPtr<ID3D11Device> d3d11Device, u32 size, u32 bindFlags, u32 usage, u32 cpuAccessFlags, u32 miscFlags)
+void Buffer::Create(ComPtr<ID3D11Device> d3d11Device, u32 size, u32 bindFlags, u32 usage, u32 cpuAccessFlags, u32 miscFlags, const void* initialData)
 {
     //Save buffer size and reset existing data
     size_ = size;
@@ -20,8 +20,12 @@ void Buffer::Create(ComPtr<ID3D11Device> d3d11Device, u32 size, u32 bindFlags, u
     bufferDesc.CPUAccessFlags = cpuAccessFlags;
     bufferDesc.MiscFlags = miscFlags;
 
+    D3D11_SUBRESOURCE_DATA data;
+    ZeroMemory(&data, sizeof(D3D11_SUBRESOURCE_DATA));
+    data.pSysMem = initialData;
+
     //Attempt to create buffer
-    if (FAILED(d3d11Device->CreateBuffer(&bufferDesc, NULL, buffer_.GetAddressOf())))
+    if (FAILED(d3d11Device->CreateBuffer(&bufferDesc, initialData ? &data : NULL, buffer_.GetAddressOf())))
         THROW_EXCEPTION("Failed to create render buffer.");
 }
 
@@ -31,6 +35,19 @@ void Buffer::SetData(ComPtr<ID3D11DeviceContext> d3d11Context, void* pData)
     d3d11Context->UpdateSubresource(buffer_.Get(), 0, NULL, pData, 0, 0);
 }
 
+void Buffer::SetData(ComPtr<ID3D11DeviceContext> d3d11Context, const void* pData, u32 offset, u32 size)
+{
+    //Buffers are one dimensional so only left and right matter
+    D3D11_BOX box;
+    box.left = offset;
+    box.right = offset + size;
+    box.top = 0;
+    box.bottom = 1;
+    box.front = 0;
+    box.back = 1;
+    d3d11Context->UpdateSubresource(buffer_.Get(), 0, &box, pData, 0, 0);
+}
+
 void Buffer::Resize(ComPtr<ID3D11Device> d3d11Device, u32 newSize)
 {
     Create(d3d11Device, newSize, bindFlags_, usage_, cpuAccessFlags_, miscFlags_);
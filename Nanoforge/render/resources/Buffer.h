@@ -10,10 +10,12 @@ using Microsoft::WRL::ComPtr;
 class Buffer
 {
 public:
-    //Creates a buffer from the provided variables
-    void Create(ComPtr<ID3D11Device> d3d11Device, u32 size, u32 bindFlags, u32 usage = D3D11_USAGE_DEFAULT, u32 cpuAccessFlags = 0, u32 miscFlags = 0);
+    //Creates a buffer from the provided variables. If initialData is provided it must be size bytes. Doesn't need the context so it's safe to call from any thread
+    void Create(ComPtr<ID3D11Device> d3d11Device, u32 size, u32 bindFlags, u32 usage = D3D11_USAGE_DEFAULT, u32 cpuAccessFlags = 0, u32 miscFlags = 0, const void* initialData = nullptr);
     //Update contents of buffer from pData
     void SetData(ComPtr<ID3D11DeviceContext> d3d11Context, void* pData);
+    //Update size bytes of the buffer starting at offset. Only valid for buffers without D3D11_USAGE_DYNAMIC or D3D11_USAGE_IMMUTABLE
+    void SetData(ComPtr<ID3D11DeviceContext> d3d11Context, const void* pData, u32 offset, u32 size);
     //Get raw pointer of underlying ID3D11Buffer
     ID3D11Buffer* Get() { return buffer_.Get(); }
     //Get pointer pointer to underlying ID3D11Buffer
@@ -22,6 +24,7 @@ public:
     void Resize(ComPtr<ID3D11Device> d3d11Device, u32 newSize);
     //Resize the buffer if its size is less than requiredSize
     void ResizeIfNeeded(ComPtr<ID3D11Device> d3d11Device, u32 requiredSize);
+    u32 Size() const { return size_; }
 
 private:
     ComPtr<ID3D11Buffer> buffer_ = nullptr;
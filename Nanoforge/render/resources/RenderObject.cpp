@@ -6,7 +6,19 @@ void RenderObject::Create(const Mesh& mesh, const Vec3& position)
     Position = position;
 }
 
-void RenderObject::Draw(ComPtr<ID3D11DeviceContext> d3d11Context, Buffer& perObjectBuffer, Camera& cam)
+Aabb RenderObject::WorldBounds() const
+{
+    if (!Bounds.Valid())
+        return Bounds;
+
+    //Scale can be negative so the corners are re-sorted
+    Aabb world;
+    world.Extend(Vec3(Bounds.Min.x * Scale.x + Position.x, Bounds.Min.y * Scale.y + Position.y, Bounds.Min.z * Scale.z + Position.z));
+    world.Extend(Vec3(Bounds.Max.x * Scale.x + Position.x, Bounds.Max.y * Scale.y + Position.y, Bounds.Max.z * Scale.z + Position.z));
+    return world;
+}
+
+void RenderObject::Draw(RenderDevice* device, BufferHandle perObjectBuffer, Camera& cam)
 {
     if (!Visible)
         return;
@@ -15,27 +27,24 @@ void RenderObject::Draw(ComPtr<ID3D11DeviceContext> d3d11Context, Buffer& perObj
     PerObjectConstants constants;
 
     //Calculate MVP matrix for object
-    DirectX::XMVECTOR rotaxis = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    DirectX::XMMATRIX rotation = DirectX::XMMatrixRotationAxis(rotaxis, 0.0f);
-    DirectX::XMMATRIX translation = DirectX::XMMatrixTranslation(Position.x, Position.y, Position.z);
-    DirectX::XMMATRIX scale = DirectX::XMMatrixScaling(Scale.x, Scale.y, Scale.z);
-    constants.MVP = DirectX::XMMatrixIdentity();
-    constants.MVP = translation * rotation * scale; //First calculate the model matrix
+    Mat4 translation = Mat4::Translation(Position.x, Position.y, Position.z);
+    Mat4 scale = Mat4::Scaling(Scale.x, Scale.y, Scale.z);
+    constants.MVP = translation * scale; //First calculate the model matrix
     //Then calculate model matrix with Model * View * Projection
-    constants.MVP = DirectX::XMMatrixTranspose(constants.MVP * cam.camView * cam.camProjection);
+    constants.MVP = (constants.MVP * cam.camView * cam.camProjection).Transposed();
 
     //Set MVP matrix in shader
-    perObjectBuffer.SetData(d3d11Context, &constants);
+    device->UpdateBuffer(perObjectBuffer, &constants, 0, sizeof(PerObjectConstants));
 
     //Bind textures
     if (UseTextures)
     {
-        DiffuseTexture.Bind(d3d11Context, 0);
-        SpecularTexture.Bind(d3d11Context, 1);
-        NormalTexture.Bind(d3d11Context, 2);
+        device->SetTexture(0, DiffuseTexture);
+        device->SetTexture(1, SpecularTexture);
+        device->SetTexture(2, NormalTexture);
     }
 
     //Bind objects mesh and draw it
-    ObjectMesh.Bind(d3d11Context);
-    d3d11Context->DrawIndexed(ObjectMesh.NumIndices(), 0, 0);
+    ObjectMesh.Bind(device);
+    device->DrawIndexed(ObjectMesh.NumIndices(), 0);
 }
\ No newline at end of file
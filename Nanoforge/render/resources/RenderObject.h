@@ -3,13 +3,14 @@
 #include "render/resources/Mesh.h"
 #include "RfgTools++/types/Vec3.h"
 #include "render/camera/Camera.h"
-#include "render/resources/Texture2D.h"
-#include <DirectXMath.h>
+#include "render/backend/RenderDevice.h"
+#include "util/Geometry.h"
+#include "util/Matrix.h"
 
 //Buffer for per-object shader constants (set once per object)
 struct PerObjectConstants
 {
-    DirectX::XMMATRIX MVP;
+    Mat4 MVP;
 };
 
 class RenderObject
@@ -18,7 +19,7 @@ public:
     //Create a render object
     void Create(const Mesh& mesh, const Vec3& position);
     //Draw the objects mesh
-    void Draw(ComPtr<ID3D11DeviceContext> d3d11Context, Buffer& perObjectBuffer, Camera& cam);
+    void Draw(RenderDevice* device, BufferHandle perObjectBuffer, Camera& cam);
     //Set uniform scale
     void SetScale(f32 scale)
     {
@@ -26,16 +27,21 @@ public:
         Scale.y = scale;
         Scale.z = scale;
     }
+    //Bounds after scale and position are applied
+    Aabb WorldBounds() const;
 
     Mesh ObjectMesh;
     Vec3 Scale = { 1.0f, 1.0f, 1.0f };
     Vec3 Position = { 0.0f, 0.0f, 0.0f };
     bool Visible = true;
+    //Bounds of the mesh before it's scaled and moved to Position. Used for view culling. Objects with invalid bounds are never culled
+    Aabb Bounds;
 
+    //Textures are owned by the scene device and may be shared by several objects. The scene frees them when it's destroyed
     bool UseTextures = false;
-    Texture2D DiffuseTexture;
-    Texture2D SpecularTexture;
-    Texture2D NormalTexture;
+    TextureHandle DiffuseTexture = NullRenderHandle;
+    TextureHandle SpecularTexture = NullRenderHandle;
+    TextureHandle NormalTexture = NullRenderHandle;
 
     //Todo: Terrain specific, should be in a material once material support is added
     //Index of this terrain subpiece on 3x3 grid that makes up the terrain of a single zone
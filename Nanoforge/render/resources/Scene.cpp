@@ -1,50 +1,70 @@
 #include "Scene.h"
-#include "render/util/DX11Helpers.h"
 #include <filesystem>
 #include "Log.h"
 #include "util/StringHelpers.h"
 #include "application/Config.h"
+#include <algorithm>
+#include <unordered_set>
 
-//Todo: Stick this in a debug namespace
-void SetDebugName(ID3D11DeviceChild* child, const std::string& name)
+void Scene::Init(Handle<RenderDevice> device, Config* config)
 {
-    if (child != nullptr)
-        child->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<u32>(name.size()), name.c_str());
-}
-
-void Scene::Init(ComPtr<ID3D11Device> d3d11Device, ComPtr<ID3D11DeviceContext> d3d11Context, Config* config)
-{
-    d3d11Device_ = d3d11Device;
-    d3d11Context_ = d3d11Context;
+    Device = device;
     config_ = config;
+    if (config_)
+    {
+        config_->EnsureVariableExists("Use geometry shaders", ConfigType::Bool);
+        useGeometryShaders_ = config_->GetBoolReadonly("Use geometry shaders").value();
+    }
 
-    config_->EnsureVariableExists("Use geometry shaders", ConfigType::Bool);
-
-    InitInternal();
+    renderTarget_ = Device->CreateRenderTarget(sceneViewWidth_, sceneViewHeight_);
     InitPrimitiveState();
-    InitRenderTarget();
 
-    //Create buffer for per object constants
-    perObjectBuffer_.Create(d3d11Device_, sizeof(PerObjectConstants), D3D11_BIND_CONSTANT_BUFFER);
+    //Create buffers for per frame and per object constants
+    perFrameBuffer_ = Device->CreateBuffer(RenderBufferType::Constant, sizeof(PerFrameConstants));
+    perObjectBuffer_ = Device->CreateBuffer(RenderBufferType::Constant, sizeof(PerObjectConstants));
+}
+
+Scene::~Scene()
+{
+    if (!Device)
+        return;
+
+    //Objects can share textures so each one is only destroyed once
+    std::unordered_set<TextureHandle> textures = {};
+    for (RenderObject& object : Objects)
+    {
+        object.ObjectMesh.Destroy(Device.get());
+        textures.insert(object.DiffuseTexture);
+        textures.insert(object.SpecularTexture);
+        textures.insert(object.NormalTexture);
+    }
+    for (TextureHandle texture : textures)
+        if (texture != NullRenderHandle)
+            Device->DestroyTexture(texture);
+
+    DestroyBuffer(perFrameBuffer_);
+    DestroyBuffer(perObjectBuffer_);
+    DestroyBuffer(lineVertexBuffer_);
+    DestroyBuffer(retainedLineVertexBuffer_);
+    DestroyPipeline(meshPipeline_);
+    DestroyPipeline(linelistPipeline_);
+    if (renderTarget_ != NullRenderHandle)
+        Device->DestroyRenderTarget(renderTarget_);
 }
 
 void Scene::SetShader(const string& path)
 {
-    shader_.Load(path, d3d11Device_, config_->GetBoolReadonly("Use geometry shaders").value());
+    shaderPath_ = path;
     shaderSet_ = true;
 }
 
-void Scene::SetVertexLayout(const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout)
+void Scene::SetVertexLayout(const std::vector<RenderVertexAttribute>& layout)
 {
-    auto pVSBlob = shader_.GetVertexShaderBytes();
-
-    //Create the input layout
-    if (FAILED(d3d11Device_->CreateInputLayout(layout.data(), layout.size(), pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), vertexLayout_.GetAddressOf())))
-        THROW_EXCEPTION("Failed to create scene vertex layout.");
+    if (!shaderSet_)
+        THROW_EXCEPTION("Scene::SetShader() must be called before Scene::SetVertexLayout().");
 
-    //Set the input layout
-    d3d11Context_->IASetInputLayout(vertexLayout_.Get());
-    vertexLayoutSet_ = true;
+    DestroyPipeline(meshPipeline_);
+    meshPipeline_ = Device->CreatePipeline({ .ShaderPath = shaderPath_, .Layout = layout, .CullMode = RenderCullMode::Back, .UseGeometryShader = useGeometryShaders_ });
 }
 
 void Scene::Draw(f32 deltaTime)
@@ -52,83 +72,111 @@ void Scene::Draw(f32 deltaTime)
     TotalTime += deltaTime;
 
     //Don't draw scene if critical data not set
-    if (!shaderSet_ || !vertexLayoutSet_)
+    if (meshPipeline_ == NullRenderHandle)
         return;
 
-    //Reload shaders if necessary
-    shader_.TryReload();
-    linelistShader_.TryReload();
-
     //Set render target and clear it
-    d3d11Context_->ClearRenderTargetView(sceneViewTexture_.GetRenderTargetView(), reinterpret_cast<const float*>(&ClearColor));
-    d3d11Context_->ClearDepthStencilView(depthBufferTexture_.GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-    d3d11Context_->OMSetRenderTargets(1, sceneViewTexture_.GetRenderTargetViewPP(), depthBufferTexture_.GetDepthStencilView());
-    d3d11Context_->RSSetViewports(1, &sceneViewport_);
-    d3d11Context_->RSSetState(meshRasterizerState_.Get());
+    Device->BeginPass(renderTarget_, reinterpret_cast<const f32*>(&ClearColor));
 
     //Update per-frame constant buffer
     perFrameStagingBuffer_.Time += deltaTime;
-    perFrameStagingBuffer_.ViewPos = Cam.Position();
+    Vec3 viewPos = Cam.Position();
+    perFrameStagingBuffer_.ViewPos = { viewPos.x, viewPos.y, viewPos.z, 1.0f };
     perFrameStagingBuffer_.ViewportDimensions = Vec2{ (f32)sceneViewWidth_, (f32)sceneViewHeight_ };
-    perFrameBuffer_.SetData(d3d11Context_, &perFrameStagingBuffer_);
-    d3d11Context_->PSSetConstantBuffers(0, 1, perFrameBuffer_.GetAddressOf());
+    Device->UpdateBuffer(perFrameBuffer_, &perFrameStagingBuffer_, 0, sizeof(PerFrameConstants));
+    Device->SetConstantBuffer(ShaderStagePixel, 0, perFrameBuffer_);
 
-    //Draw render objects
-    d3d11Context_->IASetInputLayout(vertexLayout_.Get());
-    d3d11Context_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-
-    //Draw all render objects
-    shader_.Bind(d3d11Context_);
-    d3d11Context_->VSSetConstantBuffers(0, 1, perObjectBuffer_.GetAddressOf());
-    for (auto& renderObject : Objects)
-        renderObject.Draw(d3d11Context_, perObjectBuffer_, Cam);
+    //Draw all render objects. Each mesh sets its own topology
+    Device->SetPipeline(meshPipeline_);
+    Device->SetConstantBuffer(ShaderStageVertex, 0, perObjectBuffer_);
+    CullObjectsForFrame();
+    for (u32 index : visibleObjects_)
+        Objects[index].Draw(Device.get(), perObjectBuffer_, Cam);
 
 
 
     //Prepare state to render primitives
-    d3d11Context_->RSSetState(primitiveRasterizerState_.Get());
-    d3d11Context_->IASetInputLayout(linelistVertexLayout_.Get());
-    d3d11Context_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-    linelistShader_.Bind(d3d11Context_);
+    Device->SetPipeline(linelistPipeline_);
+    Device->SetTopology(RenderTopology::LineList);
 
     //Update primitive vertex buffers if necessary
     u32 linelistVertexStride = sizeof(ColoredVertex);
-    u32 vertexOffset = 0;
     if (primitiveBufferNeedsUpdate_)
     {
-        lineVertexBuffer_.ResizeIfNeeded(d3d11Device_, lineVertices_.size() * linelistVertexStride);
-        D3D11_MAPPED_SUBRESOURCE mappedResource;
-        ZeroMemory(&mappedResource, sizeof(D3D11_MAPPED_SUBRESOURCE));
-        d3d11Context_->Map(lineVertexBuffer_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-        memcpy(mappedResource.pData, lineVertices_.data(), lineVertices_.size() * linelistVertexStride);
-        d3d11Context_->Unmap(lineVertexBuffer_.Get(), 0);
+        u32 requiredSize = (u32)(lineVertices_.size() * linelistVertexStride);
+        if (requiredSize > lineVertexBufferSize_)
+        {
+            DestroyBuffer(lineVertexBuffer_);
+            lineVertexBuffer_ = Device->CreateBuffer(RenderBufferType::Vertex, requiredSize, nullptr, true);
+            lineVertexBufferSize_ = requiredSize;
+        }
+        if (requiredSize > 0)
+            Device->UpdateBuffer(lineVertexBuffer_, lineVertices_.data(), 0, requiredSize);
 
         numLineVertices_ = lineVertices_.size();
         lineVertices_.clear();
         primitiveBufferNeedsUpdate_ = false;
     }
 
-    d3d11Context_->IASetVertexBuffers(0, 1, lineVertexBuffer_.GetAddressOf(), &linelistVertexStride, &vertexOffset);
+    Device->SetVertexBuffer(lineVertexBuffer_, linelistVertexStride);
 
     //Shader constants for all primitives
     PerObjectConstants constants;
 
     //Calculate MVP matrix for all primitives
-    DirectX::XMVECTOR rotaxis = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    DirectX::XMMATRIX rotation = DirectX::XMMatrixRotationAxis(rotaxis, 0.0f);
-    DirectX::XMMATRIX translation = DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.0f);
-    DirectX::XMMATRIX scale = DirectX::XMMatrixScaling(1.0f, 1.0f, 1.0f);
-    constants.MVP = DirectX::XMMatrixIdentity();
-    constants.MVP = translation * rotation * scale; //First calculate the model matrix
-    //Then calculate model matrix with Model * View * Projection
-    constants.MVP = DirectX::XMMatrixTranspose(constants.MVP * Cam.camView * Cam.camProjection);
+    //Primitives are already in world space so the model matrix is identity
+    constants.MVP = (Cam.camView * Cam.camProjection).Transposed();
 
     //Set MVP matrix in shader
-    d3d11Context_->GSSetConstantBuffers(0, 1, perFrameBuffer_.GetAddressOf());
-    perObjectBuffer_.SetData(d3d11Context_, &constants);
+    Device->SetConstantBuffer(ShaderStageGeometry, 0, perFrameBuffer_);
+    Device->UpdateBuffer(perObjectBuffer_, &constants, 0, sizeof(PerObjectConstants));
 
     //Draw linelist primitives
-    d3d11Context_->Draw(numLineVertices_, 0);
+    if (numLineVertices_ > 0)
+        Device->Draw(numLineVertices_, 0);
+
+    //Upload retained lines if they changed
+    if (retainedLinesNeedUpload_)
+    {
+        DestroyBuffer(retainedLineVertexBuffer_);
+        if (retainedLineVertices_.size() > 0)
+            retainedLineVertexBuffer_ = Device->CreateBuffer(RenderBufferType::Vertex, (u32)(retainedLineVertices_.size() * linelistVertexStride), retainedLineVertices_.data());
+
+        retainedLineVertices_.clear();
+        retainedLineVertices_.shrink_to_fit();
+        lineBatchUpdates_.clear();
+        retainedLinesNeedUpload_ = false;
+    }
+    for (LineBatchUpdate& update : lineBatchUpdates_)
+        Device->UpdateBuffer(retainedLineVertexBuffer_, update.Vertices.data(), update.FirstVertex * linelistVertexStride, (u32)(update.Vertices.size() * linelistVertexStride));
+    lineBatchUpdates_.clear();
+
+    //Draw retained lines after the per frame lines so highlights drawn over a retained line win the depth test. Neighboring visible batches are merged into one draw call
+    if (lineBatches_.size() > 0 && retainedLineVertexBuffer_ != NullRenderHandle)
+    {
+        Device->SetVertexBuffer(retainedLineVertexBuffer_, linelistVertexStride);
+        u32 runStart = 0;
+        u32 runSize = 0;
+        for (const LineBatch& batch : lineBatches_)
+        {
+            if (!batch.Visible || batch.NumVertices == 0)
+                continue;
+
+            if (runSize > 0 && runStart + runSize == batch.FirstVertex)
+            {
+                runSize += batch.NumVertices;
+                continue;
+            }
+            if (runSize > 0)
+                Device->Draw(runSize, runStart);
+
+            runStart = batch.FirstVertex;
+            runSize = batch.NumVertices;
+        }
+        if (runSize > 0)
+            Device->Draw(runSize, runStart);
+    }
+    Device->EndPass();
 }
 
 void Scene::HandleResize(u32 windowWidth, u32 windowHeight)
@@ -139,97 +187,81 @@ void Scene::HandleResize(u32 windowWidth, u32 windowHeight)
         sceneViewHeight_ = windowHeight;
 
         //Recreate scene view resources with new size
-        InitInternal();
-        CreateDepthBuffer();
-
-        sceneViewport_.TopLeftX = 0.0f;
-        sceneViewport_.TopLeftY = 0.0f;
-        sceneViewport_.Width = static_cast<f32>(sceneViewWidth_);
-        sceneViewport_.Height = static_cast<f32>(sceneViewHeight_);
-        sceneViewport_.MinDepth = 0.0f;
-        sceneViewport_.MaxDepth = 1.0f;
+        Device->ResizeRenderTarget(renderTarget_, sceneViewWidth_, sceneViewHeight_);
         Cam.HandleResize({ (f32)sceneViewWidth_, (f32)sceneViewHeight_ });
         NeedsRedraw = true;
     }
 }
 
-void Scene::InitInternal()
-{
-    //Create texture and map a render target and shader resource view to it
-    DXGI_FORMAT sceneViewFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
-    sceneViewTexture_.Create(d3d11Device_, sceneViewWidth_, sceneViewHeight_, sceneViewFormat, (D3D11_BIND_FLAG)(D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE));
-    sceneViewTexture_.CreateRenderTargetView(); //Allows us to use texture as a render target
-    sceneViewTexture_.CreateShaderResourceView(); //Lets shaders view texture. Used by dear imgui to draw textures in gui
-#ifdef DEBUG_BUILD
-    SetDebugName(sceneViewTexture_.Get(), "sceneViewTexture_");
-#endif
-
-    //Create per-frame constant buffer
-    perFrameBuffer_.Create(d3d11Device_, sizeof(PerFrameConstants), D3D11_BIND_CONSTANT_BUFFER);
-
-    //Setup rasterizer state used for meshes
-    D3D11_RASTERIZER_DESC rasterizerDesc;
-    ZeroMemory(&rasterizerDesc, sizeof(rasterizerDesc));
-    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
-    rasterizerDesc.CullMode = D3D11_CULL_BACK;
-    rasterizerDesc.FrontCounterClockwise = false;
-    rasterizerDesc.DepthBias = false;
-    rasterizerDesc.DepthBiasClamp = 0;
-    rasterizerDesc.SlopeScaledDepthBias = 0;
-    rasterizerDesc.DepthClipEnable = true;
-    rasterizerDesc.ScissorEnable = false;
-    rasterizerDesc.MultisampleEnable = false;
-    rasterizerDesc.AntialiasedLineEnable = false;
-    DxCheck(d3d11Device_->CreateRasterizerState(&rasterizerDesc, meshRasterizerState_.GetAddressOf()), "Mesh rasterizer state creation failed!");
-}
-
 void Scene::InitPrimitiveState()
 {
-    //Setup rasterizer state used for primitives
-    D3D11_RASTERIZER_DESC rasterizerDesc;
-    ZeroMemory(&rasterizerDesc, sizeof(rasterizerDesc));
-    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
-    rasterizerDesc.CullMode = D3D11_CULL_NONE;
-    rasterizerDesc.FrontCounterClockwise = false;
-    rasterizerDesc.DepthBias = false;
-    rasterizerDesc.DepthBiasClamp = 0;
-    rasterizerDesc.SlopeScaledDepthBias = 0;
-    rasterizerDesc.DepthClipEnable = true;
-    rasterizerDesc.ScissorEnable = false;
-    rasterizerDesc.MultisampleEnable = false;
-    rasterizerDesc.AntialiasedLineEnable = false;
-    DxCheck(d3d11Device_->CreateRasterizerState(&rasterizerDesc, primitiveRasterizerState_.GetAddressOf()), "Primitive rasterizer state creation failed!");
-
     //Create linelist primitive vertex buffer
-    lineVertexBuffer_.Create(d3d11Device_, 1200, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
-
-    linelistShader_.Load(linelistShaderPath_, d3d11Device_, config_->GetBoolReadonly("Use geometry shaders").value());
+    lineVertexBufferSize_ = 1200;
+    lineVertexBuffer_ = Device->CreateBuffer(RenderBufferType::Vertex, lineVertexBufferSize_, nullptr, true);
 
-    //Create linelist vertex layout
-    D3D11_INPUT_ELEMENT_DESC inputLayout[] =
+    //Lines aren't culled since they have no facing
+    RenderPipelineDesc linelist;
+    linelist.ShaderPath = linelistShaderPath_;
+    linelist.Layout =
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+        { "COLOR", 0, RenderVertexFormat::Float3, 12 },
     };
+    linelist.CullMode = RenderCullMode::None;
+    linelist.UseGeometryShader = useGeometryShaders_;
+    linelistPipeline_ = Device->CreatePipeline(linelist);
+}
+
+void Scene::DestroyBuffer(BufferHandle& buffer)
+{
+    if (buffer != NullRenderHandle)
+        Device->DestroyBuffer(buffer);
 
-    auto pVSBlob = linelistShader_.GetVertexShaderBytes();
-    //Create the input layout
-    if (FAILED(d3d11Device_->CreateInputLayout(inputLayout, 2, pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), linelistVertexLayout_.GetAddressOf())))
-        THROW_EXCEPTION("Failed to create scene primitive vertex layout.");
+    buffer = NullRenderHandle;
 }
 
-void Scene::InitRenderTarget()
+void Scene::DestroyPipeline(PipelineHandle& pipeline)
 {
-    CreateDepthBuffer();
-    d3d11Context_->OMSetRenderTargets(1, sceneViewTexture_.GetRenderTargetViewPP(), depthBufferTexture_.GetDepthStencilView());
-    d3d11Context_->RSSetViewports(1, &sceneViewport_);
+    if (pipeline != NullRenderHandle)
+        Device->DestroyPipeline(pipeline);
+
+    pipeline = NullRenderHandle;
 }
 
-void Scene::CreateDepthBuffer()
+void Scene::CullObjectsForFrame()
 {
-    //Create depth buffer texture and view
-    depthBufferTexture_.Create(d3d11Device_, sceneViewWidth_, sceneViewHeight_, DXGI_FORMAT_D24_UNORM_S8_UINT, D3D11_BIND_DEPTH_STENCIL);
-    depthBufferTexture_.CreateDepthStencilView();
+    visibleObjects_.clear();
+    if (!CullObjects)
+    {
+        culler_.Clear();
+        for (u32 i = 0; i < Objects.size(); i++)
+            if (Objects[i].Visible)
+                visibleObjects_.push_back(i);
+
+        NumObjectsDrawn = (u32)visibleObjects_.size();
+        NumObjectsCulled = 0;
+        return;
+    }
+
+    //Hidden objects stay in the culler so toggling visibility doesn't rebuild it
+    objectBounds_.resize(Objects.size());
+    for (u32 i = 0; i < Objects.size(); i++)
+        objectBounds_[i] = Objects[i].WorldBounds();
+    culler_.SetBounds(objectBounds_);
+
+    Frustum frustum = Frustum::FromViewProjection(Cam.GetViewProjMatrix().Data());
+    culler_.Cull(frustum, Cam.Position(), MaxDrawDistance, visibleObjects_);
+
+    //Drop hidden objects and count visible ones that were culled
+    u32 numVisible = 0;
+    for (const RenderObject& object : Objects)
+        if (object.Visible)
+            numVisible++;
+
+    auto hidden = std::remove_if(visibleObjects_.begin(), visibleObjects_.end(), [&](u32 index) { return !Objects[index].Visible; });
+    visibleObjects_.erase(hidden, visibleObjects_.end());
+    NumObjectsDrawn = (u32)visibleObjects_.size();
+    NumObjectsCulled = numVisible - NumObjectsDrawn;
 }
 
 void Scene::DrawLine(const Vec3& start, const Vec3& end, const Vec3& color)
@@ -240,6 +272,12 @@ void Scene::DrawLine(const Vec3& start, const Vec3& end, const Vec3& color)
 }
 
 void Scene::DrawBox(const Vec3& min, const Vec3& max, const Vec3& color)
+{
+    AppendBoxLines(lineVertices_, min, max, color);
+    primitiveBufferNeedsUpdate_ = true;
+}
+
+void Scene::AppendBoxLines(std::vector<ColoredVertex>& output, const Vec3& min, const Vec3& max, const Vec3& color)
 {
     Vec3 diff = max - min;
     Vec3 vert0 = min;
@@ -252,20 +290,17 @@ void Scene::DrawBox(const Vec3& min, const Vec3& max, const Vec3& color)
     Vec3 vert6(vert2.x, max.y, vert2.z);
     Vec3 vert7(min.x, max.y, min.z);
 
-    DrawLine(vert0, vert1, color);
-    DrawLine(vert0, vert2, color);
-    DrawLine(vert0, vert7, color);
-    DrawLine(vert1, vert3, color);
-    DrawLine(vert1, vert5, color);
-    DrawLine(vert2, vert3, color);
-    DrawLine(vert2, vert6, color);
-    DrawLine(vert3, vert4, color);
-    DrawLine(vert4, vert5, color);
-    DrawLine(vert4, vert6, color);
-    DrawLine(vert5, vert7, color);
-    DrawLine(vert6, vert7, color);
-
-    primitiveBufferNeedsUpdate_ = true;
+    const Vec3* edges[12][2] =
+    {
+        { &vert0, &vert1 }, { &vert0, &vert2 }, { &vert0, &vert7 }, { &vert1, &vert3 },
+        { &vert1, &vert5 }, { &vert2, &vert3 }, { &vert2, &vert6 }, { &vert3, &vert4 },
+        { &vert4, &vert5 }, { &vert4, &vert6 }, { &vert5, &vert7 }, { &vert6, &vert7 },
+    };
+    for (auto& edge : edges)
+    {
+        output.push_back({ *edge[0], color });
+        output.push_back({ *edge[1], color });
+    }
 }
 
 void Scene::ResetPrimitives()
@@ -273,3 +308,35 @@ void Scene::ResetPrimitives()
     primitiveBufferNeedsUpdate_ = true;
     lineVertices_.clear();
 }
+
+void Scene::SetRetainedLines(std::vector<ColoredVertex>&& vertices, std::vector<LineBatch>&& batches)
+{
+    retainedLineVertices_ = std::move(vertices);
+    lineBatches_ = std::move(batches);
+    retainedLinesNeedUpload_ = true;
+    NeedsRedraw = true;
+}
+
+void Scene::SetLineBatchVisible(u32 batch, bool visible)
+{
+    if (lineBatches_[batch].Visible == visible)
+        return;
+
+    lineBatches_[batch].Visible = visible;
+    NeedsRedraw = true;
+}
+
+void Scene::UpdateLineBatch(u32 batch, std::vector<ColoredVertex>&& vertices)
+{
+    const LineBatch& lineBatch = lineBatches_[batch];
+    if (vertices.size() != lineBatch.NumVertices)
+        THROW_EXCEPTION("Line batch update has {} vertices. Expected {}.", vertices.size(), lineBatch.NumVertices);
+
+    //Not uploaded yet. Overwrite the pending data
+    if (retainedLinesNeedUpload_)
+        std::copy(vertices.begin(), vertices.end(), retainedLineVertices_.begin() + lineBatch.FirstVertex);
+    else
+        lineBatchUpdates_.push_back({ lineBatch.FirstVertex, std::move(vertices) });
+
+    NeedsRedraw = true;
+}
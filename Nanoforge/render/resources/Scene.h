@@ -1,15 +1,14 @@
 #pragma once
 #include "common/Typedefs.h"
 #include "render/resources/RenderObject.h"
-#include "render/resources/Texture2D.h"
-#include "render/resources/Shader.h"
-#include "render/resources/Buffer.h"
 #include "render/resources/Mesh.h"
+#include "render/backend/RenderDevice.h"
 #include "render/camera/Camera.h"
 #include "rfg/TerrainHelpers.h"
+#include "util/VisibilityCuller.h"
 #include "RfgTools++/types/Vec2.h"
+#include "RfgTools++/types/Vec4.h"
 #include <filesystem>
-#include <d3d11.h>
 #include <array>
 #include <mutex>
 
@@ -27,8 +26,8 @@ const string linelistShaderPath_ = shaderFolderPath_ + "Linelist.fx";
 //Buffer for per-frame shader constants (set once per frame)
 struct PerFrameConstants
 {
-    DirectX::XMVECTOR ViewPos = { 0.0f, 0.0f, 0.0f, 1.0f };
-    DirectX::XMVECTOR DiffuseColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+    Vec4 ViewPos = { 0.0f, 0.0f, 0.0f, 1.0f };
+    Vec4 DiffuseColor = { 1.0f, 1.0f, 1.0f, 1.0f };
     f32 DiffuseIntensity = 0.65f;
     f32 ElevationFactorBias = 0.8f;
     i32 ShadeMode = 1;
@@ -45,13 +44,30 @@ const Vec3 ColorWhite(1.0f, 1.0f, 1.0f);
 class Scene
 {
 public:
-    void Init(ComPtr<ID3D11Device> d3d11Device, ComPtr<ID3D11DeviceContext> d3d11Context, Config* config);
+    struct ColoredVertex //Used by primitives that need different colors per vertex
+    {
+        Vec3 Position;
+        Vec3 Color;
+    };
+    //Range of vertices in the retained line buffer
+    struct LineBatch
+    {
+        u32 FirstVertex = 0;
+        u32 NumVertices = 0;
+        bool Visible = true;
+    };
+
+    //Config is optional. Geometry shaders are disabled without it. Any RenderDevice can be used, e.g. NullRenderDevice to run a scene without a GPU
+    void Init(Handle<RenderDevice> device, Config* config);
+    ~Scene();
+    //Set the shader used by Objects. Must be followed by SetVertexLayout()
     void SetShader(const string& path);
-    void SetVertexLayout(const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout);
+    void SetVertexLayout(const std::vector<RenderVertexAttribute>& layout);
     void Draw(f32 deltaTime);
     //Resizes scene render target and resources if the provided size is different than the current scene view dimensions
     void HandleResize(u32 windowWidth, u32 windowHeight);
-    ID3D11ShaderResourceView* GetView() { return sceneViewTexture_.GetShaderResourceView(); }
+    //Texture id of the scene render target for the UI to draw. nullptr if the device has no UI
+    void* GetView() { return Device->GetRenderTargetView(renderTarget_); }
     u32 Width() { return sceneViewWidth_; }
     u32 Height() { return sceneViewHeight_; }
 
@@ -59,64 +75,87 @@ public:
     void DrawLine(const Vec3& start, const Vec3& end, const Vec3& color = ColorWhite);
     //void DrawLineStrip(const std::vector<Vec3>& points, const Vec3& color = ColorWhite);
     void DrawBox(const Vec3& min, const Vec3& max, const Vec3& color = ColorWhite);
+    //Append the 24 vertices of a boxes 12 edges to a line list
+    static void AppendBoxLines(std::vector<ColoredVertex>& output, const Vec3& min, const Vec3& max, const Vec3& color = ColorWhite);
     //Clear any existing primitives and force the primitive vertex buffers to be updated
     void ResetPrimitives();
 
+    //Retained lines. Uploaded once and drawn every frame until replaced, unlike the functions above which must be called each frame.
+    //Replace all retained lines. Each batch is a range of vertices that can be hidden or rewritten without touching the rest
+    void SetRetainedLines(std::vector<ColoredVertex>&& vertices, std::vector<LineBatch>&& batches);
+    void SetLineBatchVisible(u32 batch, bool visible);
+    //Overwrite the vertices of a batch. Must be the same size as the batch. Only that range of the buffer is uploaded
+    void UpdateLineBatch(u32 batch, std::vector<ColoredVertex>&& vertices);
+    u32 NumLineBatches() const { return (u32)lineBatches_.size(); }
+
     Camera Cam;
     std::vector<RenderObject> Objects = {};
-    DirectX::XMFLOAT4 ClearColor{ 0.0f, 0.0f, 0.0f, 1.0f };
+    Vec4 ClearColor{ 0.0f, 0.0f, 0.0f, 1.0f };
     f32 TotalTime = 0.0f; //Total frame time
+    //Skip objects outside of the camera frustum or further than MaxDrawDistance. MaxDrawDistance <= 0 disables the distance limit
+    bool CullObjects = true;
+    f32 MaxDrawDistance = 0.0f;
+    //Visible objects drawn and skipped by culling last frame
+    u32 NumObjectsDrawn = 0;
+    u32 NumObjectsCulled = 0;
 
     //Buffer for per-frame shader constants (set once per frame)
     PerFrameConstants perFrameStagingBuffer_; //Cpu side copy of the buffer
-    Buffer perFrameBuffer_; //Gpu side copy of the buffer
 
-    //General render state
-    ComPtr<ID3D11Device> d3d11Device_ = nullptr;
-    ComPtr<ID3D11DeviceContext> d3d11Context_ = nullptr;
+    //Owns all GPU resources used by the scene. Object meshes and textures are created with it
+    Handle<RenderDevice> Device = nullptr;
 
     bool NeedsRedraw = true;
 
 private:
-    void InitInternal();
     void InitPrimitiveState();
-    void InitRenderTarget();
-    void CreateDepthBuffer();
+    //Fill visibleObjects_ with the indices of the objects to draw this frame
+    void CullObjectsForFrame();
+    //Destroy a resource if the handle is valid and reset the handle
+    void DestroyBuffer(BufferHandle& buffer);
+    void DestroyPipeline(PipelineHandle& pipeline);
 
     //Scene state
-    D3D11_VIEWPORT sceneViewport_;
-    Texture2D sceneViewTexture_;
-    Texture2D depthBufferTexture_;
+    RenderTargetHandle renderTarget_ = NullRenderHandle;
     u32 sceneViewWidth_ = 200;
     u32 sceneViewHeight_ = 200;
 
-    //Buffer for per-object shader constants (set once per object)
-    Buffer perObjectBuffer_; //Gpu side copy of the buffer
+    //Buffers for per-frame and per-object shader constants
+    BufferHandle perFrameBuffer_ = NullRenderHandle;
+    BufferHandle perObjectBuffer_ = NullRenderHandle;
 
-    //Vertex layout used by all meshes in this scene
-    ComPtr<ID3D11InputLayout> vertexLayout_ = nullptr;
-    ComPtr<ID3D11RasterizerState> meshRasterizerState_ = nullptr;
-    Shader shader_;
+    //Shader, vertex layout, and rasterizer state used by all meshes in this scene
+    PipelineHandle meshPipeline_ = NullRenderHandle;
+    string shaderPath_;
     bool shaderSet_ = false;
-    bool vertexLayoutSet_ = false;
+    bool useGeometryShaders_ = false;
 
-    //Data used for drawing primitives
-    struct ColoredVertex //Used by primitives that need different colors per vertex
-    {
-        Vec3 Position;
-        Vec3 Color;
-    };
-
-    ComPtr<ID3D11RasterizerState> primitiveRasterizerState_ = nullptr;
-    ComPtr<ID3D11InputLayout> linelistVertexLayout_ = nullptr;
-    Shader linelistShader_;
+    PipelineHandle linelistPipeline_ = NullRenderHandle;
 
     //Primitive drawing temporary buffers. Cleared each frame
     //Line and linestrip data. Lines are also used to draw boxes
     std::vector<ColoredVertex> lineVertices_;
-    Buffer lineVertexBuffer_;
+    BufferHandle lineVertexBuffer_ = NullRenderHandle;
+    u32 lineVertexBufferSize_ = 0;
     u32 numLineVertices_ = 0;
     bool primitiveBufferNeedsUpdate_ = true;
 
+    //Retained line data. Vertices are only kept on the CPU until they're uploaded
+    std::vector<LineBatch> lineBatches_;
+    std::vector<ColoredVertex> retainedLineVertices_;
+    BufferHandle retainedLineVertexBuffer_ = NullRenderHandle;
+    bool retainedLinesNeedUpload_ = false;
+    struct LineBatchUpdate
+    {
+        u32 FirstVertex = 0;
+        std::vector<ColoredVertex> Vertices;
+    };
+    std::vector<LineBatchUpdate> lineBatchUpdates_;
+
+    //View culling state. Bounds are gathered from Objects each frame so objects can be moved or added without notifying the scene
+    VisibilityCuller culler_;
+    std::vector<Aabb> objectBounds_;
+    std::vector<u32> visibleObjects_;
+
     Config* config_ = nullptr;
 };
\ No newline at end of file
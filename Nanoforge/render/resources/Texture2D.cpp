@@ -1,10 +1,11 @@
 #include "Texture2D.h"
 #include "render/util/DX11Helpers.h"
 
-void Texture2D::Create(ComPtr<ID3D11Device> d3d11Device, u32 width, u32 height, DXGI_FORMAT format, D3D11_BIND_FLAG bindFlags, D3D11_SUBRESOURCE_DATA* data)
+void Texture2D::Create(ComPtr<ID3D11Device> d3d11Device, u32 width, u32 height, DXGI_FORMAT format, D3D11_BIND_FLAG bindFlags, D3D11_SUBRESOURCE_DATA* data, u32 mipLevels)
 {
     d3d11Device_ = d3d11Device;
     format_ = format;
+    mipLevels_ = mipLevels;
 
     //Clear any existing resources. This way you can call ::Create repeatedly to resize or recreate the texture
     depthStencilView_.Reset();
@@ -16,7 +17,7 @@ void Texture2D::Create(ComPtr<ID3D11Device> d3d11Device, u32 width, u32 height,
     ZeroMemory(&textureDesc, sizeof(D3D11_TEXTURE2D_DESC));
     textureDesc.Width = width;
     textureDesc.Height = height;
-    textureDesc.MipLevels = 1;
+    textureDesc.MipLevels = mipLevels_;
     textureDesc.ArraySize = 1;
     textureDesc.Format = format_;
     textureDesc.SampleDesc.Count = 1;
@@ -55,7 +56,7 @@ void Texture2D::CreateShaderResourceView()
     shaderResourceViewDesc.Format = format_;
     shaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
     shaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
-    shaderResourceViewDesc.Texture2D.MipLevels = 1;
+    shaderResourceViewDesc.Texture2D.MipLevels = mipLevels_;
 
     //Create the shader resource view
     if(FAILED(d3d11Device_->CreateShaderResourceView(texture_.Get(), &shaderResourceViewDesc, shaderResourceView_.GetAddressOf())))
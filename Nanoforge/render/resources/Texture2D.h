@@ -9,8 +9,8 @@ using Microsoft::WRL::ComPtr;
 class Texture2D
 {
 public:
-    //Create D3D11 texture from provided parameters. If called more than once it will be recreated
-    void Create(ComPtr<ID3D11Device> d3d11Device, u32 width, u32 height, DXGI_FORMAT format, D3D11_BIND_FLAG bindFlags, D3D11_SUBRESOURCE_DATA* data = nullptr);
+    //Create D3D11 texture from provided parameters. If called more than once it will be recreated. If data is provided it must have an entry per mip level
+    void Create(ComPtr<ID3D11Device> d3d11Device, u32 width, u32 height, DXGI_FORMAT format, D3D11_BIND_FLAG bindFlags, D3D11_SUBRESOURCE_DATA* data = nullptr, u32 mipLevels = 1);
     //Create render target view from texture. Must call ::Create first
     void CreateRenderTargetView();
     //Create shader resource view from texture. Must call ::Create first
@@ -43,4 +43,5 @@ private:
     ComPtr<ID3D11SamplerState> samplerState_ = nullptr;
     ComPtr<ID3D11Device> d3d11Device_ = nullptr;
     DXGI_FORMAT format_ = DXGI_FORMAT_UNKNOWN;
+    u32 mipLevels_ = 1;
 };
\ No newline at end of file
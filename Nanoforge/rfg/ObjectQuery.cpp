@@ -0,0 +1,359 @@
+#include "ObjectQuery.h"
+#include "Territory.h"
+#include "common/string/String.h"
+#include <spdlog/fmt/fmt.h>
+#include <RfgTools++\formats\zones\properties\primitive\StringProperty.h>
+#include <RfgTools++\formats\zones\properties\primitive\BoolProperty.h>
+#include <RfgTools++\formats\zones\properties\primitive\FloatProperty.h>
+#include <RfgTools++\formats\zones\properties\primitive\UintProperty.h>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+//Parse a number literal. Accepts decimal, hex (0x prefix), true, and false
+static bool ParseNumber(const string& text, f64& outValue)
+{
+    if (String::EqualIgnoreCase(text, "true") || String::EqualIgnoreCase(text, "false"))
+    {
+        outValue = String::EqualIgnoreCase(text, "true") ? 1.0 : 0.0;
+        return true;
+    }
+    if (text.empty())
+        return false;
+
+    char* end = nullptr;
+    outValue = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size();
+}
+
+static bool IsWordChar(char c)
+{
+    return std::isalnum((unsigned char)c) || c == '_' || c == '.' || c == '-' || c == ':';
+}
+
+bool ObjectQuery::Parse(const string& expression, string& outError)
+{
+    nodes_.clear();
+    tokens_.clear();
+    position_ = 0;
+    if (!Tokenize(expression, outError))
+        return false;
+
+    if (Peek().Type == TokenType::End)
+    {
+        outError = "Query is empty";
+        return false;
+    }
+
+    try
+    {
+        ParseOr();
+        if (Peek().Type != TokenType::End)
+            throw std::runtime_error("Unexpected \"" + Peek().Text + "\"");
+    }
+    catch (std::exception& ex)
+    {
+        outError = ex.what();
+        nodes_.clear();
+    }
+
+    tokens_.clear();
+    return nodes_.size() != 0;
+}
+
+bool ObjectQuery::Evaluate(const string& territory, const ZoneData& zone, const ZoneObject36& object) const
+{
+    if (nodes_.size() == 0)
+        return false;
+
+    return EvaluateNode((u32)nodes_.size() - 1, territory, zone, object);
+}
+
+bool ObjectQuery::Tokenize(const string& expression, string& outError)
+{
+    size_t i = 0;
+    while (i < expression.size())
+    {
+        char c = expression[i];
+        if (std::isspace((unsigned char)c))
+        {
+            i++;
+        }
+        else if (c == '"')
+        {
+            size_t end = expression.find('"', i + 1);
+            if (end == string::npos)
+            {
+                outError = "Unterminated string";
+                return false;
+            }
+            tokens_.push_back({ TokenType::String, expression.substr(i + 1, end - i - 1) });
+            i = end + 1;
+        }
+        else if (c == '(' || c == ')')
+        {
+            tokens_.push_back({ c == '(' ? TokenType::OpenParen : TokenType::CloseParen, string(1, c) });
+            i++;
+        }
+        else if (expression.compare(i, 2, "&&") == 0 || expression.compare(i, 2, "||") == 0)
+        {
+            tokens_.push_back({ c == '&' ? TokenType::And : TokenType::Or, expression.substr(i, 2) });
+            i += 2;
+        }
+        else if (expression.compare(i, 2, "==") == 0 || expression.compare(i, 2, "!=") == 0 || expression.compare(i, 2, "<=") == 0 ||
+                 expression.compare(i, 2, ">=") == 0 || expression.compare(i, 2, "~=") == 0)
+        {
+            tokens_.push_back({ TokenType::Op, expression.substr(i, 2) });
+            i += 2;
+        }
+        else if (c == '<' || c == '>')
+        {
+            tokens_.push_back({ TokenType::Op, string(1, c) });
+            i++;
+        }
+        else if (c == '!')
+        {
+            tokens_.push_back({ TokenType::Not, "!" });
+            i++;
+        }
+        else if (IsWordChar(c))
+        {
+            size_t start = i;
+            while (i < expression.size() && IsWordChar(expression[i]))
+                i++;
+            tokens_.push_back({ TokenType::Word, expression.substr(start, i - start) });
+        }
+        else
+        {
+            outError = fmt::format("Unexpected character '{}' at position {}", c, i);
+            return false;
+        }
+    }
+
+    tokens_.push_back({ TokenType::End, "end of query" });
+    return true;
+}
+
+u32 ObjectQuery::ParseOr()
+{
+    u32 left = ParseAnd();
+    while (Peek().Type == TokenType::Or)
+    {
+        Next();
+        u32 right = ParseAnd();
+        Node node;
+        node.Type = NodeType::Or;
+        node.Left = left;
+        node.Right = right;
+        left = AddNode(node);
+    }
+    return left;
+}
+
+u32 ObjectQuery::ParseAnd()
+{
+    u32 left = ParseUnary();
+    while (Peek().Type == TokenType::And)
+    {
+        Next();
+        u32 right = ParseUnary();
+        Node node;
+        node.Type = NodeType::And;
+        node.Left = left;
+        node.Right = right;
+        left = AddNode(node);
+    }
+    return left;
+}
+
+u32 ObjectQuery::ParseUnary()
+{
+    if (Peek().Type == TokenType::Not)
+    {
+        Next();
+        Node node;
+        node.Type = NodeType::Not;
+        node.Left = ParseUnary();
+        return AddNode(node);
+    }
+    if (Peek().Type == TokenType::OpenParen)
+    {
+        Next();
+        u32 inner = ParseOr();
+        if (Next().Type != TokenType::CloseParen)
+            throw std::runtime_error("Expected \")\"");
+        return inner;
+    }
+
+    return ParseComparison();
+}
+
+u32 ObjectQuery::ParseComparison()
+{
+    const Token& fieldToken = Next();
+    if (fieldToken.Type != TokenType::Word)
+        throw std::runtime_error("Expected a field or property name before \"" + fieldToken.Text + "\"");
+
+    Node node;
+    const string& name = fieldToken.Text;
+    if (String::EqualIgnoreCase(name, "class"))
+        node.Target = Field::Class;
+    else if (String::EqualIgnoreCase(name, "handle"))
+        node.Target = Field::Handle;
+    else if (String::EqualIgnoreCase(name, "num"))
+        node.Target = Field::Num;
+    else if (String::EqualIgnoreCase(name, "zone"))
+        node.Target = Field::Zone;
+    else if (String::EqualIgnoreCase(name, "territory"))
+        node.Target = Field::Territory;
+    else
+        node.Target = Field::Property;
+    node.PropertyName = name;
+
+    //Property name on its own checks if the object has that property
+    if (Peek().Type != TokenType::Op)
+    {
+        if (node.Target != Field::Property)
+            throw std::runtime_error("Expected a comparison after \"" + name + "\"");
+
+        node.Type = NodeType::Exists;
+        return AddNode(node);
+    }
+
+    const string& op = Next().Text;
+    if (op == "==")
+        node.Op = CompareOp::Equal;
+    else if (op == "!=")
+        node.Op = CompareOp::NotEqual;
+    else if (op == "<")
+        node.Op = CompareOp::Less;
+    else if (op == "<=")
+        node.Op = CompareOp::LessEqual;
+    else if (op == ">")
+        node.Op = CompareOp::Greater;
+    else if (op == ">=")
+        node.Op = CompareOp::GreaterEqual;
+    else
+        node.Op = CompareOp::Contains;
+
+    const Token& valueToken = Next();
+    if (valueToken.Type != TokenType::Word && valueToken.Type != TokenType::String)
+        throw std::runtime_error("Expected a value after \"" + name + " " + op + "\"");
+
+    node.Type = NodeType::Compare;
+    node.Value = String::ToLower(valueToken.Text);
+    node.ValueIsNumber = valueToken.Type == TokenType::Word && ParseNumber(valueToken.Text, node.NumericValue);
+    if ((node.Target == Field::Handle || node.Target == Field::Num) && !node.ValueIsNumber)
+        throw std::runtime_error("\"" + name + "\" can only be compared with numbers");
+
+    return AddNode(node);
+}
+
+u32 ObjectQuery::AddNode(const Node& node)
+{
+    nodes_.push_back(node);
+    return (u32)nodes_.size() - 1;
+}
+
+bool ObjectQuery::EvaluateNode(u32 index, const string& territory, const ZoneData& zone, const ZoneObject36& object) const
+{
+    const Node& node = nodes_[index];
+    switch (node.Type)
+    {
+    case NodeType::And:
+        return EvaluateNode(node.Left, territory, zone, object) && EvaluateNode(node.Right, territory, zone, object);
+    case NodeType::Or:
+        return EvaluateNode(node.Left, territory, zone, object) || EvaluateNode(node.Right, territory, zone, object);
+    case NodeType::Not:
+        return !EvaluateNode(node.Left, territory, zone, object);
+    default:
+        break;
+    }
+
+    switch (node.Target)
+    {
+    case Field::Class:
+        return CompareString(node, object.Classname);
+    case Field::Handle:
+        return CompareNumber(node, (f64)object.Handle);
+    case Field::Num:
+        return CompareNumber(node, (f64)object.Num);
+    case Field::Zone:
+        return CompareString(node, zone.Name);
+    case Field::Territory:
+        return CompareString(node, territory);
+    default:
+        break;
+    }
+
+    IZoneProperty* property = nullptr;
+    for (IZoneProperty* prop : object.Properties)
+    {
+        if (prop && String::EqualIgnoreCase(prop->Name, node.PropertyName))
+        {
+            property = prop;
+            break;
+        }
+    }
+
+    if (node.Type == NodeType::Exists)
+        return property != nullptr;
+    if (!property)
+        return false;
+
+    //Only primitive property types can be compared. Compound types like vectors and matrices can only be checked for existence
+    switch (property->DataType)
+    {
+    case ZonePropertyType::String:
+        return CompareString(node, static_cast<StringProperty*>(property)->Data);
+    case ZonePropertyType::Bool:
+        return CompareNumber(node, static_cast<BoolProperty*>(property)->Data ? 1.0 : 0.0);
+    case ZonePropertyType::Float:
+        return CompareNumber(node, (f64)static_cast<FloatProperty*>(property)->Data);
+    case ZonePropertyType::Uint:
+        return CompareNumber(node, (f64)static_cast<UintProperty*>(property)->Data);
+    default:
+        return false;
+    }
+}
+
+bool ObjectQuery::CompareString(const Node& node, const string& value) const
+{
+    //node.Value is already lowercase
+    switch (node.Op)
+    {
+    case CompareOp::Equal:
+        return String::EqualIgnoreCase(value, node.Value);
+    case CompareOp::NotEqual:
+        return !String::EqualIgnoreCase(value, node.Value);
+    case CompareOp::Contains:
+        return String::Contains(String::ToLower(value), node.Value);
+    default:
+        return false;
+    }
+}
+
+bool ObjectQuery::CompareNumber(const Node& node, f64 value) const
+{
+    //Numbers never equal non numeric values
+    if (!node.ValueIsNumber)
+        return node.Op == CompareOp::NotEqual;
+
+    switch (node.Op)
+    {
+    case CompareOp::Equal:
+        return value == node.NumericValue;
+    case CompareOp::NotEqual:
+        return value != node.NumericValue;
+    case CompareOp::Less:
+        return value < node.NumericValue;
+    case CompareOp::LessEqual:
+        return value <= node.NumericValue;
+    case CompareOp::Greater:
+        return value > node.NumericValue;
+    case CompareOp::GreaterEqual:
+        return value >= node.NumericValue;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <RfgTools++\formats\zones\ZonePc36.h>
+#include <vector>
+
+struct ZoneData;
+
+//Predicate over zone objects parsed from an expression. Used to search zone objects without viewing them. Expression syntax:
+//    Comparison: <field> <op> <value>. Ops: ==, !=, <, <=, >, >=, ~= (contains, strings only)
+//    Existence:  <property name> (true if the object has the property)
+//    Logic:      &&, ||, !, parentheses
+//Fields are class, handle, num, zone, territory, or the name of any object property. Values are quoted strings, numbers (hex allowed), true, or false.
+//String comparisons ignore case. Example: class == "rfg_mover" && (gameplay_props ~= "bridge" || !building_type)
+class ObjectQuery
+{
+public:
+    //Parse an expression. Returns false and sets outError if it's invalid
+    bool Parse(const string& expression, string& outError);
+    bool Empty() const { return nodes_.size() == 0; }
+    //Returns true if the object matches the expression. Safe to call from multiple threads at once
+    bool Evaluate(const string& territory, const ZoneData& zone, const ZoneObject36& object) const;
+
+private:
+    enum class NodeType
+    {
+        And,
+        Or,
+        Not,
+        Compare,
+        Exists
+    };
+    enum class Field
+    {
+        Class,
+        Handle,
+        Num,
+        Zone,
+        Territory,
+        Property
+    };
+    enum class CompareOp
+    {
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Contains
+    };
+    struct Node
+    {
+        NodeType Type = NodeType::Compare;
+        //Children of And, Or, and Not nodes. Indices into nodes_
+        u32 Left = 0;
+        u32 Right = 0;
+        //Compare and Exists nodes
+        Field Target = Field::Property;
+        string PropertyName;
+        CompareOp Op = CompareOp::Equal;
+        string Value;
+        f64 NumericValue = 0.0;
+        bool ValueIsNumber = false;
+    };
+    enum class TokenType
+    {
+        Word, //Field names, numbers, and unquoted values
+        String,
+        Op,
+        And,
+        Or,
+        Not,
+        OpenParen,
+        CloseParen,
+        End
+    };
+    struct Token
+    {
+        TokenType Type = TokenType::End;
+        string Text;
+    };
+
+    //Split expression into tokens. Returns false and sets outError if it has invalid characters or an unterminated string
+    bool Tokenize(const string& expression, string& outError);
+    //Recursive descent parser. Each returns the index of the node it added or throws std::runtime_error on syntax errors
+    u32 ParseOr();
+    u32 ParseAnd();
+    u32 ParseUnary();
+    u32 ParseComparison();
+    u32 AddNode(const Node& node);
+    const Token& Peek() const { return tokens_[position_]; }
+    const Token& Next() { return tokens_[position_ == tokens_.size() - 1 ? position_ : position_++]; }
+
+    bool EvaluateNode(u32 index, const string& territory, const ZoneData& zone, const ZoneObject36& object) const;
+    bool CompareString(const Node& node, const string& value) const;
+    bool CompareNumber(const Node& node, f64 value) const;
+
+    //Expression tree. The root is the last node added
+    std::vector<Node> nodes_ = {};
+    //Only used while parsing
+    std::vector<Token> tokens_ = {};
+    size_t position_ = 0;
+};
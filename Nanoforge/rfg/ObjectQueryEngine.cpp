@@ -0,0 +1,50 @@
+#include "ObjectQueryEngine.h"
+#include "Territory.h"
+#include "util/ThreadUtil.h"
+#include "Log.h"
+
+std::vector<ObjectQueryResult> ObjectQueryEngine::Run(const ObjectQuery& query, const std::vector<string>& territories)
+{
+    TerritoriesSearched = 0;
+    TerritoriesFailed = 0;
+    NumTerritories = (u32)territories.size();
+    if (query.Empty())
+        return {};
+
+    //Each territory writes to its own result list so the final order doesn't depend on which thread finished first
+    std::vector<std::vector<ObjectQueryResult>> territoryResults(territories.size());
+    ParallelFor((u32)territories.size(), [&](u32 i)
+    {
+        const string& shortname = territories[i];
+        std::vector<ObjectQueryResult>& results = territoryResults[i];
+        try
+        {
+            Territory territory;
+            territory.Init(packfileVFS_, Territory::GetTerritoryFilename(shortname), shortname);
+            territory.LoadZoneData();
+
+            for (const ZoneData& zone : territory.ZoneFiles)
+                for (const ZoneObject36& object : zone.Zone.Objects)
+                    if (query.Evaluate(shortname, zone, object))
+                        results.push_back({ shortname, zone.Name, object.Classname, object.Handle, object.Num });
+        }
+        catch (std::exception& ex)
+        {
+            Log->warn("Object query failed to load {}. Skipping it. Error: {}", shortname, ex.what());
+            results.clear();
+            TerritoriesFailed++;
+        }
+        TerritoriesSearched++;
+    }, MaxTerritoriesInParallel);
+
+    size_t numResults = 0;
+    for (auto& results : territoryResults)
+        numResults += results.size();
+
+    std::vector<ObjectQueryResult> output = {};
+    output.reserve(numResults);
+    for (auto& results : territoryResults)
+        output.insert(output.end(), std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+
+    return output;
+}
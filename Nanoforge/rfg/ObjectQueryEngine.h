@@ -0,0 +1,40 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "ObjectQuery.h"
+#include <atomic>
+#include <vector>
+
+class PackfileVFS;
+
+//Zone object matched by ObjectQueryEngine
+struct ObjectQueryResult
+{
+    string Territory; //Territory short name. E.g. terr01
+    string Zone;
+    string Classname;
+    u32 Handle = 0;
+    u32 Num = 0;
+};
+
+//Runs an ObjectQuery over every zone object in a list of territories without opening them in a TerritoryDocument.
+//Territories are loaded in parallel without terrain or rendering resources and freed as soon as they've been searched.
+//Zone loading goes through Territory so territory snapshots are used when available, which makes repeat queries much faster than the first.
+class ObjectQueryEngine
+{
+public:
+    void Init(PackfileVFS* packfileVFS) { packfileVFS_ = packfileVFS; }
+    //Search territories for objects matching query. Territories are short names (e.g. terr01, mp_crescent). Results are ordered by territory, zone, then object.
+    //Blocks until every territory is searched so it should be run in a background task. Territories that fail to load are logged and skipped
+    std::vector<ObjectQueryResult> Run(const ObjectQuery& query, const std::vector<string>& territories);
+
+    //Progress of the current run. Safe to read from other threads
+    std::atomic<u32> TerritoriesSearched = 0;
+    std::atomic<u32> TerritoriesFailed = 0;
+    std::atomic<u32> NumTerritories = 0;
+
+private:
+    PackfileVFS* packfileVFS_ = nullptr;
+
+    //Max territories loaded at once. Each territory load is multithreaded and keeps all of its zones in memory until it's searched
+    static constexpr u32 MaxTerritoriesInParallel = 4;
+};
@@ -22,6 +22,7 @@ void PackfileVFS::ScanPackfilesAndLoadCache()
 {
     TRACE();
     //Load global cache
+    std::lock_guard<std::recursive_mutex> lock(globalFileCacheLock_);
     globalFileCache_.Load(globalCachePath_);
 
     //Loop through all files in data folder
@@ -233,6 +234,7 @@ std::optional<string> PackfileVFS::GetFilePath(const string& packfileName, const
         return std::filesystem::absolute(project_->GetCachePath() + filePath).string();
 
     //Cache the file if it isn't already
+    std::lock_guard<std::recursive_mutex> lock(globalFileCacheLock_);
     if (!globalFileCache_.IsCached(filePath))
         AddFileToCache(packfileName, filename1, filename2);
 
@@ -274,6 +276,7 @@ bool PackfileVFS::AddFileToCache(const string& packfileName, const string& filen
         filePath += "\\" + filename2;
 
     //Extract single file if possible
+    std::lock_guard<std::recursive_mutex> lock(globalFileCacheLock_);
     if (parent->CanExtractSingleFile())
     {
         auto bytes = inContainer ?
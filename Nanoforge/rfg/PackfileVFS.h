@@ -5,6 +5,8 @@
 #include <RfgTools++\formats\zones\ZonePc36.h>
 #include <RfgTools++\formats\asm\AsmFile5.h>
 #include <vector>
+#include <filesystem>
+#include <mutex>
 
 //Enum used internally by PackfileVFS during file searches
 enum class SearchType
@@ -40,6 +42,8 @@ public:
     Packfile3* GetContainer(const string& name, const string& parentName);
     //If true this class is ready for use by guis / other code
     bool Ready() const { return ready_; }
+    //Get the path of a vpp_pc file in the data folder
+    string GetPackfilePath(const string& packfileName) const { return (std::filesystem::path(packfileFolderPath_) / packfileName).string(); }
 
     //Gets the path of a file in the cache. The file will be extracted and cached if it's not already cached. Arguments:
     //packfileName: the name of the .vpp_pc file the target file is in
@@ -60,6 +64,9 @@ private:
 
     //Global file cache
     FileCache globalFileCache_;
+    //Guards globalFileCache_. Files are requested from background threads such as thumbnail generation.
+    //Recursive since GetFilePath() holds it while calling AddFileToCache(), so two threads can't extract the same file at once
+    std::recursive_mutex globalFileCacheLock_;
     //The current project
     Project* project_ = nullptr;
     //RFG data folder path
@@ -0,0 +1,270 @@
+#include "TerrainCache.h"
+#include "TerrainHelpers.h"
+#include "TerrainLod.h"
+#include "PackfileVFS.h"
+#include "FileHandle.h"
+#include "common/filesystem/Path.h"
+#include "util/HashUtil.h"
+#include "util/FileUtil.h"
+#include "Log.h"
+#include <RfgTools++\formats\packfiles\Packfile3.h>
+#include <filesystem>
+#include <fstream>
+
+//Stored separately from the global file cache since these aren't extracted game files
+const string terrainCacheFolder_ = ".\\Cache\\Terrain\\";
+constexpr u32 TerrainCacheSignature = 0x5443464E; //"NFCT"
+//Increment any time the cache format or terrain processing (e.g. normal generation) changes
+constexpr u32 TerrainCacheVersion = 3;
+//Low lod terrain files have 9 meshes. Used to reject malformed files before allocating anything
+constexpr u32 MaxCachedMeshes = 64;
+
+//On disk layout: header, mesh table, the index and vertex data of each mesh, the LOD tree nodes, vertices, and indices, the height pyramid heights and level bounds,
+//then the blend texture pixels. The blend texture is last so ReadBlendTexture() can find it from the end of the file
+struct TerrainCacheHeader
+{
+    u32 Signature = TerrainCacheSignature;
+    u32 Version = TerrainCacheVersion;
+    u64 Key = 0;
+    u64 FileSize = 0;
+    u32 NumMeshes = 0;
+    u32 BlendTextureWidth = 0;
+    u32 BlendTextureHeight = 0;
+    u32 BlendTextureSize = 0;
+    //Non zero if the vertex normals were generated. Most loads don't need them so they aren't always written
+    u32 HasNormals = 0;
+    //LOD tree and height pyramid. Stored so cached tiles skip TerrainLoader::BuildLod()
+    u32 NumLodNodes = 0;
+    u32 NumLodVertices = 0;
+    u32 NumLodIndices = 0;
+    u32 NumLodLevels = 0;
+    u32 HeightsResolution = 0;
+    u32 NumHeightLevelBounds = 0;
+    f32 HeightsOrigin[3] = { 0.0f, 0.0f, 0.0f };
+    f32 HeightsSpacing = 0.0f;
+    u32 Padding0 = 0;
+};
+struct TerrainCacheMesh
+{
+    u32 NumIndices = 0;
+    u32 NumVertices = 0;
+};
+
+//Bytes taken by the LOD tree and height pyramid
+static u64 LodAndHeightsSize(const TerrainCacheHeader& header)
+{
+    return (u64)header.NumLodNodes * sizeof(TerrainLodNode) + (u64)header.NumLodVertices * sizeof(LowLodTerrainVertex) + (u64)header.NumLodIndices * sizeof(u16) +
+           (u64)header.HeightsResolution * header.HeightsResolution * sizeof(f32) + (u64)header.NumHeightLevelBounds * sizeof(f32);
+}
+
+string TerrainCache::GetPath(const string& terrainFilename)
+{
+    return terrainCacheFolder_ + Path::GetFileNameNoExtension(terrainFilename) + ".nfterrain";
+}
+
+u64 TerrainCache::GetKey(PackfileVFS* packfileVFS, const string& terrainFilename, FileHandle& mesh, FileHandle* blendTexture)
+{
+    //Hashing the source files would mean extracting them on every load, which is most of what the cache skips. The size and write time of their packfiles are used instead.
+    //See the comment on TerrainCache for what this misses
+    u64 key = HashUtil::Fnv1a64(terrainFilename);
+    key = HashUtil::Fnv1a64Value(TerrainCacheVersion, key);
+    for (FileHandle* handle : { &mesh, blendTexture })
+    {
+        if (!handle)
+        {
+            key = HashUtil::Fnv1a64Value((u64)0, key);
+            continue;
+        }
+
+        string packfileName = handle->GetPackfile()->Name();
+        string path = packfileVFS->GetPackfilePath(packfileName);
+        u64 size = 0;
+        i64 writeTime = 0;
+        if (std::filesystem::exists(path))
+        {
+            size = std::filesystem::file_size(path);
+            writeTime = (i64)std::filesystem::last_write_time(path).time_since_epoch().count();
+        }
+        key = HashUtil::Fnv1a64(packfileName, key);
+        key = HashUtil::Fnv1a64(handle->ContainerName(), key);
+        key = HashUtil::Fnv1a64Value(size, key);
+        key = HashUtil::Fnv1a64Value(writeTime, key);
+    }
+
+    return key;
+}
+
+bool TerrainCache::Write(const string& path, u64 key, const TerrainInstance& terrain, const TerrainLodTree& lod, const HeightfieldPyramid& heights)
+{
+    if (terrain.Indices.size() != terrain.Vertices.size())
+        return false;
+
+    TerrainCacheHeader header;
+    header.Key = key;
+    header.NumMeshes = (u32)terrain.Indices.size();
+    header.HasNormals = terrain.HasNormals ? 1 : 0;
+    if (terrain.HasBlendTexture)
+    {
+        header.BlendTextureWidth = terrain.BlendTextureWidth;
+        header.BlendTextureHeight = terrain.BlendTextureHeight;
+        header.BlendTextureSize = (u32)terrain.BlendTextureBytes.size();
+    }
+
+    std::vector<f32> levelBounds = heights.LevelBounds();
+    const Vec3 heightsOrigin = heights.Origin();
+    header.NumLodNodes = (u32)lod.Nodes.size();
+    header.NumLodVertices = (u32)lod.Vertices.size();
+    header.NumLodIndices = (u32)lod.Indices.size();
+    header.NumLodLevels = lod.NumLevels;
+    header.HeightsResolution = heights.Resolution();
+    header.NumHeightLevelBounds = (u32)levelBounds.size();
+    header.HeightsOrigin[0] = heightsOrigin.x;
+    header.HeightsOrigin[1] = heightsOrigin.y;
+    header.HeightsOrigin[2] = heightsOrigin.z;
+    header.HeightsSpacing = heights.Spacing();
+
+    std::vector<TerrainCacheMesh> meshTable(header.NumMeshes);
+    header.FileSize = sizeof(TerrainCacheHeader) + meshTable.size() * sizeof(TerrainCacheMesh) + LodAndHeightsSize(header) + header.BlendTextureSize;
+    for (u32 i = 0; i < header.NumMeshes; i++)
+    {
+        meshTable[i].NumIndices = (u32)terrain.Indices[i].size();
+        meshTable[i].NumVertices = (u32)terrain.Vertices[i].size();
+        header.FileSize += terrain.Indices[i].size_bytes() + terrain.Vertices[i].size_bytes();
+    }
+
+    //Several documents can process the same tile at once, so each writes to its own temporary file and renames it into place
+    std::filesystem::create_directories(terrainCacheFolder_);
+    return FileUtil::WriteAtomic(path, [&](std::ostream& out)
+    {
+        out.write((const char*)&header, sizeof(TerrainCacheHeader));
+        out.write((const char*)meshTable.data(), meshTable.size() * sizeof(TerrainCacheMesh));
+        for (u32 i = 0; i < header.NumMeshes; i++)
+        {
+            out.write((const char*)terrain.Indices[i].data(), terrain.Indices[i].size_bytes());
+            out.write((const char*)terrain.Vertices[i].data(), terrain.Vertices[i].size_bytes());
+        }
+        out.write((const char*)lod.Nodes.data(), lod.Nodes.size() * sizeof(TerrainLodNode));
+        out.write((const char*)lod.Vertices.data(), lod.Vertices.size() * sizeof(LowLodTerrainVertex));
+        out.write((const char*)lod.Indices.data(), lod.Indices.size() * sizeof(u16));
+        out.write((const char*)heights.Heights().data(), heights.Heights().size_bytes());
+        out.write((const char*)levelBounds.data(), levelBounds.size() * sizeof(f32));
+        if (header.BlendTextureSize > 0)
+            out.write((const char*)terrain.BlendTextureBytes.data(), header.BlendTextureSize);
+    });
+}
+
+bool TerrainCache::Read(const string& path, u64 key, TerrainInstance& terrain, TerrainLodTree& lod, HeightfieldPyramid& heights)
+{
+    if (!std::filesystem::exists(path))
+        return false;
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    //Validate the header and mesh table before allocating any buffers
+    TerrainCacheHeader header;
+    in.read((char*)&header, sizeof(TerrainCacheHeader));
+    if (!in.good() || header.Signature != TerrainCacheSignature || header.Version != TerrainCacheVersion || header.Key != key)
+        return false;
+    if (header.NumMeshes > MaxCachedMeshes || header.FileSize != std::filesystem::file_size(path))
+        return false;
+
+    std::vector<TerrainCacheMesh> meshTable(header.NumMeshes);
+    in.read((char*)meshTable.data(), meshTable.size() * sizeof(TerrainCacheMesh));
+    if (!in.good())
+        return false;
+
+    u64 expectedSize = sizeof(TerrainCacheHeader) + meshTable.size() * sizeof(TerrainCacheMesh) + LodAndHeightsSize(header) + header.BlendTextureSize;
+    for (TerrainCacheMesh& mesh : meshTable)
+        expectedSize += (u64)mesh.NumIndices * sizeof(u16) + (u64)mesh.NumVertices * sizeof(LowLodTerrainVertex);
+    if (expectedSize != header.FileSize)
+        return false;
+
+    //Read straight into the buffers the terrain instance will own
+    std::vector<std::span<u16>> indices = {};
+    std::vector<std::span<LowLodTerrainVertex>> vertices = {};
+    std::span<u8> blendTextureBytes = {};
+    auto freeBuffers = [&]()
+    {
+        for (std::span<u16> buffer : indices)
+            delete[] (u8*)buffer.data();
+        for (std::span<LowLodTerrainVertex> buffer : vertices)
+            delete[] (u8*)buffer.data();
+        delete[] blendTextureBytes.data();
+    };
+
+    for (TerrainCacheMesh& mesh : meshTable)
+    {
+        indices.push_back(std::span<u16>((u16*)new u8[mesh.NumIndices * sizeof(u16)], mesh.NumIndices));
+        vertices.push_back(std::span<LowLodTerrainVertex>((LowLodTerrainVertex*)new u8[mesh.NumVertices * sizeof(LowLodTerrainVertex)], mesh.NumVertices));
+        in.read((char*)indices.back().data(), indices.back().size_bytes());
+        in.read((char*)vertices.back().data(), vertices.back().size_bytes());
+    }
+
+    //The sizes were checked against the file size above, so these can't allocate more than the file holds
+    TerrainLodTree lodData;
+    lodData.Nodes.resize(header.NumLodNodes);
+    lodData.Vertices.resize(header.NumLodVertices);
+    lodData.Indices.resize(header.NumLodIndices);
+    lodData.NumLevels = header.NumLodLevels;
+    std::vector<f32> heightData((u64)header.HeightsResolution * header.HeightsResolution);
+    std::vector<f32> levelBounds(header.NumHeightLevelBounds);
+    in.read((char*)lodData.Nodes.data(), lodData.Nodes.size() * sizeof(TerrainLodNode));
+    in.read((char*)lodData.Vertices.data(), lodData.Vertices.size() * sizeof(LowLodTerrainVertex));
+    in.read((char*)lodData.Indices.data(), lodData.Indices.size() * sizeof(u16));
+    in.read((char*)heightData.data(), heightData.size() * sizeof(f32));
+    in.read((char*)levelBounds.data(), levelBounds.size() * sizeof(f32));
+
+    if (header.BlendTextureSize > 0)
+    {
+        blendTextureBytes = std::span<u8>(new u8[header.BlendTextureSize], header.BlendTextureSize);
+        in.read((char*)blendTextureBytes.data(), blendTextureBytes.size());
+    }
+    //Tiles whose heightfield couldn't be built have an empty pyramid
+    HeightfieldPyramid heightPyramid;
+    const Vec3 heightsOrigin = { header.HeightsOrigin[0], header.HeightsOrigin[1], header.HeightsOrigin[2] };
+    bool heightsLoaded = header.HeightsResolution == 0 ? levelBounds.size() == 0 :
+                         heightPyramid.Load(heightData, header.HeightsResolution, heightsOrigin, header.HeightsSpacing, levelBounds);
+    if (!in.good() || !lodData.Valid() || !heightsLoaded)
+    {
+        freeBuffers();
+        return false;
+    }
+
+    terrain.Indices = std::move(indices);
+    terrain.Vertices = std::move(vertices);
+    terrain.HasNormals = header.HasNormals != 0;
+    lod = std::move(lodData);
+    heights = std::move(heightPyramid);
+    if (header.BlendTextureSize > 0)
+    {
+        terrain.HasBlendTexture = true;
+        terrain.BlendTextureOwned = true;
+        terrain.BlendTextureBytes = blendTextureBytes;
+        terrain.BlendTextureWidth = header.BlendTextureWidth;
+        terrain.BlendTextureHeight = header.BlendTextureHeight;
+    }
+
+    return true;
+}
+
+bool TerrainCache::ReadBlendTexture(const string& path, u64 key, std::span<u8> output)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    //The file may have been replaced since the tile was loaded. Only read it if it's still for the same source files
+    TerrainCacheHeader header;
+    in.read((char*)&header, sizeof(TerrainCacheHeader));
+    if (!in.good() || header.Signature != TerrainCacheSignature || header.Version != TerrainCacheVersion || header.Key != key)
+        return false;
+    if (output.size() > header.BlendTextureSize || header.FileSize != std::filesystem::file_size(path))
+        return false;
+
+    //Blend texture pixels are at the end of the file
+    in.seekg(header.FileSize - header.BlendTextureSize);
+    in.read((char*)output.data(), output.size());
+    return in.good();
+}
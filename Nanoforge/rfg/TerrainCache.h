@@ -0,0 +1,31 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <span>
+
+class PackfileVFS;
+class FileHandle;
+struct TerrainInstance;
+class TerrainLodTree;
+class HeightfieldPyramid;
+
+//Disk cache of processed low lod terrain tiles. Stores the vertices (with normals if they were generated), the indices, the LOD tree, the height pyramid,
+//and the decoded blend texture pixels. Lets previously opened territories skip extracting, parsing, and building LODs for their terrain.
+//Entries are keyed by the name, size, and write time of their source packfiles and are discarded when the key doesn't match.
+//The files inside the packfiles aren't hashed since that would mean extracting them, which is most of the work the cache skips.
+//So a packfile that's modified without changing its size or write time (e.g. by a tool that preserves timestamps) gives stale tiles until the cache is cleared.
+class TerrainCache
+{
+public:
+    //Get the path of the cache file for a terrain tile
+    static string GetPath(const string& terrainFilename);
+    //Get the key for a terrain tile. blendTexture can be null if the tile has no blend texture. Only reads the packfile metadata, see above
+    static u64 GetKey(PackfileVFS* packfileVFS, const string& terrainFilename, FileHandle& mesh, FileHandle* blendTexture);
+    //Write the vertices, indices, LOD tree, height pyramid, and blend texture of a processed tile. Returns false on failure
+    static bool Write(const string& path, u64 key, const TerrainInstance& terrain, const TerrainLodTree& lod, const HeightfieldPyramid& heights);
+    //Load a tile into terrain, lod, and heights. Buffers are allocated with new[] like those of tiles loaded from packfiles and BlendTextureOwned is set if it has a blend texture.
+    //Returns false without modifying the outputs if the file doesn't exist, is out of date, or is malformed
+    static bool Read(const string& path, u64 key, TerrainInstance& terrain, TerrainLodTree& lod, HeightfieldPyramid& heights);
+    //Read the first output.size() bytes of a tiles blend texture pixels. Used to stream blend textures from disk instead of keeping them in memory.
+    //Returns false if the file is out of date, malformed, or its blend texture is smaller than output
+    static bool ReadBlendTexture(const string& path, u64 key, std::span<u8> output);
+};
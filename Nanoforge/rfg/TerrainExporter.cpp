@@ -0,0 +1,318 @@
+#include "TerrainExporter.h"
+#include "TerrainLoader.h"
+#include "Territory.h"
+#include "util/BoundedQueue.h"
+#include "util/ThreadUtil.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+
+//Distance between the centers of neighboring zones
+constexpr f32 ZoneSize = 511.0f;
+
+//Output of a single tile. Failed tiles are still sent to the writer so it knows when each row of zones is complete
+struct TerrainExportTile
+{
+    u32 GridX = 0;
+    u32 GridZ = 0;
+    bool Failed = false;
+    //(samples + 1)^2 heightmap pixels. Row 0 is the tiles lowest z
+    std::vector<u16> Heights = {};
+    //Obj vertices and faces. Faces use negative indices so chunks can be written in any order
+    string Obj;
+};
+
+//Append a tiles meshes to an obj chunk. Triangle strips are converted to triangles and vertices are converted to world space
+static void WriteObjChunk(const TerrainInstance& terrain, string& output)
+{
+    auto out = std::back_inserter(output);
+    fmt::format_to(out, "o {}\n", terrain.Name);
+    for (u32 meshIndex = 0; meshIndex < terrain.Vertices.size(); meshIndex++)
+    {
+        std::span<const LowLodTerrainVertex> vertices = terrain.Vertices[meshIndex];
+        std::span<const u16> indices = terrain.Indices[meshIndex];
+        for (const LowLodTerrainVertex& vertex : vertices)
+        {
+            Vec3 position = TerrainToZoneSpace(vertex.x, vertex.y, vertex.z);
+            fmt::format_to(out, "v {} {} {}\n", position.x + terrain.Position.x, position.y + terrain.Position.y, position.z + terrain.Position.z);
+        }
+        for (const LowLodTerrainVertex& vertex : vertices)
+            fmt::format_to(out, "vn {} {} {}\n", vertex.normal.x, vertex.normal.y, vertex.normal.z);
+
+        //Strip winding alternates every triangle. Negative indices are relative to the end of this meshes vertices
+        const i64 numVertices = (i64)vertices.size();
+        for (size_t i = 0; i + 2 < indices.size(); i++)
+        {
+            u16 a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            if (a == b || b == c || a == c || a >= numVertices || b >= numVertices || c >= numVertices)
+                continue;
+            if (i % 2 == 1)
+                std::swap(a, b);
+
+            i64 ra = a - numVertices, rb = b - numVertices, rc = c - numVertices;
+            fmt::format_to(out, "f {}//{} {}//{} {}//{}\n", ra, ra, rb, rb, rc, rc);
+        }
+    }
+}
+
+bool TerrainExporter::Export(Territory& territory, PackfileVFS* packfileVFS, const TerrainExportOptions& options)
+{
+    cancelled_ = false;
+    TilesExported = 0;
+    NumTiles = 0;
+    if (!options.Heightmap && !options.Obj)
+        return false;
+
+    std::vector<TerrainLoadRequest> requests = TerrainLoader::GetRequests(territory);
+    if (requests.size() == 0)
+    {
+        Log->error("Failed to export terrain for {}. It has no terrain tiles.", options.Name);
+        return false;
+    }
+
+    //Place tiles on a grid by their zone position
+    f32 minX = std::numeric_limits<f32>::max();
+    f32 minZ = std::numeric_limits<f32>::max();
+    for (TerrainLoadRequest& request : requests)
+    {
+        minX = std::min(minX, request.Position.x);
+        minZ = std::min(minZ, request.Position.z);
+    }
+    auto gridX = [&](const TerrainLoadRequest& request) { return (u32)std::lround((request.Position.x - minX) / ZoneSize); };
+    auto gridZ = [&](const TerrainLoadRequest& request) { return (u32)std::lround((request.Position.z - minZ) / ZoneSize); };
+    u32 gridWidth = 0;
+    u32 gridHeight = 0;
+    for (TerrainLoadRequest& request : requests)
+    {
+        gridWidth = std::max(gridWidth, gridX(request) + 1);
+        gridHeight = std::max(gridHeight, gridZ(request) + 1);
+    }
+
+    //The heightmap is written from the top row (highest z) down, so tiles are decoded in that order to finish each row of zones as early as possible
+    std::sort(requests.begin(), requests.end(), [&](const TerrainLoadRequest& a, const TerrainLoadRequest& b)
+    {
+        return gridZ(a) != gridZ(b) ? gridZ(a) > gridZ(b) : gridX(a) < gridX(b);
+    });
+    std::vector<u32> tilesPerRow(gridHeight, 0);
+    for (TerrainLoadRequest& request : requests)
+        tilesPerRow[gridZ(request)]++;
+    NumTiles = (u32)requests.size();
+
+    //Open output files
+    std::filesystem::create_directories(options.OutputFolder);
+    const u32 samples = std::max(options.HeightmapSamplesPerZone, 1u);
+    const u32 imageWidth = gridWidth * samples + 1;
+    const u32 imageHeight = gridHeight * samples + 1;
+    std::ofstream heightmapFile;
+    std::ofstream objFile;
+    if (options.Heightmap)
+    {
+        string path = (std::filesystem::path(options.OutputFolder) / (options.Name + "_heightmap.pgm")).string();
+        heightmapFile.open(path, std::ios::binary | std::ios::trunc);
+        if (!heightmapFile.is_open())
+        {
+            Log->error("Failed to open {} for terrain export.", path);
+            return false;
+        }
+        heightmapFile << "P5\n# height = value / " << HeightmapScale << " - " << HeightmapOffset << "\n" << imageWidth << " " << imageHeight << "\n65535\n";
+    }
+    if (options.Obj)
+    {
+        string path = (std::filesystem::path(options.OutputFolder) / (options.Name + "_terrain.obj")).string();
+        objFile.open(path, std::ios::binary | std::ios::trunc);
+        if (!objFile.is_open())
+        {
+            Log->error("Failed to open {} for terrain export.", path);
+            return false;
+        }
+        objFile << "# Terrain of " << options.Name << " exported by Nanoforge\n";
+    }
+
+    //Decode tiles in parallel. Workers block once the writer falls behind so memory use stays flat
+    BoundedQueue<Handle<TerrainExportTile>> writeQueue(WriteQueueCapacity);
+    std::atomic<u32> nextRequest = 0;
+    const u32 numWorkers = std::min(WorkerThreadCount(), (u32)requests.size());
+    auto workersRunning = std::make_shared<std::atomic<u32>>(numWorkers);
+    std::vector<std::future<void>> workers = {};
+    for (u32 i = 0; i < numWorkers; i++)
+    {
+        workers.push_back(std::async(std::launch::async, [&, workersRunning]()
+        {
+            for (u32 requestIndex = nextRequest++; requestIndex < requests.size(); requestIndex = nextRequest++)
+            {
+                const TerrainLoadRequest& request = requests[requestIndex];
+                Handle<TerrainExportTile> tile = CreateHandle<TerrainExportTile>();
+                tile->GridX = gridX(request);
+                tile->GridZ = gridZ(request);
+                if (cancelled_)
+                {
+                    tile->Failed = true;
+                    writeQueue.Push(tile);
+                    continue;
+                }
+
+                TerrainLoadJob job;
+                job.Request = request;
+                try
+                {
+                    TerrainLoader::Extract(job, packfileVFS);
+                    TerrainLoader::Parse(job);
+                    if (options.Obj)
+                        TerrainLoader::GenerateNormals(job, 1);
+                    job.Terrain.Name = request.Filename;
+                    job.Terrain.Position = request.Position;
+
+                    if (options.Heightmap)
+                    {
+                        TerrainHeightfield heightfield;
+                        heightfield.Build(job.Terrain, samples + 1);
+                        tile->Heights.resize(heightfield.Heights.size());
+                        for (u32 sample = 0; sample < heightfield.Heights.size(); sample++)
+                        {
+                            f32 height = TerrainToZoneSpace(0.0f, heightfield.Heights[sample], 0.0f).y + request.Position.y;
+                            tile->Heights[sample] = (u16)std::clamp((height + HeightmapOffset) * HeightmapScale, 0.0f, 65535.0f);
+                        }
+                    }
+                    if (options.Obj)
+                        WriteObjChunk(job.Terrain, tile->Obj);
+                }
+                catch (std::exception& ex)
+                {
+                    Log->error("Failed to export terrain mesh {}. Error: {}", request.Filename, ex.what());
+                    tile->Failed = true;
+                }
+                TerrainLoader::FreeJob(job);
+                writeQueue.Push(tile);
+            }
+
+            if (--(*workersRunning) == 0)
+                writeQueue.Close();
+        }));
+    }
+
+    //Write tiles as they arrive. Heightmap rows are buffered one row of zones at a time and flushed once every tile in the row is done.
+    //Each row of zones writes its top samples rows. The shared edge row is written by the row above it. The last row also writes its bottom edge
+    struct HeightmapRow
+    {
+        std::vector<u16> Pixels = {};
+        u32 TilesRemaining = 0;
+    };
+    std::map<u32, HeightmapRow> openRows = {};
+    i64 nextRowToWrite = (i64)gridHeight - 1;
+    u32 tilesWritten = 0;
+    auto flushRows = [&]()
+    {
+        while (nextRowToWrite >= 0)
+        {
+            auto it = openRows.find((u32)nextRowToWrite);
+            bool emptyRow = tilesPerRow[nextRowToWrite] == 0;
+            if (!emptyRow && (it == openRows.end() || it->second.TilesRemaining > 0))
+                return;
+
+            //Local rows from the top edge down. PGM stores 16 bit values big endian
+            std::vector<u8> rowBytes(imageWidth * 2, 0);
+            u32 lastLocalRow = nextRowToWrite == 0 ? 0 : 1;
+            for (u32 localRow = samples + 1; localRow-- > lastLocalRow;)
+            {
+                if (!emptyRow)
+                {
+                    const u16* pixels = it->second.Pixels.data() + (size_t)localRow * imageWidth;
+                    for (u32 x = 0; x < imageWidth; x++)
+                    {
+                        rowBytes[x * 2] = (u8)(pixels[x] >> 8);
+                        rowBytes[x * 2 + 1] = (u8)(pixels[x] & 0xFF);
+                    }
+                }
+                heightmapFile.write((const char*)rowBytes.data(), rowBytes.size());
+            }
+
+            if (!emptyRow)
+                openRows.erase(it);
+            nextRowToWrite--;
+        }
+    };
+
+    //Stop the workers if writing fails. Closing the queue makes their pushes fail instead of blocking on a writer that stopped popping
+    bool writeFailed = false;
+    auto stopWorkers = [&]()
+    {
+        writeFailed = true;
+        cancelled_ = true;
+        writeQueue.Close();
+    };
+    try
+    {
+        while (std::optional<Handle<TerrainExportTile>> maybeTile = writeQueue.Pop())
+        {
+            Handle<TerrainExportTile> tile = maybeTile.value();
+            if (!tile->Failed)
+            {
+                tilesWritten++;
+                if (options.Obj)
+                    objFile.write(tile->Obj.data(), tile->Obj.size());
+            }
+
+            if (options.Heightmap)
+            {
+                HeightmapRow& row = openRows[tile->GridZ];
+                if (row.Pixels.size() == 0)
+                {
+                    row.Pixels.resize((size_t)imageWidth * (samples + 1), 0);
+                    row.TilesRemaining = tilesPerRow[tile->GridZ];
+                }
+                if (!tile->Failed)
+                {
+                    for (u32 z = 0; z <= samples; z++)
+                    {
+                        const u16* source = tile->Heights.data() + (size_t)z * (samples + 1);
+                        std::copy(source, source + samples + 1, row.Pixels.data() + (size_t)z * imageWidth + tile->GridX * samples);
+                    }
+                }
+                row.TilesRemaining--;
+                flushRows();
+            }
+            TilesExported++;
+
+            //Writes fail silently when the disk is full. Stop early instead of decoding tiles that can't be written
+            if (heightmapFile.fail() || objFile.fail())
+            {
+                Log->error("Failed to write terrain export files for {}.", options.Name);
+                stopWorkers();
+                break;
+            }
+        }
+    }
+    catch (std::exception& ex)
+    {
+        Log->error("Failed to write terrain export for {}. Error: {}", options.Name, ex.what());
+        stopWorkers();
+    }
+
+    for (auto& worker : workers)
+        worker.wait();
+
+    //Closing flushes the last buffered writes, which can fail too. close() sets failbit on streams that were never opened so those are skipped
+    if (heightmapFile.is_open())
+        heightmapFile.close();
+    if (objFile.is_open())
+        objFile.close();
+    if (!writeFailed && (heightmapFile.fail() || objFile.fail()))
+    {
+        Log->error("Failed to write terrain export files for {}.", options.Name);
+        writeFailed = true;
+    }
+    if (writeFailed)
+        return false;
+    if (cancelled_)
+    {
+        Log->warn("Terrain export for {} was cancelled.", options.Name);
+        return false;
+    }
+
+    Log->info("Exported {}/{} terrain tiles for {} to {}", tilesWritten, requests.size(), options.Name, options.OutputFolder);
+    return tilesWritten > 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <atomic>
+
+class PackfileVFS;
+class Territory;
+
+struct TerrainExportOptions
+{
+    string OutputFolder;
+    //Prefix of the output filenames. Usually the territory name
+    string Name;
+    //Write <Name>_heightmap.pgm. 16 bit grayscale covering every zone of the territory
+    bool Heightmap = true;
+    //Write <Name>_terrain.obj. Every terrain mesh of the territory in world space with normals
+    bool Obj = true;
+    //Heightmap pixels per zone side. Neighboring zones share their edge pixels
+    u32 HeightmapSamplesPerZone = 256;
+};
+
+//Exports the terrain of a whole territory as a heightmap image and/or a single mesh.
+//Tiles are decoded in parallel and written as they finish, so only a few tiles and one row of zones of the heightmap are in memory at once no matter how large the map is.
+class TerrainExporter
+{
+public:
+    //Heightmap pixel value = (world height + HeightmapOffset) * HeightmapScale
+    static constexpr f32 HeightmapOffset = 1024.0f;
+    static constexpr f32 HeightmapScale = 32.0f;
+
+    //Export the terrain of a territory with loaded zones. Blocks until done. Returns false if nothing could be exported
+    bool Export(Territory& territory, PackfileVFS* packfileVFS, const TerrainExportOptions& options);
+    //Stop an export running on another thread
+    void Cancel() { cancelled_ = true; }
+
+    //Progress of the current export
+    std::atomic<u32> TilesExported = 0;
+    std::atomic<u32> NumTiles = 0;
+
+private:
+    std::atomic<bool> cancelled_ = false;
+
+    //Max decoded tiles waiting to be written
+    static constexpr u32 WriteQueueCapacity = 4;
+};
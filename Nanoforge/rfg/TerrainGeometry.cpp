@@ -0,0 +1,144 @@
+#include "TerrainGeometry.h"
+#include <emmintrin.h>
+#include <cmath>
+
+//Normal of strip triangle i. sx, sy, and sz are positions in strip order. Normals are flipped to point up since strip winding alternates
+static void FaceNormal(u32 i, const f32* sx, const f32* sy, const f32* sz, f32& outX, f32& outY, f32& outZ)
+{
+    f32 e1x = sx[i + 1] - sx[i], e1y = sy[i + 1] - sy[i], e1z = sz[i + 1] - sz[i];
+    f32 e2x = sx[i + 2] - sx[i + 1], e2y = sy[i + 2] - sy[i + 1], e2z = sz[i + 2] - sz[i + 1];
+    f32 x = e1y * e2z - e1z * e2y;
+    f32 y = e1z * e2x - e1x * e2z;
+    f32 z = e1x * e2y - e1y * e2x;
+    f32 sign = y < 0.0f ? -1.0f : 1.0f;
+    outX = x * sign;
+    outY = y * sign;
+    outZ = z * sign;
+}
+
+//Sum the normals of the 3 triangles using each of 4 consecutive strip entries. faces holds triangles i to i + 3 and previous holds triangles i - 4 to i - 1
+static __m128 SumStripFaces(__m128 previous, __m128 faces)
+{
+    __m128 back2 = _mm_shuffle_ps(previous, faces, _MM_SHUFFLE(1, 0, 3, 2)); //Triangles i - 2 to i + 1
+    __m128 back1 = _mm_shuffle_ps(back2, faces, _MM_SHUFFLE(2, 1, 2, 1)); //Triangles i - 1 to i + 2
+    return _mm_add_ps(_mm_add_ps(back2, back1), faces);
+}
+
+void GenerateTerrainNormals(std::span<const u16> indices, std::span<LowLodTerrainVertex> vertices)
+{
+    //Normal sums are stored as structure of arrays so 4 vertices can be normalized at once with SSE
+    const u32 numVertices = (u32)vertices.size();
+    std::vector<f32> normals(numVertices * 3, 0.0f);
+    f32* nx = normals.data();
+    f32* ny = nx + numVertices;
+    f32* nz = ny + numVertices;
+
+    //Copy positions into strip order. Triangle i of the strip uses entries i, i + 1, and i + 2, so the corners of 4 consecutive triangles
+    //are contiguous and can be read with one unaligned load each instead of gathering 4 scattered vertices per corner
+    const u16* strip = indices.data();
+    const u32 numStrip = (u32)indices.size();
+    const u32 numTriangles = numStrip >= 3 ? numStrip - 2 : 0;
+    std::vector<f32> stripPositions((size_t)numStrip * 3);
+    f32* sx = stripPositions.data();
+    f32* sy = sx + numStrip;
+    f32* sz = sy + numStrip;
+    for (u32 i = 0; i < numStrip; i++)
+    {
+        const LowLodTerrainVertex& vertex = vertices[strip[i]];
+        sx[i] = vertex.x;
+        sy[i] = vertex.y;
+        sz[i] = vertex.z;
+    }
+
+    //Strip entry i is a corner of triangles i - 2, i - 1, and i, so its share of the vertex normal is the sum of those 3 face normals.
+    //Faces are summed per strip entry as they're calculated instead of being added to each of their 3 corners, which cuts the scattered adds by 3x.
+    //The sums overwrite the strip positions once they've been read
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    __m128 previousX = _mm_setzero_ps(), previousY = _mm_setzero_ps(), previousZ = _mm_setzero_ps();
+    u32 triangle = 0;
+    for (; triangle + 4 <= numTriangles; triangle += 4)
+    {
+        //Calculate normals for 4 triangles at once
+        __m128 ax = _mm_loadu_ps(sx + triangle), ay = _mm_loadu_ps(sy + triangle), az = _mm_loadu_ps(sz + triangle);
+        __m128 bx = _mm_loadu_ps(sx + triangle + 1), by = _mm_loadu_ps(sy + triangle + 1), bz = _mm_loadu_ps(sz + triangle + 1);
+        __m128 cx = _mm_loadu_ps(sx + triangle + 2), cy = _mm_loadu_ps(sy + triangle + 2), cz = _mm_loadu_ps(sz + triangle + 2);
+
+        __m128 e1x = _mm_sub_ps(bx, ax), e1y = _mm_sub_ps(by, ay), e1z = _mm_sub_ps(bz, az);
+        __m128 e2x = _mm_sub_ps(cx, bx), e2y = _mm_sub_ps(cy, by), e2z = _mm_sub_ps(cz, bz);
+        __m128 x = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+        __m128 y = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+        __m128 z = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+
+        //Flip normals pointing down by flipping the sign bit
+        __m128 flip = _mm_and_ps(_mm_cmplt_ps(y, _mm_setzero_ps()), signBit);
+        x = _mm_xor_ps(x, flip);
+        y = _mm_xor_ps(y, flip);
+        z = _mm_xor_ps(z, flip);
+
+        _mm_storeu_ps(sx + triangle, SumStripFaces(previousX, x));
+        _mm_storeu_ps(sy + triangle, SumStripFaces(previousY, y));
+        _mm_storeu_ps(sz + triangle, SumStripFaces(previousZ, z));
+        previousX = x;
+        previousY = y;
+        previousZ = z;
+    }
+
+    //Remaining triangles and the last 2 strip entries, which only have the triangles before them
+    alignas(16) f32 lastX[4];
+    alignas(16) f32 lastY[4];
+    alignas(16) f32 lastZ[4];
+    _mm_store_ps(lastX, previousX);
+    _mm_store_ps(lastY, previousY);
+    _mm_store_ps(lastZ, previousZ);
+    f32 back2X = lastX[2], back2Y = lastY[2], back2Z = lastZ[2];
+    f32 back1X = lastX[3], back1Y = lastY[3], back1Z = lastZ[3];
+    for (u32 entry = triangle; entry < numStrip; entry++)
+    {
+        f32 x = 0.0f, y = 0.0f, z = 0.0f;
+        if (entry < numTriangles)
+            FaceNormal(entry, sx, sy, sz, x, y, z);
+
+        sx[entry] = back2X + back1X + x;
+        sy[entry] = back2Y + back1Y + y;
+        sz[entry] = back2Z + back1Z + z;
+        back2X = back1X; back2Y = back1Y; back2Z = back1Z;
+        back1X = x; back1Y = y; back1Z = z;
+    }
+
+    //Vertices can appear in the strip more than once, so this last step is still a scatter
+    for (u32 i = 0; i < numStrip; i++)
+    {
+        u32 index = strip[i];
+        nx[index] += sx[i];
+        ny[index] += sy[i];
+        nz[index] += sz[i];
+    }
+
+    //Normalize 4 vertex normals at once. Vertices not used by any triangle get an up vector
+    alignas(16) f32 outX[4];
+    alignas(16) f32 outY[4];
+    alignas(16) f32 outZ[4];
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    u32 i = 0;
+    for (; i + 4 <= numVertices; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(nx + i);
+        __m128 y = _mm_loadu_ps(ny + i);
+        __m128 z = _mm_loadu_ps(nz + i);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        __m128 valid = _mm_cmpgt_ps(length, zero);
+        __m128 safeLength = _mm_or_ps(_mm_and_ps(valid, length), _mm_andnot_ps(valid, one));
+        _mm_store_ps(outX, _mm_and_ps(valid, _mm_div_ps(x, safeLength)));
+        _mm_store_ps(outY, _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(y, safeLength)), _mm_andnot_ps(valid, one)));
+        _mm_store_ps(outZ, _mm_and_ps(valid, _mm_div_ps(z, safeLength)));
+
+        for (u32 lane = 0; lane < 4; lane++)
+            vertices[i + lane].normal = { outX[lane], outY[lane], outZ[lane] };
+    }
+    for (; i < numVertices; i++)
+    {
+        f32 length = std::sqrt(nx[i] * nx[i] + ny[i] * ny[i] + nz[i] * nz[i]);
+        vertices[i].normal = length > 0.0f ? Vec3{ nx[i] / length, ny[i] / length, nz[i] / length } : Vec3{ 0.0f, 1.0f, 0.0f };
+    }
+}
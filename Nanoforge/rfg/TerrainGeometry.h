@@ -0,0 +1,49 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "RfgTools++/types/Vec3.h"
+#include <vector>
+#include <span>
+
+//Vertex format of low lod terrain meshes in gterrain_pc files
+struct ShortVec4
+{
+    i16 x = 0;
+    i16 y = 0;
+    i16 z = 0;
+    i16 w = 0;
+
+    ShortVec4 operator-(const ShortVec4& B)
+    {
+        return ShortVec4{ x - B.x, y - B.y, z - B.z, w - B.w };
+    }
+};
+
+//Stride = 20 bytes
+struct LowLodTerrainVertex
+{
+    //8 bytes
+    i16 x = 0;
+    i16 y = 0;
+    i16 z = 0;
+    i16 w = 0;
+
+    //12 bytes
+    Vec3 normal;
+};
+static_assert(sizeof(LowLodTerrainVertex) == 20, "LowLodTerrainVertex size incorrect!");
+
+//Meshes of a single zones terrain. Made up of 9 smaller meshes which are stitched together. Indices[i] and Vertices[i] are mesh i.
+//Kept separate from TerrainInstance so code that only needs the geometry doesn't depend on the texture formats
+struct TerrainGeometry
+{
+    string Name;
+    std::vector<std::span<u16>> Indices = {};
+    std::vector<std::span<LowLodTerrainVertex>> Vertices = {};
+    //If false vertex normals are zero. Only generated when needed (e.g. obj export) since the LOD patches calculate their own
+    bool HasNormals = false;
+    Vec3 Position;
+};
+
+//Generate smooth vertex normals for a low lod terrain mesh. indices is a triangle strip.
+//Sets the normal of each vertex to the normalized sum of the face normals of the triangles using it. Positions aren't changed
+void GenerateTerrainNormals(std::span<const u16> indices, std::span<LowLodTerrainVertex> vertices);
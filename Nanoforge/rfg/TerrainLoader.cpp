@@ -0,0 +1,291 @@
+#include "TerrainLoader.h"
+#include "TerrainCache.h"
+#include "TerrainLowLod.h"
+#include "PackfileVFS.h"
+#include "Territory.h"
+#include "common/filesystem/Path.h"
+#include "util/ThreadUtil.h"
+#include "Log.h"
+#include <RfgTools++\formats\zones\properties\primitive\StringProperty.h>
+#include <RfgTools++\formats\packfiles\Packfile3.h>
+#include <BinaryTools/BinaryReader.h>
+
+std::vector<TerrainLoadRequest> TerrainLoader::GetRequests(Territory& territory)
+{
+    std::vector<TerrainLoadRequest> requests = {};
+    for (auto& zone : territory.ZoneFiles)
+    {
+        //Get obj_zone object with a terrain_file_name property
+        auto* objZoneObject = zone.Zone.GetSingleObject("obj_zone");
+        if (!objZoneObject)
+            continue;
+        auto* terrainFilenameProperty = objZoneObject->GetProperty<StringProperty>("terrain_file_name");
+        if (!terrainFilenameProperty)
+            continue;
+
+        //Remove extra null terminators that RFG so loves to have in it's files
+        string filename = terrainFilenameProperty->Data;
+        if (filename.ends_with('\0'))
+            filename.pop_back();
+
+        Vec3 position = objZoneObject->Bmin + ((objZoneObject->Bmax - objZoneObject->Bmin) / 2.0f);
+        requests.push_back({ filename + ".cterrain_pc", position });
+    }
+
+
+    return requests;
+}
+
+void TerrainLoader::Extract(TerrainLoadJob& job, PackfileVFS* packfileVFS)
+{
+    auto terrainMeshHandles = packfileVFS->GetFiles(job.Request.Filename, true, true);
+    if (terrainMeshHandles.size() == 0)
+        THROW_EXCEPTION("Couldn't find terrain mesh.");
+
+    //Todo: Use + "_alpha00" here to get the blend weights texture, load high res textures, and apply those. Will make terrain texture higher res and have specular + normal maps
+    //Todo: Remember to also change the DXGI_FORMAT for the Texture2D to DXGI_FORMAT_R8G8B8A8_UNORM since that's what the _alpha00 textures used instead of DXT1
+    //Get terrain blending texture
+    FileHandle& terrainMesh = terrainMeshHandles[0];
+    job.BlendTextureName = Path::GetFileNameNoExtension(terrainMesh.Filename()) + "comb.cvbm_pc";
+    auto blendTextureHandlesCpu = packfileVFS->GetFiles(job.BlendTextureName, true, true);
+    FileHandle* blendTextureHandle = blendTextureHandlesCpu.size() > 0 ? &blendTextureHandlesCpu[0] : nullptr;
+
+    //Use the processed tile from a previous load if its source files haven't changed
+    job.CacheKey = TerrainCache::GetKey(packfileVFS, job.Request.Filename, terrainMesh, blendTextureHandle);
+    if (TerrainCache::Read(TerrainCache::GetPath(job.Request.Filename), job.CacheKey, job.Terrain, job.Lod, job.Heights))
+    {
+        job.Terrain.Name = job.Request.Filename;
+        job.Terrain.Position = job.Request.Position;
+        job.Cached = true;
+        return;
+    }
+
+    //Get packfile that holds terrain meshes
+    auto* container = terrainMesh.GetContainer();
+    if (!container)
+        THROW_EXCEPTION("Failed to get container pointer for a terrain mesh.");
+
+    //Todo: This does a full extract twice on the container due to the way single file extracts work. Fix this
+    //Get mesh file byte arrays
+    auto cpuFileBytes = container->ExtractSingleFile(terrainMesh.Filename(), true);
+    auto gpuFileBytes = container->ExtractSingleFile(Path::GetFileNameNoExtension(terrainMesh.Filename()) + ".gterrain_pc", true);
+    delete container;
+
+    //Ensure the mesh files were extracted
+    if (cpuFileBytes)
+        job.CpuFile = cpuFileBytes.value();
+    if (gpuFileBytes)
+        job.GpuFile = gpuFileBytes.value();
+    if (!cpuFileBytes)
+        THROW_EXCEPTION("Failed to extract terrain mesh cpu file.");
+    if (!gpuFileBytes)
+        THROW_EXCEPTION("Failed to extract terrain mesh gpu file.");
+
+    if (blendTextureHandle)
+    {
+        auto* containerBlend = blendTextureHandle->GetContainer();
+        if (!containerBlend)
+            THROW_EXCEPTION("Failed to get container pointer for a terrain mesh.");
+
+        //Get texture file byte arrays
+        auto cpuFileBytesBlend = containerBlend->ExtractSingleFile(job.BlendTextureName, true);
+        auto gpuFileBytesBlend = containerBlend->ExtractSingleFile(Path::GetFileNameNoExtension(job.BlendTextureName) + ".gvbm_pc", true);
+        delete containerBlend;
+
+        //Ensure the texture files were extracted
+        if (cpuFileBytesBlend)
+            job.BlendCpuFile = cpuFileBytesBlend.value();
+        if (gpuFileBytesBlend)
+            job.BlendGpuFile = gpuFileBytesBlend.value();
+        if (!cpuFileBytesBlend)
+            THROW_EXCEPTION("Failed to extract terrain mesh cpu file.");
+        if (!gpuFileBytesBlend)
+            THROW_EXCEPTION("Failed to extract terrain mesh gpu file.");
+    }
+    else
+    {
+        Log->warn("Couldn't find blend texture for {}.", terrainMesh.Filename());
+    }
+}
+
+void TerrainLoader::Parse(TerrainLoadJob& job)
+{
+    if (job.Cached)
+        return;
+
+    TerrainLowLod file;
+    file.Read(job.CpuFile, job.GpuFile, job.Request.Filename);
+
+    //Create new instance
+    TerrainInstance& terrain = job.Terrain;
+    terrain.Name = job.Request.Filename;
+    terrain.Position = job.Request.Position;
+
+    //Copy mesh data out of the gpu file so it can be freed. Each terrain file is made up of several meshes which are stitched together
+    for (TerrainLowLodMesh& mesh : file.Meshes)
+    {
+        u16* indexBuffer = (u16*)new u8[mesh.Indices.size_bytes()];
+        std::copy(mesh.Indices.begin(), mesh.Indices.end(), indexBuffer);
+        terrain.Indices.push_back(std::span<u16>{ indexBuffer, mesh.Indices.size() });
+
+        //Normals are left zeroed until GenerateNormals() since most loads don't need them
+        LowLodTerrainVertex* vertexBuffer = (LowLodTerrainVertex*)new u8[mesh.Vertices.size() * sizeof(LowLodTerrainVertex)];
+        for (size_t i = 0; i < mesh.Vertices.size(); i++)
+        {
+            const ShortVec4& source = mesh.Vertices[i];
+            vertexBuffer[i] = { source.x, source.y, source.z, source.w };
+        }
+        terrain.Vertices.push_back(std::span<LowLodTerrainVertex>{ vertexBuffer, mesh.Vertices.size() });
+    }
+
+    //Mesh files aren't needed anymore. Free them before the job waits in the next queue
+    delete[] job.CpuFile.data();
+    delete[] job.GpuFile.data();
+    job.CpuFile = {};
+    job.GpuFile = {};
+}
+
+void TerrainLoader::GenerateNormals(TerrainLoadJob& job, u32 maxThreads)
+{
+    TerrainInstance& terrain = job.Terrain;
+    if (terrain.HasNormals)
+        return;
+
+    //Generate normals for each mesh in parallel
+    ParallelFor((u32)terrain.Vertices.size(), [&](u32 i)
+    {
+        GenerateTerrainNormals(terrain.Indices[i], terrain.Vertices[i]);
+    }, maxThreads);
+    terrain.HasNormals = true;
+}
+
+void TerrainLoader::BuildLod(TerrainLoadJob& job)
+{
+    //Cached tiles store their LOD tree and heights
+    if (job.Cached)
+        return;
+
+    //Resample the tile into a heightfield with about as many samples as the source meshes have vertices, then decimate it into a quadtree
+    u32 numVertices = 0;
+    for (std::span<LowLodTerrainVertex> vertices : job.Terrain.Vertices)
+        numVertices += (u32)vertices.size();
+
+    TerrainHeightfield heightfield;
+    heightfield.Build(job.Terrain, TerrainLodTree::ChooseResolution(numVertices));
+    job.Lod.Build(heightfield);
+    heightfield.BuildPyramid(job.Terrain.Position, job.Heights);
+}
+
+void TerrainLoader::DecodeBlendTexture(TerrainLoadJob& job)
+{
+    if (job.BlendCpuFile.size() == 0 || job.BlendGpuFile.size() == 0)
+        return;
+
+    TerrainInstance& terrain = job.Terrain;
+    BinaryReader cpuFileBlend(job.BlendCpuFile);
+    BinaryReader gpuFileBlend(job.BlendGpuFile);
+
+    terrain.BlendPeg.Read(cpuFileBlend, gpuFileBlend);
+    terrain.BlendPeg.ReadTextureData(gpuFileBlend, terrain.BlendPeg.Entries[0]);
+    auto maybeBlendTexturePixelData = terrain.BlendPeg.GetTextureData(0);
+    if (maybeBlendTexturePixelData)
+    {
+        terrain.HasBlendTexture = true;
+        terrain.BlendTextureBytes = maybeBlendTexturePixelData.value();
+        terrain.BlendTextureWidth = terrain.BlendPeg.Entries[0].Width;
+        terrain.BlendTextureHeight = terrain.BlendPeg.Entries[0].Height;
+    }
+    else
+    {
+        Log->warn("Failed to extract pixel data for terrain blend texture {}", job.BlendTextureName);
+    }
+
+    delete[] job.BlendCpuFile.data();
+    delete[] job.BlendGpuFile.data();
+    job.BlendCpuFile = {};
+    job.BlendGpuFile = {};
+}
+
+//Blend textures are BC1. 8 bytes per 4x4 block
+static u64 BlendTextureMipSize(u32 width, u32 height)
+{
+    return (u64)std::max((width + 3) / 4, 1u) * std::max((height + 3) / 4, 1u) * 8;
+}
+
+StreamedTextureDesc TerrainLoader::GetBlendTextureDesc(const TerrainInstance& terrain, const string& cachePath, u64 cacheKey)
+{
+    //Peg entries store their mips one after another. Count how many of them are in the texture data
+    StreamedTextureDesc desc;
+    desc.Name = terrain.Name;
+    desc.Width = terrain.BlendTextureWidth;
+    desc.Height = terrain.BlendTextureHeight;
+    desc.Center = terrain.Position;
+    desc.WorldSize = 511.0f; //Terrain tiles cover a whole zone
+    u64 offset = 0;
+    for (u32 width = desc.Width, height = desc.Height; ; width = std::max(width / 2, 1u), height = std::max(height / 2, 1u))
+    {
+        u64 mipSize = BlendTextureMipSize(width, height);
+        if (offset + mipSize > terrain.BlendTextureBytes.size())
+            break;
+
+        desc.MipSizes.push_back(mipSize);
+        offset += mipSize;
+        if (width == 1 && height == 1)
+            break;
+    }
+
+    //Only tiles that failed to write their cache file keep a copy in memory. It's outside of the streaming budget so this should be rare
+    Handle<std::vector<u8>> copy = nullptr;
+    if (cachePath.empty())
+        copy = std::make_shared<std::vector<u8>>(terrain.BlendTextureBytes.begin(), terrain.BlendTextureBytes.begin() + offset);
+
+    desc.Decode = [copy, cachePath, cacheKey, chainSize = offset, width = desc.Width, height = desc.Height, mipSizes = desc.MipSizes](u32 firstMip)
+    {
+        //The mip chain is read in one go. Only the mips that were asked for are kept
+        std::vector<u8> diskData = {};
+        const u8* data = copy ? copy->data() : nullptr;
+        if (!copy)
+        {
+            diskData.resize(chainSize);
+            if (!TerrainCache::ReadBlendTexture(cachePath, cacheKey, diskData))
+                THROW_EXCEPTION("Failed to read blend texture from terrain cache file {}", cachePath);
+
+            data = diskData.data();
+        }
+
+        std::vector<StreamedMip> mips = {};
+        u64 offset = 0;
+        for (u32 mip = 0; mip < mipSizes.size(); mip++)
+        {
+            if (mip >= firstMip)
+            {
+                StreamedMip& output = mips.emplace_back();
+                output.Width = std::max(width >> mip, 1u);
+                output.Height = std::max(height >> mip, 1u);
+                output.Data.assign(data + offset, data + offset + mipSizes[mip]);
+            }
+            offset += mipSizes[mip];
+        }
+        return mips;
+    };
+    return desc;
+}
+
+void TerrainLoader::FreeJob(TerrainLoadJob& job)
+{
+    //Free whatever the job still owns. Which buffers are set depends on the stage it was dropped in
+    delete[] job.CpuFile.data();
+    delete[] job.GpuFile.data();
+    delete[] job.BlendCpuFile.data();
+    delete[] job.BlendGpuFile.data();
+    for (std::span<u16> indices : job.Terrain.Indices)
+        delete[] (u8*)indices.data();
+    for (std::span<LowLodTerrainVertex> vertices : job.Terrain.Vertices)
+        delete[] (u8*)vertices.data();
+    if (job.Terrain.BlendTextureOwned)
+        delete[] job.Terrain.BlendTextureBytes.data();
+    else if (job.Terrain.HasBlendTexture)
+        job.Terrain.BlendPeg.Cleanup();
+
+    job = {};
+}
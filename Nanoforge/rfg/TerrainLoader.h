@@ -0,0 +1,59 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "TerrainHelpers.h"
+#include "TerrainLod.h"
+#include "util/TextureStreamer.h"
+#include <vector>
+#include <span>
+
+class PackfileVFS;
+class Territory;
+
+//Terrain mesh to load. Filename is the cterrain_pc file and Position is the center of its zone
+struct TerrainLoadRequest
+{
+    string Filename;
+    Vec3 Position;
+};
+
+//Terrain mesh moving through the terrain loading pipeline. Each stage frees the buffers it no longer needs
+struct TerrainLoadJob
+{
+    TerrainLoadRequest Request;
+    //Extracted files. Set by the extract stage
+    std::span<u8> CpuFile = {};
+    std::span<u8> GpuFile = {};
+    std::span<u8> BlendCpuFile = {};
+    std::span<u8> BlendGpuFile = {};
+    string BlendTextureName;
+    TerrainInstance Terrain;
+    //Key used to read and write the tiles TerrainCache file. If Cached is true Terrain, Lod, and Heights were loaded from the cache and the processing stages are skipped
+    u64 CacheKey = 0;
+    bool Cached = false;
+    //Level of detail patches built from the processed meshes. Drawn instead of the full detail meshes
+    TerrainLodTree Lod;
+    HeightfieldPyramid Heights;
+};
+
+//Steps for loading low lod terrain tiles. Used as the stages of loading pipelines (e.g. TerritoryDocument, TerrainExporter), which decide how they're threaded.
+//Stages throw on failure. Jobs that don't make it through every stage must be freed with FreeJob()
+class TerrainLoader
+{
+public:
+    //Get the terrain tiles referenced by the obj_zone objects of a territory
+    static std::vector<TerrainLoadRequest> GetRequests(Territory& territory);
+    //Extract the mesh and blend texture files. Loads the processed tile from TerrainCache instead if it's up to date
+    static void Extract(TerrainLoadJob& job, PackfileVFS* packfileVFS);
+    //Read the vertices and indices of each mesh from the extracted files. Vertex normals aren't set
+    static void Parse(TerrainLoadJob& job);
+    //Generate vertex normals if the tile doesn't have them yet. Meshes are processed in parallel on up to maxThreads threads
+    static void GenerateNormals(TerrainLoadJob& job, u32 maxThreads);
+    //Build the LOD tree and height query structure. Does nothing for cached tiles
+    static void BuildLod(TerrainLoadJob& job);
+    static void DecodeBlendTexture(TerrainLoadJob& job);
+    //Describe the blend texture of a tile for TextureStreamer. Mips are read from the tiles TerrainCache file when they're decoded.
+    //If cachePath is empty the pixels are copied into the desc instead so the instance can still be freed
+    static StreamedTextureDesc GetBlendTextureDesc(const TerrainInstance& terrain, const string& cachePath, u64 cacheKey);
+    //Free buffers owned by a job. Which buffers are set depends on the stage it was dropped in
+    static void FreeJob(TerrainLoadJob& job);
+};
@@ -0,0 +1,365 @@
+#include "TerrainLod.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+//Terrain mesh coordinate range and the scale applied to it by Terrain.fx
+constexpr f32 TerrainMin = -32768.0f;
+constexpr f32 TerrainMax = 32767.0f;
+constexpr f32 TerrainRange = (TerrainMax - TerrainMin) * 0.9980f;
+constexpr f32 ZoneMin = -255.5f;
+constexpr f32 ZoneRange = 511.0f;
+//The shader doubles terrain height after scaling it
+constexpr f32 TerrainHeightToZone = (ZoneRange / TerrainRange) * 2.0f;
+
+Vec3 TerrainToZoneSpace(f32 x, f32 y, f32 z)
+{
+    return
+    {
+        (((x - TerrainMin) * ZoneRange) / TerrainRange) + ZoneMin,
+        ((((y - TerrainMin) * ZoneRange) / TerrainRange) + ZoneMin) * 2.0f,
+        (((z - TerrainMin) * ZoneRange) / TerrainRange) + ZoneMin
+    };
+}
+
+f32 TerrainHeightfield::Spacing() const
+{
+    return (TerrainMax - TerrainMin) / (f32)(Resolution - 1);
+}
+
+f32 TerrainHeightfield::SampleCoord(u32 i) const
+{
+    return TerrainMin + (f32)i * Spacing();
+}
+
+void TerrainHeightfield::Build(const TerrainGeometry& terrain, u32 resolution)
+{
+    Resolution = resolution;
+    Heights.assign(resolution * resolution, 0.0f);
+    std::vector<u8> covered(resolution * resolution, 0);
+    const f32 invSpacing = 1.0f / Spacing();
+
+    //Rasterize each triangle of the strips onto the xz plane and interpolate height at the samples it covers
+    for (u32 meshIndex = 0; meshIndex < terrain.Indices.size(); meshIndex++)
+    {
+        std::span<const u16> indices = terrain.Indices[meshIndex];
+        std::span<const LowLodTerrainVertex> vertices = terrain.Vertices[meshIndex];
+        for (size_t i = 0; i + 2 < indices.size(); i++)
+        {
+            u16 ia = indices[i], ib = indices[i + 1], ic = indices[i + 2];
+            if (ia == ib || ib == ic || ia == ic) //Degenerate triangles join strip segments
+                continue;
+            if (ia >= vertices.size() || ib >= vertices.size() || ic >= vertices.size())
+                continue;
+
+            const LowLodTerrainVertex& a = vertices[ia];
+            const LowLodTerrainVertex& b = vertices[ib];
+            const LowLodTerrainVertex& c = vertices[ic];
+            f32 ax = (a.x - TerrainMin) * invSpacing, az = (a.z - TerrainMin) * invSpacing;
+            f32 bx = (b.x - TerrainMin) * invSpacing, bz = (b.z - TerrainMin) * invSpacing;
+            f32 cx = (c.x - TerrainMin) * invSpacing, cz = (c.z - TerrainMin) * invSpacing;
+            f32 area = (bx - ax) * (cz - az) - (cx - ax) * (bz - az);
+            if (std::abs(area) < 1e-6f)
+                continue;
+
+            const f32 invArea = 1.0f / area;
+            i32 minX = std::max((i32)std::ceil(std::min({ ax, bx, cx })), 0);
+            i32 maxX = std::min((i32)std::floor(std::max({ ax, bx, cx })), (i32)resolution - 1);
+            i32 minZ = std::max((i32)std::ceil(std::min({ az, bz, cz })), 0);
+            i32 maxZ = std::min((i32)std::floor(std::max({ az, bz, cz })), (i32)resolution - 1);
+            for (i32 z = minZ; z <= maxZ; z++)
+            {
+                for (i32 x = minX; x <= maxX; x++)
+                {
+                    //Barycentric coordinates. Small tolerance so samples on shared edges aren't missed
+                    f32 wb = ((x - ax) * (cz - az) - (cx - ax) * (z - az)) * invArea;
+                    f32 wc = ((bx - ax) * (z - az) - (x - ax) * (bz - az)) * invArea;
+                    f32 wa = 1.0f - wb - wc;
+                    if (wa < -1e-4f || wb < -1e-4f || wc < -1e-4f)
+                        continue;
+
+                    u32 sample = z * resolution + x;
+                    Heights[sample] = wa * a.y + wb * b.y + wc * c.y;
+                    covered[sample] = 1;
+                }
+            }
+        }
+    }
+
+    //Fill holes by flooding outward from covered samples
+    std::deque<u32> frontier = {};
+    for (u32 i = 0; i < covered.size(); i++)
+        if (covered[i])
+            frontier.push_back(i);
+
+    while (frontier.size() > 0)
+    {
+        u32 sample = frontier.front();
+        frontier.pop_front();
+        u32 x = sample % resolution;
+        u32 z = sample / resolution;
+        auto visit = [&](u32 neighbor)
+        {
+            if (covered[neighbor])
+                return;
+
+            covered[neighbor] = 1;
+            Heights[neighbor] = Heights[sample];
+            frontier.push_back(neighbor);
+        };
+        if (x > 0) visit(sample - 1);
+        if (x + 1 < resolution) visit(sample + 1);
+        if (z > 0) visit(sample - resolution);
+        if (z + 1 < resolution) visit(sample + resolution);
+    }
+}
+
+void TerrainHeightfield::BuildPyramid(const Vec3& position, HeightfieldPyramid& output) const
+{
+    std::vector<f32> worldHeights(Heights.size());
+    for (u32 i = 0; i < Heights.size(); i++)
+        worldHeights[i] = Heights[i] * TerrainHeightToZone;
+
+    //TerrainToZoneSpace() is linear so the zone space offset of height zero is added through the origin
+    Vec3 origin = TerrainToZoneSpace(SampleCoord(0), 0.0f, SampleCoord(0));
+    origin = { origin.x + position.x, origin.y + position.y, origin.z + position.z };
+    output.Build(worldHeights, Resolution, origin, Spacing() * (ZoneRange / TerrainRange));
+}
+
+u32 TerrainLodTree::ChooseResolution(u32 numSourceVertices)
+{
+    for (u32 level = 0; level < MaxLevels; level++)
+    {
+        u32 resolution = (PatchSize << level) + 1;
+        if (resolution * resolution >= numSourceVertices)
+            return resolution;
+    }
+    return (PatchSize << (MaxLevels - 1)) + 1;
+}
+
+void TerrainLodTree::Build(const TerrainHeightfield& heightfield)
+{
+    Nodes.clear();
+    Vertices.clear();
+    Indices.clear();
+
+    NumLevels = 0;
+    for (u32 level = 0; level < MaxLevels; level++)
+        if ((PatchSize << level) + 1 == heightfield.Resolution)
+            NumLevels = level + 1;
+    if (NumLevels == 0)
+        return;
+
+    //Create nodes breadth first so each nodes children are consecutive
+    Nodes.push_back({});
+    for (u32 i = 0; i < Nodes.size(); i++)
+    {
+        if (Nodes[i].Level + 1 >= NumLevels)
+            continue;
+
+        TerrainLodNode parent = Nodes[i];
+        Nodes[i].FirstChild = (u32)Nodes.size();
+        for (u32 child = 0; child < 4; child++)
+        {
+            TerrainLodNode& node = Nodes.emplace_back();
+            node.Level = parent.Level + 1;
+            node.X = parent.X * 2 + (child & 1);
+            node.Z = parent.Z * 2 + (child >> 1);
+        }
+    }
+
+    //Calculate errors bottom up so parents are never less accurate than their children. Selection relies on this to stop refining
+    for (u32 i = (u32)Nodes.size(); i-- > 0;)
+    {
+        TerrainLodNode& node = Nodes[i];
+        node.GeometricError = CalculatePatchError(heightfield, node) * TerrainHeightToZone;
+        if (!node.Leaf())
+            for (u32 child = 0; child < 4; child++)
+                node.GeometricError = std::max(node.GeometricError, Nodes[node.FirstChild + child].GeometricError);
+    }
+
+    for (TerrainLodNode& node : Nodes)
+        BuildPatch(heightfield, node);
+}
+
+f32 TerrainLodTree::CalculatePatchError(const TerrainHeightfield& heightfield, const TerrainLodNode& node) const
+{
+    const u32 step = 1 << (NumLevels - 1 - node.Level);
+    if (step == 1)
+        return 0.0f; //Leaves use every sample
+
+    const u32 span = PatchSize * step;
+    const u32 startX = node.X * span;
+    const u32 startZ = node.Z * span;
+    f32 maxError = 0.0f;
+    for (u32 z = 0; z <= span; z++)
+    {
+        for (u32 x = 0; x <= span; x++)
+        {
+            //Interpolate between the patch vertices around this sample
+            u32 cellX = std::min(x / step, PatchSize - 1);
+            u32 cellZ = std::min(z / step, PatchSize - 1);
+            f32 fx = (f32)(x - cellX * step) / (f32)step;
+            f32 fz = (f32)(z - cellZ * step) / (f32)step;
+            u32 x0 = startX + cellX * step, x1 = x0 + step;
+            u32 z0 = startZ + cellZ * step, z1 = z0 + step;
+            f32 h0 = heightfield.Height(x0, z0) + (heightfield.Height(x1, z0) - heightfield.Height(x0, z0)) * fx;
+            f32 h1 = heightfield.Height(x0, z1) + (heightfield.Height(x1, z1) - heightfield.Height(x0, z1)) * fx;
+            f32 approximate = h0 + (h1 - h0) * fz;
+            maxError = std::max(maxError, std::abs(heightfield.Height(startX + x, startZ + z) - approximate));
+        }
+    }
+    return maxError;
+}
+
+void TerrainLodTree::BuildPatch(const TerrainHeightfield& heightfield, TerrainLodNode& node)
+{
+    const u32 step = 1 << (NumLevels - 1 - node.Level);
+    const u32 span = PatchSize * step;
+    const u32 startX = node.X * span;
+    const u32 startZ = node.Z * span;
+    const u32 rowSize = PatchSize + 1;
+    const u32 last = heightfield.Resolution - 1;
+    const f32 spacing = heightfield.Spacing();
+
+    //Skirts hang down far enough to cover the largest gap to a neighbor drawn at a different level
+    const f32 skirtDepth = node.GeometricError / TerrainHeightToZone + spacing * (f32)step * 0.25f;
+
+    node.FirstVertex = (u32)Vertices.size();
+    node.FirstIndex = (u32)Indices.size();
+    f32 minHeight = std::numeric_limits<f32>::max();
+    f32 maxHeight = std::numeric_limits<f32>::lowest();
+
+    //Surface vertices. Normals are taken from the full detail heightfield so lighting doesn't change between levels
+    for (u32 z = 0; z < rowSize; z++)
+    {
+        for (u32 x = 0; x < rowSize; x++)
+        {
+            u32 sampleX = startX + x * step;
+            u32 sampleZ = startZ + z * step;
+            f32 height = heightfield.Height(sampleX, sampleZ);
+            f32 dx = heightfield.Height(std::min(sampleX + 1, last), sampleZ) - heightfield.Height(sampleX > 0 ? sampleX - 1 : 0, sampleZ);
+            f32 dz = heightfield.Height(sampleX, std::min(sampleZ + 1, last)) - heightfield.Height(sampleX, sampleZ > 0 ? sampleZ - 1 : 0);
+            Vec3 normal = { -dx, 2.0f * spacing, -dz };
+            f32 length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+
+            LowLodTerrainVertex& vertex = Vertices.emplace_back();
+            vertex.x = (i16)std::clamp(heightfield.SampleCoord(sampleX), TerrainMin, TerrainMax);
+            vertex.y = (i16)std::clamp(height, TerrainMin, TerrainMax);
+            vertex.z = (i16)std::clamp(heightfield.SampleCoord(sampleZ), TerrainMin, TerrainMax);
+            vertex.normal = { normal.x / length, normal.y / length, normal.z / length };
+        }
+    }
+
+    //Min and max height of every sample in the patch, not just its vertices, so the bounds also contain its children
+    for (u32 z = startZ; z <= startZ + span; z++)
+    {
+        for (u32 x = startX; x <= startX + span; x++)
+        {
+            minHeight = std::min(minHeight, heightfield.Height(x, z));
+            maxHeight = std::max(maxHeight, heightfield.Height(x, z));
+        }
+    }
+
+    //Two triangles per cell. Clockwise when viewed from above to match the mesh rasterizer state
+    for (u32 z = 0; z < PatchSize; z++)
+    {
+        for (u32 x = 0; x < PatchSize; x++)
+        {
+            u16 v00 = (u16)(z * rowSize + x);
+            u16 v10 = v00 + 1;
+            u16 v01 = (u16)(v00 + rowSize);
+            u16 v11 = v01 + 1;
+            Indices.insert(Indices.end(), { v00, v01, v10, v10, v01, v11 });
+        }
+    }
+
+    //Skirts. Each edge gets a copy of its vertices pushed down by skirtDepth. Skirt triangles face both ways so the winding of each edge doesn't matter
+    auto addSkirt = [&](u32 firstEdgeVertex, u32 edgeStride)
+    {
+        u32 firstSkirtVertex = (u32)Vertices.size() - node.FirstVertex;
+        for (u32 i = 0; i < rowSize; i++)
+        {
+            LowLodTerrainVertex vertex = Vertices[node.FirstVertex + firstEdgeVertex + i * edgeStride];
+            vertex.y = (i16)std::clamp((f32)vertex.y - skirtDepth, TerrainMin, TerrainMax);
+            Vertices.push_back(vertex);
+        }
+        for (u32 i = 0; i < PatchSize; i++)
+        {
+            u16 top0 = (u16)(firstEdgeVertex + i * edgeStride);
+            u16 top1 = (u16)(firstEdgeVertex + (i + 1) * edgeStride);
+            u16 bottom0 = (u16)(firstSkirtVertex + i);
+            u16 bottom1 = (u16)(firstSkirtVertex + i + 1);
+            Indices.insert(Indices.end(), { top0, bottom0, top1, top1, bottom0, bottom1 });
+            Indices.insert(Indices.end(), { top0, top1, bottom0, top1, bottom1, bottom0 });
+        }
+    };
+    addSkirt(0, 1); //-z edge
+    addSkirt(PatchSize * rowSize, 1); //+z edge
+    addSkirt(0, rowSize); //-x edge
+    addSkirt(PatchSize, rowSize); //+x edge
+
+    node.NumVertices = (u32)Vertices.size() - node.FirstVertex;
+    node.NumIndices = (u32)Indices.size() - node.FirstIndex;
+
+    Vec3 min = TerrainToZoneSpace(heightfield.SampleCoord(startX), minHeight - skirtDepth, heightfield.SampleCoord(startZ));
+    Vec3 max = TerrainToZoneSpace(heightfield.SampleCoord(startX + span), maxHeight, heightfield.SampleCoord(startZ + span));
+    node.Bounds = {};
+    node.Bounds.Extend(min);
+    node.Bounds.Extend(max);
+}
+
+f32 TerrainLodTree::ErrorToPixels(f32 fovRadians, f32 viewportHeight)
+{
+    return viewportHeight / (2.0f * std::tan(fovRadians * 0.5f));
+}
+
+void TerrainLodTree::Select(const Vec3& cameraPosition, f32 errorToPixels, f32 maxScreenError, std::vector<u32>& output) const
+{
+    if (Nodes.size() == 0)
+        return;
+
+    u32 stack[MaxLevels * 4];
+    u32 stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        u32 index = stack[--stackSize];
+        const TerrainLodNode& node = Nodes[index];
+
+        //Refine while the error projected at the closest point of the patch is too large
+        f32 distance = std::max(std::sqrt(node.Bounds.DistanceSquared(cameraPosition)), 0.001f);
+        f32 screenError = node.GeometricError * errorToPixels / distance;
+        if (node.Leaf() || screenError <= maxScreenError)
+        {
+            output.push_back(index);
+            continue;
+        }
+
+        for (u32 child = 0; child < 4; child++)
+            stack[stackSize++] = node.FirstChild + child;
+    }
+}
+
+void TerrainLodTree::FreeMeshData()
+{
+    std::vector<LowLodTerrainVertex>().swap(Vertices);
+    std::vector<u16>().swap(Indices);
+}
+
+bool TerrainLodTree::Valid() const
+{
+    if (NumLevels > MaxLevels || (NumLevels > 0) != (Nodes.size() > 0))
+        return false;
+
+    for (u32 i = 0; i < Nodes.size(); i++)
+    {
+        //Children always come after their parent since nodes are created breadth first. Select() relies on this to terminate
+        const TerrainLodNode& node = Nodes[i];
+        if (!node.Leaf() && (node.FirstChild <= i || (u64)node.FirstChild + 4 > Nodes.size()))
+            return false;
+        if ((u64)node.FirstVertex + node.NumVertices > Vertices.size() || (u64)node.FirstIndex + node.NumIndices > Indices.size())
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "TerrainGeometry.h"
+#include "util/Geometry.h"
+#include "util/HeightfieldPyramid.h"
+#include <vector>
+
+//Convert a position in terrain mesh units (-32768 to 32767 on each axis) to zone local units. Matches the vertex shader in Terrain.fx
+Vec3 TerrainToZoneSpace(f32 x, f32 y, f32 z);
+
+//Regular grid of heights resampled from the meshes of a terrain tile. Samples are evenly spaced over the full terrain mesh coordinate range.
+//Heights are in terrain mesh units so they can be written straight into LowLodTerrainVertex
+struct TerrainHeightfield
+{
+    u32 Resolution = 0; //Samples per side
+    std::vector<f32> Heights = {};
+
+    f32 Height(u32 x, u32 z) const { return Heights[z * Resolution + x]; }
+    //Terrain mesh units between samples
+    f32 Spacing() const;
+    //Terrain mesh x or z coordinate of a sample row or column
+    f32 SampleCoord(u32 i) const;
+
+    //Rasterize the triangle strips of a terrain tile into a resolution x resolution grid. Samples not covered by any triangle copy the nearest covered sample
+    void Build(const TerrainGeometry& terrain, u32 resolution);
+    //Build a height query structure in world space. position is the position of the terrain tile
+    void BuildPyramid(const Vec3& position, HeightfieldPyramid& output) const;
+};
+
+//Quadtree node. Each node is a patch of TerrainLodTree::PatchSize x PatchSize cells covering a quarter of its parent
+struct TerrainLodNode
+{
+    u32 Level = 0; //0 is the root
+    u32 X = 0; //Patch coordinates on the grid of patches at this level
+    u32 Z = 0;
+    //Zone space bounds
+    Aabb Bounds;
+    //Max height difference in zone units between this patch and the full detail heightfield. Includes the error of its children
+    f32 GeometricError = 0.0f;
+    //Children are stored consecutively. InvalidIndex for leaves
+    u32 FirstChild = 0xFFFFFFFF;
+    //Range of the patches mesh in TerrainLodTree::Vertices and TerrainLodTree::Indices. Indices are relative to FirstVertex
+    u32 FirstVertex = 0;
+    u32 NumVertices = 0;
+    u32 FirstIndex = 0;
+    u32 NumIndices = 0;
+
+    bool Leaf() const { return FirstChild == 0xFFFFFFFF; }
+};
+
+//Level of detail hierarchy for a terrain tile. Built on the CPU from a heightfield as a quadtree of decimated patches.
+//Patches have skirts along their edges that hang below the surface to hide cracks between neighbors of different levels.
+//Select() picks the coarsest patches whose projected error is below a pixel threshold so distant terrain is drawn with far fewer vertices.
+class TerrainLodTree
+{
+public:
+    static constexpr u32 InvalidIndex = 0xFFFFFFFF;
+    //Cells per patch side. Each patch has (PatchSize + 1)^2 surface vertices
+    static constexpr u32 PatchSize = 32;
+    static constexpr u32 MaxLevels = 4;
+
+    //Pick a heightfield resolution with about as many samples as the source meshes have vertices. Always PatchSize * 2^n + 1
+    static u32 ChooseResolution(u32 numSourceVertices);
+    //Build the tree. heightfield.Resolution must be PatchSize * 2^n + 1 with n < MaxLevels
+    void Build(const TerrainHeightfield& heightfield);
+    //Scale factor that converts a geometric error at a distance of 1 into pixels. screenError = GeometricError * ErrorToPixels() / distance
+    static f32 ErrorToPixels(f32 fovRadians, f32 viewportHeight);
+    //Select the patches to draw for a camera position in zone local space. Selected patches cover the tile without overlapping.
+    //A patch is refined into its children while its projected error is larger than maxScreenError pixels
+    void Select(const Vec3& cameraPosition, f32 errorToPixels, f32 maxScreenError, std::vector<u32>& output) const;
+    //Free vertex and index data once it's been uploaded. Nodes are kept for selection
+    void FreeMeshData();
+    //Check that the child and mesh ranges of each node are in bounds. Used to reject malformed trees loaded from cache files
+    bool Valid() const;
+
+    //Node 0 is the root
+    std::vector<TerrainLodNode> Nodes = {};
+    std::vector<LowLodTerrainVertex> Vertices = {};
+    std::vector<u16> Indices = {};
+    u32 NumLevels = 0;
+
+private:
+    void BuildPatch(const TerrainHeightfield& heightfield, TerrainLodNode& node);
+    //Max difference between the heightfield and the patch surface, which is bilinearly interpolated between patch vertices
+    f32 CalculatePatchError(const TerrainHeightfield& heightfield, const TerrainLodNode& node) const;
+};
@@ -0,0 +1,158 @@
+#include "TerrainLowLod.h"
+#include "Log.h"
+#include <BinaryTools/BinaryReader.h>
+#include <algorithm>
+#include <cstring>
+
+static u64 AlignUp(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static u32 ReadU32(std::span<u8> data, u64 offset)
+{
+    u32 value = 0;
+    memcpy(&value, data.data() + offset, sizeof(u32));
+    return value;
+}
+
+void TerrainLowLod::Read(std::span<u8> cpuFile, std::span<u8> gpuFile, const string& name)
+{
+    Name = name;
+    Meshes.clear();
+    Sections.clear();
+    DescriptorSearches = 0;
+
+    //Validate header
+    if (cpuFile.size() < sizeof(TerrainLowLodHeader))
+        THROW_EXCEPTION("Terrain cpu file is too small to have a header.");
+    memcpy(&Header, cpuFile.data(), sizeof(TerrainLowLodHeader));
+    if (Header.Signature != ExpectedSignature)
+        THROW_EXCEPTION("Invalid terrain file signature. Expected {}, found {}.", ExpectedSignature, Header.Signature);
+    if (Header.Version != ExpectedVersion)
+        Log->warn("Unexpected version {} in terrain file {}. Expected version {}. Reading it anyway.", Header.Version, name, ExpectedVersion);
+
+    //Follow the mesh blocks of the gpu file. Each one names the descriptor for it in the cpu file
+    u64 cpuOffset = sizeof(TerrainLowLodHeader);
+    u64 gpuOffset = 0;
+    while (gpuOffset + sizeof(u32) <= gpuFile.size())
+    {
+        //The last block may be followed by padding
+        u32 hash = ReadU32(gpuFile, gpuOffset);
+        if (hash == 0 && Meshes.size() > 0)
+            break;
+
+        //The first descriptor follows sections that aren't parsed yet so it has to be searched for. The others should be right after the previous one
+        TerrainLowLodMesh mesh;
+        mesh.Hash = hash;
+        bool found = Meshes.size() > 0 && ReadNextDescriptor(cpuFile, gpuFile, cpuOffset, gpuOffset, mesh);
+        if (!found)
+        {
+            DescriptorSearches++;
+            found = FindDescriptor(cpuFile, gpuFile, cpuOffset, gpuOffset, mesh);
+        }
+        if (!found)
+        {
+            if (Meshes.size() == 0)
+                THROW_EXCEPTION("Failed to find the descriptor of the first mesh in terrain file {}. Hash: {}", name, hash);
+
+            //Keep the meshes that were found. Anything left in the gpu file isn't a mesh block
+            Log->warn("Stopped reading terrain file {} after {} meshes. {} bytes at the end of the gpu file aren't a mesh block.", name, Meshes.size(), gpuFile.size() - gpuOffset);
+            break;
+        }
+
+        //Locate the vertices and indices
+        u64 indicesOffset = 0;
+        u64 verticesOffset = 0;
+        u64 blockEnd = GetGpuBlockEnd(gpuFile, gpuOffset, mesh.Info, indicesOffset, verticesOffset);
+        mesh.Indices = std::span<u16>((u16*)(gpuFile.data() + indicesOffset), mesh.Info.NumIndices);
+        mesh.Vertices = std::span<ShortVec4>((ShortVec4*)(gpuFile.data() + verticesOffset), mesh.Info.NumVertices);
+
+        AddSection(cpuFile, cpuOffset, mesh.DescriptorOffset);
+        cpuOffset = mesh.DescriptorOffset + mesh.DescriptorSize;
+        gpuOffset = blockEnd;
+        Meshes.push_back(mesh);
+    }
+    AddSection(cpuFile, cpuOffset, cpuFile.size());
+
+    if (Meshes.size() == 0)
+        THROW_EXCEPTION("Terrain file {} has no meshes.", name);
+    if (DescriptorSearches > 1)
+        Log->warn("{} mesh descriptors in terrain file {} weren't stored back to back.", DescriptorSearches - 1, name);
+}
+
+bool TerrainLowLod::ReadDescriptor(std::span<u8> cpuFile, std::span<u8> gpuFile, u64 descriptorOffset, u64 gpuBlockOffset, TerrainLowLodMesh& mesh)
+{
+    //Descriptors start with a u32 followed by the hash. Check it before parsing the rest
+    if (descriptorOffset + 2 * sizeof(u32) > cpuFile.size() || ReadU32(cpuFile, descriptorOffset + sizeof(u32)) != mesh.Hash)
+        return false;
+
+    //The same value can show up in unrelated data. Only accept descriptors whose layout matches the gpu block
+    try
+    {
+        BinaryReader reader(cpuFile);
+        reader.SeekBeg(descriptorOffset);
+        MeshDataBlock info;
+        info.Read(reader);
+        if (info.IndexSize != sizeof(u16) || info.VertexStride0 != sizeof(ShortVec4))
+            return false;
+
+        u64 indicesOffset = 0;
+        u64 verticesOffset = 0;
+        if (GetGpuBlockEnd(gpuFile, gpuBlockOffset, info, indicesOffset, verticesOffset) == 0)
+            return false;
+
+        mesh.Info = info;
+        mesh.DescriptorOffset = descriptorOffset;
+        mesh.DescriptorSize = reader.Position() - descriptorOffset;
+        return true;
+    }
+    catch (std::exception&)
+    {
+        return false;
+    }
+}
+
+bool TerrainLowLod::ReadNextDescriptor(std::span<u8> cpuFile, std::span<u8> gpuFile, u64 searchStart, u64 gpuBlockOffset, TerrainLowLodMesh& mesh)
+{
+    //Only a few positions need to be checked. The padding between descriptors depends on their alignment
+    const u64 end = std::min(AlignUp(searchStart, sizeof(u32)) + MaxDescriptorPadding, (u64)cpuFile.size());
+    for (u64 offset = AlignUp(searchStart, sizeof(u32)); offset < end; offset += sizeof(u32))
+        if (ReadDescriptor(cpuFile, gpuFile, offset, gpuBlockOffset, mesh))
+            return true;
+
+    return false;
+}
+
+bool TerrainLowLod::FindDescriptor(std::span<u8> cpuFile, std::span<u8> gpuFile, u64 searchStart, u64 gpuBlockOffset, TerrainLowLodMesh& mesh)
+{
+    //Descriptors are 4 byte aligned, so only aligned positions are checked
+    for (u64 offset = AlignUp(searchStart, sizeof(u32)); offset + 2 * sizeof(u32) <= cpuFile.size(); offset += sizeof(u32))
+        if (ReadDescriptor(cpuFile, gpuFile, offset, gpuBlockOffset, mesh))
+            return true;
+
+    return false;
+}
+
+u64 TerrainLowLod::GetGpuBlockEnd(std::span<u8> gpuFile, u64 gpuBlockOffset, const MeshDataBlock& info, u64& indicesOffset, u64& verticesOffset)
+{
+    indicesOffset = AlignUp(gpuBlockOffset + sizeof(u32), GpuDataAlignment);
+    verticesOffset = AlignUp(indicesOffset + (u64)info.NumIndices * info.IndexSize, GpuDataAlignment);
+    u64 endHashOffset = verticesOffset + (u64)info.NumVertices * info.VertexStride0;
+    if (endHashOffset + sizeof(u32) > gpuFile.size())
+        return 0;
+
+    //Blocks end with the same hash they start with
+    if (ReadU32(gpuFile, endHashOffset) != ReadU32(gpuFile, gpuBlockOffset))
+        return 0;
+
+    return endHashOffset + sizeof(u32);
+}
+
+void TerrainLowLod::AddSection(std::span<u8> cpuFile, u64 start, u64 end)
+{
+    if (end <= start)
+        return;
+
+    Sections.push_back({ start, cpuFile.subspan(start, end - start) });
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "TerrainGeometry.h"
+#include <RfgTools++/formats/meshes/MeshDataBlock.h>
+#include <vector>
+#include <span>
+
+//Header at the start of cterrain_pc files
+struct TerrainLowLodHeader
+{
+    u32 Signature = 0;
+    u32 Version = 0;
+};
+static_assert(sizeof(TerrainLowLodHeader) == 8, "TerrainLowLodHeader size incorrect!");
+
+//Mesh stored in a cterrain_pc + gterrain_pc pair. Indices and Vertices point into the gpu file passed to TerrainLowLod::Read()
+struct TerrainLowLodMesh
+{
+    //Vertex + index layout, counts, and submeshes. Read from the cpu file
+    MeshDataBlock Info;
+    //Hash at the start of the descriptor in the cpu file and the start and end of the meshes block in the gpu file
+    u32 Hash = 0;
+    //Location of the descriptor in the cpu file
+    u64 DescriptorOffset = 0;
+    u64 DescriptorSize = 0;
+    //Triangle strip
+    std::span<u16> Indices = {};
+    std::span<ShortVec4> Vertices = {};
+};
+
+//Range of the cpu file that isn't the header or a mesh descriptor. Holds the rest of the zones terrain data (materials, stitch pieces, undergrowth, etc).
+//Their layout isn't known yet so they're kept as raw bytes
+struct TerrainLowLodSection
+{
+    u64 Offset = 0;
+    std::span<u8> Data = {};
+};
+
+//Low lod terrain mesh file pair. Extension: .cterrain_pc|.gterrain_pc
+//Read() builds a view of the files without copying them, so the views are only valid while the file buffers are alive.
+//Meshes are found by following the gpu file, which is a sequence of mesh blocks: hash, indices, vertices, hash.
+//The hash of each block identifies its descriptor in the cpu file, which gives the sizes needed to seek to the next block.
+//Descriptors are stored back to back in the cpu file, so only the first one is searched for. The rest are read directly after the previous one.
+//The first has to be searched for since the layout of the data before it isn't known. Only the signature and version of the header are understood
+class TerrainLowLod
+{
+public:
+    static constexpr u32 ExpectedSignature = 1381123412; //ASCII string "TERR"
+    static constexpr u32 ExpectedVersion = 31;
+    //Index and vertex data of each gpu file mesh block start on this alignment
+    static constexpr u64 GpuDataAlignment = 16;
+    //Descriptors start on a 4 byte boundary within this many bytes of the end of the previous one
+    static constexpr u64 MaxDescriptorPadding = 32;
+
+    //Parse a file pair. Throws if the files are malformed
+    void Read(std::span<u8> cpuFile, std::span<u8> gpuFile, const string& name);
+
+    string Name;
+    TerrainLowLodHeader Header;
+    //Usually 9 meshes which are stitched together to form the zones terrain
+    std::vector<TerrainLowLodMesh> Meshes = {};
+    //Parts of the cpu file between the header and mesh descriptors, in file order
+    std::vector<TerrainLowLodSection> Sections = {};
+    //Descriptors that weren't directly after the previous one and had to be searched for. 1 for well formed files
+    u32 DescriptorSearches = 0;
+
+private:
+    //Read the descriptor at descriptorOffset if it belongs to the gpu block at gpuBlockOffset
+    bool ReadDescriptor(std::span<u8> cpuFile, std::span<u8> gpuFile, u64 descriptorOffset, u64 gpuBlockOffset, TerrainLowLodMesh& mesh);
+    //Read the descriptor of the gpu block at gpuBlockOffset from the padding after searchStart. Returns false if it isn't there
+    bool ReadNextDescriptor(std::span<u8> cpuFile, std::span<u8> gpuFile, u64 searchStart, u64 gpuBlockOffset, TerrainLowLodMesh& mesh);
+    //Search the cpu file from searchStart onward for the descriptor of the gpu block at gpuBlockOffset
+    bool FindDescriptor(std::span<u8> cpuFile, std::span<u8> gpuFile, u64 searchStart, u64 gpuBlockOffset, TerrainLowLodMesh& mesh);
+    //Locate the index and vertex data of the mesh block at gpuBlockOffset. Returns the end of the block or 0 if it doesn't fit in the gpu file
+    static u64 GetGpuBlockEnd(std::span<u8> gpuFile, u64 gpuBlockOffset, const MeshDataBlock& info, u64& indicesOffset, u64& verticesOffset);
+    void AddSection(std::span<u8> cpuFile, u64 start, u64 end);
+};
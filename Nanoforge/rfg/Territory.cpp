@@ -3,10 +3,80 @@
 #include "common/filesystem/File.h"
 #include "common/string/String.h"
 #include "Log.h"
+#include "util/ThreadUtil.h"
+#include "util/HashUtil.h"
+#include "TerritorySnapshot.h"
+#include "TerritoryView.h"
+#include <numeric>
 
 //Todo: Separate gui specific code into a different file or class
 #include <IconsFontAwesome5_c.h>
 
+//Object classes with hand picked colors, icons, and default visibility. Classes found in zones that aren't in this list are registered at load
+static const std::vector<ZoneObjectClass>& KnownObjectClasses()
+{
+    static const std::vector<ZoneObjectClass> knownClasses =
+    {
+        {"rfg_mover",                      2898847573, 0, Vec3{ 0.923f, 0.648f, 0.0f }, true ,   false, ICON_FA_HOME " "},
+        {"cover_node",                     3322951465, 0, Vec3{ 1.0f, 0.0f, 0.0f },     false,   false, ICON_FA_SHIELD_ALT " "},
+        {"navpoint",                       4055578105, 0, Vec3{ 1.0f, 0.968f, 0.0f },   false,   false, ICON_FA_LOCATION_ARROW " "},
+        {"general_mover",                  1435016567, 0, Vec3{ 0.738f, 0.0f, 0.0f },   true ,   false, ICON_FA_CUBES  " "},
+        {"player_start",                   1794022917, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_STREET_VIEW " "},
+        {"multi_object_marker",            1332551546, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_MAP_MARKER " "},
+        {"weapon",                         2760055731, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_CROSSHAIRS " "},
+        {"object_action_node",             2017715543, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_RUNNING " "},
+        {"object_squad_spawn_node",        311451949,  0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USERS " "},
+        {"object_npc_spawn_node",          2305434277, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USER " "},
+        {"object_guard_node",              968050919,  0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_SHIELD_ALT " "},
+        {"object_path_road",               3007680500, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_ROAD " "},
+        {"shape_cutter",                   753322256,  0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_CUT " "},
+        {"item",                           27482413,   0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_TOOLS " "},
+        {"object_vehicle_spawn_node",      3057427650, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_CAR_SIDE " "},
+        {"ladder",                         1620465961, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_LEVEL_UP_ALT " "},
+        {"constraint",                     1798059225, 0, Vec3{ 0.958f, 0.0f, 1.0f },   true ,   false, ICON_FA_LOCK " "},
+        {"object_effect",                  2663183315, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_FIRE " "},
+        //Todo: Want a better icon for this one
+        {"trigger_region",                 2367895008, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_BORDER_STYLE " "},
+        {"object_bftp_node",               3005715123, 0, Vec3{ 1.0f, 1.0f, 1.0f },     false,   false, ICON_FA_BOMB " "},
+        {"object_bounding_box",            2575178582, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_BORDER_NONE " "},
+        {"object_turret_spawn_node",       96035668,   0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_CROSSHAIRS " "},
+        //Todo: Want a better icon for this one
+        {"obj_zone",                       3740226015, 0, Vec3{ 0.935f, 0.0f, 1.0f },     true ,   false, ICON_FA_SEARCH_LOCATION " "},
+        {"object_patrol",                  3656745166, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_BINOCULARS " "},
+        {"object_dummy",                   2671133140, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_MEH_BLANK " "},
+        {"object_raid_node",               3006762854, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_CAR_CRASH " "},
+        {"object_delivery_node",           1315235117, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_SHIPPING_FAST " "},
+        {"marauder_ambush_region",         1783727054, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_USER_NINJA " "},
+        {"unknown",                        0, 0,          Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_QUESTION_CIRCLE " "},
+        {"object_activity_spawn",          2219327965, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_SCROLL " "},
+        {"object_mission_start_node",      1536827764, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_MAP_MARKED " "},
+        {"object_demolitions_master_node", 3497250449, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_BOMB " "},
+        {"object_restricted_area",         3157693713, 0, Vec3{ 1.0f, 0.0f, 0.0f },     true ,   true,  ICON_FA_USER_SLASH " "},
+        {"effect_streaming_node",          1742767984, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   true,  ICON_FA_SPINNER " "},
+        {"object_house_arrest_node",       227226529,  0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USER_LOCK " "},
+        {"object_area_defense_node",       2107155776, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USER_SHIELD " "},
+        {"object_safehouse",               3291687510, 0, Vec3{ 0.0f, 0.905f, 1.0f },     true ,   false, ICON_FA_FIST_RAISED " "},
+        {"object_convoy_end_point",        1466427822, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_TRUCK_MOVING " "},
+        {"object_courier_end_point",       3654824104, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_FLAG_CHECKERED " "},
+        {"object_riding_shotgun_node",     1227520137, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_TRUCK_MONSTER " "},
+        {"object_upgrade_node",            2502352132, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_ARROW_UP " "},
+        {"object_ambient_behavior_region", 2407660945, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_TREE " "},
+        {"object_roadblock_node",          2100364527, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   true,  ICON_FA_HAND_PAPER " "},
+        {"object_spawn_region",            1854373986, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   true,  ICON_FA_USER_PLUS " "},
+        {"obj_light",                      2915886275, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   true,  ICON_FA_LIGHTBULB " "}
+    };
+    return knownClasses;
+}
+
+string Territory::GetTerritoryFilename(const string& territoryShortname)
+{
+    //Main campaign zones are in zonescript vpps. The rest are named after the territory
+    if (territoryShortname == "terr01" || territoryShortname == "dlc01")
+        return "zonescript_" + territoryShortname + ".vpp_pc";
+
+    return territoryShortname + ".vpp_pc";
+}
+
 void Territory::Init(PackfileVFS* packfileVFS, const string& territoryFilename, const string& territoryShortname)
 {
     packfileVFS_ = packfileVFS;
@@ -16,21 +86,45 @@ void Territory::Init(PackfileVFS* packfileVFS, const string& territoryFilename,
 
 void Territory::LoadZoneData()
 {
-    //Todo: Add a popup to warn the user that the thread running this is waiting for packfiles to be done loading
-    //Spinlock until all packfiles have been read. This can fail to read zone data if all the packfiles haven't been read.
-    //This should only really happen on slow computers and debug builds.
-    while (!packfileVFS_->Ready())
-    {
+    //Callers should run this in a task with GuiState::PackfileScanTask as a prerequisite
+    if (!packfileVFS_->Ready())
+        THROW_EXCEPTION("Tried to load zone data for {} before the packfile scan finished.", territoryFilename_);
+
+    Log->info("Loading zone data from {}", territoryFilename_);
+    if (!packfileVFS_->GetPackfile(territoryFilename_))
+        THROW_EXCEPTION("Could not find territory file {} in data folder. Required for the program to function.", territoryFilename_);
+
+    //Use snapshot from a previous load if the source files haven't changed. Otherwise parse the zones and write a new snapshot
+    string snapshotPath = TerritorySnapshot::GetPath(territoryFilename_);
+    u64 snapshotKey = GetSnapshotKey();
+    if (LoadZonesFromSnapshot(snapshotPath, snapshotKey))
+        Log->info("Loaded zone data for {} from snapshot", territoryFilename_);
+    else
+        LoadZonesFromPackfiles(snapshotPath, snapshotKey);
 
+    if (ZoneFiles.size() == 0)
+        THROW_EXCEPTION("No zone files found in {}", territoryFilename_);
+
+    //Get zone name with most characters for UI purposes. Really shouldn't be in this class like other UI things
+    u32 longest = 0;
+    for (auto& zone : ZoneFiles)
+    {
+        if (zone.ShortName.length() > longest)
+            longest = (u32)zone.ShortName.length();
     }
+    LongestZoneName = longest;
 
-    Log->info("Loading zone data from {}", territoryFilename_);
+    zoneDataLoaded_ = true;
+}
+
+void Territory::LoadZonesFromPackfiles(const string& snapshotPath, u64 snapshotKey)
+{
     Packfile3* zonescriptVpp = packfileVFS_->GetPackfile(territoryFilename_);
-    if (!zonescriptVpp)
-        THROW_EXCEPTION("Could not find territory file {} in data folder. Required for the program to function.", territoryFilename_);
+
+    //Gather a list of zone files to load first so they can be parsed in parallel. Each zone is independent of the others.
+    std::vector<ZoneLoadJob> jobs = {};
 
     //Todo: Use packfile search functions and also search str2s
-    //Todo: Use caching system
     for (u32 i = 0; i < zonescriptVpp->Entries.size(); i++)
     {
         const char* path = zonescriptVpp->EntryNames[i];
@@ -38,132 +132,305 @@ void Territory::LoadZoneData()
         if (extension != ".rfgzone_pc" && extension != ".layer_pc")
             continue;
 
-        auto fileBuffer = zonescriptVpp->ExtractSingleFile(path);
-        if (!fileBuffer)
-            THROW_EXCEPTION("Failed to extract zone file \"{}\" from \"{}\".", Path::GetFileName(string(path)), territoryFilename_);
+        jobs.push_back({ FileHandle(zonescriptVpp, path), false, false });
+    }
 
-        BinaryReader reader(fileBuffer.value());
-        ZoneData& zoneFile = ZoneFiles.emplace_back();
-        zoneFile.Name = Path::GetFileName(std::filesystem::path(path));
-        zoneFile.Zone.SetName(zoneFile.Name);
-        zoneFile.Zone.Read(reader);
-        zoneFile.Zone.GenerateObjectHierarchy();
-        if (String::StartsWith(zoneFile.Name, "p_"))
-            zoneFile.Persistent = true;
+    //Get mission and activity zones (layer_pc files) if territory has any
+    string missionPackfile, activityPackfile;
+    if (GetLayerPackfiles(missionPackfile, activityPackfile))
+    {
+        for (auto& layerFile : packfileVFS_->GetFiles(missionPackfile, "*.layer_pc", true, false))
+            jobs.push_back({ layerFile, true, false });
+        for (auto& layerFile : packfileVFS_->GetFiles(activityPackfile, "*.layer_pc", true, false))
+            jobs.push_back({ layerFile, false, true });
+    }
 
-        SetZoneShortName(zoneFile);
+    //Zone bytes are allocated by the jobs and must be freed on every path, including when a job throws. ParallelFor() waits for every job before rethrowing so none are still allocating
+    auto freeZoneBytes = [&]()
+    {
+        for (auto& job : jobs)
+        {
+            delete[] job.Bytes.data();
+            job.Bytes = {};
+        }
+    };
 
-        delete[] fileBuffer.value().data();
-    }
+    try
+    {
+        //Parse zones on a bounded set of worker threads. Results are written to their job index so the final order doesn't depend on thread timing
+        std::vector<ZoneData> zones(jobs.size());
+        ParallelFor((u32)jobs.size(), [&](u32 i) { LoadZone(jobs[i], zones[i]); });
+
+        //Sort by object count for convenience. Stable so zones with equal object counts keep their load order.
+        //Sorts indices so each zone can still be matched with its file bytes when writing the snapshot.
+        std::vector<u32> order(zones.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+        [&](u32 a, u32 b)
+        {
+            return zones[a].Zone.Header.NumObjects > zones[b].Zone.Header.NumObjects;
+        });
 
-    //Get mission and activity zones (layer_pc files) if territory has any
-    std::vector<FileHandle> missionLayerFiles = {};
-    std::vector<FileHandle> activityLayerFiles = {};
-    if (String::Contains(territoryFilename_, "terr01"))
+        ZoneFiles.clear();
+        ZoneFiles.reserve(zones.size());
+        std::vector<std::span<u8>> zoneBytes = {};
+        for (u32 i : order)
+        {
+            ZoneFiles.push_back(std::move(zones[i]));
+            zoneBytes.push_back(jobs[i].Bytes);
+        }
+
+        //Init object class data used for filtering and labelling
+        InitObjectClassData();
+        //Build acceleration structure used for picking and other spatial queries
+        BuildObjectBvh();
+
+        if (!TerritorySnapshot::Write(snapshotPath, snapshotKey, ZoneFiles, zoneBytes, ZoneObjectClasses, (u32)KnownObjectClasses().size(), ObjectTable, ObjectBvh))
+            Log->warn("Failed to write zone snapshot for {} to \"{}\"", territoryFilename_, snapshotPath);
+    }
+    catch (...)
     {
-        missionLayerFiles = packfileVFS_->GetFiles("missions.vpp_pc", "*.layer_pc", true, false);
-        activityLayerFiles = packfileVFS_->GetFiles("activities.vpp_pc", "*.layer_pc", true, false);
+        freeZoneBytes();
+        throw;
     }
-    else if (String::Contains(territoryFilename_, "dlc01"))
+
+    freeZoneBytes();
+}
+
+//Recreate count hierarchy nodes starting at nodes[next] and append them to output. Returns the index of the node after the last one used
+static size_t RestoreObjectHierarchy(std::vector<ZoneObject36>& objects, std::span<const ZoneHierarchyNode> nodes, size_t next, u32 count, std::vector<ZoneObjectNode36>& output)
+{
+    output.reserve(output.size() + count);
+    for (u32 i = 0; i < count; i++)
     {
-        missionLayerFiles = packfileVFS_->GetFiles("dlcp01_missions.vpp_pc", "*.layer_pc", true, false);
-        activityLayerFiles = packfileVFS_->GetFiles("dlcp01_activities.vpp_pc", "*.layer_pc", true, false);
+        const ZoneHierarchyNode& stored = nodes[next++];
+        ZoneObjectNode36& node = output.emplace_back(&objects[stored.Object]);
+        next = RestoreObjectHierarchy(objects, nodes, next, stored.NumChildren, node.Children);
     }
+    return next;
+}
+
+bool Territory::LoadZonesFromSnapshot(const string& snapshotPath, u64 snapshotKey)
+{
+    TerritorySnapshot snapshot;
+    if (!snapshot.Open(snapshotPath, snapshotKey))
+        return false;
+
+    //Restore class list in the same order it was registered in when the snapshot was written so the cached class indices are valid
+    RegisterKnownObjectClasses();
+    for (auto& objectClass : snapshot.GetUnknownClasses())
+        RegisterObjectClass({ objectClass.Name, objectClass.Hash, 0, Vec3{ 1.0f, 1.0f, 1.0f }, true });
 
-    //Load mission zones
-    for (auto& layerFile : missionLayerFiles)
+    u32 numZones = snapshot.NumZones();
+    if (numZones == 0 || snapshot.GetZone(0).ClassInstanceCounts.size() != ZoneObjectClasses.size())
     {
-        auto fileBuffer = layerFile.Get();
-        BinaryReader reader(fileBuffer);
-
-        ZoneData& zoneFile = ZoneFiles.emplace_back();
-        zoneFile.Name = Path::GetFileNameNoExtension(layerFile.ContainerName()) + " - " + Path::GetFileNameNoExtension(layerFile.Filename()).substr(7);
-        zoneFile.Zone.SetName(zoneFile.Name);
-        zoneFile.Zone.Read(reader);
-        zoneFile.Zone.GenerateObjectHierarchy();
-        zoneFile.MissionLayer = true;
-        zoneFile.ActivityLayer = false;
-        if (String::StartsWith(zoneFile.Name, "p_"))
-            zoneFile.Persistent = true;
-
-        SetZoneShortName(zoneFile);
-        delete[] fileBuffer.data();
+        ResetTerritoryData();
+        return false;
     }
 
-    //Load activity zones
-    for (auto& layerFile : activityLayerFiles)
+    //Zones are stored pre-sorted. Parse them straight from the mapped file, skipping packfile extraction
+    try
     {
-        auto fileBuffer = layerFile.Get();
-        BinaryReader reader(fileBuffer);
-
-        ZoneData& zoneFile = ZoneFiles.emplace_back();
-        zoneFile.Name = Path::GetFileNameNoExtension(layerFile.ContainerName()) + " - " + Path::GetFileNameNoExtension(layerFile.Filename()).substr(7);
-        zoneFile.Zone.SetName(zoneFile.Name);
-        zoneFile.Zone.Read(reader);
-        zoneFile.Zone.GenerateObjectHierarchy();
-        zoneFile.MissionLayer = false;
-        zoneFile.ActivityLayer = true;
-        if (String::StartsWith(zoneFile.Name, "p_"))
-            zoneFile.Persistent = true;
-
-        SetZoneShortName(zoneFile);
-        delete[] fileBuffer.data();
+        ZoneFiles.resize(numZones);
+        ParallelFor(numZones, [&](u32 i)
+        {
+            ZoneSnapshotView view = snapshot.GetZone(i);
+            ZoneData& zone = ZoneFiles[i];
+            zone.Name = view.Name;
+            zone.ShortName = view.ShortName;
+            zone.Persistent = view.Persistent;
+            zone.MissionLayer = view.MissionLayer;
+            zone.ActivityLayer = view.ActivityLayer;
+
+            BinaryReader reader(view.ZoneBytes);
+            zone.Zone.SetName(zone.Name);
+            zone.Zone.Read(reader);
+            if (zone.Zone.Objects.size() != view.ObjectClassIndices.size())
+                THROW_EXCEPTION("Object count mismatch in snapshot zone {}", zone.Name);
+
+            //Node indices were validated against the object count when the snapshot was opened
+            for (size_t next = 0; next < view.Hierarchy.size();)
+                next = RestoreObjectHierarchy(zone.Zone.Objects, view.Hierarchy, next, 1, zone.Zone.ObjectsHierarchical);
+
+            zone.ObjectClassIndices.assign(view.ObjectClassIndices.begin(), view.ObjectClassIndices.end());
+            zone.ClassInstanceCounts.assign(view.ClassInstanceCounts.begin(), view.ClassInstanceCounts.end());
+        });
+    }
+    catch (std::exception& ex)
+    {
+        Log->warn("Failed to load zone snapshot \"{}\". Loading zones from packfiles instead. Error: {}", snapshotPath, ex.what());
+        ResetTerritoryData();
+        return false;
     }
 
-    //Sort vector by object count for convenience
-    std::sort(ZoneFiles.begin(), ZoneFiles.end(),
-    [](const ZoneData& a, const ZoneData& b)
+    UpdateObjectClassInstanceCounts();
+
+    //Restore the object table and BVH instead of rebuilding them. Rebuilt if the stored BVH is malformed
+    snapshot.ReadObjectTable(ObjectTable);
+    if (snapshot.ReadObjectBvh(ObjectBvh, GetObjectBounds()))
+        ObjectBoundsVersion++;
+    else
+        BuildObjectBvh();
+
+    return true;
+}
+
+void Territory::LoadZone(ZoneLoadJob& job, ZoneData& zoneFile)
+{
+    //Zones in the territory vpp are extracted directly. Mission and activity layers are inside str2_pc files
+    job.Bytes = job.File.Get();
+    BinaryReader reader(job.Bytes);
+
+    if (job.MissionLayer || job.ActivityLayer)
+        zoneFile.Name = Path::GetFileNameNoExtension(job.File.ContainerName()) + " - " + Path::GetFileNameNoExtension(job.File.Filename()).substr(7);
+    else
+        zoneFile.Name = Path::GetFileName(std::filesystem::path(job.File.Filename()));
+
+    zoneFile.Zone.SetName(zoneFile.Name);
+    zoneFile.Zone.Read(reader);
+    zoneFile.Zone.GenerateObjectHierarchy();
+    zoneFile.MissionLayer = job.MissionLayer;
+    zoneFile.ActivityLayer = job.ActivityLayer;
+    if (String::StartsWith(zoneFile.Name, "p_"))
+        zoneFile.Persistent = true;
+
+    SetZoneShortName(zoneFile);
+}
+
+bool Territory::GetLayerPackfiles(string& outMissionPackfile, string& outActivityPackfile)
+{
+    if (String::Contains(territoryFilename_, "terr01"))
     {
-        return a.Zone.Header.NumObjects > b.Zone.Header.NumObjects;
-    });
-    //Get zone name with most characters for UI purposes. Really shouldn't be in this class like other UI things
-    u32 longest = 0;
-    for (auto& zone : ZoneFiles)
+        outMissionPackfile = "missions.vpp_pc";
+        outActivityPackfile = "activities.vpp_pc";
+        return true;
+    }
+    else if (String::Contains(territoryFilename_, "dlc01"))
     {
-        if (zone.ShortName.length() > longest)
-            longest = (u32)zone.ShortName.length();
+        outMissionPackfile = "dlcp01_missions.vpp_pc";
+        outActivityPackfile = "dlcp01_activities.vpp_pc";
+        return true;
     }
-    LongestZoneName = longest;
 
+    return false;
+}
+
+u64 Territory::GetSnapshotKey()
+{
+    //Keyed by the entry tables of the source packfiles. They're already in memory so this is nearly free, unlike hashing the packfiles or the zones in them.
+    //Packfile entries don't store a checksum, so an edit that keeps every entries offset, size, and compressed size the same isn't detected.
+    //Edited zones change size in practice, and the compressed size of compressed packfiles changes with any edit
+    std::vector<string> sourcePackfiles = { territoryFilename_ };
+    string missionPackfile, activityPackfile;
+    if (GetLayerPackfiles(missionPackfile, activityPackfile))
+    {
+        sourcePackfiles.push_back(missionPackfile);
+        sourcePackfiles.push_back(activityPackfile);
+    }
 
-    //Make first zone visible for convenience when debugging
-    ZoneFiles[0].RenderBoundingBoxes = true;
-    //Init object class data used for filtering and labelling
-    InitObjectClassData();
+    u64 key = HashUtil::Fnv1a64(territoryShortname_);
+    for (auto& packfileName : sourcePackfiles)
+    {
+        //Missing packfiles hash as empty so the key changes if they're added later
+        Packfile3* packfile = packfileVFS_->GetPackfile(packfileName);
+        u64 numEntries = packfile ? packfile->Entries.size() : 0;
+        key = HashUtil::Fnv1a64(packfileName, key);
+        key = HashUtil::Fnv1a64Value(numEntries, key);
+        for (u64 i = 0; i < numEntries; i++)
+        {
+            //Layer zones are inside str2_pc files, so every entry is hashed rather than only the zones
+            const Packfile3Entry& entry = packfile->Entries[i];
+            key = HashUtil::Fnv1a64(packfile->EntryNames[i], key);
+            key = HashUtil::Fnv1a64Value(entry.DataOffset, key);
+            key = HashUtil::Fnv1a64Value(entry.DataSize, key);
+            key = HashUtil::Fnv1a64Value(entry.CompressedDataSize, key);
+        }
+    }
 
-    zoneDataLoaded_ = true;
+    //Class indices in the snapshot depend on the known class list
+    for (auto& objectClass : KnownObjectClasses())
+    {
+        key = HashUtil::Fnv1a64(objectClass.Name, key);
+        key = HashUtil::Fnv1a64Value(objectClass.Hash, key);
+    }
+
+    return key;
 }
 
 void Territory::ResetTerritoryData()
 {
     ZoneFiles.clear();
-    ZoneObjectClasses.clear();;
+    ZoneObjectClasses.clear();
+    classTableHashes_.clear();
+    classTableIndices_.clear();
+    ObjectBvh.Clear();
+    ObjectTable.Clear();
+}
+
+bool Territory::ObjectClassRegistered(u32 classnameHash, u32& outIndex)
+{
+    outIndex = GetObjectClassIndex(classnameHash);
+    return outIndex != InvalidZoneIndex;
 }
 
-bool Territory::ShouldShowObjectClass(u32 classnameHash)
+u32 Territory::GetObjectClassIndex(u32 classnameHash)
 {
-    for (const auto& objectClass : ZoneObjectClasses)
+    if (classTableIndices_.size() == 0)
+        return InvalidZoneIndex;
+
+    //Probe from the hashes home slot until a match or an empty slot is found
+    u32 mask = (u32)classTableIndices_.size() - 1;
+    for (u32 slot = classnameHash & mask; ; slot = (slot + 1) & mask)
     {
-        if (objectClass.Hash == classnameHash)
-            return objectClass.Show;
+        u32 index = classTableIndices_[slot];
+        if (index == InvalidZoneIndex)
+            return InvalidZoneIndex;
+        if (classTableHashes_[slot] == classnameHash)
+            return index;
     }
-    return true;
 }
 
-bool Territory::ObjectClassRegistered(u32 classnameHash, u32& outIndex)
+u32 Territory::RegisterObjectClass(const ZoneObjectClass& objectClass)
 {
-    outIndex = InvalidZoneIndex;
-    u32 i = 0;
-    for (const auto& objectClass : ZoneObjectClasses)
+    //Class indices are stored as u16 in ZoneData::ObjectClassIndices, ZoneObjectTable::ClassIndex and territory snapshots
+    if (ZoneObjectClasses.size() >= UINT16_MAX)
+        THROW_EXCEPTION("Too many object classes in {}. Class indices are limited to {}", territoryFilename_, UINT16_MAX);
+
+    u32 index = (u32)ZoneObjectClasses.size();
+    ZoneObjectClasses.push_back(objectClass);
+
+    //Grow table once it's half full to keep probe sequences short. Rebuilding also inserts the new class
+    if (ZoneObjectClasses.size() * 2 > classTableIndices_.size())
     {
-        if (objectClass.Hash == classnameHash)
-        {
-            outIndex = i;
-            return true;
-        }
-        i++;
+        RebuildObjectClassTable(std::max((u32)classTableIndices_.size() * 2, 64u));
+        return index;
+    }
+
+    u32 mask = (u32)classTableIndices_.size() - 1;
+    u32 slot = objectClass.Hash & mask;
+    while (classTableIndices_[slot] != InvalidZoneIndex)
+        slot = (slot + 1) & mask;
+
+    classTableHashes_[slot] = objectClass.Hash;
+    classTableIndices_[slot] = index;
+    return index;
+}
+
+void Territory::RebuildObjectClassTable(u32 capacity)
+{
+    classTableHashes_.assign(capacity, 0);
+    classTableIndices_.assign(capacity, InvalidZoneIndex);
+
+    u32 mask = capacity - 1;
+    for (u32 i = 0; i < ZoneObjectClasses.size(); i++)
+    {
+        u32 slot = ZoneObjectClasses[i].Hash & mask;
+        while (classTableIndices_[slot] != InvalidZoneIndex)
+            slot = (slot + 1) & mask;
+
+        classTableHashes_[slot] = ZoneObjectClasses[i].Hash;
+        classTableIndices_[slot] = i;
     }
-    return false;
 }
 
 void Territory::UpdateObjectClassInstanceCounts()
@@ -172,113 +439,138 @@ void Territory::UpdateObjectClassInstanceCounts()
     for (auto& objectClass : ZoneObjectClasses)
         objectClass.NumInstances = 0;
 
-    //Update instance count for each object class in visible zones
+    //Sum per zone class counts
     for (auto& zoneFile : ZoneFiles)
-    {
-        if (!zoneFile.RenderBoundingBoxes)
-            continue;
-
-        auto& zone = zoneFile.Zone;
-        for (auto& object : zone.Objects)
-        {
-            for (auto& objectClass : ZoneObjectClasses)
-            {
-                if (objectClass.Hash == object.ClassnameHash)
-                {
-                    objectClass.NumInstances++;
-                    break;
-                }
-            }
-        }
-    }
+        for (u32 i = 0; i < zoneFile.ClassInstanceCounts.size(); i++)
+            ZoneObjectClasses[i].NumInstances += zoneFile.ClassInstanceCounts[i];
+}
 
-    //Sort vector by instance count for convenience
-    std::sort(ZoneObjectClasses.begin(), ZoneObjectClasses.end(),
-    [](const ZoneObjectClass& a, const ZoneObjectClass& b)
-    {
-        return a.NumInstances > b.NumInstances;
-    });
+void Territory::RegisterKnownObjectClasses()
+{
+    ZoneObjectClasses.clear();
+    RebuildObjectClassTable(128);
+    for (auto& objectClass : KnownObjectClasses())
+        RegisterObjectClass(objectClass);
 }
 
 void Territory::InitObjectClassData()
 {
-    ZoneObjectClasses =
-    {
-        {"rfg_mover",                      2898847573, 0, Vec3{ 0.923f, 0.648f, 0.0f }, true ,   false, ICON_FA_HOME " "},
-        {"cover_node",                     3322951465, 0, Vec3{ 1.0f, 0.0f, 0.0f },     false,   false, ICON_FA_SHIELD_ALT " "},
-        {"navpoint",                       4055578105, 0, Vec3{ 1.0f, 0.968f, 0.0f },   false,   false, ICON_FA_LOCATION_ARROW " "},
-        {"general_mover",                  1435016567, 0, Vec3{ 0.738f, 0.0f, 0.0f },   true ,   false, ICON_FA_CUBES  " "},
-        {"player_start",                   1794022917, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_STREET_VIEW " "},
-        {"multi_object_marker",            1332551546, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_MAP_MARKER " "},
-        {"weapon",                         2760055731, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_CROSSHAIRS " "},
-        {"object_action_node",             2017715543, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_RUNNING " "},
-        {"object_squad_spawn_node",        311451949,  0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USERS " "},
-        {"object_npc_spawn_node",          2305434277, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USER " "},
-        {"object_guard_node",              968050919,  0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_SHIELD_ALT " "},
-        {"object_path_road",               3007680500, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_ROAD " "},
-        {"shape_cutter",                   753322256,  0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_CUT " "},
-        {"item",                           27482413,   0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_TOOLS " "},
-        {"object_vehicle_spawn_node",      3057427650, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_CAR_SIDE " "},
-        {"ladder",                         1620465961, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_LEVEL_UP_ALT " "},
-        {"constraint",                     1798059225, 0, Vec3{ 0.958f, 0.0f, 1.0f },   true ,   false, ICON_FA_LOCK " "},
-        {"object_effect",                  2663183315, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_FIRE " "},
-        //Todo: Want a better icon for this one
-        {"trigger_region",                 2367895008, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_BORDER_STYLE " "},
-        {"object_bftp_node",               3005715123, 0, Vec3{ 1.0f, 1.0f, 1.0f },     false,   false, ICON_FA_BOMB " "},
-        {"object_bounding_box",            2575178582, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_BORDER_NONE " "},
-        {"object_turret_spawn_node",       96035668,   0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_CROSSHAIRS " "},
-        //Todo: Want a better icon for this one
-        {"obj_zone",                       3740226015, 0, Vec3{ 0.935f, 0.0f, 1.0f },     true ,   false, ICON_FA_SEARCH_LOCATION " "},
-        {"object_patrol",                  3656745166, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_BINOCULARS " "},
-        {"object_dummy",                   2671133140, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_MEH_BLANK " "},
-        {"object_raid_node",               3006762854, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_CAR_CRASH " "},
-        {"object_delivery_node",           1315235117, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_SHIPPING_FAST " "},
-        {"marauder_ambush_region",         1783727054, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_USER_NINJA " "},
-        {"unknown",                        0, 0,          Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_QUESTION_CIRCLE " "},
-        {"object_activity_spawn",          2219327965, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_SCROLL " "},
-        {"object_mission_start_node",      1536827764, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_MAP_MARKED " "},
-        {"object_demolitions_master_node", 3497250449, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_BOMB " "},
-        {"object_restricted_area",         3157693713, 0, Vec3{ 1.0f, 0.0f, 0.0f },     true ,   true,  ICON_FA_USER_SLASH " "},
-        {"effect_streaming_node",          1742767984, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   true,  ICON_FA_SPINNER " "},
-        {"object_house_arrest_node",       227226529,  0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USER_LOCK " "},
-        {"object_area_defense_node",       2107155776, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_USER_SHIELD " "},
-        {"object_safehouse",               3291687510, 0, Vec3{ 0.0f, 0.905f, 1.0f },     true ,   false, ICON_FA_FIST_RAISED " "},
-        {"object_convoy_end_point",        1466427822, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_TRUCK_MOVING " "},
-        {"object_courier_end_point",       3654824104, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_FLAG_CHECKERED " "},
-        {"object_riding_shotgun_node",     1227520137, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_TRUCK_MONSTER " "},
-        {"object_upgrade_node",            2502352132, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   false, ICON_FA_ARROW_UP " "},
-        {"object_ambient_behavior_region", 2407660945, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   false, ICON_FA_TREE " "},
-        {"object_roadblock_node",          2100364527, 0, Vec3{ 0.25f, 0.177f, 1.0f },  false,   true,  ICON_FA_HAND_PAPER " "},
-        {"object_spawn_region",            1854373986, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   true,  ICON_FA_USER_PLUS " "},
-        {"obj_light",                      2915886275, 0, Vec3{ 1.0f, 1.0f, 1.0f },     true ,   true,  ICON_FA_LIGHTBULB " "}
-    };
+    RegisterKnownObjectClasses();
 
+    //Cache the class index of each object, count instances of each class per zone, and register any unknown classes
     for (auto& zone : ZoneFiles)
     {
-        for (auto& object : zone.Zone.Objects)
+        zone.ObjectClassIndices.resize(zone.Zone.Objects.size());
+        zone.ClassInstanceCounts.assign(ZoneObjectClasses.size(), 0);
+        for (u32 i = 0; i < zone.Zone.Objects.size(); i++)
         {
-            u32 outIndex = InvalidZoneIndex;
-            if (!ObjectClassRegistered(object.ClassnameHash, outIndex))
+            auto& object = zone.Zone.Objects[i];
+            u32 classIndex = GetObjectClassIndex(object.ClassnameHash);
+            if (classIndex == InvalidZoneIndex)
             {
-                ZoneObjectClasses.push_back({ object.Classname, object.ClassnameHash, 0, Vec3{ 1.0f, 1.0f, 1.0f }, true });
+                classIndex = RegisterObjectClass({ object.Classname, object.ClassnameHash, 0, Vec3{ 1.0f, 1.0f, 1.0f }, true });
+                zone.ClassInstanceCounts.resize(ZoneObjectClasses.size(), 0);
                 Log->warn("Found unknown object class with hash {} and name \"{}\"", object.ClassnameHash, object.Classname);
             }
+            zone.ObjectClassIndices[i] = (u16)classIndex; //Fits, see RegisterObjectClass()
+            zone.ClassInstanceCounts[classIndex]++;
         }
     }
+
+    //Classes found in later zones are missing from the count vectors of earlier zones
+    for (auto& zone : ZoneFiles)
+        zone.ClassInstanceCounts.resize(ZoneObjectClasses.size(), 0);
+
+    UpdateObjectClassInstanceCounts();
 }
 
 ZoneObjectClass& Territory::GetObjectClass(u32 classnameHash)
 {
-    for (auto& objectClass : ZoneObjectClasses)
-    {
-        if (objectClass.Hash == classnameHash)
-            return objectClass;
-    }
+    u32 index = GetObjectClassIndex(classnameHash);
+    if (index != InvalidZoneIndex)
+        return ZoneObjectClasses[index];
 
     //Todo: Handle case of invalid hash. Returning std::optional would work
     THROW_EXCEPTION("Failed to find object class with classname hash {}", classnameHash);
 }
 
+void Territory::BuildObjectBvh()
+{
+    ObjectTable.Build(ZoneFiles);
+    std::vector<Aabb> bounds = GetObjectBounds();
+    ObjectBvh.Build(bounds);
+    ObjectBoundsVersion++;
+    Log->info("Built object BVH for {} with {} objects", territoryFilename_, bounds.size());
+}
+
+void Territory::RefitObjectBvh()
+{
+    ObjectTable.UpdateBounds(ZoneFiles);
+    ObjectBvh.Refit(GetObjectBounds());
+    ObjectBoundsVersion++;
+}
+
+void Territory::GetVisibleObjectsMask(const TerritoryView& view, std::vector<u8>& mask) const
+{
+    ObjectTable.ResetMask(mask);
+    ObjectTable.FilterZones(view.ZoneMask(), mask);
+    ObjectTable.FilterClasses(view.ClassMask(), mask);
+}
+
+void Territory::ObjectsInFrustum(const Frustum& frustum, std::vector<ZoneObjectRef>& output) const
+{
+    std::vector<u32> primitives = {};
+    ObjectBvh.QueryFrustum(frustum, primitives);
+    ToObjectRefs(primitives, output);
+}
+
+void Territory::ObjectsInBox(const Aabb& box, std::vector<ZoneObjectRef>& output) const
+{
+    std::vector<u32> primitives = {};
+    ObjectBvh.QueryBox(box, primitives);
+    ToObjectRefs(primitives, output);
+}
+
+void Territory::ObjectsInSphere(const Vec3& center, f32 radius, std::vector<ZoneObjectRef>& output) const
+{
+    std::vector<u32> primitives = {};
+    ObjectBvh.QuerySphere(center, radius, primitives);
+    ToObjectRefs(primitives, output);
+}
+
+std::optional<ZoneObjectRef> Territory::RaycastObjects(const Ray& ray, const TerritoryView& view, f32 maxDistance) const
+{
+    auto filter = [&](u32 row)
+    {
+        return view.ObjectVisible(ObjectTable.Zone[row], ObjectTable.ClassIndex[row]);
+    };
+
+    std::optional<BvhRayHit> hit = ObjectBvh.Raycast(ray, maxDistance, filter);
+    if (!hit)
+        return {};
+
+    u32 row = hit.value().Primitive;
+    return ZoneObjectRef{ ObjectTable.Zone[row], ObjectTable.Object[row] };
+}
+
+std::vector<Aabb> Territory::GetObjectBounds() const
+{
+    std::vector<Aabb> bounds(ObjectTable.Size());
+    for (u32 i = 0; i < bounds.size(); i++)
+    {
+        bounds[i].Min = { ObjectTable.MinX[i], ObjectTable.MinY[i], ObjectTable.MinZ[i] };
+        bounds[i].Max = { ObjectTable.MaxX[i], ObjectTable.MaxY[i], ObjectTable.MaxZ[i] };
+    }
+    return bounds;
+}
+
+void Territory::ToObjectRefs(const std::vector<u32>& rows, std::vector<ZoneObjectRef>& output) const
+{
+    output.reserve(output.size() + rows.size());
+    for (u32 row : rows)
+        output.push_back({ ObjectTable.Zone[row], ObjectTable.Object[row] });
+}
+
 void Territory::SetZoneShortName(ZoneData& zone)
 {
     const string& fullName = zone.Name;
@@ -1,8 +1,13 @@
 #pragma once
 #include "common/Typedefs.h"
 #include "PackfileVFS.h"
+#include "util/Bvh.h"
+#include "ZoneObjectTable.h"
 #include <RfgTools++\formats\zones\ZonePc36.h>
 #include <RfgTools++\types\Vec4.h>
+#include <optional>
+
+class TerritoryView;
 
 //Wrapper around ZonePc36 used by Territory
 struct ZoneData
@@ -10,10 +15,14 @@ struct ZoneData
     string Name;
     string ShortName;
     ZonePc36 Zone;
-    bool RenderBoundingBoxes = false;
     bool Persistent = false;
     bool MissionLayer = false; //If true the zone is from a mission layer file
     bool ActivityLayer = false; //If true the zone is from a activity layer file
+    //Index into Territory::ZoneObjectClasses for each object in Zone.Objects. Cached at load so per object class lookups are an array access.
+    //u16 to keep the per object columns small. RegisterObjectClass() throws if the class count would overflow it
+    std::vector<u16> ObjectClassIndices = {};
+    //Number of objects of each class in this zone, indexed the same as Territory::ZoneObjectClasses
+    std::vector<u32> ClassInstanceCounts = {};
 };
 
 //Used by Territory to filter objects list by class type
@@ -21,54 +30,125 @@ struct ZoneObjectClass
 {
     string Name;
     u32 Hash = 0;
+    //Instances of the class in every zone of the territory. TerritoryView tracks the count for visible zones
     u32 NumInstances = 0;
-    //Todo: This is mixing ui logic with data. I'd like to separate this stuff out of Territory if possible
-    Vec3 Color = { 1.0f, 1.0f, 1.0f };
-    bool Show = true;
-    bool ShowLabel = false;
+    //Filter settings new TerritoryViews start with
+    Vec3 DefaultColor = { 1.0f, 1.0f, 1.0f };
+    bool DefaultShow = true;
+    bool DefaultShowLabel = false;
     const char* LabelIcon = "";
 };
 
+//A zone file queued for loading by Territory::LoadZoneData()
+struct ZoneLoadJob
+{
+    FileHandle File;
+    bool MissionLayer = false;
+    bool ActivityLayer = false;
+    //Zone file contents. Kept after parsing so they can be written to the territory snapshot. Freed by LoadZoneData()
+    std::span<u8> Bytes = {};
+};
+
 constexpr u32 InvalidZoneIndex = 0xFFFFFFFF;
 
+//Reference to an object in Territory::ZoneFiles. Used to map Territory::ObjectBvh primitives back to zone objects
+struct ZoneObjectRef
+{
+    u32 Zone = InvalidZoneIndex; //Index into Territory::ZoneFiles
+    u32 Object = InvalidZoneIndex; //Index into ZoneData::Zone.Objects
+};
+
 //Loads all zone files for a territory and tracks info about them and their contents
 class Territory
 {
 public:
+    //Get the vpp_pc that holds a territories zone files from its short name. E.g. terr01 -> zonescript_terr01.vpp_pc
+    static string GetTerritoryFilename(const string& territoryShortname);
     //Set values needed for it to function
     void Init(PackfileVFS* packfileVFS, const string& territoryFilename, const string& territoryShortname);
-    //Load all zone files and gather info about them
+    //Load all zone files and gather info about them. Must not be called until PackfileVFS is ready
     void LoadZoneData();
     //Reset / clear data in preparation for territory reload
     void ResetTerritoryData();
     //Returns true if zone data has been loaded and is ready for use
     bool Ready() { return zoneDataLoaded_; }
 
-    //Whether or not this object should be shown based on filtering settings
-    bool ShouldShowObjectClass(u32 classnameHash);
     //Checks if a object class is in the selected zones class list
     bool ObjectClassRegistered(u32 classnameHash, u32& outIndex);
-    //Update number of instances of each object class for visible zones
+    //Get index of object class in ZoneObjectClasses. Returns InvalidZoneIndex if the class isn't registered
+    u32 GetObjectClassIndex(u32 classnameHash);
+    //Recalculate number of instances of each object class in every zone
     void UpdateObjectClassInstanceCounts();
     //Scans all zone objects for any object class types that aren't known. Used for filtering and coloring purposes
     void InitObjectClassData();
     ZoneObjectClass& GetObjectClass(u32 classnameHash);
+    //Get class of an object using the class index cached at load time
+    ZoneObjectClass& GetObjectClass(const ZoneData& zone, u32 objectIndex) { return ZoneObjectClasses[zone.ObjectClassIndices[objectIndex]]; }
+
+    //Get the index of an object in zone.Zone.Objects
+    u32 GetObjectIndex(const ZoneData& zone, const ZoneObject36* object) const { return (u32)(object - zone.Zone.Objects.data()); }
+
+    //Build ObjectTable and the bounding volume hierarchy over the bounding boxes of every zone object. Used by the spatial queries below
+    void BuildObjectBvh();
+    //Update ObjectTable bounds and the object BVH after objects move. Much cheaper than rebuilding it. Objects must not have been added or removed
+    void RefitObjectBvh();
+    //Get a mask of ObjectTable rows that are in zones and have a class visible in view
+    void GetVisibleObjectsMask(const TerritoryView& view, std::vector<u8>& mask) const;
+    //Spatial queries over all zone objects. Results are appended to output. These don't apply visibility filters
+    void ObjectsInFrustum(const Frustum& frustum, std::vector<ZoneObjectRef>& output) const;
+    void ObjectsInBox(const Aabb& box, std::vector<ZoneObjectRef>& output) const;
+    void ObjectsInSphere(const Vec3& center, f32 radius, std::vector<ZoneObjectRef>& output) const;
+    //Get the closest object hit by the ray. Only considers objects in zones visible in view whose class is shown. Used for viewport picking
+    std::optional<ZoneObjectRef> RaycastObjects(const Ray& ray, const TerritoryView& view, f32 maxDistance = std::numeric_limits<f32>::max()) const;
 
     std::vector<ZoneData> ZoneFiles;
+    //Note: Classes are never reordered once registered so their indices stay valid. Use TerritoryView::ClassDisplayOrder for sorted iteration
     std::vector<ZoneObjectClass> ZoneObjectClasses = {};
 
     u32 LongestZoneName = 0;
 
+    //Packed copy of frequently accessed object fields for fast filtering
+    ZoneObjectTable ObjectTable;
+    //Bounding volume hierarchy over every zone object. Primitive indices are ObjectTable rows
+    Bvh ObjectBvh;
+    //Incremented whenever ObjectTable is rebuilt or its bounds change. Lets views cache geometry built from object bounds
+    u32 ObjectBoundsVersion = 0;
+
 private:
+    //Extract and parse every zone file from the territory and layer packfiles then write a snapshot of the results
+    void LoadZonesFromPackfiles(const string& snapshotPath, u64 snapshotKey);
+    //Load zones from a snapshot written by a previous load. Returns false if there's no valid snapshot for the current source files
+    bool LoadZonesFromSnapshot(const string& snapshotPath, u64 snapshotKey);
+    //Extract and parse a single zone file. Called from worker threads so it must only write to job and zoneFile
+    void LoadZone(ZoneLoadJob& job, ZoneData& zoneFile);
+    //Get the packfiles that hold mission and activity layer zones for this territory. Returns false if it has none
+    bool GetLayerPackfiles(string& outMissionPackfile, string& outActivityPackfile);
+    //Hash of the entry tables of the source packfiles and anything else that affects snapshot contents. Snapshots with a different key are stale
+    u64 GetSnapshotKey();
+    //Reset ZoneObjectClasses and the classname hash table to the list of known object classes
+    void RegisterKnownObjectClasses();
     //Determine short name for zone if possible. E.g. terr01_07_02.rfgzone_pc -> 07_02
     //Goal is to hide unecessary info such as the territory, prefix, and extension where possible
     //Still has full name for situations where that info is useful or for users who prefer that format
     //Note: Assumes persistence prefix "p_" has already been checked for and that Name has already been set.
     void SetZoneShortName(ZoneData& zone);
+    //Add a class to ZoneObjectClasses and the classname hash table. Returns the class index
+    u32 RegisterObjectClass(const ZoneObjectClass& objectClass);
+    //Rebuild classname hash table from ZoneObjectClasses. Grows the table to keep the load factor at or below 50%
+    void RebuildObjectClassTable(u32 capacity);
+    //Get the bounds of every row in ObjectTable
+    std::vector<Aabb> GetObjectBounds() const;
+    //Convert object BVH query results to zone object references
+    void ToObjectRefs(const std::vector<u32>& primitives, std::vector<ZoneObjectRef>& output) const;
 
     PackfileVFS* packfileVFS_ = nullptr;
     //Name of the vpp_pc file that zone data is loaded from at startup
     string territoryFilename_;
     string territoryShortname_;
     bool zoneDataLoaded_ = false;
+
+    //Open addressed hash table (linear probing) mapping classname hashes to indices in ZoneObjectClasses
+    //Size is always a power of 2. Empty slots have an index of InvalidZoneIndex
+    std::vector<u32> classTableHashes_ = {};
+    std::vector<u32> classTableIndices_ = {};
 };
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "TerritoryRegistry.h"
+#include "Log.h"
+
+void TerritoryRegistry::Init(PackfileVFS* packfileVFS, TaskGraph* tasks)
+{
+    packfileVFS_ = packfileVFS;
+    tasks_ = tasks;
+}
+
+Handle<Territory> TerritoryRegistry::Acquire(const string& territoryFilename, const string& territoryShortname, Handle<Task> prerequisite, Handle<Task>& outLoadTask)
+{
+    //Reuse loaded or loading territory. Failed loads are retried
+    auto search = entries_.find(territoryFilename);
+    if (search != entries_.end() && !search->second.LoadTask->Failed())
+    {
+        Entry& entry = search->second;
+        entry.Unused = false;
+        outLoadTask = entry.LoadTask;
+        return entry.Territory;
+    }
+
+    //Terrain of a failed load never started since its prerequisite failed
+    Entry& entry = entries_[territoryFilename];
+    entry.Terrain = nullptr;
+    entry.Territory = CreateHandle<Territory>();
+    entry.Territory->Init(packfileVFS_, territoryFilename, territoryShortname);
+    entry.Unused = false;
+
+    Handle<Territory> territory = entry.Territory;
+    entry.LoadTask = tasks_->AddTask("Load zones for " + territoryFilename, [territory]() { territory->LoadZoneData(); }, { prerequisite });
+    outLoadTask = entry.LoadTask;
+    return territory;
+}
+
+Handle<TerritoryTerrain> TerritoryRegistry::AcquireTerrain(const string& territoryFilename)
+{
+    Entry& entry = entries_.at(territoryFilename);
+    if (entry.Terrain && entry.Terrain->Cancelled())
+    {
+        //Loading was stopped when the last document using the terrain closed. Start over once the old pipeline exits
+        entry.Terrain->LoadTask->Wait();
+        entry.Terrain = nullptr;
+    }
+    if (!entry.Terrain)
+    {
+        entry.Terrain = CreateHandle<TerritoryTerrain>();
+        entry.Terrain->Load(territoryFilename, entry.Territory.get(), packfileVFS_, tasks_, entry.LoadTask);
+    }
+
+    entry.Unused = false;
+    return entry.Terrain;
+}
+
+void TerritoryRegistry::Update()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::erase_if(entries_, [&](auto& pair)
+    {
+        Entry& entry = pair.second;
+
+        //Stop loading terrain once no document is using it
+        if (entry.Terrain && entry.Terrain.use_count() == 1 && !entry.Terrain->LoadTask->Completed())
+            entry.Terrain->Cancel();
+
+        if (!Releasable(entry))
+        {
+            entry.Unused = false;
+            return false;
+        }
+        if (!entry.Unused)
+        {
+            entry.Unused = true;
+            entry.UnusedSince = now;
+            return false;
+        }
+        if (now - entry.UnusedSince < CacheTimeout)
+            return false;
+
+        Log->info("Freeing cached territory {}", pair.first);
+        return true;
+    });
+}
+
+void TerritoryRegistry::CancelTerrainLoads()
+{
+    for (auto& [filename, entry] : entries_)
+        if (entry.Terrain && !entry.Terrain->LoadTask->Completed())
+            entry.Terrain->Cancel();
+}
+
+bool TerritoryRegistry::Releasable(const Entry& entry) const
+{
+    bool terrainReleasable = !entry.Terrain || (entry.Terrain.use_count() == 1 && entry.Terrain->LoadTask->Completed());
+    return entry.Territory.use_count() == 1 && entry.LoadTask->Completed() && terrainReleasable;
+}
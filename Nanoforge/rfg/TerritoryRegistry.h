@@ -0,0 +1,51 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "Territory.h"
+#include "TerritoryTerrain.h"
+#include "util/TaskGraph.h"
+#include <chrono>
+#include <unordered_map>
+
+class PackfileVFS;
+
+//Hands out shared territories so documents viewing the same territory use one copy of its zone data and terrain.
+//Territories no longer used by any document are kept for a short time so closing and reopening a territory doesn't reload it.
+//Note: Not thread safe. Only use this from the main thread.
+class TerritoryRegistry
+{
+public:
+    void Init(PackfileVFS* packfileVFS, TaskGraph* tasks);
+    //Get a territory. If it isn't already loaded or cached a task is queued to load it once prerequisite completes.
+    //outLoadTask is set to the task that loads the territory. It completes immediately if the territory is already loaded
+    Handle<Territory> Acquire(const string& territoryFilename, const string& territoryShortname, Handle<Task> prerequisite, Handle<Task>& outLoadTask);
+    //Get the terrain of a territory returned by Acquire(). Loading starts on the first call once the zones are loaded.
+    //Terrain that no document uses stops loading, and is loaded again if it's acquired before it finishes
+    Handle<TerritoryTerrain> AcquireTerrain(const string& territoryFilename);
+    //Free territories that haven't been used for longer than the cache timeout. Call once per frame
+    void Update();
+    //Stop all terrain that's still loading. Used on shutdown so waiting for background tasks doesn't wait for whole territories to load
+    void CancelTerrainLoads();
+
+private:
+    struct Entry
+    {
+        Handle<Territory> Territory = nullptr;
+        Handle<Task> LoadTask = nullptr;
+        //Null until AcquireTerrain() is called
+        Handle<TerritoryTerrain> Terrain = nullptr;
+        //Set once the registry holds the only reference to the territory
+        bool Unused = false;
+        std::chrono::steady_clock::time_point UnusedSince;
+    };
+
+    //Returns true if the entry is only referenced by the registry and isn't being loaded
+    bool Releasable(const Entry& entry) const;
+
+    PackfileVFS* packfileVFS_ = nullptr;
+    TaskGraph* tasks_ = nullptr;
+    //Territories keyed by territory filename
+    std::unordered_map<string, Entry> entries_ = {};
+
+    //How long unused territories are kept loaded
+    static constexpr std::chrono::seconds CacheTimeout = std::chrono::seconds(120);
+};
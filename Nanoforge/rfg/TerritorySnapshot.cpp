@@ -0,0 +1,373 @@
+#include "TerritorySnapshot.h"
+#include "Territory.h"
+#include "common/filesystem/Path.h"
+#include "util/FileUtil.h"
+#include "Log.h"
+#include <filesystem>
+#include <cstring>
+#include <type_traits>
+
+//Snapshot files are stored separately from the global file cache since they aren't extracted game files
+const string territorySnapshotFolder_ = ".\\Cache\\Snapshots\\";
+constexpr u32 SnapshotSignature = 0x5354464E; //"NFTS"
+//Increment any time the snapshot format or the data Territory derives from zones changes
+constexpr u32 SnapshotVersion = 3;
+
+//On disk layout. All offsets are relative to the start of the file
+struct SnapshotString
+{
+    u64 Offset = 0;
+    u32 Length = 0;
+    u32 Padding = 0;
+};
+//Columns of ZoneObjectTable and the object BVH built over its rows
+struct SnapshotObjectTable
+{
+    u64 NumRows = 0;
+    u64 ClassIndexOffset = 0;
+    u64 HandleOffset = 0;
+    u64 ParentOffset = 0;
+    u64 FlagsOffset = 0;
+    u64 ZoneOffset = 0;
+    u64 ObjectOffset = 0;
+    u64 BoundsOffsets[6] = {}; //MinX, MinY, MinZ, MaxX, MaxY, MaxZ
+    u64 NumBvhNodes = 0;
+    u64 BvhNodesOffset = 0;
+    u64 BvhIndicesOffset = 0; //NumRows primitive indices
+};
+struct SnapshotHeader
+{
+    u32 Signature = SnapshotSignature;
+    u32 Version = SnapshotVersion;
+    u64 SourceKey = 0;
+    u64 FileSize = 0;
+    u32 NumZones = 0;
+    u32 NumUnknownClasses = 0;
+    u32 NumClasses = 0; //Total classes, including known classes. Length of each zones class count list
+    u32 Padding = 0;
+    u64 ZoneTableOffset = 0;
+    u64 ClassTableOffset = 0;
+    SnapshotObjectTable ObjectTable;
+};
+enum SnapshotZoneFlags : u32
+{
+    SnapshotZonePersistent = 1 << 0,
+    SnapshotZoneMissionLayer = 1 << 1,
+    SnapshotZoneActivityLayer = 1 << 2
+};
+struct SnapshotZone
+{
+    SnapshotString Name;
+    SnapshotString ShortName;
+    u32 Flags = 0;
+    u32 NumObjects = 0;
+    u64 DataOffset = 0;
+    u64 DataSize = 0;
+    u64 ClassIndicesOffset = 0;
+    u64 ClassCountsOffset = 0;
+    u64 HierarchyOffset = 0;
+    u32 NumHierarchyNodes = 0;
+    u32 Padding = 0;
+};
+struct SnapshotClass
+{
+    SnapshotString Name;
+    u32 Hash = 0;
+    u32 Padding = 0;
+};
+
+//Flatten hierarchy nodes in pre-order
+static void AppendHierarchy(const ZoneData& zone, const std::vector<ZoneObjectNode36>& nodes, std::vector<ZoneHierarchyNode>& output)
+{
+    for (const ZoneObjectNode36& node : nodes)
+    {
+        output.push_back({ (u32)(node.Self - zone.Zone.Objects.data()), (u32)node.Children.size() });
+        AppendHierarchy(zone, node.Children, output);
+    }
+}
+
+string TerritorySnapshot::GetPath(const string& territoryFilename)
+{
+    return territorySnapshotFolder_ + Path::GetFileNameNoExtension(territoryFilename) + ".nfsnapshot";
+}
+
+bool TerritorySnapshot::Write(const string& path, u64 sourceKey, const std::vector<ZoneData>& zones, const std::vector<std::span<u8>>& zoneBytes,
+                              const std::vector<ZoneObjectClass>& classes, u32 firstUnknownClass, const ZoneObjectTable& objectTable, const Bvh& objectBvh)
+{
+    if (zones.size() != zoneBytes.size() || firstUnknownClass > classes.size() || objectTable.Size() != objectBvh.NumPrimitives())
+        return false;
+
+    //Build the file in memory. Sections are 8 byte aligned so they can be read in place from the mapped file
+    std::vector<u8> buffer(sizeof(SnapshotHeader), 0);
+    auto align = [&]() { buffer.resize((buffer.size() + 7) & ~(size_t)7, 0); };
+    auto append = [&](const void* data, size_t size) -> u64
+    {
+        align();
+        u64 offset = buffer.size();
+        buffer.insert(buffer.end(), (const u8*)data, (const u8*)data + size);
+        return offset;
+    };
+    auto appendString = [&](const string& str) -> SnapshotString
+    {
+        return { append(str.data(), str.size()), (u32)str.size(), 0 };
+    };
+    auto appendArray = [&](const auto& values) -> u64
+    {
+        return append(values.data(), values.size() * sizeof(values[0]));
+    };
+
+    std::vector<SnapshotZone> zoneTable(zones.size());
+    std::vector<ZoneHierarchyNode> hierarchy = {};
+    for (u32 i = 0; i < zones.size(); i++)
+    {
+        const ZoneData& zone = zones[i];
+        SnapshotZone& entry = zoneTable[i];
+        entry.Name = appendString(zone.Name);
+        entry.ShortName = appendString(zone.ShortName);
+        entry.Flags = (zone.Persistent ? SnapshotZonePersistent : 0) | (zone.MissionLayer ? SnapshotZoneMissionLayer : 0) | (zone.ActivityLayer ? SnapshotZoneActivityLayer : 0);
+        entry.NumObjects = (u32)zone.ObjectClassIndices.size();
+        entry.DataOffset = append(zoneBytes[i].data(), zoneBytes[i].size());
+        entry.DataSize = zoneBytes[i].size();
+        entry.ClassIndicesOffset = append(zone.ObjectClassIndices.data(), zone.ObjectClassIndices.size() * sizeof(u16));
+        entry.ClassCountsOffset = append(zone.ClassInstanceCounts.data(), zone.ClassInstanceCounts.size() * sizeof(u32));
+
+        hierarchy.clear();
+        AppendHierarchy(zone, zone.Zone.ObjectsHierarchical, hierarchy);
+        entry.HierarchyOffset = appendArray(hierarchy);
+        entry.NumHierarchyNodes = (u32)hierarchy.size();
+    }
+
+    std::vector<SnapshotClass> classTable = {};
+    for (u32 i = firstUnknownClass; i < classes.size(); i++)
+        classTable.push_back({ appendString(classes[i].Name), classes[i].Hash, 0 });
+
+    SnapshotHeader header;
+    header.SourceKey = sourceKey;
+    header.NumZones = (u32)zoneTable.size();
+    header.NumUnknownClasses = (u32)classTable.size();
+    header.NumClasses = (u32)classes.size();
+    header.ZoneTableOffset = append(zoneTable.data(), zoneTable.size() * sizeof(SnapshotZone));
+    header.ClassTableOffset = append(classTable.data(), classTable.size() * sizeof(SnapshotClass));
+
+    SnapshotObjectTable& tableEntry = header.ObjectTable;
+    tableEntry.NumRows = objectTable.Size();
+    tableEntry.ClassIndexOffset = appendArray(objectTable.ClassIndex);
+    tableEntry.HandleOffset = appendArray(objectTable.Handle);
+    tableEntry.ParentOffset = appendArray(objectTable.Parent);
+    tableEntry.FlagsOffset = appendArray(objectTable.Flags);
+    tableEntry.ZoneOffset = appendArray(objectTable.Zone);
+    tableEntry.ObjectOffset = appendArray(objectTable.Object);
+    tableEntry.BoundsOffsets[0] = appendArray(objectTable.MinX);
+    tableEntry.BoundsOffsets[1] = appendArray(objectTable.MinY);
+    tableEntry.BoundsOffsets[2] = appendArray(objectTable.MinZ);
+    tableEntry.BoundsOffsets[3] = appendArray(objectTable.MaxX);
+    tableEntry.BoundsOffsets[4] = appendArray(objectTable.MaxY);
+    tableEntry.BoundsOffsets[5] = appendArray(objectTable.MaxZ);
+    tableEntry.NumBvhNodes = objectBvh.Nodes().size();
+    tableEntry.BvhNodesOffset = appendArray(objectBvh.Nodes());
+    tableEntry.BvhIndicesOffset = appendArray(objectBvh.PrimitiveIndices());
+
+    align();
+    header.FileSize = buffer.size();
+    memcpy(buffer.data(), &header, sizeof(SnapshotHeader));
+
+    //Several loads of the same territory can write its snapshot at once, so each writes to its own temporary file and renames it into place
+    std::filesystem::create_directories(territorySnapshotFolder_);
+    return FileUtil::WriteAtomic(path, [&](std::ostream& out)
+    {
+        out.write((const char*)buffer.data(), buffer.size());
+    });
+}
+
+bool TerritorySnapshot::Open(const string& path, u64 sourceKey)
+{
+    Close();
+    if (!std::filesystem::exists(path) || !file_.Open(path))
+        return false;
+
+    if (file_.Size() < sizeof(SnapshotHeader))
+    {
+        Close();
+        return false;
+    }
+
+    const SnapshotHeader& header = *(const SnapshotHeader*)file_.Data().data();
+    if (header.Signature != SnapshotSignature || header.Version != SnapshotVersion || header.SourceKey != sourceKey || !Validate())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void TerritorySnapshot::Close()
+{
+    file_.Close();
+}
+
+u32 TerritorySnapshot::NumZones() const
+{
+    return ((const SnapshotHeader*)file_.Data().data())->NumZones;
+}
+
+ZoneSnapshotView TerritorySnapshot::GetZone(u32 index) const
+{
+    u8* base = file_.Data().data();
+    const SnapshotHeader& header = *(const SnapshotHeader*)base;
+    const SnapshotZone& entry = ((const SnapshotZone*)(base + header.ZoneTableOffset))[index];
+
+    ZoneSnapshotView view;
+    view.Name = ReadString(entry.Name.Offset, entry.Name.Length);
+    view.ShortName = ReadString(entry.ShortName.Offset, entry.ShortName.Length);
+    view.Persistent = entry.Flags & SnapshotZonePersistent;
+    view.MissionLayer = entry.Flags & SnapshotZoneMissionLayer;
+    view.ActivityLayer = entry.Flags & SnapshotZoneActivityLayer;
+    view.ZoneBytes = { base + entry.DataOffset, (size_t)entry.DataSize };
+    view.ObjectClassIndices = { (const u16*)(base + entry.ClassIndicesOffset), entry.NumObjects };
+    view.ClassInstanceCounts = { (const u32*)(base + entry.ClassCountsOffset), header.NumClasses };
+    view.Hierarchy = { (const ZoneHierarchyNode*)(base + entry.HierarchyOffset), entry.NumHierarchyNodes };
+    return view;
+}
+
+std::vector<ObjectClassSnapshot> TerritorySnapshot::GetUnknownClasses() const
+{
+    u8* base = file_.Data().data();
+    const SnapshotHeader& header = *(const SnapshotHeader*)base;
+    const SnapshotClass* classTable = (const SnapshotClass*)(base + header.ClassTableOffset);
+
+    std::vector<ObjectClassSnapshot> classes = {};
+    for (u32 i = 0; i < header.NumUnknownClasses; i++)
+        classes.push_back({ ReadString(classTable[i].Name.Offset, classTable[i].Name.Length), classTable[i].Hash });
+
+    return classes;
+}
+
+bool TerritorySnapshot::Validate() const
+{
+    const u64 size = file_.Size();
+    u8* base = file_.Data().data();
+    const SnapshotHeader& header = *(const SnapshotHeader*)base;
+    auto inBounds = [&](u64 offset, u64 length) { return offset <= size && length <= size - offset; };
+
+    if (header.FileSize != size)
+        return false;
+    if (!inBounds(header.ZoneTableOffset, (u64)header.NumZones * sizeof(SnapshotZone)) || header.ZoneTableOffset % 8 != 0)
+        return false;
+    if (!inBounds(header.ClassTableOffset, (u64)header.NumUnknownClasses * sizeof(SnapshotClass)) || header.ClassTableOffset % 8 != 0)
+        return false;
+
+    const SnapshotZone* zoneTable = (const SnapshotZone*)(base + header.ZoneTableOffset);
+    for (u32 i = 0; i < header.NumZones; i++)
+    {
+        const SnapshotZone& entry = zoneTable[i];
+        if (!inBounds(entry.Name.Offset, entry.Name.Length) || !inBounds(entry.ShortName.Offset, entry.ShortName.Length))
+            return false;
+        if (!inBounds(entry.DataOffset, entry.DataSize))
+            return false;
+        if (!inBounds(entry.ClassIndicesOffset, (u64)entry.NumObjects * sizeof(u16)) || !inBounds(entry.ClassCountsOffset, (u64)header.NumClasses * sizeof(u32)))
+            return false;
+
+        //Class indices must reference a class that will exist once the snapshot is loaded
+        const u16* classIndices = (const u16*)(base + entry.ClassIndicesOffset);
+        for (u32 j = 0; j < entry.NumObjects; j++)
+            if (classIndices[j] >= header.NumClasses)
+                return false;
+
+        //Hierarchy nodes must reference objects in the zone and their child counts must add up to the node count. Each node claims NumChildren
+        //of the nodes after it, so the list is only consistent if every node is claimed by at most one parent before the list ends
+        if (!inBounds(entry.HierarchyOffset, (u64)entry.NumHierarchyNodes * sizeof(ZoneHierarchyNode)) || entry.HierarchyOffset % 8 != 0)
+            return false;
+
+        const ZoneHierarchyNode* hierarchy = (const ZoneHierarchyNode*)(base + entry.HierarchyOffset);
+        std::vector<u32> unclaimedChildren = {}; //Stack of child counts still to be read for each open node
+        for (u32 j = 0; j < entry.NumHierarchyNodes; j++)
+        {
+            if (hierarchy[j].Object >= entry.NumObjects)
+                return false;
+
+            while (unclaimedChildren.size() > 0 && unclaimedChildren.back() == 0)
+                unclaimedChildren.pop_back();
+            if (unclaimedChildren.size() > 0)
+                unclaimedChildren.back()--;
+
+            unclaimedChildren.push_back(hierarchy[j].NumChildren);
+        }
+        for (u32 count : unclaimedChildren)
+            if (count != 0)
+                return false;
+    }
+
+    const SnapshotClass* classTable = (const SnapshotClass*)(base + header.ClassTableOffset);
+    for (u32 i = 0; i < header.NumUnknownClasses; i++)
+        if (!inBounds(classTable[i].Name.Offset, classTable[i].Name.Length))
+            return false;
+
+    //Object table columns and the BVH. Every row must reference an object that exists in the stored zones
+    const SnapshotObjectTable& table = header.ObjectTable;
+    u64 numObjects = 0;
+    for (u32 i = 0; i < header.NumZones; i++)
+        numObjects += zoneTable[i].NumObjects;
+    if (table.NumRows != numObjects)
+        return false;
+
+    auto columnInBounds = [&](u64 offset, u64 elementSize) { return inBounds(offset, table.NumRows * elementSize) && offset % 8 == 0; };
+    if (!columnInBounds(table.ClassIndexOffset, sizeof(u16)) || !columnInBounds(table.HandleOffset, sizeof(u32)) || !columnInBounds(table.ParentOffset, sizeof(u32)) ||
+        !columnInBounds(table.FlagsOffset, sizeof(u16)) || !columnInBounds(table.ZoneOffset, sizeof(u32)) || !columnInBounds(table.ObjectOffset, sizeof(u32)) ||
+        !columnInBounds(table.BvhIndicesOffset, sizeof(u32)))
+        return false;
+    for (u64 boundsOffset : table.BoundsOffsets)
+        if (!columnInBounds(boundsOffset, sizeof(f32)))
+            return false;
+    if (!inBounds(table.BvhNodesOffset, table.NumBvhNodes * sizeof(BvhNode)) || table.BvhNodesOffset % 8 != 0)
+        return false;
+
+    const u16* rowClasses = (const u16*)(base + table.ClassIndexOffset);
+    const u32* rowZones = (const u32*)(base + table.ZoneOffset);
+    const u32* rowObjects = (const u32*)(base + table.ObjectOffset);
+    for (u64 row = 0; row < table.NumRows; row++)
+        if (rowClasses[row] >= header.NumClasses || rowZones[row] >= header.NumZones || rowObjects[row] >= zoneTable[rowZones[row]].NumObjects)
+            return false;
+
+    return true;
+}
+
+void TerritorySnapshot::ReadObjectTable(ZoneObjectTable& table) const
+{
+    const u8* base = file_.Data().data();
+    const SnapshotObjectTable& entry = ((const SnapshotHeader*)base)->ObjectTable;
+    auto readColumn = [&](auto& column, u64 offset)
+    {
+        using T = typename std::decay_t<decltype(column)>::value_type;
+        const T* values = (const T*)(base + offset);
+        column.assign(values, values + entry.NumRows);
+    };
+
+    table.Clear();
+    readColumn(table.ClassIndex, entry.ClassIndexOffset);
+    readColumn(table.Handle, entry.HandleOffset);
+    readColumn(table.Parent, entry.ParentOffset);
+    readColumn(table.Flags, entry.FlagsOffset);
+    readColumn(table.Zone, entry.ZoneOffset);
+    readColumn(table.Object, entry.ObjectOffset);
+    readColumn(table.MinX, entry.BoundsOffsets[0]);
+    readColumn(table.MinY, entry.BoundsOffsets[1]);
+    readColumn(table.MinZ, entry.BoundsOffsets[2]);
+    readColumn(table.MaxX, entry.BoundsOffsets[3]);
+    readColumn(table.MaxY, entry.BoundsOffsets[4]);
+    readColumn(table.MaxZ, entry.BoundsOffsets[5]);
+}
+
+bool TerritorySnapshot::ReadObjectBvh(Bvh& bvh, std::span<const Aabb> bounds) const
+{
+    const u8* base = file_.Data().data();
+    const SnapshotObjectTable& entry = ((const SnapshotHeader*)base)->ObjectTable;
+    std::span<const BvhNode> nodes((const BvhNode*)(base + entry.BvhNodesOffset), (size_t)entry.NumBvhNodes);
+    std::span<const u32> primitiveIndices((const u32*)(base + entry.BvhIndicesOffset), (size_t)entry.NumRows);
+    return bvh.Load(nodes, primitiveIndices, bounds);
+}
+
+string TerritorySnapshot::ReadString(u64 offset, u32 length) const
+{
+    return string((const char*)file_.Data().data() + offset, length);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "util/MappedFile.h"
+#include "util/Bvh.h"
+#include <span>
+#include <vector>
+
+struct ZoneData;
+struct ZoneObjectClass;
+class ZoneObjectTable;
+
+//Node of a zones object hierarchy (ZonePc36::ObjectsHierarchical). Stored in pre-order: each node is followed by its NumChildren children and their descendants
+struct ZoneHierarchyNode
+{
+    u32 Object = 0; //Index into ZonePc36::Objects
+    u32 NumChildren = 0;
+};
+
+//Zone stored in a territory snapshot. Spans point into the mapped snapshot file and are only valid while it's open
+struct ZoneSnapshotView
+{
+    string Name;
+    string ShortName;
+    bool Persistent = false;
+    bool MissionLayer = false;
+    bool ActivityLayer = false;
+    //Unmodified zone file. Parsed with ZonePc36::Read()
+    std::span<u8> ZoneBytes;
+    //See ZoneData::ObjectClassIndices and ZoneData::ClassInstanceCounts
+    std::span<const u16> ObjectClassIndices;
+    std::span<const u32> ClassInstanceCounts;
+    //Object hierarchy. Top level nodes follow each other. Lets loads skip ZonePc36::GenerateObjectHierarchy()
+    std::span<const ZoneHierarchyNode> Hierarchy;
+};
+
+//Object class found in zone files that isn't in Territory's list of known classes
+struct ObjectClassSnapshot
+{
+    string Name;
+    u32 Hash = 0;
+};
+
+//Binary snapshot of a territories zone files and the data Territory derives from them (load order, names, class indices, class counts, object hierarchy, object table, object BVH).
+//Lets territories be reopened without extracting zones from their vpp_pc and str2_pc files, re-sorting and re-classifying them, or rebuilding the hierarchy and BVH.
+//Zone objects and their properties are RfgTools++ types whose property classes are created by its own reader, so those are still parsed from the stored zone files by ZonePc36::Read().
+//Snapshots are memory mapped when opened. They only contain offsets relative to the start of the file so they can be used in place.
+//Snapshots are keyed by a hash of the entry tables of their source packfiles and are discarded when the key doesn't match.
+class TerritorySnapshot
+{
+public:
+    //Get the path of the snapshot file for a territory
+    static string GetPath(const string& territoryFilename);
+    //Write a snapshot of loaded zones. zoneBytes[i] must be the zone file that zones[i] was parsed from.
+    //Classes at or after firstUnknownClass are stored so class indices can be restored. objectTable and objectBvh must have been built from zones.
+    //Safe to call from several threads for the same path. Returns false on failure
+    static bool Write(const string& path, u64 sourceKey, const std::vector<ZoneData>& zones, const std::vector<std::span<u8>>& zoneBytes,
+                      const std::vector<ZoneObjectClass>& classes, u32 firstUnknownClass, const ZoneObjectTable& objectTable, const Bvh& objectBvh);
+
+    //Map a snapshot file and validate it. Returns false if it doesn't exist, is out of date, or is malformed
+    bool Open(const string& path, u64 sourceKey);
+    void Close();
+    u32 NumZones() const;
+    ZoneSnapshotView GetZone(u32 index) const;
+    std::vector<ObjectClassSnapshot> GetUnknownClasses() const;
+    //Copy the stored object table into table
+    void ReadObjectTable(ZoneObjectTable& table) const;
+    //Restore the stored object BVH. bounds must be the bounds of each row of the stored object table. Returns false if the BVH is malformed
+    bool ReadObjectBvh(Bvh& bvh, std::span<const Aabb> bounds) const;
+
+private:
+    //Check that all offsets in the snapshot are in bounds
+    bool Validate() const;
+    string ReadString(u64 offset, u32 length) const;
+
+    MappedFile file_;
+};
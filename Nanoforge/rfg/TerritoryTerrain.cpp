@@ -0,0 +1,162 @@
+#include "TerritoryTerrain.h"
+#include "TerrainLoader.h"
+#include "TerrainCache.h"
+#include "Territory.h"
+#include "util/ThreadUtil.h"
+#include "util/BoundedQueue.h"
+#include "Log.h"
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <optional>
+
+void TerritoryTerrain::Load(const string& territoryFilename, Territory* territory, PackfileVFS* packfileVFS, TaskGraph* tasks, Handle<Task> zoneLoadTask)
+{
+    LoadTask = tasks->AddTask("Load terrain for " + territoryFilename, [this, territory, packfileVFS]()
+    {
+        WorkerThread_Load(*territory, packfileVFS);
+    }, { zoneLoadTask });
+}
+
+u32 TerritoryTerrain::NumTiles()
+{
+    std::lock_guard<std::mutex> lock(tilesLock_);
+    return (u32)tiles_.size();
+}
+
+std::vector<Handle<const TerrainTile>> TerritoryTerrain::GetTiles(u32 first)
+{
+    std::lock_guard<std::mutex> lock(tilesLock_);
+    if (first >= tiles_.size())
+        return {};
+
+    return { tiles_.begin() + first, tiles_.end() };
+}
+
+Vec3 TerritoryTerrain::GetStreamingFocus()
+{
+    std::lock_guard<std::mutex> lock(streamingFocusLock_);
+    return streamingFocus_;
+}
+
+void TerritoryTerrain::SetStreamingFocus(const Vec3& focus)
+{
+    std::lock_guard<std::mutex> lock(streamingFocusLock_);
+    streamingFocus_ = focus;
+}
+
+void TerritoryTerrain::WorkerThread_Load(Territory& territory, PackfileVFS* packfileVFS)
+{
+    if (cancel_)
+        return;
+
+    //Find terrain meshes. Only their names and positions are gathered here so loading can be ordered by distance from the camera
+    std::vector<TerrainLoadRequest> requests = TerrainLoader::GetRequests(territory);
+
+    //Terrain is loaded by a pipeline: extract -> parse -> build LOD -> decode blend texture -> publish the tile to documents.
+    //Each stage has its own threads and the stages are connected by bounded queues. When a stage falls behind the stages before it block,
+    //which caps the number of terrain tiles in memory at once no matter how many cores there are or which stage is the bottleneck.
+    BoundedQueue<Handle<TerrainLoadJob>> parseQueue(TerrainQueueCapacity);
+    BoundedQueue<Handle<TerrainLoadJob>> lodQueue(TerrainQueueCapacity);
+    BoundedQueue<Handle<TerrainLoadJob>> blendQueue(TerrainQueueCapacity);
+    std::vector<std::future<void>> futures;
+
+    //Run a stage on numThreads threads. output is closed once every thread has exited so the next stage knows when to stop.
+    //Jobs are dropped if the stage fails or loading is cancelled. Failures are logged per tile so one bad file doesn't stop the rest from loading
+    auto runStage = [&](const char* stageName, u32 numThreads, std::function<std::optional<Handle<TerrainLoadJob>>()> getInput,
+                        std::function<void(TerrainLoadJob&)> func, BoundedQueue<Handle<TerrainLoadJob>>* output)
+    {
+        auto threadsRunning = std::make_shared<std::atomic<u32>>(numThreads);
+        for (u32 i = 0; i < numThreads; i++)
+        {
+            futures.push_back(std::async(std::launch::async, [=, this]()
+            {
+                while (std::optional<Handle<TerrainLoadJob>> input = getInput())
+                {
+                    Handle<TerrainLoadJob> job = input.value();
+                    bool succeeded = false;
+                    if (!cancel_)
+                    {
+                        try
+                        {
+                            func(*job);
+                            succeeded = true;
+                        }
+                        catch (std::exception& ex)
+                        {
+                            Log->error("Failed to {} for terrain mesh {}. Error: {}", stageName, job->Request.Filename, ex.what());
+                        }
+                    }
+
+                    if (!succeeded || (output && !output->Push(job)))
+                        TerrainLoader::FreeJob(*job);
+                }
+
+                if (--(*threadsRunning) == 0 && output)
+                    output->Close();
+            }));
+        }
+    };
+
+    //Extract stage takes the remaining terrain closest to the camera. The camera position is re-read for each pick so loading follows the camera as it moves
+    std::mutex requestsLock;
+    auto nextRequest = [&]() -> std::optional<Handle<TerrainLoadJob>>
+    {
+        std::lock_guard<std::mutex> lock(requestsLock);
+        if (requests.size() == 0 || cancel_)
+            return {};
+
+        //Distance on the xz plane. Terrain is a grid of zones so camera height shouldn't change the order
+        Vec3 focus = GetStreamingFocus();
+        auto distanceSquared = [&](const TerrainLoadRequest& r)
+        {
+            f32 dx = r.Position.x - focus.x;
+            f32 dz = r.Position.z - focus.z;
+            return dx * dx + dz * dz;
+        };
+        auto nearest = std::min_element(requests.begin(), requests.end(),
+            [&](const TerrainLoadRequest& a, const TerrainLoadRequest& b) { return distanceSquared(a) < distanceSquared(b); });
+
+        Handle<TerrainLoadJob> job = CreateHandle<TerrainLoadJob>();
+        job->Request = *nearest;
+        *nearest = requests.back();
+        requests.pop_back();
+        return job;
+    };
+
+    //Building the LOD tree is the most expensive stage so it gets most of the threads. Vertex normals aren't generated since the LOD patches calculate their own
+    const u32 numLodThreads = std::max(WorkerThreadCount() - TerrainExtractThreads, 1u);
+    runStage("extract files", TerrainExtractThreads, nextRequest, [&](TerrainLoadJob& job) { TerrainLoader::Extract(job, packfileVFS); }, &parseQueue);
+    runStage("parse mesh", 1, [&]() { return parseQueue.Pop(); }, [&](TerrainLoadJob& job) { TerrainLoader::Parse(job); }, &lodQueue);
+    runStage("build LOD", numLodThreads, [&]() { return lodQueue.Pop(); }, [&](TerrainLoadJob& job) { TerrainLoader::BuildLod(job); }, &blendQueue);
+    runStage("decode blend texture", 1, [&]() { return blendQueue.Pop(); }, [&](TerrainLoadJob& job)
+    {
+        TerrainLoader::DecodeBlendTexture(job);
+
+        //Save the processed tile so the next load can skip the earlier stages. Failing to write it isn't fatal
+        const string cachePath = TerrainCache::GetPath(job.Request.Filename);
+        bool cacheWritten = job.Cached || TerrainCache::Write(cachePath, job.CacheKey, job.Terrain, job.Lod, job.Heights);
+        if (!cacheWritten)
+            Log->warn("Failed to write terrain cache file for {}", job.Request.Filename);
+
+        //Only the LOD tree and heights are kept. The full detail meshes and blend texture pixels are freed with the job. Blend texture mips are streamed from the cache file
+        Handle<TerrainTile> tile = CreateHandle<TerrainTile>();
+        tile->Name = job.Terrain.Name;
+        tile->Position = job.Terrain.Position;
+        tile->Lod = std::move(job.Lod);
+        tile->Heights = std::move(job.Heights);
+        tile->HasBlendTexture = job.Terrain.HasBlendTexture;
+        if (tile->HasBlendTexture)
+            tile->BlendTexture = TerrainLoader::GetBlendTextureDesc(job.Terrain, cacheWritten ? cachePath : "", job.CacheKey);
+        TerrainLoader::FreeJob(job);
+
+        std::lock_guard<std::mutex> lock(tilesLock_);
+        tiles_.push_back(tile);
+    }, nullptr);
+
+    //Wait for all threads to exit
+    for (auto& future : futures)
+        future.wait();
+
+    Log->info("{} loading terrain meshes. Loaded {} tiles", cancel_ ? "Cancelled" : "Done", NumTiles());
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "TerrainLod.h"
+#include "util/TextureStreamer.h"
+#include "util/TaskGraph.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class PackfileVFS;
+class Territory;
+
+//Processed terrain tile. Shared by every document viewing the territory so it's never modified once loaded
+struct TerrainTile
+{
+    string Name;
+    Vec3 Position;
+    //Level of detail patches. Mesh data is kept so each document can create its own gpu buffers
+    TerrainLodTree Lod;
+    //World space heights of the tile. Used for height and ray queries
+    HeightfieldPyramid Heights;
+    //Blend texture for TextureStreamer. Only set if HasBlendTexture is true
+    StreamedTextureDesc BlendTexture;
+    bool HasBlendTexture = false;
+};
+
+//Low lod terrain of a territory. Owned by TerritoryRegistry so documents viewing the same territory load it once.
+//Tiles are loaded in the background by a pipeline and published one at a time. Documents poll NumTiles() and create render data for new tiles
+class TerritoryTerrain
+{
+public:
+    //Load every terrain tile of the territory on a background task once zoneLoadTask completes. Sets LoadTask.
+    //The territory must outlive LoadTask. TerritoryRegistry only frees territories once their terrain is done loading
+    void Load(const string& territoryFilename, Territory* territory, PackfileVFS* packfileVFS, TaskGraph* tasks, Handle<Task> zoneLoadTask);
+    //Stop loading. Tiles that were already loaded are kept. Doesn't block, wait on LoadTask to know when it's stopped
+    void Cancel() { cancel_ = true; }
+    bool Cancelled() const { return cancel_; }
+
+    u32 NumTiles();
+    //Get tiles [first, NumTiles()). Tiles are only ever appended so documents can track which ones they've seen by count
+    std::vector<Handle<const TerrainTile>> GetTiles(u32 first);
+
+    //Tiles closest to this position are loaded first. Set each frame by the documents viewing the territory
+    Vec3 GetStreamingFocus();
+    void SetStreamingFocus(const Vec3& focus);
+
+    Handle<Task> LoadTask = nullptr;
+
+private:
+    void WorkerThread_Load(Territory& territory, PackfileVFS* packfileVFS);
+
+    std::vector<Handle<const TerrainTile>> tiles_ = {};
+    std::mutex tilesLock_;
+    Vec3 streamingFocus_;
+    std::mutex streamingFocusLock_;
+    std::atomic<bool> cancel_ = false;
+
+    //Threads extracting terrain files. Extraction is mostly disk and decompression bound so more threads don't help much
+    static constexpr u32 TerrainExtractThreads = 2;
+    //Max terrain tiles waiting between each terrain loading stage
+    static constexpr u32 TerrainQueueCapacity = 2;
+};
@@ -0,0 +1,78 @@
+#include "TerritoryView.h"
+#include "Territory.h"
+#include <algorithm>
+#include <numeric>
+
+void TerritoryView::Init(const Territory& territory)
+{
+    territory_ = &territory;
+    zoneVisible_.assign(territory.ZoneFiles.size(), 0);
+    Classes.resize(territory.ZoneObjectClasses.size());
+    for (u32 i = 0; i < Classes.size(); i++)
+    {
+        const ZoneObjectClass& objectClass = territory.ZoneObjectClasses[i];
+        Classes[i] = { 0, objectClass.DefaultColor, objectClass.DefaultShow, objectClass.DefaultShowLabel };
+    }
+    ClassDisplayOrder.resize(Classes.size());
+    std::iota(ClassDisplayOrder.begin(), ClassDisplayOrder.end(), 0);
+
+    //Make first zone visible for convenience when debugging
+    if (zoneVisible_.size() > 0)
+        UpdateZoneVisibility(0, true);
+
+    SortClassDisplayOrder();
+}
+
+void TerritoryView::SetZoneVisible(u32 zone, bool visible)
+{
+    if (UpdateZoneVisibility(zone, visible))
+        SortClassDisplayOrder();
+}
+
+void TerritoryView::SetAllZonesVisible(bool visible)
+{
+    //Sort once after every zone is updated instead of once per zone
+    bool changed = false;
+    for (u32 i = 0; i < zoneVisible_.size(); i++)
+        changed |= UpdateZoneVisibility(i, visible);
+
+    if (changed)
+        SortClassDisplayOrder();
+}
+
+std::vector<u8> TerritoryView::ClassMask() const
+{
+    std::vector<u8> mask(Classes.size());
+    for (u32 i = 0; i < Classes.size(); i++)
+        mask[i] = Classes[i].Show;
+
+    return mask;
+}
+
+bool TerritoryView::UpdateZoneVisibility(u32 zone, bool visible)
+{
+    if (ZoneVisible(zone) == visible)
+        return false;
+
+    zoneVisible_[zone] = visible;
+    const std::vector<u32>& counts = territory_->ZoneFiles[zone].ClassInstanceCounts;
+    for (u32 i = 0; i < counts.size(); i++)
+    {
+        if (visible)
+            Classes[i].NumInstances += counts[i];
+        else
+            Classes[i].NumInstances -= counts[i];
+    }
+
+    return true;
+}
+
+void TerritoryView::SortClassDisplayOrder()
+{
+    //Sort display order by instance count for convenience. Classes isn't sorted so cached class indices stay valid
+    std::stable_sort(ClassDisplayOrder.begin(), ClassDisplayOrder.end(),
+    [&](u32 a, u32 b)
+    {
+        return Classes[a].NumInstances > Classes[b].NumInstances;
+    });
+}
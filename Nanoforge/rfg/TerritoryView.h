@@ -0,0 +1,50 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "RfgTools++/types/Vec3.h"
+#include <vector>
+
+class Territory;
+
+//Display settings of an object class in one TerritoryView
+struct ObjectClassView
+{
+    //Instances of the class in the zones visible in the view
+    u32 NumInstances = 0;
+    Vec3 Color = { 1.0f, 1.0f, 1.0f };
+    bool Show = true;
+    bool ShowLabel = false;
+};
+
+//Zone and object class filters of one view of a territory. Territories are shared by every document viewing them (see TerritoryRegistry),
+//so each document has its own view to keep its filters from changing the others. Zones and classes are indexed the same as Territory::ZoneFiles and Territory::ZoneObjectClasses
+class TerritoryView
+{
+public:
+    //Set filters to the defaults of each object class and show the first zone. The territory must be loaded
+    void Init(const Territory& territory);
+    bool Initialized() const { return territory_ != nullptr; }
+
+    bool ZoneVisible(u32 zone) const { return zoneVisible_[zone] != 0; }
+    //Show or hide a zone. Adjusts class instance counts by the zones per class counts instead of recounting every object
+    void SetZoneVisible(u32 zone, bool visible);
+    //Show or hide every zone. Only sorts ClassDisplayOrder once
+    void SetAllZonesVisible(bool visible);
+    //Objects are drawn and pickable if their zone and class are both visible
+    bool ObjectVisible(u32 zone, u32 classIndex) const { return zoneVisible_[zone] && Classes[classIndex].Show; }
+    //Zone and class visibility as masks for ZoneObjectTable::FilterZones() and ZoneObjectTable::FilterClasses()
+    const std::vector<u8>& ZoneMask() const { return zoneVisible_; }
+    std::vector<u8> ClassMask() const;
+
+    std::vector<ObjectClassView> Classes = {};
+    //Indices into Classes sorted by instance count. Used by the gui
+    std::vector<u32> ClassDisplayOrder = {};
+
+private:
+    //Set zone visibility and adjust class instance counts without sorting. Returns true if the visibility changed
+    bool UpdateZoneVisibility(u32 zone, bool visible);
+    //Sort ClassDisplayOrder by instance count
+    void SortClassDisplayOrder();
+
+    const Territory* territory_ = nullptr;
+    std::vector<u8> zoneVisible_ = {};
+};
@@ -0,0 +1,92 @@
+#include "ThumbnailCache.h"
+#include "util/HashUtil.h"
+#include "util/FileUtil.h"
+#include "Log.h"
+#include <filesystem>
+#include <fstream>
+
+//Stored separately from the global file cache since these aren't extracted game files
+const string thumbnailCacheFolder_ = ".\\Cache\\Thumbnails\\";
+constexpr u32 ThumbnailCacheSignature = 0x4854464E; //"NFTH"
+//Increment any time the cache format or thumbnail generation (e.g. size or lighting) changes
+constexpr u32 ThumbnailCacheVersion = 1;
+//Thumbnails are small. Used to reject malformed files before allocating anything
+constexpr u32 MaxThumbnailSize = 1024;
+
+//On disk layout: header followed by the RGBA8 pixels
+struct ThumbnailCacheHeader
+{
+    u32 Signature = ThumbnailCacheSignature;
+    u32 Version = ThumbnailCacheVersion;
+    u64 Key = 0;
+    u64 FileSize = 0;
+    u32 Width = 0;
+    u32 Height = 0;
+};
+
+string ThumbnailCache::GetPath(u64 key)
+{
+    return thumbnailCacheFolder_ + fmt::format("{:016x}", key) + ".nfthumb";
+}
+
+u64 ThumbnailCache::GetKey(std::span<const u8> cpuFile, std::span<const u8> gpuFile)
+{
+    //Sizes are hashed too so moving bytes between the files changes the key
+    u64 key = HashUtil::Fnv1a64Value(ThumbnailCacheVersion);
+    key = HashUtil::Fnv1a64Value((u64)cpuFile.size(), key);
+    key = HashUtil::Fnv1a64(cpuFile, key);
+    key = HashUtil::Fnv1a64Value((u64)gpuFile.size(), key);
+    key = HashUtil::Fnv1a64(gpuFile, key);
+    return key;
+}
+
+bool ThumbnailCache::Write(u64 key, const Thumbnail& thumbnail)
+{
+    if (thumbnail.Pixels.size() != (u64)thumbnail.Width * thumbnail.Height * 4)
+        return false;
+
+    ThumbnailCacheHeader header;
+    header.Key = key;
+    header.Width = thumbnail.Width;
+    header.Height = thumbnail.Height;
+    header.FileSize = sizeof(ThumbnailCacheHeader) + thumbnail.Pixels.size();
+
+    //Several threads can generate the same thumbnail at once, so each writes to its own temporary file and renames it into place
+    std::filesystem::create_directories(thumbnailCacheFolder_);
+    return FileUtil::WriteAtomic(GetPath(key), [&](std::ostream& out)
+    {
+        out.write((const char*)&header, sizeof(ThumbnailCacheHeader));
+        out.write((const char*)thumbnail.Pixels.data(), thumbnail.Pixels.size());
+    });
+}
+
+bool ThumbnailCache::Read(u64 key, Thumbnail& thumbnail)
+{
+    string path = GetPath(key);
+    if (!std::filesystem::exists(path))
+        return false;
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    //Validate the header before allocating the pixel buffer
+    ThumbnailCacheHeader header;
+    in.read((char*)&header, sizeof(ThumbnailCacheHeader));
+    if (!in.good() || header.Signature != ThumbnailCacheSignature || header.Version != ThumbnailCacheVersion || header.Key != key)
+        return false;
+    if (header.Width == 0 || header.Height == 0 || header.Width > MaxThumbnailSize || header.Height > MaxThumbnailSize)
+        return false;
+    if (header.FileSize != sizeof(ThumbnailCacheHeader) + (u64)header.Width * header.Height * 4 || header.FileSize != std::filesystem::file_size(path))
+        return false;
+
+    std::vector<u8> pixels((u64)header.Width * header.Height * 4);
+    in.read((char*)pixels.data(), pixels.size());
+    if (!in.good())
+        return false;
+
+    thumbnail.Width = header.Width;
+    thumbnail.Height = header.Height;
+    thumbnail.Pixels = std::move(pixels);
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <span>
+#include <vector>
+
+//Small RGBA8 preview image of an asset
+struct Thumbnail
+{
+    u32 Width = 0;
+    u32 Height = 0;
+    std::vector<u8> Pixels = {};
+};
+
+//Disk cache of asset thumbnails generated by ThumbnailGenerator. Lets the file explorer show previews of previously seen files without decoding or rendering them again.
+//Entries are keyed by a hash of the contents of the files the thumbnail was made from, so identical files in different packfiles share one entry
+//and edited files get a new one.
+class ThumbnailCache
+{
+public:
+    //Get the path of the cache file for a key
+    static string GetPath(u64 key);
+    //Get the key for a thumbnail made from a cpu file and gpu file
+    static u64 GetKey(std::span<const u8> cpuFile, std::span<const u8> gpuFile);
+    //Write a thumbnail. Returns false on failure
+    static bool Write(u64 key, const Thumbnail& thumbnail);
+    //Read a thumbnail. Returns false without modifying thumbnail if the file doesn't exist, is out of date, or is malformed
+    static bool Read(u64 key, Thumbnail& thumbnail);
+};
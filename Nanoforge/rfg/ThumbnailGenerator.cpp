@@ -0,0 +1,166 @@
+#include "ThumbnailGenerator.h"
+#include "gui/documents/PegHelpers.h"
+#include "util/ImageUtil.h"
+#include "util/SoftwareRasterizer.h"
+#include "common/filesystem/Path.h"
+#include "Log.h"
+#include <RfgTools++\formats\meshes\StaticMesh.h>
+#include <RfgTools++\formats\textures\PegFile10.h>
+#include <BinaryTools/BinaryReader.h>
+#include <algorithm>
+#include <cstring>
+
+bool ThumbnailGenerator::Supported(const string& extension)
+{
+    return extension == ".cpeg_pc" || extension == ".cvbm_pc" || extension == ".gpeg_pc" || extension == ".gvbm_pc" ||
+           extension == ".csmesh_pc" || extension == ".gsmesh_pc" || extension == ".ccmesh_pc" || extension == ".gcmesh_pc";
+}
+
+string ThumbnailGenerator::GetCpuFilename(const string& filename)
+{
+    string extension = Path::GetExtension(filename);
+    if (extension == ".gpeg_pc")
+        return Path::GetFileNameNoExtension(filename) + ".cpeg_pc";
+    else if (extension == ".gvbm_pc")
+        return Path::GetFileNameNoExtension(filename) + ".cvbm_pc";
+    else if (extension == ".gsmesh_pc")
+        return Path::GetFileNameNoExtension(filename) + ".csmesh_pc";
+    else if (extension == ".gcmesh_pc")
+        return Path::GetFileNameNoExtension(filename) + ".ccmesh_pc";
+    else
+        return filename;
+}
+
+Thumbnail ThumbnailGenerator::Generate(const string& cpuFilename, std::span<u8> cpuFile, std::span<u8> gpuFile)
+{
+    string extension = Path::GetExtension(cpuFilename);
+    if (extension == ".cpeg_pc" || extension == ".cvbm_pc")
+        return FromPeg(cpuFile, gpuFile);
+    else if (extension == ".csmesh_pc" || extension == ".ccmesh_pc")
+        return FromStaticMesh(cpuFilename, cpuFile, gpuFile);
+    else
+        THROW_EXCEPTION("Can't generate a thumbnail for \"{}\". Unsupported file type.", cpuFilename);
+}
+
+Thumbnail ThumbnailGenerator::FromPeg(std::span<u8> cpuFile, std::span<u8> gpuFile)
+{
+    BinaryReader cpuFileReader(cpuFile);
+    BinaryReader gpuFileReader(gpuFile);
+    PegFile10 peg;
+    peg.Read(cpuFileReader, gpuFileReader);
+    if (peg.Entries.size() == 0)
+    {
+        peg.Cleanup();
+        THROW_EXCEPTION("Peg has no entries to make a thumbnail from.");
+    }
+
+    Thumbnail thumbnail;
+    try
+    {
+        PegEntry10& entry = peg.Entries[0];
+        peg.ReadTextureData(gpuFileReader, entry);
+        RenderTextureFormat format = PegHelpers::PegFormatToRenderTextureFormat(entry.BitmapFormat);
+
+        //Peg entries store their mips one after another. Skip to the smallest one that still covers the thumbnail so large textures aren't fully decoded
+        u32 width = entry.Width;
+        u32 height = entry.Height;
+        u64 offset = 0;
+        for (u32 mip = 1; mip < entry.MipLevels; mip++)
+        {
+            u32 nextWidth = std::max(width / 2, 1u);
+            u32 nextHeight = std::max(height / 2, 1u);
+            u64 nextOffset = offset + RenderDevice::MipSize(format, width, height);
+            if (std::max(nextWidth, nextHeight) < ThumbnailSize || nextOffset + RenderDevice::MipSize(format, nextWidth, nextHeight) > entry.RawData.size())
+                break;
+
+            width = nextWidth;
+            height = nextHeight;
+            offset = nextOffset;
+        }
+
+        std::vector<u8> pixels = ImageUtil::DecodeToRgba8(format, width, height, entry.RawData.subspan(offset));
+        ImageUtil::FitSize(width, height, ThumbnailSize, thumbnail.Width, thumbnail.Height);
+        thumbnail.Pixels = ImageUtil::ResizeRgba8(pixels, width, height, thumbnail.Width, thumbnail.Height);
+    }
+    catch (...)
+    {
+        peg.Cleanup();
+        throw;
+    }
+
+    peg.Cleanup();
+    return thumbnail;
+}
+
+Thumbnail ThumbnailGenerator::FromStaticMesh(const string& cpuFilename, std::span<u8> cpuFile, std::span<u8> gpuFile)
+{
+    BinaryReader cpuFileReader(cpuFile);
+    BinaryReader gpuFileReader(gpuFile);
+    StaticMesh mesh;
+    string extension = Path::GetExtension(cpuFilename);
+    if (extension == ".csmesh_pc")
+        mesh.Read(cpuFileReader, cpuFilename, 0xC0FFEE11, 5);
+    else if (extension == ".ccmesh_pc")
+        mesh.Read(cpuFileReader, cpuFilename, 0xFAC351A9, 4);
+    else
+        THROW_EXCEPTION("Can't generate a thumbnail for \"{}\". Unsupported mesh type.", cpuFilename);
+
+    //Same as StaticMeshDocument. If num submeshes = num lods the other submeshes are low lod copies of the first
+    u32 numSubmeshes = mesh.NumLods == mesh.NumSubmeshes ? std::min(1u, (u32)mesh.SubMeshes.size()) : (u32)mesh.SubMeshes.size();
+    u32 numVertices = mesh.VertexBufferConfig.NumVerts;
+    std::vector<MeshInstanceData> submeshes = {};
+    auto freeBuffers = [&]()
+    {
+        for (MeshInstanceData& data : submeshes)
+        {
+            delete[] data.IndexBuffer.data();
+            delete[] data.VertexBuffer.data();
+        }
+    };
+
+    SoftwareRasterizer rasterizer(ThumbnailSize, ThumbnailSize);
+    try
+    {
+        //Vertex positions are 3 floats at the start of each vertex for every static mesh vertex format
+        Aabb bounds;
+        for (u32 i = 0; i < numSubmeshes; i++)
+        {
+            auto maybeMeshData = mesh.ReadSubmeshData(gpuFileReader, i);
+            if (!maybeMeshData)
+                THROW_EXCEPTION("Failed to read data for submesh {} of \"{}\".", i, cpuFilename);
+
+            MeshInstanceData& data = submeshes.emplace_back(maybeMeshData.value());
+            u32 stride = numVertices > 0 ? (u32)(data.VertexBuffer.size() / numVertices) : 0;
+            for (u64 offset = 0; stride >= sizeof(f32) * 3 && offset + sizeof(f32) * 3 <= data.VertexBuffer.size(); offset += stride)
+            {
+                f32 position[3];
+                memcpy(position, data.VertexBuffer.data() + offset, sizeof(position));
+                bounds.Extend(Vec3{ position[0], position[1], position[2] });
+            }
+        }
+
+        const u8 color[3] = { 200, 200, 200 };
+        rasterizer.FitView(bounds);
+        for (MeshInstanceData& data : submeshes)
+        {
+            u32 stride = numVertices > 0 ? (u32)(data.VertexBuffer.size() / numVertices) : 0;
+            std::span<const u16> indices((const u16*)data.IndexBuffer.data(), data.IndexBuffer.size() / sizeof(u16));
+            rasterizer.DrawIndexed(data.VertexBuffer, stride, indices, true, color);
+        }
+    }
+    catch (...)
+    {
+        freeBuffers();
+        throw;
+    }
+
+    freeBuffers();
+    if (rasterizer.TrianglesDrawn() == 0)
+        THROW_EXCEPTION("Static mesh \"{}\" has no triangles to draw.", cpuFilename);
+
+    Thumbnail thumbnail;
+    thumbnail.Width = rasterizer.Width();
+    thumbnail.Height = rasterizer.Height();
+    thumbnail.Pixels = rasterizer.Pixels();
+    return thumbnail;
+}
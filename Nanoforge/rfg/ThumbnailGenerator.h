@@ -0,0 +1,25 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "ThumbnailCache.h"
+#include <span>
+
+//Makes thumbnails of game assets on the CPU so they can be generated on background threads without creating GPU resources.
+//Textures are decoded from the smallest mip that's at least the thumbnail size and then downsampled. Static meshes are drawn with SoftwareRasterizer.
+//Functions throw if the files are malformed or unsupported.
+class ThumbnailGenerator
+{
+public:
+    //Width and height of thumbnails. Textures that aren't square keep their aspect ratio, so one side may be smaller
+    static constexpr u32 ThumbnailSize = 96;
+
+    //Returns true if thumbnails can be made for files with this extension. Works with cpu and gpu file extensions
+    static bool Supported(const string& extension);
+    //Get the cpu filename of an asset from either its cpu or gpu filename. Thumbnails are always requested by cpu filename
+    static string GetCpuFilename(const string& filename);
+    //Make a thumbnail of a file. The extension of the cpu filename determines the type of asset
+    static Thumbnail Generate(const string& cpuFilename, std::span<u8> cpuFile, std::span<u8> gpuFile);
+    //Make a thumbnail of the first entry in a peg
+    static Thumbnail FromPeg(std::span<u8> cpuFile, std::span<u8> gpuFile);
+    //Make a thumbnail of a static mesh. Only the highest lod is drawn
+    static Thumbnail FromStaticMesh(const string& cpuFilename, std::span<u8> cpuFile, std::span<u8> gpuFile);
+};
@@ -0,0 +1,308 @@
+#include "ZoneDiff.h"
+#include "Territory.h"
+#include "common/string/String.h"
+#include "util/HashUtil.h"
+#include "util/ThreadUtil.h"
+#include <RfgTools++\formats\zones\properties\primitive\StringProperty.h>
+#include <RfgTools++\formats\zones\properties\primitive\BoolProperty.h>
+#include <RfgTools++\formats\zones\properties\primitive\FloatProperty.h>
+#include <RfgTools++\formats\zones\properties\primitive\UintProperty.h>
+#include <RfgTools++\formats\zones\properties\compound\Vec3Property.h>
+#include <RfgTools++\formats\zones\properties\compound\Matrix33Property.h>
+#include <RfgTools++\formats\zones\properties\compound\BoundingBoxProperty.h>
+#include <RfgTools++\formats\zones\properties\compound\OpProperty.h>
+#include <RfgTools++\formats\zones\properties\special\DistrictFlagsProperty.h>
+#include <cmath>
+#include <string_view>
+#include <unordered_map>
+
+//Objects whose bounding box center moved less than this are considered to be in the same place
+constexpr f32 MoveTolerance = 0.001f;
+//Grid size used to match objects by position when their handle changed
+constexpr f32 PositionMatchGridSize = 0.1f;
+
+static Vec3 GetObjectPosition(const ZoneObject36& object)
+{
+    return { (object.Bmin.x + object.Bmax.x) / 2.0f, (object.Bmin.y + object.Bmax.y) / 2.0f, (object.Bmin.z + object.Bmax.z) / 2.0f };
+}
+
+static bool Equal(const Vec3& a, const Vec3& b, f32 tolerance = 0.0f)
+{
+    return std::abs(a.x - b.x) <= tolerance && std::abs(a.y - b.y) <= tolerance && std::abs(a.z - b.z) <= tolerance;
+}
+
+static u64 HashVec3(const Vec3& value, u64 hash)
+{
+    hash = HashUtil::Fnv1a64Value(value.x, hash);
+    hash = HashUtil::Fnv1a64Value(value.y, hash);
+    return HashUtil::Fnv1a64Value(value.z, hash);
+}
+
+template<typename Matrix>
+static u64 HashMatrix33(const Matrix& value, u64 hash)
+{
+    hash = HashVec3(value.rvec, hash);
+    hash = HashVec3(value.uvec, hash);
+    return HashVec3(value.fvec, hash);
+}
+
+//Key used to match objects by class and position
+static u64 GetPositionKey(const ZoneObject36& object)
+{
+    Vec3 position = GetObjectPosition(object);
+    u64 hash = HashUtil::Fnv1a64Value(object.ClassnameHash);
+    hash = HashUtil::Fnv1a64Value((i64)std::llround(position.x / PositionMatchGridSize), hash);
+    hash = HashUtil::Fnv1a64Value((i64)std::llround(position.y / PositionMatchGridSize), hash);
+    return HashUtil::Fnv1a64Value((i64)std::llround(position.z / PositionMatchGridSize), hash);
+}
+
+std::vector<ZoneDiffResult> ZoneDiff::DiffZones(const std::vector<ZoneData>& base, const std::vector<ZoneData>& modded)
+{
+    //Pair zones by name
+    std::unordered_map<string, u32> moddedZones = {};
+    for (u32 i = 0; i < modded.size(); i++)
+        moddedZones[String::ToLower(modded[i].Name)] = i;
+
+    std::vector<std::pair<const ZoneData*, const ZoneData*>> pairs = {};
+    std::vector<bool> moddedPaired(modded.size(), false);
+    for (const ZoneData& zone : base)
+    {
+        auto search = moddedZones.find(String::ToLower(zone.Name));
+        if (search != moddedZones.end())
+        {
+            pairs.push_back({ &zone, &modded[search->second] });
+            moddedPaired[search->second] = true;
+        }
+        else
+        {
+            pairs.push_back({ &zone, nullptr });
+        }
+    }
+    for (u32 i = 0; i < modded.size(); i++)
+        if (!moddedPaired[i])
+            pairs.push_back({ nullptr, &modded[i] });
+
+    //Zones are independent so they can be compared in parallel
+    std::vector<ZoneDiffResult> results(pairs.size());
+    ParallelFor((u32)pairs.size(), [&](u32 i)
+    {
+        results[i] = Diff(pairs[i].first, pairs[i].second);
+    });
+
+    std::erase_if(results, [](const ZoneDiffResult& result) { return result.Empty(); });
+    return results;
+}
+
+ZoneDiffResult ZoneDiff::Diff(const ZoneData* base, const ZoneData* modded)
+{
+    ZoneDiffResult result;
+    if (!base && !modded)
+        return result;
+
+    result.Zone = base ? base->Name : modded->Name;
+    result.Added = !base;
+    result.Removed = !modded;
+
+    //Zone only exists in one set. Every object in it was added or removed
+    if (!base || !modded)
+    {
+        const ZoneData& zone = base ? *base : *modded;
+        for (u32 i = 0; i < zone.Zone.Objects.size(); i++)
+        {
+            const ZoneObject36& object = zone.Zone.Objects[i];
+            ObjectDiff& diff = result.Objects.emplace_back();
+            diff.Type = base ? ObjectDiffType::Removed : ObjectDiffType::Added;
+            diff.Handle = object.Handle;
+            diff.Classname = object.Classname;
+            (base ? diff.BaseIndex : diff.ModdedIndex) = i;
+            (base ? diff.BasePosition : diff.ModdedPosition) = GetObjectPosition(object);
+        }
+        return result;
+    }
+
+    const std::vector<ZoneObject36>& baseObjects = base->Zone.Objects;
+    const std::vector<ZoneObject36>& moddedObjects = modded->Zone.Objects;
+    std::vector<u64> baseHashes(baseObjects.size());
+    std::vector<u64> moddedHashes(moddedObjects.size());
+    for (u32 i = 0; i < baseObjects.size(); i++)
+        baseHashes[i] = HashObject(baseObjects[i]);
+    for (u32 i = 0; i < moddedObjects.size(); i++)
+        moddedHashes[i] = HashObject(moddedObjects[i]);
+
+    //Fast path for unchanged zones. Most zones in a mod are untouched
+    if (baseHashes == moddedHashes)
+        return result;
+
+    std::vector<u32> baseMatches(baseObjects.size(), InvalidObjectIndex);
+    std::vector<u32> moddedMatches(moddedObjects.size(), InvalidObjectIndex);
+
+    //Match by handle first
+    std::unordered_map<u32, u32> baseHandles = {};
+    baseHandles.reserve(baseObjects.size());
+    for (u32 i = 0; i < baseObjects.size(); i++)
+        baseHandles.emplace(baseObjects[i].Handle, i);
+
+    for (u32 i = 0; i < moddedObjects.size(); i++)
+    {
+        auto search = baseHandles.find(moddedObjects[i].Handle);
+        if (search != baseHandles.end() && baseMatches[search->second] == InvalidObjectIndex)
+        {
+            baseMatches[search->second] = i;
+            moddedMatches[i] = search->second;
+        }
+    }
+
+    //Match remaining objects by class and position. Catches objects whose handle was regenerated by an editor
+    std::unordered_map<u64, std::vector<u32>> basePositions = {};
+    for (u32 i = 0; i < baseObjects.size(); i++)
+        if (baseMatches[i] == InvalidObjectIndex)
+            basePositions[GetPositionKey(baseObjects[i])].push_back(i);
+
+    std::vector<bool> matchedByPosition(moddedObjects.size(), false);
+    for (u32 i = 0; i < moddedObjects.size(); i++)
+    {
+        if (moddedMatches[i] != InvalidObjectIndex)
+            continue;
+
+        auto search = basePositions.find(GetPositionKey(moddedObjects[i]));
+        if (search == basePositions.end() || search->second.size() == 0)
+            continue;
+
+        u32 baseIndex = search->second.back();
+        search->second.pop_back();
+        baseMatches[baseIndex] = i;
+        moddedMatches[i] = baseIndex;
+        matchedByPosition[i] = true;
+    }
+
+    //Report differences in modded object order followed by removed objects
+    for (u32 i = 0; i < moddedObjects.size(); i++)
+    {
+        const ZoneObject36& moddedObject = moddedObjects[i];
+        u32 baseIndex = moddedMatches[i];
+        if (baseIndex == InvalidObjectIndex)
+        {
+            ObjectDiff& diff = result.Objects.emplace_back();
+            diff.Type = ObjectDiffType::Added;
+            diff.Handle = moddedObject.Handle;
+            diff.Classname = moddedObject.Classname;
+            diff.ModdedIndex = i;
+            diff.ModdedPosition = GetObjectPosition(moddedObject);
+            continue;
+        }
+        if (baseHashes[baseIndex] == moddedHashes[i])
+            continue;
+
+        const ZoneObject36& baseObject = baseObjects[baseIndex];
+        ObjectDiff diff;
+        diff.Type = ObjectDiffType::Changed;
+        diff.Handle = moddedObject.Handle;
+        diff.Classname = moddedObject.Classname;
+        diff.BaseIndex = baseIndex;
+        diff.ModdedIndex = i;
+        diff.MatchedByPosition = matchedByPosition[i];
+        diff.BasePosition = GetObjectPosition(baseObject);
+        diff.ModdedPosition = GetObjectPosition(moddedObject);
+        diff.Moved = !Equal(diff.BasePosition, diff.ModdedPosition, MoveTolerance);
+        DiffProperties(baseObject, moddedObject, diff);
+
+        //Hashes can differ without a meaningful change. E.g. properties were reordered
+        if (diff.MatchedByPosition || diff.Moved || diff.ChangedProperties.size() != 0)
+            result.Objects.push_back(std::move(diff));
+    }
+    for (u32 i = 0; i < baseObjects.size(); i++)
+    {
+        if (baseMatches[i] != InvalidObjectIndex)
+            continue;
+
+        const ZoneObject36& baseObject = baseObjects[i];
+        ObjectDiff& diff = result.Objects.emplace_back();
+        diff.Type = ObjectDiffType::Removed;
+        diff.Handle = baseObject.Handle;
+        diff.Classname = baseObject.Classname;
+        diff.BaseIndex = i;
+        diff.BasePosition = GetObjectPosition(baseObject);
+    }
+
+    return result;
+}
+
+u64 ZoneDiff::HashObject(const ZoneObject36& object)
+{
+    u64 hash = HashUtil::Fnv1a64Value(object.ClassnameHash);
+    hash = HashUtil::Fnv1a64Value(object.Handle, hash);
+    hash = HashUtil::Fnv1a64Value(object.Parent, hash);
+    hash = HashUtil::Fnv1a64Value(object.Flags, hash);
+    hash = HashVec3(object.Bmin, hash);
+    hash = HashVec3(object.Bmax, hash);
+    for (IZoneProperty* property : object.Properties)
+        if (property)
+            hash = HashUtil::Fnv1a64Value(HashProperty(*property), hash);
+
+    return hash;
+}
+
+u64 ZoneDiff::HashProperty(const IZoneProperty& property)
+{
+    u64 hash = HashUtil::Fnv1a64(std::string_view(property.Name));
+    hash = HashUtil::Fnv1a64Value(property.DataType, hash);
+    switch (property.DataType)
+    {
+    case ZonePropertyType::String:
+        return HashUtil::Fnv1a64(static_cast<const StringProperty&>(property).Data, hash);
+    case ZonePropertyType::Bool:
+        return HashUtil::Fnv1a64Value(static_cast<const BoolProperty&>(property).Data, hash);
+    case ZonePropertyType::Float:
+        return HashUtil::Fnv1a64Value(static_cast<const FloatProperty&>(property).Data, hash);
+    case ZonePropertyType::Uint:
+        return HashUtil::Fnv1a64Value(static_cast<const UintProperty&>(property).Data, hash);
+    case ZonePropertyType::Vec3:
+        return HashVec3(static_cast<const Vec3Property&>(property).Data, hash);
+    case ZonePropertyType::Matrix33:
+        return HashMatrix33(static_cast<const Matrix33Property&>(property).Data, hash);
+    case ZonePropertyType::BoundingBox:
+        hash = HashVec3(static_cast<const BoundingBoxProperty&>(property).Min, hash);
+        return HashVec3(static_cast<const BoundingBoxProperty&>(property).Max, hash);
+    case ZonePropertyType::Op:
+        hash = HashVec3(static_cast<const OpProperty&>(property).Position, hash);
+        return HashMatrix33(static_cast<const OpProperty&>(property).Orient, hash);
+    case ZonePropertyType::DistrictFlags:
+        return HashUtil::Fnv1a64Value(static_cast<const DistrictFlagsProperty&>(property).Data, hash);
+    default:
+        return hash;
+    }
+}
+
+void ZoneDiff::DiffProperties(const ZoneObject36& base, const ZoneObject36& modded, ObjectDiff& diff)
+{
+    //Objects only have a few dozen properties at most so a linear search is fine
+    auto find = [](const ZoneObject36& object, std::string_view name) -> const IZoneProperty*
+    {
+        for (IZoneProperty* property : object.Properties)
+            if (property && std::string_view(property->Name) == name)
+                return property;
+
+        return nullptr;
+    };
+
+    for (IZoneProperty* property : modded.Properties)
+    {
+        if (!property)
+            continue;
+
+        const IZoneProperty* baseProperty = find(base, property->Name);
+        if (!baseProperty || HashProperty(*baseProperty) != HashProperty(*property))
+            diff.ChangedProperties.push_back(string(property->Name));
+    }
+    for (IZoneProperty* property : base.Properties)
+        if (property && !find(modded, property->Name))
+            diff.ChangedProperties.push_back(string(property->Name));
+
+    //Fields stored outside of the property list
+    if (base.Parent != modded.Parent)
+        diff.ChangedProperties.push_back("parent");
+    if (base.Flags != modded.Flags)
+        diff.ChangedProperties.push_back("flags");
+    if (!diff.Moved && (!Equal(base.Bmin, modded.Bmin) || !Equal(base.Bmax, modded.Bmax)))
+        diff.ChangedProperties.push_back("bounds");
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <RfgTools++\formats\zones\ZonePc36.h>
+#include <vector>
+
+struct ZoneData;
+
+enum class ObjectDiffType
+{
+    Added, //Only in the modded zone
+    Removed, //Only in the base zone
+    Changed //In both zones with a different position or properties
+};
+
+//Difference between an object in the base and modded versions of a zone
+struct ObjectDiff
+{
+    ObjectDiffType Type = ObjectDiffType::Changed;
+    u32 Handle = 0;
+    string Classname;
+    //Indices into ZoneData::Zone.Objects of each version. ZoneDiff::InvalidObjectIndex if the object isn't in that version
+    u32 BaseIndex = 0xFFFFFFFF;
+    u32 ModdedIndex = 0xFFFFFFFF;
+    //Matched by class and position because the handle changed
+    bool MatchedByPosition = false;
+    //Bounding box center moved
+    bool Moved = false;
+    Vec3 BasePosition = { 0.0f, 0.0f, 0.0f };
+    Vec3 ModdedPosition = { 0.0f, 0.0f, 0.0f };
+    //Names of properties that were added, removed, or have different values
+    std::vector<string> ChangedProperties = {};
+};
+
+//Differences between the base and modded versions of a zone
+struct ZoneDiffResult
+{
+    string Zone;
+    bool Added = false; //Zone only exists in the modded set
+    bool Removed = false; //Zone only exists in the base set
+    std::vector<ObjectDiff> Objects = {};
+
+    bool Empty() const { return !Added && !Removed && Objects.size() == 0; }
+};
+
+//Compares two sets of zones (e.g. vanilla and modded versions of a territory) and reports added, removed, moved, and changed objects.
+//Zones are matched by name. Objects are matched by handle, falling back to class and position for objects whose handle changed.
+//Each object and zone is hashed first so unchanged zones and objects are skipped without comparing their properties one by one.
+class ZoneDiff
+{
+public:
+    static constexpr u32 InvalidObjectIndex = 0xFFFFFFFF;
+
+    //Diff every zone in base against the zone with the same name in modded. Zones are compared in parallel.
+    //Only zones with differences are returned. Ordered by base zone order followed by zones only in modded
+    static std::vector<ZoneDiffResult> DiffZones(const std::vector<ZoneData>& base, const std::vector<ZoneData>& modded);
+    //Diff a single zone. Either zone can be null if it only exists in one set
+    static ZoneDiffResult Diff(const ZoneData* base, const ZoneData* modded);
+
+    //Hash of an objects class, handle, bounds, and property values
+    static u64 HashObject(const ZoneObject36& object);
+    //Hash of a single property name and value. Values of list, navpoint, and constraint properties aren't hashed so changes to them aren't detected
+    static u64 HashProperty(const IZoneProperty& property);
+
+private:
+    //Compare properties of matched objects and fill out diff.ChangedProperties
+    static void DiffProperties(const ZoneObject36& base, const ZoneObject36& modded, ObjectDiff& diff);
+};
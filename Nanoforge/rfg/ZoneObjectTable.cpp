@@ -0,0 +1,268 @@
+#include "ZoneObjectTable.h"
+#include "Territory.h"
+#include <emmintrin.h>
+#include <bit>
+#include <cstring>
+
+void ZoneObjectTable::Build(const std::vector<ZoneData>& zones)
+{
+    Clear();
+
+    size_t numObjects = 0;
+    for (auto& zone : zones)
+        numObjects += zone.Zone.Objects.size();
+
+    ClassIndex.reserve(numObjects);
+    Handle.reserve(numObjects);
+    Parent.reserve(numObjects);
+    Flags.reserve(numObjects);
+    Zone.reserve(numObjects);
+    Object.reserve(numObjects);
+    MinX.reserve(numObjects);
+    MinY.reserve(numObjects);
+    MinZ.reserve(numObjects);
+    MaxX.reserve(numObjects);
+    MaxY.reserve(numObjects);
+    MaxZ.reserve(numObjects);
+
+    for (u32 zoneIndex = 0; zoneIndex < zones.size(); zoneIndex++)
+    {
+        const ZoneData& zone = zones[zoneIndex];
+        for (u32 objectIndex = 0; objectIndex < zone.Zone.Objects.size(); objectIndex++)
+        {
+            const ZoneObject36& object = zone.Zone.Objects[objectIndex];
+            ClassIndex.push_back(zone.ObjectClassIndices[objectIndex]);
+            Handle.push_back(object.Handle);
+            Parent.push_back(object.Parent);
+            Flags.push_back(object.Flags);
+            Zone.push_back(zoneIndex);
+            Object.push_back(objectIndex);
+            MinX.push_back(object.Bmin.x);
+            MinY.push_back(object.Bmin.y);
+            MinZ.push_back(object.Bmin.z);
+            MaxX.push_back(object.Bmax.x);
+            MaxY.push_back(object.Bmax.y);
+            MaxZ.push_back(object.Bmax.z);
+        }
+    }
+}
+
+void ZoneObjectTable::UpdateBounds(const std::vector<ZoneData>& zones)
+{
+    const u32 size = Size();
+    for (u32 i = 0; i < size; i++)
+    {
+        const ZoneObject36& object = zones[Zone[i]].Zone.Objects[Object[i]];
+        MinX[i] = object.Bmin.x;
+        MinY[i] = object.Bmin.y;
+        MinZ[i] = object.Bmin.z;
+        MaxX[i] = object.Bmax.x;
+        MaxY[i] = object.Bmax.y;
+        MaxZ[i] = object.Bmax.z;
+    }
+}
+
+void ZoneObjectTable::Clear()
+{
+    ClassIndex.clear();
+    Handle.clear();
+    Parent.clear();
+    Flags.clear();
+    Zone.clear();
+    Object.clear();
+    MinX.clear();
+    MinY.clear();
+    MinZ.clear();
+    MaxX.clear();
+    MaxY.clear();
+    MaxZ.clear();
+}
+
+void ZoneObjectTable::ResetMask(std::vector<u8>& mask) const
+{
+    mask.assign(Size(), 1);
+}
+
+void ZoneObjectTable::FilterZones(const std::vector<u8>& zoneVisible, std::vector<u8>& mask) const
+{
+    //Lookups by index can't be vectorized with SSE2. The inner loop is still branchless and only touches two contiguous arrays
+    const u32 size = Size();
+    for (u32 i = 0; i < size; i++)
+        mask[i] &= zoneVisible[Zone[i]] != 0;
+}
+
+void ZoneObjectTable::FilterClasses(const std::vector<u8>& classVisible, std::vector<u8>& mask) const
+{
+    const u32 size = Size();
+    for (u32 i = 0; i < size; i++)
+        mask[i] &= classVisible[ClassIndex[i]] != 0;
+}
+
+void ZoneObjectTable::FilterBox(const Aabb& box, std::vector<u8>& mask) const
+{
+    const u32 size = Size();
+    const __m128 boxMinX = _mm_set1_ps(box.Min.x);
+    const __m128 boxMinY = _mm_set1_ps(box.Min.y);
+    const __m128 boxMinZ = _mm_set1_ps(box.Min.z);
+    const __m128 boxMaxX = _mm_set1_ps(box.Max.x);
+    const __m128 boxMaxY = _mm_set1_ps(box.Max.y);
+    const __m128 boxMaxZ = _mm_set1_ps(box.Max.z);
+
+    //Test 4 objects at a time
+    u32 i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128 pass = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&MinX[i]), boxMaxX), _mm_cmpge_ps(_mm_loadu_ps(&MaxX[i]), boxMinX));
+        pass = _mm_and_ps(pass, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&MinY[i]), boxMaxY), _mm_cmpge_ps(_mm_loadu_ps(&MaxY[i]), boxMinY)));
+        pass = _mm_and_ps(pass, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&MinZ[i]), boxMaxZ), _mm_cmpge_ps(_mm_loadu_ps(&MaxZ[i]), boxMinZ)));
+
+        u32 bits = (u32)_mm_movemask_ps(pass);
+        mask[i + 0] &= (bits >> 0) & 1;
+        mask[i + 1] &= (bits >> 1) & 1;
+        mask[i + 2] &= (bits >> 2) & 1;
+        mask[i + 3] &= (bits >> 3) & 1;
+    }
+
+    //Remaining objects
+    for (; i < size; i++)
+    {
+        bool pass = MinX[i] <= box.Max.x && MaxX[i] >= box.Min.x &&
+                    MinY[i] <= box.Max.y && MaxY[i] >= box.Min.y &&
+                    MinZ[i] <= box.Max.z && MaxZ[i] >= box.Min.z;
+        mask[i] &= pass;
+    }
+}
+
+void ZoneObjectTable::FilterFlags(u16 requiredFlags, std::vector<u8>& mask) const
+{
+    const u32 size = Size();
+    const __m128i required = _mm_set1_epi16((short)requiredFlags);
+    const __m128i one = _mm_set1_epi8(1);
+
+    //Test 8 objects at a time
+    u32 i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        __m128i flags = _mm_loadu_si128((const __m128i*)&Flags[i]);
+        __m128i pass = _mm_cmpeq_epi16(_mm_and_si128(flags, required), required); //0xFFFF per passing object
+        __m128i passBytes = _mm_and_si128(_mm_packs_epi16(pass, pass), one); //Narrow to 1 byte per object
+        __m128i current = _mm_loadl_epi64((const __m128i*)&mask[i]);
+        _mm_storel_epi64((__m128i*)&mask[i], _mm_and_si128(current, passBytes));
+    }
+
+    //Remaining objects
+    for (; i < size; i++)
+        mask[i] &= (Flags[i] & requiredFlags) == requiredFlags;
+}
+
+u32 ZoneObjectTable::CountMask(const std::vector<u8>& mask) const
+{
+    const u32 size = Size();
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sums = _mm_setzero_si128();
+
+    //Sum 16 mask bytes at a time. _mm_sad_epu8 adds them into two 64 bit lanes
+    u32 i = 0;
+    for (; i + 16 <= size; i += 16)
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)&mask[i]), zero));
+
+    u32 count = (u32)(_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    for (; i < size; i++)
+        count += mask[i];
+
+    return count;
+}
+
+void ZoneObjectTable::CountClasses(const std::vector<u8>& mask, u32 numClasses, std::vector<u32>& outCounts) const
+{
+    outCounts.assign(numClasses, 0);
+    const u32 size = Size();
+    for (u32 i = 0; i < size; i++)
+        outCounts[ClassIndex[i]] += mask[i];
+}
+
+void ZoneObjectTable::MaskToRows(const std::vector<u8>& mask, std::vector<u32>& output) const
+{
+    const u32 size = Size();
+    const __m128i zero = _mm_setzero_si128();
+
+    //Skip 16 failing rows at a time. Most filters only pass a small portion of objects
+    u32 i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        u32 bits = (u32)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)&mask[i]), zero));
+        while (bits != 0)
+        {
+            output.push_back(i + (u32)std::countr_zero(bits));
+            bits &= bits - 1; //Clear lowest set bit
+        }
+    }
+
+    for (; i < size; i++)
+        if (mask[i])
+            output.push_back(i);
+}
+
+Aabb ZoneObjectTable::Bounds(const std::vector<u8>& mask) const
+{
+    const u32 size = Size();
+    const __m128i zero = _mm_setzero_si128();
+    __m128 minX = _mm_set1_ps(std::numeric_limits<f32>::max());
+    __m128 minY = minX;
+    __m128 minZ = minX;
+    __m128 maxX = _mm_set1_ps(std::numeric_limits<f32>::lowest());
+    __m128 maxY = maxX;
+    __m128 maxZ = maxX;
+
+    //Process 4 objects at a time. Objects that fail the mask are replaced with an empty box so they don't affect the result
+    u32 i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        i32 maskBytes;
+        memcpy(&maskBytes, &mask[i], sizeof(maskBytes));
+        __m128i lanes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(maskBytes), zero), zero);
+        __m128 pass = _mm_castsi128_ps(_mm_cmpgt_epi32(lanes, zero));
+
+        auto select = [&](__m128 value, __m128 fallback) { return _mm_or_ps(_mm_and_ps(pass, value), _mm_andnot_ps(pass, fallback)); };
+        const __m128 emptyMin = _mm_set1_ps(std::numeric_limits<f32>::max());
+        const __m128 emptyMax = _mm_set1_ps(std::numeric_limits<f32>::lowest());
+        minX = _mm_min_ps(minX, select(_mm_loadu_ps(&MinX[i]), emptyMin));
+        minY = _mm_min_ps(minY, select(_mm_loadu_ps(&MinY[i]), emptyMin));
+        minZ = _mm_min_ps(minZ, select(_mm_loadu_ps(&MinZ[i]), emptyMin));
+        maxX = _mm_max_ps(maxX, select(_mm_loadu_ps(&MaxX[i]), emptyMax));
+        maxY = _mm_max_ps(maxY, select(_mm_loadu_ps(&MaxY[i]), emptyMax));
+        maxZ = _mm_max_ps(maxZ, select(_mm_loadu_ps(&MaxZ[i]), emptyMax));
+    }
+
+    //Reduce lanes
+    f32 lanesMinX[4], lanesMinY[4], lanesMinZ[4], lanesMaxX[4], lanesMaxY[4], lanesMaxZ[4];
+    _mm_storeu_ps(lanesMinX, minX);
+    _mm_storeu_ps(lanesMinY, minY);
+    _mm_storeu_ps(lanesMinZ, minZ);
+    _mm_storeu_ps(lanesMaxX, maxX);
+    _mm_storeu_ps(lanesMaxY, maxY);
+    _mm_storeu_ps(lanesMaxZ, maxZ);
+
+    Aabb bounds;
+    for (u32 lane = 0; lane < 4; lane++)
+    {
+        //Lanes where no objects passed are still empty
+        if (lanesMinX[lane] > lanesMaxX[lane])
+            continue;
+
+        bounds.Extend(Vec3{ lanesMinX[lane], lanesMinY[lane], lanesMinZ[lane] });
+        bounds.Extend(Vec3{ lanesMaxX[lane], lanesMaxY[lane], lanesMaxZ[lane] });
+    }
+
+    //Remaining objects
+    for (; i < size; i++)
+    {
+        if (!mask[i])
+            continue;
+
+        bounds.Extend(Vec3{ MinX[i], MinY[i], MinZ[i] });
+        bounds.Extend(Vec3{ MaxX[i], MaxY[i], MaxZ[i] });
+    }
+
+    return bounds;
+}
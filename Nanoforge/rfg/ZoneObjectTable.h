@@ -0,0 +1,59 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "util/Geometry.h"
+#include <vector>
+
+struct ZoneData;
+
+//Structure of arrays copy of the frequently accessed fields of every zone object in a territory. Filters run as passes over contiguous arrays
+//instead of walking the ZoneObject36 structs in each zone. Rows are ordered by zone then by object index within the zone.
+//Filter passes write one byte per row to a mask (1 = passes, 0 = fails) and AND their result with the existing mask so they can be chained.
+//Call ResetMask() first to start a new filter.
+class ZoneObjectTable
+{
+public:
+    //Copy fields from zone objects. Must be rebuilt if zones are added or removed
+    void Build(const std::vector<ZoneData>& zones);
+    //Re-copy bounding boxes after objects move. Zones must be the same as the last call to Build()
+    void UpdateBounds(const std::vector<ZoneData>& zones);
+    void Clear();
+    u32 Size() const { return (u32)Handle.size(); }
+
+    //Set every row in the mask to 1
+    void ResetMask(std::vector<u8>& mask) const;
+    //Objects in zones where zoneVisible[zone] != 0
+    void FilterZones(const std::vector<u8>& zoneVisible, std::vector<u8>& mask) const;
+    //Objects whose class has classVisible[classIndex] != 0
+    void FilterClasses(const std::vector<u8>& classVisible, std::vector<u8>& mask) const;
+    //Objects whose bounding box intersects box
+    void FilterBox(const Aabb& box, std::vector<u8>& mask) const;
+    //Objects that have all bits of requiredFlags set
+    void FilterFlags(u16 requiredFlags, std::vector<u8>& mask) const;
+
+    //Number of rows that pass the mask
+    u32 CountMask(const std::vector<u8>& mask) const;
+    //Number of rows that pass the mask for each object class. outCounts is resized to numClasses
+    void CountClasses(const std::vector<u8>& mask, u32 numClasses, std::vector<u32>& outCounts) const;
+    //Append indices of rows that pass the mask to output
+    void MaskToRows(const std::vector<u8>& mask, std::vector<u32>& output) const;
+    //Combined bounds of rows that pass the mask. Invalid if no rows pass
+    Aabb Bounds(const std::vector<u8>& mask) const;
+
+    //Index into Territory::ZoneObjectClasses
+    std::vector<u16> ClassIndex = {};
+    std::vector<u32> Handle = {};
+    //Handle of the parent object. 0xFFFFFFFF if the object has no parent
+    std::vector<u32> Parent = {};
+    std::vector<u16> Flags = {};
+    //Index into Territory::ZoneFiles
+    std::vector<u32> Zone = {};
+    //Index into ZoneData::Zone.Objects
+    std::vector<u32> Object = {};
+    //Bounding box
+    std::vector<f32> MinX = {};
+    std::vector<f32> MinY = {};
+    std::vector<f32> MinZ = {};
+    std::vector<f32> MaxX = {};
+    std::vector<f32> MaxY = {};
+    std::vector<f32> MaxZ = {};
+};
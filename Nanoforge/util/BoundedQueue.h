@@ -0,0 +1,60 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+//Thread safe FIFO queue with a max size. Push() blocks while the queue is full so fast producers wait for slow consumers (backpressure).
+//Used to connect the stages of multithreaded pipelines while capping the number of items in flight.
+//Once Close() is called Push() fails and Pop() returns the remaining items then std::nullopt so consumers know to exit.
+template<typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    //Add an item. Blocks while the queue is full. Returns false without adding the item if the queue is closed
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [&]() { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    //Remove the oldest item. Blocks while the queue is empty. Returns std::nullopt once the queue is closed and empty
+    std::optional<T> Pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&]() { return closed_ || items_.size() > 0; });
+        if (items_.size() == 0)
+            return {};
+
+        T item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return item;
+    }
+
+    //Stop accepting items and wake up any blocked threads. Items already in the queue can still be popped
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::deque<T> items_ = {};
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
@@ -0,0 +1,321 @@
+#include "Bvh.h"
+#include <numeric>
+
+void Bvh::Build(std::span<const Aabb> bounds)
+{
+    Clear();
+    if (bounds.size() == 0)
+        return;
+
+    primitiveBounds_.assign(bounds.begin(), bounds.end());
+    primitiveIndices_.resize(bounds.size());
+    std::iota(primitiveIndices_.begin(), primitiveIndices_.end(), 0);
+
+    //Splits are chosen using primitive centroids
+    std::vector<Vec3> centroids(bounds.size());
+    for (u32 i = 0; i < bounds.size(); i++)
+        centroids[i] = bounds[i].Center();
+
+    //A binary tree with N leaves has at most 2N - 1 nodes
+    nodes_.reserve(bounds.size() * 2);
+    BvhNode& root = nodes_.emplace_back();
+    root.First = 0;
+    root.Count = (u32)bounds.size();
+    UpdateNodeBounds(0);
+
+    //Split nodes until the SAH says it's not worth it. Uses a stack instead of recursion to avoid deep call stacks on degenerate inputs
+    std::vector<u32> stack = { 0 };
+    while (stack.size() > 0)
+    {
+        u32 nodeIndex = stack.back();
+        stack.pop_back();
+        if (Subdivide(nodeIndex, centroids))
+        {
+            stack.push_back(nodes_[nodeIndex].First);
+            stack.push_back(nodes_[nodeIndex].First + 1);
+        }
+    }
+}
+
+void Bvh::Refit(std::span<const Aabb> bounds)
+{
+    if (bounds.size() != primitiveBounds_.size())
+        return;
+
+    primitiveBounds_.assign(bounds.begin(), bounds.end());
+
+    //Children are always stored after their parent, so walking backwards updates children before parents
+    for (i64 i = (i64)nodes_.size() - 1; i >= 0; i--)
+    {
+        BvhNode& node = nodes_[i];
+        if (node.Leaf())
+        {
+            UpdateNodeBounds((u32)i);
+        }
+        else
+        {
+            node.Bounds = nodes_[node.First].Bounds;
+            node.Bounds.Extend(nodes_[node.First + 1].Bounds);
+        }
+    }
+}
+
+bool Bvh::Load(std::span<const BvhNode> nodes, std::span<const u32> primitiveIndices, std::span<const Aabb> bounds)
+{
+    Clear();
+    if (primitiveIndices.size() != bounds.size() || (nodes.size() == 0) != (bounds.size() == 0))
+        return false;
+
+    //Check every index so a bad file can't make queries read out of bounds. Children must come after their parent, which also rules out cycles
+    for (u32 i = 0; i < nodes.size(); i++)
+    {
+        const BvhNode& node = nodes[i];
+        bool valid = node.Leaf() ? (u64)node.First + node.Count <= primitiveIndices.size() : node.First > i && (u64)node.First + 1 < nodes.size();
+        if (!valid)
+            return false;
+    }
+    for (u32 index : primitiveIndices)
+        if (index >= bounds.size())
+            return false;
+
+    nodes_.assign(nodes.begin(), nodes.end());
+    primitiveIndices_.assign(primitiveIndices.begin(), primitiveIndices.end());
+    primitiveBounds_.assign(bounds.begin(), bounds.end());
+    return true;
+}
+
+void Bvh::Clear()
+{
+    nodes_.clear();
+    primitiveIndices_.clear();
+    primitiveBounds_.clear();
+}
+
+template<typename NodeTest, typename PrimitiveTest>
+void Bvh::Query(NodeTest nodeTest, PrimitiveTest primitiveTest, std::vector<u32>& output) const
+{
+    if (Empty())
+        return;
+
+    std::vector<u32> stack = { 0 };
+    while (stack.size() > 0)
+    {
+        const BvhNode& node = nodes_[stack.back()];
+        stack.pop_back();
+        if (!nodeTest(node.Bounds))
+            continue;
+
+        if (node.Leaf())
+        {
+            for (u32 i = node.First; i < node.First + node.Count; i++)
+            {
+                u32 primitive = primitiveIndices_[i];
+                if (primitiveTest(primitiveBounds_[primitive]))
+                    output.push_back(primitive);
+            }
+        }
+        else
+        {
+            stack.push_back(node.First);
+            stack.push_back(node.First + 1);
+        }
+    }
+}
+
+void Bvh::QueryFrustum(const Frustum& frustum, std::vector<u32>& output) const
+{
+    Query([&](const Aabb& box) { return frustum.Intersects(box); }, [&](const Aabb& box) { return frustum.Intersects(box); }, output);
+}
+
+void Bvh::QueryBox(const Aabb& queryBox, std::vector<u32>& output) const
+{
+    Query([&](const Aabb& box) { return queryBox.Intersects(box); }, [&](const Aabb& box) { return queryBox.Intersects(box); }, output);
+}
+
+void Bvh::QuerySphere(const Vec3& center, f32 radius, std::vector<u32>& output) const
+{
+    Query([&](const Aabb& box) { return box.IntersectsSphere(center, radius); }, [&](const Aabb& box) { return box.IntersectsSphere(center, radius); }, output);
+}
+
+void Bvh::QueryFrustumSphere(const Frustum& frustum, const Vec3& center, f32 radius, std::vector<u32>& output) const
+{
+    auto test = [&](const Aabb& box) { return box.IntersectsSphere(center, radius) && frustum.Intersects(box); };
+    Query(test, test, output);
+}
+
+std::optional<BvhRayHit> Bvh::Raycast(const Ray& ray, f32 maxDistance, const std::function<bool(u32)>& filter) const
+{
+    if (Empty())
+        return {};
+
+    std::optional<BvhRayHit> closest = {};
+    f32 closestDistance = maxDistance;
+    std::vector<u32> stack = { 0 };
+    while (stack.size() > 0)
+    {
+        const BvhNode& node = nodes_[stack.back()];
+        stack.pop_back();
+
+        //Skip nodes that are missed or further away than the closest hit so far
+        f32 nodeDistance = 0.0f;
+        if (!RayIntersectsAabb(ray, node.Bounds, closestDistance, nodeDistance))
+            continue;
+
+        if (node.Leaf())
+        {
+            for (u32 i = node.First; i < node.First + node.Count; i++)
+            {
+                u32 primitive = primitiveIndices_[i];
+                f32 distance = 0.0f;
+                if (!RayIntersectsAabb(ray, primitiveBounds_[primitive], closestDistance, distance))
+                    continue;
+                if (filter && !filter(primitive))
+                    continue;
+
+                closestDistance = distance;
+                closest = BvhRayHit{ primitive, distance };
+            }
+        }
+        else
+        {
+            //Visit the nearer child first so the closest distance shrinks sooner
+            f32 leftDistance = 0.0f;
+            f32 rightDistance = 0.0f;
+            bool hitLeft = RayIntersectsAabb(ray, nodes_[node.First].Bounds, closestDistance, leftDistance);
+            bool hitRight = RayIntersectsAabb(ray, nodes_[node.First + 1].Bounds, closestDistance, rightDistance);
+            if (hitLeft && hitRight)
+            {
+                bool leftFirst = leftDistance <= rightDistance;
+                stack.push_back(leftFirst ? node.First + 1 : node.First);
+                stack.push_back(leftFirst ? node.First : node.First + 1);
+            }
+            else if (hitLeft)
+            {
+                stack.push_back(node.First);
+            }
+            else if (hitRight)
+            {
+                stack.push_back(node.First + 1);
+            }
+        }
+    }
+
+    return closest;
+}
+
+bool Bvh::Subdivide(u32 nodeIndex, const std::vector<Vec3>& centroids)
+{
+    const u32 first = nodes_[nodeIndex].First;
+    const u32 count = nodes_[nodeIndex].Count;
+    if (count <= MaxLeafSize)
+        return false;
+
+    //Get bounds of primitive centroids. Bins are spread over this range
+    Aabb centroidBounds;
+    for (u32 i = first; i < first + count; i++)
+        centroidBounds.Extend(centroids[primitiveIndices_[i]]);
+
+    const f32 centroidMin[3] = { centroidBounds.Min.x, centroidBounds.Min.y, centroidBounds.Min.z };
+    const f32 centroidMax[3] = { centroidBounds.Max.x, centroidBounds.Max.y, centroidBounds.Max.z };
+    auto axisValue = [](const Vec3& value, u32 axis) { return axis == 0 ? value.x : (axis == 1 ? value.y : value.z); };
+
+    //Find the cheapest split plane across all axes using binned SAH
+    f32 bestCost = std::numeric_limits<f32>::max();
+    u32 bestAxis = 0;
+    u32 bestSplit = 0; //Bins [0, bestSplit) go to the left child
+    for (u32 axis = 0; axis < 3; axis++)
+    {
+        f32 extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f)
+            continue;
+
+        struct Bin
+        {
+            Aabb Bounds;
+            u32 Count = 0;
+        };
+        Bin bins[NumBins];
+        f32 scale = (f32)NumBins / extent;
+        for (u32 i = first; i < first + count; i++)
+        {
+            u32 primitive = primitiveIndices_[i];
+            u32 binIndex = std::min(NumBins - 1, (u32)((axisValue(centroids[primitive], axis) - centroidMin[axis]) * scale));
+            bins[binIndex].Count++;
+            bins[binIndex].Bounds.Extend(primitiveBounds_[primitive]);
+        }
+
+        //Sweep from both sides to get the area and count on each side of every split plane
+        f32 leftAreas[NumBins - 1];
+        f32 rightAreas[NumBins - 1];
+        u32 leftCounts[NumBins - 1];
+        u32 rightCounts[NumBins - 1];
+        Aabb leftBox, rightBox;
+        u32 leftSum = 0, rightSum = 0;
+        for (u32 i = 0; i < NumBins - 1; i++)
+        {
+            leftSum += bins[i].Count;
+            leftCounts[i] = leftSum;
+            leftBox.Extend(bins[i].Bounds);
+            leftAreas[i] = leftBox.SurfaceArea();
+
+            rightSum += bins[NumBins - 1 - i].Count;
+            rightCounts[NumBins - 2 - i] = rightSum;
+            rightBox.Extend(bins[NumBins - 1 - i].Bounds);
+            rightAreas[NumBins - 2 - i] = rightBox.SurfaceArea();
+        }
+
+        for (u32 i = 0; i < NumBins - 1; i++)
+        {
+            if (leftCounts[i] == 0 || rightCounts[i] == 0)
+                continue;
+
+            f32 cost = leftCounts[i] * leftAreas[i] + rightCounts[i] * rightAreas[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i + 1;
+            }
+        }
+    }
+
+    //Keep as a leaf if there's no valid split (all centroids equal) or if splitting costs more than intersecting every primitive
+    f32 leafCost = count * nodes_[nodeIndex].Bounds.SurfaceArea();
+    if (bestSplit == 0 || bestCost >= leafCost)
+        return false;
+
+    //Partition primitives around the split plane
+    f32 extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+    f32 scale = (f32)NumBins / extent;
+    auto middle = std::partition(primitiveIndices_.begin() + first, primitiveIndices_.begin() + first + count, [&](u32 primitive)
+    {
+        u32 binIndex = std::min(NumBins - 1, (u32)((axisValue(centroids[primitive], bestAxis) - centroidMin[bestAxis]) * scale));
+        return binIndex < bestSplit;
+    });
+    u32 leftCount = (u32)(middle - (primitiveIndices_.begin() + first));
+    if (leftCount == 0 || leftCount == count)
+        return false;
+
+    //Create children. Note: Can't hold references to nodes_ across emplace_back since it may reallocate
+    u32 leftIndex = (u32)nodes_.size();
+    nodes_.emplace_back();
+    nodes_.emplace_back();
+    nodes_[leftIndex].First = first;
+    nodes_[leftIndex].Count = leftCount;
+    nodes_[leftIndex + 1].First = first + leftCount;
+    nodes_[leftIndex + 1].Count = count - leftCount;
+    UpdateNodeBounds(leftIndex);
+    UpdateNodeBounds(leftIndex + 1);
+
+    nodes_[nodeIndex].First = leftIndex;
+    nodes_[nodeIndex].Count = 0;
+    return true;
+}
+
+void Bvh::UpdateNodeBounds(u32 nodeIndex)
+{
+    BvhNode& node = nodes_[nodeIndex];
+    node.Bounds = Aabb{};
+    for (u32 i = node.First; i < node.First + node.Count; i++)
+        node.Bounds.Extend(primitiveBounds_[primitiveIndices_[i]]);
+}
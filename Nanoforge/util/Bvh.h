@@ -0,0 +1,70 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "util/Geometry.h"
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+//Node of a Bvh. Leaf nodes have Count > 0 and reference primitives [First, First + Count) in the primitive index list.
+//Interior nodes have Count == 0 and their children are at First and First + 1.
+struct BvhNode
+{
+    Aabb Bounds;
+    u32 First = 0;
+    u32 Count = 0;
+
+    bool Leaf() const { return Count > 0; }
+};
+
+struct BvhRayHit
+{
+    u32 Primitive = 0; //Index of the primitive in the bounds list passed to Bvh::Build()
+    f32 Distance = 0.0f;
+};
+
+//Bounding volume hierarchy over a list of axis aligned boxes. Built with the surface area heuristic (SAH) and can be refit
+//in place when primitives move without changing the tree structure. Queries return indices into the bounds list used to build it.
+class Bvh
+{
+public:
+    //Build the tree. Replaces any existing tree
+    void Build(std::span<const Aabb> bounds);
+    //Update node bounds after primitives move. Bounds must be in the same order and have the same size as the list passed to Build()
+    void Refit(std::span<const Aabb> bounds);
+    //Restore a tree from the Nodes() and PrimitiveIndices() of a previous build, e.g. from a cache file. Returns false and clears the tree if they're malformed
+    bool Load(std::span<const BvhNode> nodes, std::span<const u32> primitiveIndices, std::span<const Aabb> bounds);
+    void Clear();
+    bool Empty() const { return nodes_.size() == 0; }
+    std::span<const BvhNode> Nodes() const { return nodes_; }
+    std::span<const u32> PrimitiveIndices() const { return primitiveIndices_; }
+    u32 NumPrimitives() const { return (u32)primitiveBounds_.size(); }
+
+    //Append primitives that intersect the query volume to output
+    void QueryFrustum(const Frustum& frustum, std::vector<u32>& output) const;
+    void QueryBox(const Aabb& box, std::vector<u32>& output) const;
+    void QuerySphere(const Vec3& center, f32 radius, std::vector<u32>& output) const;
+    //Primitives that intersect both the frustum and the sphere. Used for view culling with a max draw distance
+    void QueryFrustumSphere(const Frustum& frustum, const Vec3& center, f32 radius, std::vector<u32>& output) const;
+    //Get the closest primitive hit by the ray. The optional filter can be used to skip primitives (e.g. hidden objects)
+    std::optional<BvhRayHit> Raycast(const Ray& ray, f32 maxDistance = std::numeric_limits<f32>::max(), const std::function<bool(u32)>& filter = nullptr) const;
+
+private:
+    //Split node into children if it's worth it according to the SAH. Returns false if the node should stay a leaf
+    bool Subdivide(u32 nodeIndex, const std::vector<Vec3>& centroids);
+    void UpdateNodeBounds(u32 nodeIndex);
+    //Visit all nodes whose bounds pass nodeTest and append primitives that pass primitiveTest
+    template<typename NodeTest, typename PrimitiveTest>
+    void Query(NodeTest nodeTest, PrimitiveTest primitiveTest, std::vector<u32>& output) const;
+
+    std::vector<BvhNode> nodes_ = {};
+    //Primitive indices referenced by leaf nodes. Reordered during build so each leaf references a contiguous range
+    std::vector<u32> primitiveIndices_ = {};
+    //Copy of the bounds passed to Build()/Refit() so queries can test individual primitives
+    std::vector<Aabb> primitiveBounds_ = {};
+
+    //Leaves with this many primitives or less are never split
+    static constexpr u32 MaxLeafSize = 4;
+    //Number of bins used to evaluate SAH split candidates per axis
+    static constexpr u32 NumBins = 12;
+};
@@ -0,0 +1,93 @@
+#include "FileUtil.h"
+#include "Log.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace FileUtil
+{
+    //Delete files that earlier writes moved aside. Files that are still mapped fail to delete and are tried again on the next write
+    static void RemoveOldFiles(const string& path)
+    {
+        std::filesystem::path filePath(path);
+        std::filesystem::path folder = filePath.has_parent_path() ? filePath.parent_path() : std::filesystem::path(".");
+        string prefix = filePath.filename().string() + ".";
+
+        std::error_code error;
+        for (auto it = std::filesystem::directory_iterator(folder, error); !error && it != std::filesystem::directory_iterator(); it.increment(error))
+        {
+            string filename = it->path().filename().string();
+            if (filename.starts_with(prefix) && filename.ends_with(".old"))
+            {
+                std::error_code removeError;
+                std::filesystem::remove(it->path(), removeError);
+            }
+        }
+    }
+
+    string UniqueTempPath(const string& path, const string& extension)
+    {
+        //The random value keeps names unique across processes and the counter keeps them unique across threads in this process
+        static const u64 processNonce = []()
+        {
+            std::random_device device;
+            return ((u64)device() << 32) | (u64)device();
+        }();
+        static std::atomic<u64> counter = 0;
+        return fmt::format("{}.{:016x}.{}{}", path, processNonce, counter.fetch_add(1), extension);
+    }
+
+    bool WriteAtomic(const string& path, const std::function<void(std::ostream& out)>& write)
+    {
+        std::error_code error;
+        string tempPath = UniqueTempPath(path);
+        bool written = false;
+        try
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (out.is_open())
+            {
+                write(out);
+                out.close();
+                written = !out.fail();
+            }
+        }
+        catch (...)
+        {
+            std::filesystem::remove(tempPath, error);
+            throw;
+        }
+
+        if (!written)
+        {
+            Log->warn("Failed to write \"{}\". Stream error while writing temporary file.", path);
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        std::filesystem::rename(tempPath, path, error);
+        if (error && std::filesystem::exists(path))
+        {
+            //Windows won't replace a file that's open or memory mapped, but it can be renamed if it was opened with FILE_SHARE_DELETE like MappedFile does.
+            //Move the old file out of the way so readers that have it mapped keep working and new readers get the new file
+            std::error_code moveError;
+            std::filesystem::rename(path, UniqueTempPath(path, ".old"), moveError);
+            if (!moveError)
+            {
+                error.clear();
+                std::filesystem::rename(tempPath, path, error);
+            }
+        }
+
+        if (error)
+        {
+            Log->warn("Failed to write \"{}\". Error: {}", path, error.message());
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        RemoveOldFiles(path);
+        return true;
+    }
+}
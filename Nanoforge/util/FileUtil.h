@@ -0,0 +1,15 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <functional>
+#include <ostream>
+
+//Helpers for writing cache files that several threads or documents may write or read at the same time
+namespace FileUtil
+{
+    //Get a path next to path that's unique to this call. Concurrent writers of the same file each get their own temporary file
+    string UniqueTempPath(const string& path, const string& extension = ".tmp");
+    //Write a file by passing write() a stream to a unique temporary file, then renaming it over path so readers never see a partial file.
+    //The temporary file is removed if write() throws, the stream fails, or the rename fails. If path can't be replaced because another
+    //thread has it open or memory mapped, the old file is moved aside first and deleted once it's no longer in use. Returns false on failure
+    bool WriteAtomic(const string& path, const std::function<void(std::ostream& out)>& write);
+}
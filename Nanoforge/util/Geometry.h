@@ -0,0 +1,181 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "RfgTools++/types/Vec3.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+//Simple geometry types used by spatial queries. Kept free of renderer types so they can be used on any thread and outside of the renderer.
+
+//Axis aligned bounding box
+struct Aabb
+{
+    Vec3 Min = { std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max(), std::numeric_limits<f32>::max() };
+    Vec3 Max = { std::numeric_limits<f32>::lowest(), std::numeric_limits<f32>::lowest(), std::numeric_limits<f32>::lowest() };
+
+    Vec3 Center() const { return { (Min.x + Max.x) * 0.5f, (Min.y + Max.y) * 0.5f, (Min.z + Max.z) * 0.5f }; }
+    Vec3 Size() const { return { Max.x - Min.x, Max.y - Min.y, Max.z - Min.z }; }
+    bool Valid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+    f32 SurfaceArea() const
+    {
+        if (!Valid())
+            return 0.0f;
+
+        Vec3 size = Size();
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+    //Grow the box to contain a point
+    void Extend(const Vec3& point)
+    {
+        Min = { std::min(Min.x, point.x), std::min(Min.y, point.y), std::min(Min.z, point.z) };
+        Max = { std::max(Max.x, point.x), std::max(Max.y, point.y), std::max(Max.z, point.z) };
+    }
+    //Grow the box to contain another box
+    void Extend(const Aabb& box)
+    {
+        Min = { std::min(Min.x, box.Min.x), std::min(Min.y, box.Min.y), std::min(Min.z, box.Min.z) };
+        Max = { std::max(Max.x, box.Max.x), std::max(Max.y, box.Max.y), std::max(Max.z, box.Max.z) };
+    }
+    bool Intersects(const Aabb& box) const
+    {
+        return Min.x <= box.Max.x && Max.x >= box.Min.x &&
+               Min.y <= box.Max.y && Max.y >= box.Min.y &&
+               Min.z <= box.Max.z && Max.z >= box.Min.z;
+    }
+    bool Contains(const Vec3& point) const
+    {
+        return point.x >= Min.x && point.x <= Max.x &&
+               point.y >= Min.y && point.y <= Max.y &&
+               point.z >= Min.z && point.z <= Max.z;
+    }
+    //Squared distance from the box to a point. Zero if the point is inside the box
+    f32 DistanceSquared(const Vec3& point) const
+    {
+        f32 dx = std::max({ Min.x - point.x, 0.0f, point.x - Max.x });
+        f32 dy = std::max({ Min.y - point.y, 0.0f, point.y - Max.y });
+        f32 dz = std::max({ Min.z - point.z, 0.0f, point.z - Max.z });
+        return dx * dx + dy * dy + dz * dz;
+    }
+    bool IntersectsSphere(const Vec3& center, f32 radius) const
+    {
+        return DistanceSquared(center) <= radius * radius;
+    }
+};
+
+struct Ray
+{
+    Vec3 Origin;
+    Vec3 Direction; //Should be normalized
+
+    Vec3 At(f32 distance) const { return { Origin.x + Direction.x * distance, Origin.y + Direction.y * distance, Origin.z + Direction.z * distance }; }
+};
+
+//Slab test. Returns true if the ray hits the box within [0, maxDistance] and sets outDistance to the entry distance (0 if the origin is inside)
+inline bool RayIntersectsAabb(const Ray& ray, const Aabb& box, f32 maxDistance, f32& outDistance)
+{
+    f32 tMin = 0.0f;
+    f32 tMax = maxDistance;
+    const f32 origin[3] = { ray.Origin.x, ray.Origin.y, ray.Origin.z };
+    const f32 direction[3] = { ray.Direction.x, ray.Direction.y, ray.Direction.z };
+    const f32 boxMin[3] = { box.Min.x, box.Min.y, box.Min.z };
+    const f32 boxMax[3] = { box.Max.x, box.Max.y, box.Max.z };
+    for (u32 axis = 0; axis < 3; axis++)
+    {
+        if (std::abs(direction[axis]) < 1e-8f)
+        {
+            //Ray is parallel to the slab. Miss if the origin is outside of it
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+                return false;
+
+            continue;
+        }
+
+        f32 invDirection = 1.0f / direction[axis];
+        f32 t0 = (boxMin[axis] - origin[axis]) * invDirection;
+        f32 t1 = (boxMax[axis] - origin[axis]) * invDirection;
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if (tMin > tMax)
+            return false;
+    }
+
+    outDistance = tMin;
+    return true;
+}
+
+//Plane in the form Normal.Dot(point) + D = 0. Points with a positive distance are in front of the plane
+struct Plane
+{
+    Vec3 Normal = { 0.0f, 1.0f, 0.0f };
+    f32 D = 0.0f;
+
+    f32 Distance(const Vec3& point) const { return Normal.x * point.x + Normal.y * point.y + Normal.z * point.z + D; }
+    void Normalize()
+    {
+        f32 length = std::sqrt(Normal.x * Normal.x + Normal.y * Normal.y + Normal.z * Normal.z);
+        if (length <= 0.0f)
+            return;
+
+        Normal = { Normal.x / length, Normal.y / length, Normal.z / length };
+        D /= length;
+    }
+};
+
+//View frustum made of 6 inward facing planes
+struct Frustum
+{
+    enum PlaneIndex { Left, Right, Bottom, Top, Near, Far };
+    Plane Planes[6];
+
+    //Extract frustum planes from a row major view projection matrix using the row vector convention (clip = point * viewProj)
+    //with a clip space depth range of [0, 1]. This is the layout of Mat4 and DirectX::XMFLOAT4X4.
+    static Frustum FromViewProjection(const f32* m)
+    {
+        //Returns column c of the matrix as plane coefficients
+        auto column = [&](u32 c) -> std::array<f32, 4> { return { m[0 * 4 + c], m[1 * 4 + c], m[2 * 4 + c], m[3 * 4 + c] }; };
+        auto makePlane = [](std::array<f32, 4> a, std::array<f32, 4> b, f32 sign) -> Plane
+        {
+            Plane plane;
+            plane.Normal = { a[0] + sign * b[0], a[1] + sign * b[1], a[2] + sign * b[2] };
+            plane.D = a[3] + sign * b[3];
+            plane.Normalize();
+            return plane;
+        };
+
+        std::array<f32, 4> col0 = column(0);
+        std::array<f32, 4> col1 = column(1);
+        std::array<f32, 4> col2 = column(2);
+        std::array<f32, 4> col3 = column(3);
+
+        Frustum frustum;
+        frustum.Planes[Left] = makePlane(col3, col0, 1.0f);
+        frustum.Planes[Right] = makePlane(col3, col0, -1.0f);
+        frustum.Planes[Bottom] = makePlane(col3, col1, 1.0f);
+        frustum.Planes[Top] = makePlane(col3, col1, -1.0f);
+        frustum.Planes[Near] = makePlane(col2, col2, 0.0f);
+        frustum.Planes[Far] = makePlane(col3, col2, -1.0f);
+        return frustum;
+    }
+
+    //Conservative box test. Returns false only if the box is fully behind one of the planes
+    bool Intersects(const Aabb& box) const
+    {
+        for (const Plane& plane : Planes)
+        {
+            //Test the box corner furthest along the plane normal
+            Vec3 positive =
+            {
+                plane.Normal.x >= 0.0f ? box.Max.x : box.Min.x,
+                plane.Normal.y >= 0.0f ? box.Max.y : box.Min.y,
+                plane.Normal.z >= 0.0f ? box.Max.z : box.Min.z
+            };
+            if (plane.Distance(positive) < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+//Non cryptographic hash functions. Used to key caches, not for security
+namespace HashUtil
+{
+    constexpr u64 Fnv1aOffsetBasis64 = 14695981039346656037ull;
+    constexpr u64 Fnv1aPrime64 = 1099511628211ull;
+
+    //64 bit FNV-1a hash. Pass the result of a previous call as hash to combine multiple values into one hash
+    inline u64 Fnv1a64(std::span<const u8> bytes, u64 hash = Fnv1aOffsetBasis64)
+    {
+        for (u8 byte : bytes)
+        {
+            hash ^= byte;
+            hash *= Fnv1aPrime64;
+        }
+        return hash;
+    }
+
+    inline u64 Fnv1a64(std::string_view str, u64 hash = Fnv1aOffsetBasis64)
+    {
+        return Fnv1a64(std::span<const u8>((const u8*)str.data(), str.size()), hash);
+    }
+
+    //Hash the bytes of a trivially copyable value such as an integer
+    template<typename T>
+    inline u64 Fnv1a64Value(const T& value, u64 hash = Fnv1aOffsetBasis64)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "HashUtil::Fnv1a64Value() only supports trivially copyable types");
+        return Fnv1a64(std::span<const u8>((const u8*)&value, sizeof(T)), hash);
+    }
+}
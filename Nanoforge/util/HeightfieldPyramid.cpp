@@ -0,0 +1,261 @@
+#include "HeightfieldPyramid.h"
+#include <algorithm>
+#include <cmath>
+
+void HeightfieldPyramid::Build(std::span<const f32> heights, u32 resolution, const Vec3& origin, f32 spacing)
+{
+    Clear();
+    if (resolution < 2 || heights.size() < (size_t)resolution * resolution)
+        return;
+
+    heights_.assign(heights.begin(), heights.begin() + (size_t)resolution * resolution);
+    resolution_ = resolution;
+    origin_ = origin;
+    spacing_ = spacing;
+
+    //Level 0 holds the range of the 4 samples at the corners of each cell
+    Level& base = levels_.emplace_back();
+    base.Size = resolution - 1;
+    base.Min.resize(base.Size * base.Size);
+    base.Max.resize(base.Size * base.Size);
+    for (u32 z = 0; z < base.Size; z++)
+    {
+        for (u32 x = 0; x < base.Size; x++)
+        {
+            f32 h00 = Height(x, z), h10 = Height(x + 1, z), h01 = Height(x, z + 1), h11 = Height(x + 1, z + 1);
+            base.Min[z * base.Size + x] = std::min({ h00, h10, h01, h11 });
+            base.Max[z * base.Size + x] = std::max({ h00, h10, h01, h11 });
+        }
+    }
+
+    //Each level above covers 2x2 cells of the one below. Odd sizes round up so the last row and column cover a single cell
+    while (levels_.back().Size > 1)
+    {
+        u32 belowIndex = (u32)levels_.size() - 1;
+        Level level;
+        level.Size = (levels_[belowIndex].Size + 1) / 2;
+        level.Min.resize(level.Size * level.Size);
+        level.Max.resize(level.Size * level.Size);
+        const Level& below = levels_[belowIndex];
+        for (u32 z = 0; z < level.Size; z++)
+        {
+            for (u32 x = 0; x < level.Size; x++)
+            {
+                f32 minHeight = std::numeric_limits<f32>::max();
+                f32 maxHeight = std::numeric_limits<f32>::lowest();
+                for (u32 childZ = z * 2; childZ < std::min(z * 2 + 2, below.Size); childZ++)
+                {
+                    for (u32 childX = x * 2; childX < std::min(x * 2 + 2, below.Size); childX++)
+                    {
+                        minHeight = std::min(minHeight, below.Min[childZ * below.Size + childX]);
+                        maxHeight = std::max(maxHeight, below.Max[childZ * below.Size + childX]);
+                    }
+                }
+                level.Min[z * level.Size + x] = minHeight;
+                level.Max[z * level.Size + x] = maxHeight;
+            }
+        }
+        levels_.push_back(std::move(level));
+    }
+
+    bounds_ = CellBounds((u32)levels_.size() - 1, 0, 0);
+}
+
+bool HeightfieldPyramid::Load(std::span<const f32> heights, u32 resolution, const Vec3& origin, f32 spacing, std::span<const f32> levelBounds)
+{
+    Clear();
+    if (resolution < 2 || heights.size() != (size_t)resolution * resolution)
+        return false;
+
+    //Level sizes follow from the resolution the same way they do in Build()
+    size_t offset = 0;
+    for (u32 size = resolution - 1; ; size = (size + 1) / 2)
+    {
+        const size_t numCells = (size_t)size * size;
+        if (offset + numCells * 2 > levelBounds.size())
+        {
+            Clear();
+            return false;
+        }
+
+        Level& level = levels_.emplace_back();
+        level.Size = size;
+        level.Min.assign(levelBounds.begin() + offset, levelBounds.begin() + offset + numCells);
+        level.Max.assign(levelBounds.begin() + offset + numCells, levelBounds.begin() + offset + numCells * 2);
+        offset += numCells * 2;
+        if (size == 1)
+            break;
+    }
+    if (offset != levelBounds.size())
+    {
+        Clear();
+        return false;
+    }
+
+    heights_.assign(heights.begin(), heights.end());
+    resolution_ = resolution;
+    origin_ = origin;
+    spacing_ = spacing;
+    bounds_ = CellBounds((u32)levels_.size() - 1, 0, 0);
+    return true;
+}
+
+std::vector<f32> HeightfieldPyramid::LevelBounds() const
+{
+    std::vector<f32> output = {};
+    for (const Level& level : levels_)
+    {
+        output.insert(output.end(), level.Min.begin(), level.Min.end());
+        output.insert(output.end(), level.Max.begin(), level.Max.end());
+    }
+    return output;
+}
+
+void HeightfieldPyramid::Clear()
+{
+    heights_.clear();
+    levels_.clear();
+    resolution_ = 0;
+    bounds_ = {};
+}
+
+Aabb HeightfieldPyramid::CellBounds(u32 level, u32 x, u32 z) const
+{
+    const Level& data = levels_[level];
+    const u32 baseCells = levels_[0].Size;
+    u32 minX = x << level, maxX = std::min((x + 1) << level, baseCells);
+    u32 minZ = z << level, maxZ = std::min((z + 1) << level, baseCells);
+
+    Aabb bounds;
+    bounds.Min = { origin_.x + minX * spacing_, origin_.y + data.Min[z * data.Size + x], origin_.z + minZ * spacing_ };
+    bounds.Max = { origin_.x + maxX * spacing_, origin_.y + data.Max[z * data.Size + x], origin_.z + maxZ * spacing_ };
+    return bounds;
+}
+
+std::optional<f32> HeightfieldPyramid::SampleHeight(f32 x, f32 z) const
+{
+    if (Empty())
+        return {};
+
+    f32 gridX = (x - origin_.x) / spacing_;
+    f32 gridZ = (z - origin_.z) / spacing_;
+    const f32 last = (f32)(resolution_ - 1);
+    if (gridX < 0.0f || gridZ < 0.0f || gridX > last || gridZ > last)
+        return {};
+
+    u32 x0 = std::min((u32)gridX, resolution_ - 2);
+    u32 z0 = std::min((u32)gridZ, resolution_ - 2);
+    f32 fx = gridX - (f32)x0;
+    f32 fz = gridZ - (f32)z0;
+    f32 h0 = Height(x0, z0) + (Height(x0 + 1, z0) - Height(x0, z0)) * fx;
+    f32 h1 = Height(x0, z0 + 1) + (Height(x0 + 1, z0 + 1) - Height(x0, z0 + 1)) * fx;
+    return origin_.y + h0 + (h1 - h0) * fz;
+}
+
+//Moller-Trumbore ray triangle intersection. Hits from either side count
+static std::optional<f32> RayIntersectsTriangle(const Ray& ray, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+    Vec3 e1 = { b.x - a.x, b.y - a.y, b.z - a.z };
+    Vec3 e2 = { c.x - a.x, c.y - a.y, c.z - a.z };
+    const Vec3& d = ray.Direction;
+    Vec3 p = { d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x };
+    f32 determinant = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+    if (std::abs(determinant) < 1e-12f)
+        return {};
+
+    f32 invDeterminant = 1.0f / determinant;
+    Vec3 s = { ray.Origin.x - a.x, ray.Origin.y - a.y, ray.Origin.z - a.z };
+    f32 u = (s.x * p.x + s.y * p.y + s.z * p.z) * invDeterminant;
+    if (u < 0.0f || u > 1.0f)
+        return {};
+
+    Vec3 q = { s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x };
+    f32 v = (d.x * q.x + d.y * q.y + d.z * q.z) * invDeterminant;
+    if (v < 0.0f || u + v > 1.0f)
+        return {};
+
+    f32 t = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * invDeterminant;
+    if (t < 0.0f)
+        return {};
+
+    return t;
+}
+
+std::optional<f32> HeightfieldPyramid::RaycastCell(const Ray& ray, u32 x, u32 z, f32 maxDistance) const
+{
+    auto vertex = [&](u32 sx, u32 sz) -> Vec3 { return { origin_.x + sx * spacing_, origin_.y + Height(sx, sz), origin_.z + sz * spacing_ }; };
+    Vec3 v00 = vertex(x, z), v10 = vertex(x + 1, z), v01 = vertex(x, z + 1), v11 = vertex(x + 1, z + 1);
+
+    //Same split as the terrain LOD patches
+    std::optional<f32> hit0 = RayIntersectsTriangle(ray, v00, v01, v10);
+    std::optional<f32> hit1 = RayIntersectsTriangle(ray, v10, v01, v11);
+    if (!hit0 && !hit1)
+        return {};
+
+    f32 closest = std::min(hit0.value_or(std::numeric_limits<f32>::max()), hit1.value_or(std::numeric_limits<f32>::max()));
+    if (closest > maxDistance)
+        return {};
+
+    return closest;
+}
+
+std::optional<f32> HeightfieldPyramid::Raycast(const Ray& ray, f32 maxDistance) const
+{
+    if (Empty())
+        return {};
+
+    f32 entry = 0.0f;
+    if (!RayIntersectsAabb(ray, bounds_, maxDistance, entry))
+        return {};
+
+    //Visit cells nearest first and skip any that start further away than the closest hit so far
+    struct Cell
+    {
+        u32 Level;
+        u32 X;
+        u32 Z;
+        f32 Entry;
+    };
+    std::vector<Cell> stack = { { (u32)levels_.size() - 1, 0, 0, entry } };
+    f32 closest = maxDistance;
+    bool hit = false;
+    while (stack.size() > 0)
+    {
+        Cell cell = stack.back();
+        stack.pop_back();
+        if (cell.Entry > closest)
+            continue;
+
+        if (cell.Level == 0)
+        {
+            if (std::optional<f32> distance = RaycastCell(ray, cell.X, cell.Z, closest))
+            {
+                closest = distance.value();
+                hit = true;
+            }
+            continue;
+        }
+
+        //Push the children that the ray hits, furthest first so the nearest is popped next
+        const u32 childLevel = cell.Level - 1;
+        const u32 childSize = levels_[childLevel].Size;
+        Cell children[4];
+        u32 numChildren = 0;
+        for (u32 childZ = cell.Z * 2; childZ < std::min(cell.Z * 2 + 2, childSize); childZ++)
+        {
+            for (u32 childX = cell.X * 2; childX < std::min(cell.X * 2 + 2, childSize); childX++)
+            {
+                f32 childEntry = 0.0f;
+                if (RayIntersectsAabb(ray, CellBounds(childLevel, childX, childZ), closest, childEntry))
+                    children[numChildren++] = { childLevel, childX, childZ, childEntry };
+            }
+        }
+        std::sort(children, children + numChildren, [](const Cell& a, const Cell& b) { return a.Entry > b.Entry; });
+        stack.insert(stack.end(), children, children + numChildren);
+    }
+
+    if (!hit)
+        return {};
+
+    return closest;
+}
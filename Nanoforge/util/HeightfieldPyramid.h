@@ -0,0 +1,56 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "util/Geometry.h"
+#include <optional>
+#include <span>
+#include <vector>
+
+//Regular grid of heights with a min/max mip pyramid over its cells for fast height and ray queries.
+//Sample (x, z) is at Origin + (x * Spacing, height, z * Spacing). Each cell between 4 samples is split into 2 triangles for ray tests.
+//Level 0 of the pyramid stores the min and max height of each cell. Each level above stores the min and max of 2x2 cells of the level below,
+//so rays skip large empty areas and find the closest hit in O(log n) cell tests on typical terrain.
+class HeightfieldPyramid
+{
+public:
+    //Build from resolution x resolution heights stored row by row (z major). Replaces any existing data
+    void Build(std::span<const f32> heights, u32 resolution, const Vec3& origin, f32 spacing);
+    //Restore a pyramid from the data of a previous build, e.g. from a cache file. levelBounds is the result of LevelBounds().
+    //Returns false and clears the pyramid if the sizes don't match the resolution
+    bool Load(std::span<const f32> heights, u32 resolution, const Vec3& origin, f32 spacing, std::span<const f32> levelBounds);
+    void Clear();
+    bool Empty() const { return levels_.size() == 0; }
+    Aabb Bounds() const { return bounds_; }
+    std::span<const f32> Heights() const { return heights_; }
+    u32 Resolution() const { return resolution_; }
+    Vec3 Origin() const { return origin_; }
+    f32 Spacing() const { return spacing_; }
+    //Min and max heights of each level, finest level first. Each level stores its min values followed by its max values
+    std::vector<f32> LevelBounds() const;
+
+    //Bilinearly interpolated height at a point. Returns std::nullopt if the point is outside the grid
+    std::optional<f32> SampleHeight(f32 x, f32 z) const;
+    //Distance along the ray to the closest point where it hits the surface. Returns std::nullopt if it misses within maxDistance
+    std::optional<f32> Raycast(const Ray& ray, f32 maxDistance = std::numeric_limits<f32>::max()) const;
+
+private:
+    struct Level
+    {
+        u32 Size = 0; //Cells per side
+        std::vector<f32> Min = {};
+        std::vector<f32> Max = {};
+    };
+
+    f32 Height(u32 x, u32 z) const { return heights_[z * resolution_ + x]; }
+    //Bounds of a cell in a pyramid level
+    Aabb CellBounds(u32 level, u32 x, u32 z) const;
+    //Test the two triangles of a level 0 cell. Returns the hit distance or std::nullopt
+    std::optional<f32> RaycastCell(const Ray& ray, u32 x, u32 z, f32 maxDistance) const;
+
+    std::vector<f32> heights_ = {};
+    u32 resolution_ = 0;
+    Vec3 origin_;
+    f32 spacing_ = 1.0f;
+    Aabb bounds_;
+    //Level 0 is the finest
+    std::vector<Level> levels_ = {};
+};
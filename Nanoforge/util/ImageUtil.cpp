@@ -0,0 +1,197 @@
+#include "ImageUtil.h"
+#include "Log.h"
+#include <algorithm>
+
+//Expand an RGB565 color to RGBA8
+static void Unpack565(u16 color, u8* out)
+{
+    u8 r = (color >> 11) & 31;
+    u8 g = (color >> 5) & 63;
+    u8 b = color & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+    out[3] = 255;
+}
+
+//Decode the 8 byte color part of a BCn block to 16 RGBA8 pixels. BC2 and BC3 always use 4 color mode, only BC1 has the 3 color + transparent mode
+static void DecodeColorBlock(const u8* block, u8* out, bool allowTransparent)
+{
+    u16 color0 = block[0] | (block[1] << 8);
+    u16 color1 = block[2] | (block[3] << 8);
+    u32 indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((u32)block[7] << 24);
+
+    u8 palette[4][4];
+    Unpack565(color0, palette[0]);
+    Unpack565(color1, palette[1]);
+    if (color0 > color1 || !allowTransparent)
+    {
+        for (u32 i = 0; i < 3; i++)
+        {
+            palette[2][i] = (u8)((2 * palette[0][i] + palette[1][i]) / 3);
+            palette[3][i] = (u8)((palette[0][i] + 2 * palette[1][i]) / 3);
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 255;
+    }
+    else
+    {
+        for (u32 i = 0; i < 3; i++)
+        {
+            palette[2][i] = (u8)((palette[0][i] + palette[1][i]) / 2);
+            palette[3][i] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+
+    for (u32 i = 0; i < 16; i++)
+    {
+        const u8* color = palette[(indices >> (i * 2)) & 3];
+        std::copy(color, color + 4, out + i * 4);
+    }
+}
+
+//Overwrite the alpha of 16 pixels with BC2 explicit 4 bit alpha
+static void DecodeExplicitAlpha(const u8* block, u8* out)
+{
+    for (u32 i = 0; i < 16; i++)
+    {
+        u8 alpha = (block[i / 2] >> ((i % 2) * 4)) & 15;
+        out[i * 4 + 3] = (alpha << 4) | alpha;
+    }
+}
+
+//Overwrite the alpha of 16 pixels with BC3 interpolated alpha
+static void DecodeInterpolatedAlpha(const u8* block, u8* out)
+{
+    u8 palette[8];
+    palette[0] = block[0];
+    palette[1] = block[1];
+    if (palette[0] > palette[1])
+    {
+        for (u32 i = 1; i < 7; i++)
+            palette[i + 1] = (u8)(((7 - i) * palette[0] + i * palette[1]) / 7);
+    }
+    else
+    {
+        for (u32 i = 1; i < 5; i++)
+            palette[i + 1] = (u8)(((5 - i) * palette[0] + i * palette[1]) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    //16 3 bit indices packed into 6 bytes
+    u64 indices = 0;
+    for (u32 i = 0; i < 6; i++)
+        indices |= (u64)block[2 + i] << (i * 8);
+
+    for (u32 i = 0; i < 16; i++)
+        out[i * 4 + 3] = palette[(indices >> (i * 3)) & 7];
+}
+
+std::vector<u8> ImageUtil::DecodeToRgba8(RenderTextureFormat format, u32 width, u32 height, std::span<const u8> data)
+{
+    u64 expectedSize = RenderDevice::MipSize(format, width, height);
+    if (data.size() < expectedSize)
+        THROW_EXCEPTION("Image data is too small to decode. Expected {} bytes, got {}.", expectedSize, data.size());
+
+    std::vector<u8> pixels((u64)width * height * 4);
+    if (format == RenderTextureFormat::RGBA8)
+    {
+        std::copy(data.begin(), data.begin() + pixels.size(), pixels.begin());
+        return pixels;
+    }
+
+    u32 blockSize = format == RenderTextureFormat::BC1 ? 8 : 16;
+    u32 blocksWide = std::max(1u, (width + 3) / 4);
+    u32 blocksHigh = std::max(1u, (height + 3) / 4);
+    u8 decoded[16 * 4];
+    for (u32 blockY = 0; blockY < blocksHigh; blockY++)
+    {
+        for (u32 blockX = 0; blockX < blocksWide; blockX++)
+        {
+            const u8* block = data.data() + ((u64)blockY * blocksWide + blockX) * blockSize;
+            switch (format)
+            {
+            case RenderTextureFormat::BC1:
+                DecodeColorBlock(block, decoded, true);
+                break;
+            case RenderTextureFormat::BC2:
+                DecodeColorBlock(block + 8, decoded, false);
+                DecodeExplicitAlpha(block, decoded);
+                break;
+            case RenderTextureFormat::BC3:
+                DecodeColorBlock(block + 8, decoded, false);
+                DecodeInterpolatedAlpha(block, decoded);
+                break;
+            default:
+                THROW_EXCEPTION("Unsupported texture format {} passed to ImageUtil::DecodeToRgba8()", (u32)format);
+            }
+
+            //Copy the block into the image, clipping pixels past the edge of mips smaller than a block
+            for (u32 y = 0; y < 4 && blockY * 4 + y < height; y++)
+            {
+                u32 rowWidth = std::min(4u, width - blockX * 4);
+                u8* dest = pixels.data() + (((u64)blockY * 4 + y) * width + blockX * 4) * 4;
+                std::copy(decoded + y * 16, decoded + y * 16 + rowWidth * 4, dest);
+            }
+        }
+    }
+
+    return pixels;
+}
+
+std::vector<u8> ImageUtil::ResizeRgba8(std::span<const u8> pixels, u32 width, u32 height, u32 outWidth, u32 outHeight)
+{
+    if (pixels.size() < (u64)width * height * 4)
+        THROW_EXCEPTION("Image data is too small to resize. Expected {} bytes, got {}.", (u64)width * height * 4, pixels.size());
+
+    std::vector<u8> out((u64)outWidth * outHeight * 4);
+    for (u32 y = 0; y < outHeight; y++)
+    {
+        //Source rectangle covered by this output pixel. Always at least one pixel
+        u32 y0 = (u32)((u64)y * height / outHeight);
+        u32 y1 = std::max(y0 + 1, (u32)((u64)(y + 1) * height / outHeight));
+        for (u32 x = 0; x < outWidth; x++)
+        {
+            u32 x0 = (u32)((u64)x * width / outWidth);
+            u32 x1 = std::max(x0 + 1, (u32)((u64)(x + 1) * width / outWidth));
+
+            u32 sum[4] = { 0, 0, 0, 0 };
+            for (u32 sy = y0; sy < y1; sy++)
+            {
+                const u8* row = pixels.data() + (u64)sy * width * 4;
+                for (u32 sx = x0; sx < x1; sx++)
+                    for (u32 i = 0; i < 4; i++)
+                        sum[i] += row[sx * 4 + i];
+            }
+
+            u32 count = (y1 - y0) * (x1 - x0);
+            u8* dest = out.data() + ((u64)y * outWidth + x) * 4;
+            for (u32 i = 0; i < 4; i++)
+                dest[i] = (u8)(sum[i] / count);
+        }
+    }
+
+    return out;
+}
+
+void ImageUtil::FitSize(u32 width, u32 height, u32 maxSize, u32& outWidth, u32& outHeight)
+{
+    if (width <= maxSize && height <= maxSize)
+    {
+        outWidth = std::max(width, 1u);
+        outHeight = std::max(height, 1u);
+    }
+    else if (width >= height)
+    {
+        outWidth = maxSize;
+        outHeight = std::max(1u, (u32)((u64)height * maxSize / width));
+    }
+    else
+    {
+        outWidth = std::max(1u, (u32)((u64)width * maxSize / height));
+        outHeight = maxSize;
+    }
+}
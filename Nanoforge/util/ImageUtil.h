@@ -0,0 +1,17 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "render/backend/RenderDevice.h"
+#include <span>
+#include <vector>
+
+//CPU image decoding and resizing. Used to make previews without a GPU, e.g. on background threads.
+//All output images are tightly packed RGBA8.
+namespace ImageUtil
+{
+    //Decode one mip of a texture to RGBA8. BCn blocks that go past the edge of the image are clipped. Throws if data is too small
+    std::vector<u8> DecodeToRgba8(RenderTextureFormat format, u32 width, u32 height, std::span<const u8> data);
+    //Box filter an RGBA8 image down to outWidth x outHeight. Also works for upscaling, but only samples the nearest pixel when doing so
+    std::vector<u8> ResizeRgba8(std::span<const u8> pixels, u32 width, u32 height, u32 outWidth, u32 outHeight);
+    //Largest size that fits in maxSize x maxSize while preserving the aspect ratio of width x height. Never larger than the input
+    void FitSize(u32 width, u32 height, u32 maxSize, u32& outWidth, u32& outHeight);
+}
@@ -0,0 +1,136 @@
+#include "LabelLayout.h"
+#include <algorithm>
+#include <cmath>
+
+void LabelLayout::SetCandidates(std::vector<LabelCandidate>&& candidates)
+{
+    candidates_ = std::move(candidates);
+    labels_.clear();
+    layoutValid_ = false;
+}
+
+bool LabelLayout::Update(const LabelView& view)
+{
+    if (NeedsLayout(view))
+    {
+        Layout(view);
+        return true;
+    }
+
+    //Keep the placed labels attached to their objects until the next layout. Labels that end up behind the camera are dropped
+    auto behind = std::remove_if(labels_.begin(), labels_.end(), [&](PlacedLabel& label)
+    {
+        const LabelCandidate& candidate = candidates_[label.Candidate];
+        f32 x = 0.0f, y = 0.0f, w = 0.0f;
+        if (!Project(view, candidate.Position, x, y, w))
+            return true;
+
+        label.X = x - candidate.Width * 0.5f;
+        label.Y = y - candidate.Height;
+        return false;
+    });
+    labels_.erase(behind, labels_.end());
+    return false;
+}
+
+bool LabelLayout::Project(const LabelView& view, const Vec3& point, f32& outX, f32& outY, f32& outW)
+{
+    const std::array<f32, 16>& m = view.ViewProjection;
+    f32 clipX = point.x * m[0] + point.y * m[4] + point.z * m[8] + m[12];
+    f32 clipY = point.x * m[1] + point.y * m[5] + point.z * m[9] + m[13];
+    f32 clipW = point.x * m[3] + point.y * m[7] + point.z * m[11] + m[15];
+    if (clipW <= 1e-4f)
+        return false;
+
+    //Clip space y points up, viewport y points down
+    outX = (clipX / clipW * 0.5f + 0.5f) * view.Width;
+    outY = (0.5f - clipY / clipW * 0.5f) * view.Height;
+    outW = clipW;
+    return true;
+}
+
+bool LabelLayout::NeedsLayout(const LabelView& view) const
+{
+    if (!layoutValid_ || view.Width != layoutView_.Width || view.Height != layoutView_.Height || view.FovRadians != layoutView_.FovRadians)
+        return true;
+
+    f32 dx = view.Position.x - layoutView_.Position.x;
+    f32 dy = view.Position.y - layoutView_.Position.y;
+    f32 dz = view.Position.z - layoutView_.Position.z;
+    if (dx * dx + dy * dy + dz * dz > RelayoutDistance * RelayoutDistance)
+        return true;
+
+    f32 cosAngle = view.Forward.x * layoutView_.Forward.x + view.Forward.y * layoutView_.Forward.y + view.Forward.z * layoutView_.Forward.z;
+    return cosAngle < std::cos(RelayoutAngle * 3.14159265f / 180.0f);
+}
+
+void LabelLayout::Layout(const LabelView& view)
+{
+    layoutView_ = view;
+    layoutValid_ = true;
+    labels_.clear();
+    projected_.clear();
+    if (view.Width <= 0.0f || view.Height <= 0.0f)
+        return;
+
+    //Pixels covered by one world unit at distance 1
+    const f32 pixelsPerUnit = view.Height / (2.0f * std::tan(view.FovRadians * 0.5f));
+    const f32 maxDistanceSquared = MaxDistance * MaxDistance;
+
+    //Drop labels that are too far, too small, or off screen
+    for (u32 i = 0; i < candidates_.size(); i++)
+    {
+        const LabelCandidate& candidate = candidates_[i];
+        f32 dx = candidate.Position.x - view.Position.x;
+        f32 dy = candidate.Position.y - view.Position.y;
+        f32 dz = candidate.Position.z - view.Position.z;
+        f32 distanceSquared = dx * dx + dy * dy + dz * dz;
+        if (MaxDistance > 0.0f && distanceSquared > maxDistanceSquared)
+            continue;
+
+        f32 x = 0.0f, y = 0.0f, w = 0.0f;
+        if (!Project(view, candidate.Position, x, y, w))
+            continue;
+        if (candidate.Radius * 2.0f * pixelsPerUnit / w < MinScreenSize)
+            continue;
+
+        f32 left = x - candidate.Width * 0.5f;
+        f32 top = y - candidate.Height;
+        if (left + candidate.Width < 0.0f || top + candidate.Height < 0.0f || left > view.Width || top > view.Height)
+            continue;
+
+        projected_.push_back({ i, left, top, distanceSquared });
+    }
+
+    //Nearest labels get first pick of screen space
+    std::sort(projected_.begin(), projected_.end(), [](const Projected& a, const Projected& b) { return a.Distance < b.Distance; });
+
+    //Place labels into free cells. Each placed label claims every cell its padded rectangle touches
+    const i32 gridWidth = std::max((i32)std::ceil(view.Width / CellSize), 1);
+    const i32 gridHeight = std::max((i32)std::ceil(view.Height / CellSize), 1);
+    occupied_.assign((size_t)gridWidth * gridHeight, 0);
+    for (const Projected& label : projected_)
+    {
+        if (labels_.size() >= MaxLabels)
+            break;
+
+        const LabelCandidate& candidate = candidates_[label.Candidate];
+        i32 minCellX = std::clamp((i32)std::floor((label.X - Padding) / CellSize), 0, gridWidth - 1);
+        i32 minCellY = std::clamp((i32)std::floor((label.Y - Padding) / CellSize), 0, gridHeight - 1);
+        i32 maxCellX = std::clamp((i32)std::floor((label.X + candidate.Width + Padding) / CellSize), 0, gridWidth - 1);
+        i32 maxCellY = std::clamp((i32)std::floor((label.Y + candidate.Height + Padding) / CellSize), 0, gridHeight - 1);
+
+        bool overlaps = false;
+        for (i32 cellY = minCellY; cellY <= maxCellY && !overlaps; cellY++)
+            for (i32 cellX = minCellX; cellX <= maxCellX && !overlaps; cellX++)
+                overlaps = occupied_[(size_t)cellY * gridWidth + cellX] != 0;
+        if (overlaps)
+            continue;
+
+        for (i32 cellY = minCellY; cellY <= maxCellY; cellY++)
+            for (i32 cellX = minCellX; cellX <= maxCellX; cellX++)
+                occupied_[(size_t)cellY * gridWidth + cellX] = 1;
+
+        labels_.push_back({ label.Candidate, label.X, label.Y });
+    }
+}
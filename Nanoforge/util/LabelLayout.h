@@ -0,0 +1,92 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "RfgTools++/types/Vec3.h"
+#include <array>
+#include <vector>
+
+//World space point that wants a label. Its index in the list passed to LabelLayout::SetCandidates() identifies it
+struct LabelCandidate
+{
+    Vec3 Position;
+    //Radius of the labeled object. Labels of objects smaller than LabelLayout::MinScreenSize pixels are dropped
+    f32 Radius = 0.0f;
+    //Size of the label text in pixels
+    f32 Width = 0.0f;
+    f32 Height = 0.0f;
+};
+
+//Label that passed the layout. X and Y are the top left corner of the label in pixels relative to the top left of the viewport
+struct PlacedLabel
+{
+    u32 Candidate = 0;
+    f32 X = 0.0f;
+    f32 Y = 0.0f;
+};
+
+//Camera used to lay out labels
+struct LabelView
+{
+    //Row major view projection matrix using the row vector convention (clip = point * viewProj). Same layout as Frustum::FromViewProjection()
+    std::array<f32, 16> ViewProjection = {};
+    Vec3 Position;
+    //Normalized view direction
+    Vec3 Forward;
+    //Vertical field of view
+    f32 FovRadians = 0.0f;
+    f32 Width = 0.0f;
+    f32 Height = 0.0f;
+};
+
+//Picks which labels to draw so they don't overlap and stay readable with any number of candidates. Doesn't use the renderer or UI so it can be tested on its own.
+//Candidates are projected and filtered by distance and screen size, then placed nearest first into a screen space occupancy grid. Labels that hit occupied cells are dropped.
+//The layout is cached until the camera moves or turns past a threshold. In between only the placed labels (at most MaxLabels) are reprojected,
+//so the per frame cost doesn't depend on the number of candidates.
+class LabelLayout
+{
+public:
+    //Replace the candidates. Forces a relayout on the next Update()
+    void SetCandidates(std::vector<LabelCandidate>&& candidates);
+    //Lay out labels if the view changed enough, otherwise move the placed labels to their new screen positions. Returns true if the layout was redone
+    bool Update(const LabelView& view);
+    //Force a relayout on the next Update(). Call after changing the settings below
+    void Invalidate() { layoutValid_ = false; }
+
+    const std::vector<PlacedLabel>& Labels() const { return labels_; }
+    u32 NumCandidates() const { return (u32)candidates_.size(); }
+
+    //Labels further than this from the camera are dropped. <= 0 for no limit
+    f32 MaxDistance = 1000.0f;
+    //Labels of objects smaller than this many pixels on screen are dropped
+    f32 MinScreenSize = 4.0f;
+    u32 MaxLabels = 250;
+    //Size of occupancy grid cells in pixels. Smaller cells pack labels tighter but cost more to test
+    f32 CellSize = 8.0f;
+    //Empty space kept around each label in pixels
+    f32 Padding = 2.0f;
+    //Camera movement in world units and rotation in degrees that trigger a relayout
+    f32 RelayoutDistance = 2.0f;
+    f32 RelayoutAngle = 2.0f;
+
+private:
+    //Project a point into viewport pixels. Returns false if it's behind the camera
+    static bool Project(const LabelView& view, const Vec3& point, f32& outX, f32& outY, f32& outW);
+    void Layout(const LabelView& view);
+    bool NeedsLayout(const LabelView& view) const;
+
+    std::vector<LabelCandidate> candidates_ = {};
+    std::vector<PlacedLabel> labels_ = {};
+    //Layout scratch data. Kept between layouts to avoid reallocating
+    struct Projected
+    {
+        u32 Candidate = 0;
+        f32 X = 0.0f;
+        f32 Y = 0.0f;
+        f32 Distance = 0.0f;
+    };
+    std::vector<Projected> projected_ = {};
+    std::vector<u8> occupied_ = {};
+
+    //View of the last layout
+    LabelView layoutView_;
+    bool layoutValid_ = false;
+};
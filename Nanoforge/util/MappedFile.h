@@ -0,0 +1,28 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <span>
+
+//Read only memory mapped file. Lets large cache files be used in place without reading them into a buffer first.
+//The view returned by Data() is valid until Close() is called or the MappedFile is destroyed.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //Map a file into memory. Closes the previously mapped file if there is one. Returns false on failure
+    bool Open(const string& path);
+    void Close();
+    bool IsOpen() const { return view_ != nullptr; }
+    //Note: The view is mapped as read only. Writing to it will cause an access violation
+    std::span<u8> Data() const { return { view_, size_ }; }
+    size_t Size() const { return size_; }
+
+private:
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+    u8* view_ = nullptr;
+    size_t size_ = 0;
+};
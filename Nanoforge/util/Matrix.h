@@ -0,0 +1,140 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "RfgTools++/types/Vec3.h"
+#include <cmath>
+
+//Row major 4x4 matrix using the row vector convention (point * matrix). Same memory layout and conventions as DirectX::XMFLOAT4X4, so it
+//can be copied into shader constants or loaded with XMLoadFloat4x4. Only has what the cameras and scenes need. Projections are left handed with a [0, 1] depth range
+struct Mat4
+{
+    f32 m[4][4] =
+    {
+        { 1.0f, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f, 0.0f },
+        { 0.0f, 0.0f, 0.0f, 1.0f },
+    };
+
+    const f32* Data() const { return &m[0][0]; }
+
+    Mat4 operator*(const Mat4& b) const
+    {
+        Mat4 result;
+        for (u32 row = 0; row < 4; row++)
+            for (u32 col = 0; col < 4; col++)
+                result.m[row][col] = m[row][0] * b.m[0][col] + m[row][1] * b.m[1][col] + m[row][2] * b.m[2][col] + m[row][3] * b.m[3][col];
+
+        return result;
+    }
+
+    Mat4 Transposed() const
+    {
+        Mat4 result;
+        for (u32 row = 0; row < 4; row++)
+            for (u32 col = 0; col < 4; col++)
+                result.m[row][col] = m[col][row];
+
+        return result;
+    }
+
+    //Transform a point. The result is divided by w
+    Vec3 TransformCoord(const Vec3& p) const
+    {
+        f32 x = p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0];
+        f32 y = p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1];
+        f32 z = p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2];
+        f32 w = p.x * m[0][3] + p.y * m[1][3] + p.z * m[2][3] + m[3][3];
+        return { x / w, y / w, z / w };
+    }
+
+    static Mat4 Translation(f32 x, f32 y, f32 z)
+    {
+        Mat4 result;
+        result.m[3][0] = x;
+        result.m[3][1] = y;
+        result.m[3][2] = z;
+        return result;
+    }
+
+    static Mat4 Scaling(f32 x, f32 y, f32 z)
+    {
+        Mat4 result;
+        result.m[0][0] = x;
+        result.m[1][1] = y;
+        result.m[2][2] = z;
+        return result;
+    }
+
+    //Rotates by roll around z, then pitch around x, then yaw around y. Matches XMMatrixRotationRollPitchYaw
+    static Mat4 RotationRollPitchYaw(f32 pitch, f32 yaw, f32 roll)
+    {
+        const f32 cp = cosf(pitch), sp = sinf(pitch);
+        const f32 cy = cosf(yaw), sy = sinf(yaw);
+        const f32 cr = cosf(roll), sr = sinf(roll);
+
+        Mat4 result;
+        result.m[0][0] = cr * cy + sr * sp * sy;
+        result.m[0][1] = sr * cp;
+        result.m[0][2] = sr * sp * cy - cr * sy;
+        result.m[1][0] = cr * sp * sy - sr * cy;
+        result.m[1][1] = cr * cp;
+        result.m[1][2] = sr * sy + cr * sp * cy;
+        result.m[2][0] = cp * sy;
+        result.m[2][1] = -sp;
+        result.m[2][2] = cp * cy;
+        return result;
+    }
+
+    //Matches XMMatrixPerspectiveFovLH
+    static Mat4 PerspectiveFovLH(f32 fovY, f32 aspectRatio, f32 nearPlane, f32 farPlane)
+    {
+        const f32 height = 1.0f / tanf(0.5f * fovY);
+        const f32 range = farPlane / (farPlane - nearPlane);
+
+        Mat4 result;
+        result.m[0][0] = height / aspectRatio;
+        result.m[1][1] = height;
+        result.m[2][2] = range;
+        result.m[2][3] = 1.0f;
+        result.m[3][2] = -range * nearPlane;
+        result.m[3][3] = 0.0f;
+        return result;
+    }
+
+    //View matrix for a camera at eye looking at target. Matches XMMatrixLookAtLH
+    static Mat4 LookAtLH(const Vec3& eye, const Vec3& target, const Vec3& up)
+    {
+        Vec3 forward = Normalize({ target.x - eye.x, target.y - eye.y, target.z - eye.z });
+        Vec3 right = Normalize(Cross(up, forward));
+        Vec3 newUp = Cross(forward, right);
+
+        Mat4 result;
+        result.m[0][0] = right.x; result.m[0][1] = newUp.x; result.m[0][2] = forward.x;
+        result.m[1][0] = right.y; result.m[1][1] = newUp.y; result.m[1][2] = forward.y;
+        result.m[2][0] = right.z; result.m[2][1] = newUp.z; result.m[2][2] = forward.z;
+        result.m[3][0] = -Dot(right, eye);
+        result.m[3][1] = -Dot(newUp, eye);
+        result.m[3][2] = -Dot(forward, eye);
+        return result;
+    }
+
+    static f32 Dot(const Vec3& a, const Vec3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    static Vec3 Cross(const Vec3& a, const Vec3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    //Returns v unchanged if it has no length
+    static Vec3 Normalize(const Vec3& v)
+    {
+        f32 length = sqrtf(Dot(v, v));
+        if (length <= 0.0f)
+            return v;
+
+        return { v.x / length, v.y / length, v.z / length };
+    }
+};
@@ -0,0 +1,159 @@
+#include "SoftwareRasterizer.h"
+#include "util/MathUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static f32 Dot(const Vec3& a, const Vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vec3 Cross(const Vec3& a, const Vec3& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static Vec3 Normalize(const Vec3& v)
+{
+    f32 length = std::sqrt(Dot(v, v));
+    if (length <= 0.0f)
+        return { 0.0f, 0.0f, 0.0f };
+
+    return { v.x / length, v.y / length, v.z / length };
+}
+
+//Twice the signed area of the triangle abp in screen space. Used as the barycentric weight of the vertex opposite edge ab
+static f32 EdgeFunction(const Vec3& a, const Vec3& b, f32 px, f32 py)
+{
+    return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+}
+
+SoftwareRasterizer::SoftwareRasterizer(u32 width, u32 height) : width_(std::max(width, 1u)), height_(std::max(height, 1u))
+{
+    pixels_.resize((u64)width_ * height_ * 4);
+    depth_.resize((u64)width_ * height_);
+    Clear();
+}
+
+void SoftwareRasterizer::Clear(u32 color)
+{
+    for (u64 i = 0; i < depth_.size(); i++)
+        memcpy(pixels_.data() + i * 4, &color, 4);
+
+    std::fill(depth_.begin(), depth_.end(), std::numeric_limits<f32>::lowest());
+    trianglesDrawn_ = 0;
+}
+
+void SoftwareRasterizer::FitView(const Aabb& bounds, f32 yaw, f32 pitch)
+{
+    f32 yawRadians = ToRadians(yaw);
+    f32 pitchRadians = ToRadians(pitch);
+
+    //Forward points from the view center towards the camera
+    forward_ = { std::cos(pitchRadians) * std::sin(yawRadians), std::sin(pitchRadians), std::cos(pitchRadians) * std::cos(yawRadians) };
+    right_ = Normalize(Cross({ 0.0f, 1.0f, 0.0f }, forward_));
+    up_ = Cross(forward_, right_);
+
+    //Fit the bounding sphere instead of the box so the scale doesn't depend on the view angle. Leave a small margin around the edges
+    center_ = bounds.Valid() ? bounds.Center() : Vec3{ 0.0f, 0.0f, 0.0f };
+    Vec3 size = bounds.Valid() ? bounds.Size() : Vec3{ 0.0f, 0.0f, 0.0f };
+    f32 radius = 0.5f * std::sqrt(Dot(size, size));
+    if (radius <= 0.0f)
+        radius = 1.0f;
+
+    scale_ = 0.95f * (f32)std::min(width_, height_) / (2.0f * radius);
+}
+
+Vec3 SoftwareRasterizer::Project(const Vec3& point) const
+{
+    Vec3 offset = { point.x - center_.x, point.y - center_.y, point.z - center_.z };
+    return
+    {
+        (f32)width_ * 0.5f + Dot(offset, right_) * scale_,
+        (f32)height_ * 0.5f - Dot(offset, up_) * scale_,
+        Dot(offset, forward_)
+    };
+}
+
+void SoftwareRasterizer::DrawTriangle(const Vec3& a, const Vec3& b, const Vec3& c, const u8 color[3])
+{
+    Vec3 screenA = Project(a);
+    Vec3 screenB = Project(b);
+    Vec3 screenC = Project(c);
+    f32 area = EdgeFunction(screenA, screenB, screenC.x, screenC.y);
+    if (std::abs(area) < 1e-6f)
+        return;
+
+    //Light comes from over the cameras shoulder. Abs so back faces are lit the same as front faces
+    Vec3 normal = Normalize(Cross({ b.x - a.x, b.y - a.y, b.z - a.z }, { c.x - a.x, c.y - a.y, c.z - a.z }));
+    Vec3 light = Normalize({ forward_.x * 0.8f + up_.x * 0.5f - right_.x * 0.3f, forward_.y * 0.8f + up_.y * 0.5f - right_.y * 0.3f, forward_.z * 0.8f + up_.z * 0.5f - right_.z * 0.3f });
+    f32 intensity = 0.3f + 0.7f * std::abs(Dot(normal, light));
+    u8 shaded[4] = { (u8)(color[0] * intensity), (u8)(color[1] * intensity), (u8)(color[2] * intensity), 255 };
+
+    //Only visit pixels inside the triangles screen bounds
+    i32 minX = std::max(0, (i32)std::floor(std::min({ screenA.x, screenB.x, screenC.x })));
+    i32 minY = std::max(0, (i32)std::floor(std::min({ screenA.y, screenB.y, screenC.y })));
+    i32 maxX = std::min((i32)width_ - 1, (i32)std::ceil(std::max({ screenA.x, screenB.x, screenC.x })));
+    i32 maxY = std::min((i32)height_ - 1, (i32)std::ceil(std::max({ screenA.y, screenB.y, screenC.y })));
+    if (minX > maxX || minY > maxY)
+        return;
+
+    f32 invArea = 1.0f / area;
+    for (i32 y = minY; y <= maxY; y++)
+    {
+        f32 py = (f32)y + 0.5f;
+        for (i32 x = minX; x <= maxX; x++)
+        {
+            //Dividing by the signed area makes the weights positive inside the triangle for either winding
+            f32 px = (f32)x + 0.5f;
+            f32 weightA = EdgeFunction(screenB, screenC, px, py) * invArea;
+            f32 weightB = EdgeFunction(screenC, screenA, px, py) * invArea;
+            f32 weightC = 1.0f - weightA - weightB;
+            if (weightA < 0.0f || weightB < 0.0f || weightC < 0.0f)
+                continue;
+
+            u64 index = (u64)y * width_ + x;
+            f32 depth = weightA * screenA.z + weightB * screenB.z + weightC * screenC.z;
+            if (depth <= depth_[index])
+                continue;
+
+            depth_[index] = depth;
+            memcpy(pixels_.data() + index * 4, shaded, 4);
+        }
+    }
+    trianglesDrawn_++;
+}
+
+void SoftwareRasterizer::DrawIndexed(std::span<const u8> vertices, u32 stride, std::span<const u16> indices, bool triangleStrip, const u8 color[3])
+{
+    if (stride < sizeof(f32) * 3 || indices.size() < 3)
+        return;
+
+    u64 numVertices = vertices.size() / stride;
+    auto getPosition = [&](u16 index)
+    {
+        Vec3 position;
+        memcpy(&position.x, vertices.data() + (u64)index * stride, sizeof(f32));
+        memcpy(&position.y, vertices.data() + (u64)index * stride + 4, sizeof(f32));
+        memcpy(&position.z, vertices.data() + (u64)index * stride + 8, sizeof(f32));
+        return position;
+    };
+
+    u64 numTriangles = triangleStrip ? indices.size() - 2 : indices.size() / 3;
+    for (u64 i = 0; i < numTriangles; i++)
+    {
+        u64 first = triangleStrip ? i : i * 3;
+        u16 i0 = indices[first];
+        u16 i1 = indices[first + 1];
+        u16 i2 = indices[first + 2];
+        //Strips use repeated indices to join separate strips together
+        if (i0 == i1 || i1 == i2 || i0 == i2)
+            continue;
+        if (i0 >= numVertices || i1 >= numVertices || i2 >= numVertices)
+            continue;
+
+        DrawTriangle(getPosition(i0), getPosition(i1), getPosition(i2), color);
+    }
+}
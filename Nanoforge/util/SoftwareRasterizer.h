@@ -0,0 +1,47 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "util/Geometry.h"
+#include "RfgTools++/types/Vec3.h"
+#include <span>
+#include <vector>
+
+//Minimal CPU triangle rasterizer with a depth buffer. Used to render mesh previews on background threads without touching the GPU.
+//Draws with an orthographic camera looking at the center of a bounding box from a fixed angle, so any mesh fills the image regardless of its size.
+//Triangles are flat shaded from their face normal with two sided lighting since the winding of triangle strips alternates.
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer(u32 width, u32 height);
+
+    //Clear color and depth. Color is RGBA8
+    void Clear(u32 color = 0);
+    //Set the view so the bounding sphere of bounds fills the image. yaw and pitch are in degrees
+    void FitView(const Aabb& bounds, f32 yaw = 45.0f, f32 pitch = 30.0f);
+    //Draw a triangle with a base color (RGB) that's shaded by the angle between its face and the light
+    void DrawTriangle(const Vec3& a, const Vec3& b, const Vec3& c, const u8 color[3]);
+    //Draw indexed triangles from a vertex buffer with positions stored as 3 floats at the start of each vertex. Degenerate and out of range triangles are skipped
+    void DrawIndexed(std::span<const u8> vertices, u32 stride, std::span<const u16> indices, bool triangleStrip, const u8 color[3]);
+
+    //RGBA8 pixels, top row first
+    const std::vector<u8>& Pixels() const { return pixels_; }
+    u32 Width() const { return width_; }
+    u32 Height() const { return height_; }
+    u32 TrianglesDrawn() const { return trianglesDrawn_; }
+
+private:
+    //Transform a point into screen space. x and y are in pixels, z is depth with larger values closer to the camera
+    Vec3 Project(const Vec3& point) const;
+
+    u32 width_ = 0;
+    u32 height_ = 0;
+    std::vector<u8> pixels_ = {};
+    std::vector<f32> depth_ = {};
+    u32 trianglesDrawn_ = 0;
+
+    //Orthographic view. Rows of the rotation matrix, view center, and pixels per world unit
+    Vec3 right_ = { 1.0f, 0.0f, 0.0f };
+    Vec3 up_ = { 0.0f, 1.0f, 0.0f };
+    Vec3 forward_ = { 0.0f, 0.0f, 1.0f };
+    Vec3 center_ = { 0.0f, 0.0f, 0.0f };
+    f32 scale_ = 1.0f;
+};
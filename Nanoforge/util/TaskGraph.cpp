@@ -0,0 +1,136 @@
+#include "TaskGraph.h"
+#include "Log.h"
+
+bool Task::Completed()
+{
+    TaskState state = State();
+    return state == TaskState::Succeeded || state == TaskState::Failed;
+}
+
+TaskState Task::State()
+{
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    return state_;
+}
+
+void Task::Wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    stateChanged_.wait(lock, [this]() { return state_ == TaskState::Succeeded || state_ == TaskState::Failed; });
+}
+
+TaskGraph::~TaskGraph()
+{
+    WaitAll();
+}
+
+Handle<Task> TaskGraph::AddTask(const string& name, std::function<void()> func, const std::vector<Handle<Task>>& prerequisites)
+{
+    Handle<Task> task = CreateHandle<Task>(name, func);
+    std::lock_guard<std::mutex> lock(graphMutex_);
+
+    //Register with prerequisites that haven't completed yet. Those will launch this task when they finish
+    for (auto& prerequisite : prerequisites)
+    {
+        if (!prerequisite)
+            continue;
+
+        TaskState state = prerequisite->State();
+        if (state == TaskState::Failed)
+        {
+            task->prerequisiteFailed_ = true;
+        }
+        else if (state != TaskState::Succeeded)
+        {
+            prerequisite->dependents_.push_back(task);
+            task->numPendingPrerequisites_++;
+        }
+    }
+
+    if (task->numPendingPrerequisites_ == 0)
+        Launch(task);
+
+    return task;
+}
+
+void TaskGraph::WaitAll()
+{
+    //Tasks can launch other tasks when they finish, so keep waiting until no new futures are added
+    while (true)
+    {
+        std::vector<std::future<void>> futures;
+        {
+            std::lock_guard<std::mutex> lock(graphMutex_);
+            futures = std::move(futures_);
+            futures_.clear();
+        }
+        if (futures.size() == 0)
+            return;
+
+        for (auto& future : futures)
+            future.wait();
+    }
+}
+
+void TaskGraph::Launch(Handle<Task> task)
+{
+    //Skip the task if one of its prerequisites failed. Its dependents get skipped too
+    if (task->prerequisiteFailed_)
+    {
+        Log->warn("Skipped task \"{}\" since one of its prerequisites failed.", task->Name);
+        futures_.push_back(std::async(std::launch::async, &TaskGraph::Finish, this, task, TaskState::Failed));
+        return;
+    }
+
+    //Remove futures of tasks that already finished so the list doesn't grow forever
+    std::erase_if(futures_, [](std::future<void>& future) { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+
+    {
+        std::lock_guard<std::mutex> stateLock(task->stateMutex_);
+        task->state_ = TaskState::Running;
+    }
+    futures_.push_back(std::async(std::launch::async, &TaskGraph::Run, this, task));
+}
+
+void TaskGraph::Run(Handle<Task> task)
+{
+    TaskState finalState = TaskState::Succeeded;
+    try
+    {
+        task->func_();
+    }
+    catch (std::exception& ex)
+    {
+        Log->error("Task \"{}\" failed with exception: \"{}\"", task->Name, ex.what());
+        finalState = TaskState::Failed;
+    }
+    catch (...)
+    {
+        Log->error("Task \"{}\" failed with an unknown exception", task->Name);
+        finalState = TaskState::Failed;
+    }
+
+    Finish(task, finalState);
+}
+
+void TaskGraph::Finish(Handle<Task> task, TaskState finalState)
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+    {
+        std::lock_guard<std::mutex> stateLock(task->stateMutex_);
+        task->state_ = finalState;
+    }
+    task->stateChanged_.notify_all();
+
+    //Launch dependents that were only waiting on this task
+    for (auto& dependent : task->dependents_)
+    {
+        if (finalState == TaskState::Failed)
+            dependent->prerequisiteFailed_ = true;
+
+        dependent->numPendingPrerequisites_--;
+        if (dependent->numPendingPrerequisites_ == 0)
+            Launch(dependent);
+    }
+    task->dependents_.clear();
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+class TaskGraph;
+
+enum class TaskState
+{
+    Waiting, //Waiting for prerequisites to complete
+    Running,
+    Succeeded,
+    Failed //Task threw an exception or one of its prerequisites failed
+};
+
+//A unit of background work run by TaskGraph once all of its prerequisites are complete
+class Task
+{
+public:
+    Task(const string& name, std::function<void()> func) : Name(name), func_(func) {}
+
+    //Returns true if the task is done running, whether or not it succeeded
+    bool Completed();
+    bool Succeeded() { return State() == TaskState::Succeeded; }
+    bool Failed() { return State() == TaskState::Failed; }
+    TaskState State();
+    //Block the calling thread until the task is completed. Prefer making the waiting code a task with this as a prerequisite
+    void Wait();
+
+    const string Name;
+
+private:
+    friend class TaskGraph;
+
+    std::function<void()> func_;
+    //Tasks that have this one as a prerequisite
+    std::vector<Handle<Task>> dependents_ = {};
+    //Number of prerequisites that haven't completed yet. The task is launched when this reaches zero
+    u32 numPendingPrerequisites_ = 0;
+    bool prerequisiteFailed_ = false;
+
+    TaskState state_ = TaskState::Waiting;
+    std::mutex stateMutex_;
+    std::condition_variable stateChanged_;
+};
+
+//Runs background tasks on worker threads as soon as their prerequisites are complete. Used for startup and document loading
+//so independent steps overlap (e.g. localization loading and territory zone parsing) instead of running one after another or spin waiting.
+class TaskGraph
+{
+public:
+    ~TaskGraph();
+
+    //Adds a task that runs on a worker thread once all prerequisites complete. Runs immediately if they're already complete.
+    //If a prerequisite fails the task is marked as failed without being run.
+    Handle<Task> AddTask(const string& name, std::function<void()> func, const std::vector<Handle<Task>>& prerequisites = {});
+    //Block until every task added so far has completed
+    void WaitAll();
+
+private:
+    //Start running a task whose prerequisites are complete. Must be called with graphMutex_ locked
+    void Launch(Handle<Task> task);
+    void Run(Handle<Task> task);
+    //Set the final state of a task and launch any dependents that are now ready
+    void Finish(Handle<Task> task, TaskState finalState);
+
+    std::mutex graphMutex_;
+    //Must store futures for std::async to run functions asynchronously
+    std::vector<std::future<void>> futures_ = {};
+};
@@ -0,0 +1,245 @@
+#include "TextureStreamer.h"
+#include "Log.h"
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::TextureStreamer(u64 budget, u32 numDecodeThreads) : budget_(budget)
+{
+    for (u32 i = 0; i < std::max(numDecodeThreads, 1u); i++)
+        threads_.push_back(std::async(std::launch::async, [this]() { DecodeThread(); }));
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    Stop();
+}
+
+u32 TextureStreamer::Add(StreamedTextureDesc desc)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Texture& texture = textures_.emplace_back();
+    texture.NumMips = (u32)desc.MipSizes.size();
+    texture.ResidentMip = texture.NumMips;
+    texture.PendingMip = texture.NumMips;
+    texture.Desc = std::move(desc);
+    return (u32)textures_.size() - 1;
+}
+
+void TextureStreamer::Update(const Vec3& cameraPosition, f32 pixelsPerUnit, std::span<const u32> visible)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    frame_++;
+
+    //Find visible textures that need finer mips or have far more resident than they need
+    struct Request
+    {
+        u32 Id = 0;
+        u32 Mip = 0;
+        f32 Distance = 0.0f;
+    };
+    std::vector<Request> requests = {};
+    for (u32 id : visible)
+    {
+        if (id >= textures_.size())
+            continue;
+
+        Texture& texture = textures_[id];
+        texture.LastUsedFrame = frame_;
+        if (texture.Failed || texture.NumMips == 0 || texture.PendingMip < texture.NumMips)
+            continue;
+
+        //Distance to the closest point of the area covered by the texture
+        const StreamedTextureDesc& desc = texture.Desc;
+        f32 halfSize = desc.WorldSize / 2.0f;
+        f32 dx = std::max(std::abs(cameraPosition.x - desc.Center.x) - halfSize, 0.0f);
+        f32 dz = std::max(std::abs(cameraPosition.z - desc.Center.z) - halfSize, 0.0f);
+        f32 dy = cameraPosition.y - desc.Center.y;
+        f32 distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        //Textures with nothing resident start with their small mips so they're drawn textured even when the budget is tight. They're refined on later frames
+        u32 mip = ChooseMip(desc, distance, pixelsPerUnit);
+        if (texture.ResidentMip == texture.NumMips)
+        {
+            u32 baseMip = 0;
+            while (baseMip + 1 < texture.NumMips && std::max(desc.Width, desc.Height) >> baseMip > BaseMipSize)
+                baseMip++;
+            mip = std::max(mip, baseMip);
+        }
+        bool needsFinerMips = mip < texture.ResidentMip;
+        bool wastingMemory = texture.ResidentMip < texture.NumMips && mip > texture.ResidentMip + 1;
+        if (needsFinerMips || wastingMemory)
+            requests.push_back({ id, mip, distance });
+    }
+
+    //Nearest textures get first pick of the budget
+    std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) { return a.Distance < b.Distance; });
+    for (const Request& request : requests)
+    {
+        if (QueueDecode(request.Id, request.Mip, request.Distance))
+            continue;
+
+        //Settle for the finest mip that fits
+        const Texture& texture = textures_[request.Id];
+        for (u32 mip = request.Mip + 1; mip < texture.ResidentMip; mip++)
+            if (QueueDecode(request.Id, mip, request.Distance))
+                break;
+    }
+}
+
+std::vector<StreamedTextureUpdate> TextureStreamer::TakeUpdates()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    std::vector<StreamedTextureUpdate> updates = std::move(updates_);
+    updates_.clear();
+    return updates;
+}
+
+void TextureStreamer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    decodeQueueChanged_.notify_all();
+    for (auto& thread : threads_)
+        thread.wait();
+
+    threads_.clear();
+}
+
+u32 TextureStreamer::ChooseMip(const StreamedTextureDesc& desc, f32 distance, f32 pixelsPerUnit)
+{
+    if (desc.MipSizes.size() == 0 || desc.WorldSize <= 0.0f || pixelsPerUnit <= 0.0f)
+        return 0;
+
+    //Texels that land on one pixel. Each mip halves it
+    f32 texelsPerUnit = (f32)desc.Width / desc.WorldSize;
+    f32 pixelsPerWorldUnit = pixelsPerUnit / std::max(distance, 1.0f);
+    f32 texelsPerPixel = texelsPerUnit / pixelsPerWorldUnit;
+    if (texelsPerPixel <= 1.0f)
+        return 0;
+
+    u32 mip = (u32)std::floor(std::log2(texelsPerPixel));
+    return std::min(mip, (u32)desc.MipSizes.size() - 1);
+}
+
+u32 TextureStreamer::ResidentMip(u32 id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return textures_[id].ResidentMip;
+}
+
+u64 TextureStreamer::BytesUsed()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return residentBytes_ + reservedBytes_;
+}
+
+u64 TextureStreamer::ChainSize(const Texture& texture, u32 firstMip)
+{
+    u64 size = 0;
+    for (u32 mip = firstMip; mip < texture.NumMips; mip++)
+        size += texture.Desc.MipSizes[mip];
+
+    return size;
+}
+
+bool TextureStreamer::QueueDecode(u32 id, u32 firstMip, f32 distance)
+{
+    //Only the growth is reserved. The old mips are released once the new ones are uploaded
+    Texture& texture = textures_[id];
+    u64 newSize = ChainSize(texture, firstMip);
+    u64 oldSize = ChainSize(texture, texture.ResidentMip);
+    u64 growth = newSize > oldSize ? newSize - oldSize : 0;
+    if (growth > 0 && !MakeRoom(growth))
+        return false;
+
+    texture.PendingMip = firstMip;
+    texture.PendingBytes = growth;
+    reservedBytes_ += growth;
+    decodeQueue_.push_back({ id, firstMip, distance });
+    decodeQueueChanged_.notify_one();
+    return true;
+}
+
+bool TextureStreamer::MakeRoom(u64 bytes)
+{
+    while (residentBytes_ + reservedBytes_ + bytes > budget_)
+    {
+        //Textures in view this frame and textures being decoded are never evicted
+        u32 leastRecentlyUsed = InvalidId;
+        for (u32 i = 0; i < textures_.size(); i++)
+        {
+            const Texture& texture = textures_[i];
+            if (texture.LastUsedFrame >= frame_ || texture.ResidentMip >= texture.NumMips || texture.PendingMip < texture.NumMips)
+                continue;
+            if (leastRecentlyUsed == InvalidId || texture.LastUsedFrame < textures_[leastRecentlyUsed].LastUsedFrame)
+                leastRecentlyUsed = i;
+        }
+        if (leastRecentlyUsed == InvalidId)
+            return false;
+
+        Evict(leastRecentlyUsed);
+    }
+
+    return true;
+}
+
+void TextureStreamer::Evict(u32 id)
+{
+    Texture& texture = textures_[id];
+    residentBytes_ -= ChainSize(texture, texture.ResidentMip);
+    texture.ResidentMip = texture.NumMips;
+    updates_.push_back({ id, texture.NumMips, {} });
+}
+
+void TextureStreamer::DecodeThread()
+{
+    while (true)
+    {
+        //Take the nearest queued texture. Decode is copied so it can run without holding the lock
+        DecodeJob job;
+        std::function<std::vector<StreamedMip>(u32 firstMip)> decode;
+        string name;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            decodeQueueChanged_.wait(lock, [this]() { return stop_ || decodeQueue_.size() > 0; });
+            if (stop_)
+                return;
+
+            auto nearest = std::min_element(decodeQueue_.begin(), decodeQueue_.end(), [](const DecodeJob& a, const DecodeJob& b) { return a.Distance < b.Distance; });
+            job = *nearest;
+            *nearest = decodeQueue_.back();
+            decodeQueue_.pop_back();
+            decode = textures_[job.Id].Desc.Decode;
+            name = textures_[job.Id].Desc.Name;
+        }
+
+        std::vector<StreamedMip> mips = {};
+        bool succeeded = false;
+        try
+        {
+            mips = decode(job.FirstMip);
+            succeeded = true;
+        }
+        catch (std::exception& ex)
+        {
+            Log->error("Failed to decode streamed texture {}. Error: {}", name, ex.what());
+        }
+
+        std::lock_guard<std::mutex> lock(lock_);
+        Texture& texture = textures_[job.Id];
+        reservedBytes_ -= texture.PendingBytes;
+        texture.PendingBytes = 0;
+        texture.PendingMip = texture.NumMips;
+        if (!succeeded || mips.size() != texture.NumMips - job.FirstMip)
+        {
+            texture.Failed = true;
+            continue;
+        }
+
+        residentBytes_ = residentBytes_ - ChainSize(texture, texture.ResidentMip) + ChainSize(texture, job.FirstMip);
+        texture.ResidentMip = job.FirstMip;
+        updates_.push_back({ job.Id, job.FirstMip, std::move(mips) });
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "RfgTools++/types/Vec3.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <span>
+#include <vector>
+
+//Single mip level of a streamed texture
+struct StreamedMip
+{
+    u32 Width = 0;
+    u32 Height = 0;
+    std::vector<u8> Data = {};
+};
+
+//Texture managed by TextureStreamer
+struct StreamedTextureDesc
+{
+    string Name;
+    u32 Width = 0;
+    u32 Height = 0;
+    //Size in bytes of each mip level, largest first. Used for budgeting before any data is decoded
+    std::vector<u64> MipSizes = {};
+    //Center and side length of the square in world space the texture covers. Used to pick mips by camera distance
+    Vec3 Center;
+    f32 WorldSize = 1.0f;
+    //Decode mips [firstMip, MipSizes.size()). Called on a decode thread, so it must only use data it owns
+    std::function<std::vector<StreamedMip>(u32 firstMip)> Decode;
+};
+
+//Change to a textures resident mips for the renderer to apply. Mips is empty if the texture was evicted
+struct StreamedTextureUpdate
+{
+    u32 Id = 0;
+    u32 FirstMip = 0;
+    std::vector<StreamedMip> Mips = {};
+};
+
+//Keeps the mip levels of textures resident based on camera distance under a fixed byte budget. Doesn't use the GPU so residency decisions can be tested on their own.
+//Call Update() once per frame with the textures in view, then upload the results of TakeUpdates().
+//Mips are decoded on worker threads, nearest textures first. When the budget is full the least recently used textures that aren't in view are evicted.
+//If that isn't enough the request falls back to the finest mip that fits.
+class TextureStreamer
+{
+public:
+    static constexpr u32 InvalidId = 0xFFFFFFFF;
+    //Largest side in pixels of the first mips loaded for a texture
+    static constexpr u32 BaseMipSize = 64;
+
+    TextureStreamer(u64 budget, u32 numDecodeThreads);
+    ~TextureStreamer();
+
+    //Start managing a texture. Nothing is resident until it's passed to Update() as visible
+    u32 Add(StreamedTextureDesc desc);
+    //Pick the mips wanted by each visible texture and queue decodes. pixelsPerUnit converts a world size at distance 1 into pixels (see TerrainLodTree::ErrorToPixels())
+    void Update(const Vec3& cameraPosition, f32 pixelsPerUnit, std::span<const u32> visible);
+    //Get decoded textures and evictions since the last call
+    std::vector<StreamedTextureUpdate> TakeUpdates();
+    //Stop decoding. Blocks until the decode threads exit. Called by the destructor
+    void Stop();
+
+    //Finest mip needed for a texture at a distance. Mip 0 when a texel covers a pixel or more
+    static u32 ChooseMip(const StreamedTextureDesc& desc, f32 distance, f32 pixelsPerUnit);
+    //Finest resident mip of a texture. Equal to the number of mips if nothing is resident
+    u32 ResidentMip(u32 id);
+    //Bytes of resident mips plus bytes reserved by queued decodes
+    u64 BytesUsed();
+    u64 Budget() const { return budget_; }
+
+private:
+    struct Texture
+    {
+        StreamedTextureDesc Desc;
+        u32 NumMips = 0;
+        u32 ResidentMip = 0;
+        //Mip being decoded. NumMips if there's no decode queued
+        u32 PendingMip = 0;
+        u64 PendingBytes = 0;
+        u64 LastUsedFrame = 0;
+        //Stop requesting textures that failed to decode
+        bool Failed = false;
+    };
+    struct DecodeJob
+    {
+        u32 Id = 0;
+        u32 FirstMip = 0;
+        f32 Distance = 0.0f;
+    };
+
+    //Bytes needed to keep mips [firstMip, NumMips) resident
+    static u64 ChainSize(const Texture& texture, u32 firstMip);
+    //Queue a decode of mips [firstMip, NumMips). Reserves the bytes it adds to the texture. Returns false if there's no room even after evicting
+    bool QueueDecode(u32 id, u32 firstMip, f32 distance);
+    //Evict least recently used textures that weren't in view this frame until bytes fit in the budget
+    bool MakeRoom(u64 bytes);
+    void Evict(u32 id);
+    void DecodeThread();
+
+    std::vector<Texture> textures_ = {};
+    std::vector<DecodeJob> decodeQueue_ = {};
+    std::vector<StreamedTextureUpdate> updates_ = {};
+    std::vector<std::future<void>> threads_ = {};
+    std::mutex lock_;
+    std::condition_variable decodeQueueChanged_;
+    u64 budget_ = 0;
+    u64 residentBytes_ = 0;
+    u64 reservedBytes_ = 0;
+    u64 frame_ = 0;
+    bool stop_ = false;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+//Number of worker threads to use for parallel work. Leaves one core free for the main thread so the gui stays responsive
+inline u32 WorkerThreadCount()
+{
+    u32 numCores = std::thread::hardware_concurrency();
+    return numCores > 1 ? numCores - 1 : 1;
+}
+
+//Calls func(i) for each i in [0, count) using a bounded number of worker threads. Blocks until all calls are done.
+//Each worker pulls the next index from a shared counter so uneven workloads still balance out. Results should be written
+//to a pre-sized output at index i so the final order is deterministic regardless of which thread ran which index.
+//Exceptions thrown by func are rethrown on the calling thread once all workers have exited.
+template<typename Func>
+void ParallelFor(u32 count, Func&& func, u32 maxThreads = 0)
+{
+    if (count == 0)
+        return;
+
+    u32 numThreads = std::min(maxThreads == 0 ? WorkerThreadCount() : maxThreads, count);
+    if (numThreads <= 1)
+    {
+        for (u32 i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+
+    std::atomic<u32> nextIndex = 0;
+    auto worker = [&]()
+    {
+        u32 i;
+        while ((i = nextIndex.fetch_add(1)) < count)
+            func(i);
+    };
+
+    //Must store futures for std::async to run functions asynchronously
+    std::vector<std::future<void>> futures;
+    for (u32 i = 0; i < numThreads; i++)
+        futures.push_back(std::async(std::launch::async, worker));
+
+    //Wait for every worker before rethrowing so none are left referencing this stack frame
+    for (auto& future : futures)
+        future.wait();
+    for (auto& future : futures)
+        future.get();
+}
@@ -0,0 +1,106 @@
+#include "VisibilityCuller.h"
+#include <algorithm>
+
+static bool SameBounds(const Aabb& a, const Aabb& b)
+{
+    return a.Min.x == b.Min.x && a.Min.y == b.Min.y && a.Min.z == b.Min.z &&
+           a.Max.x == b.Max.x && a.Max.y == b.Max.y && a.Max.z == b.Max.z;
+}
+
+void VisibilityCuller::SetBounds(std::span<const Aabb> bounds)
+{
+    //Adding or removing objects changes the tree structure so it must be rebuilt
+    if (bounds.size() != bounds_.size())
+    {
+        bounds_.assign(bounds.begin(), bounds.end());
+        Rebuild();
+        return;
+    }
+
+    //Refit if objects only moved. Rebuild if one gained or lost its bounds since that changes which objects are in the tree
+    bool moved = false;
+    for (u32 i = 0; i < bounds.size(); i++)
+    {
+        if (SameBounds(bounds[i], bounds_[i]))
+            continue;
+        if (bounds[i].Valid() != bounds_[i].Valid())
+        {
+            bounds_.assign(bounds.begin(), bounds.end());
+            Rebuild();
+            return;
+        }
+
+        bounds_[i] = bounds[i];
+        moved = true;
+    }
+    if (!moved || !useBvh_)
+        return;
+
+    for (u32 i = 0; i < bvhObjects_.size(); i++)
+        bvhBounds_[i] = bounds_[bvhObjects_[i]];
+
+    bvh_.Refit(bvhBounds_);
+}
+
+void VisibilityCuller::Cull(const Frustum& frustum, const Vec3& cameraPosition, f32 maxDistance, std::vector<u32>& output) const
+{
+    output.clear();
+    bool limitDistance = maxDistance > 0.0f;
+    if (useBvh_)
+    {
+        if (limitDistance)
+            bvh_.QueryFrustumSphere(frustum, cameraPosition, maxDistance, output);
+        else
+            bvh_.QueryFrustum(frustum, output);
+
+        //Convert Bvh primitives to object indices
+        for (u32& index : output)
+            index = bvhObjects_[index];
+
+        output.insert(output.end(), unbounded_.begin(), unbounded_.end());
+        std::sort(output.begin(), output.end());
+        return;
+    }
+
+    for (u32 i = 0; i < bounds_.size(); i++)
+    {
+        const Aabb& box = bounds_[i];
+        if (!box.Valid() || ((!limitDistance || box.IntersectsSphere(cameraPosition, maxDistance)) && frustum.Intersects(box)))
+            output.push_back(i);
+    }
+}
+
+void VisibilityCuller::Clear()
+{
+    bounds_.clear();
+    unbounded_.clear();
+    bvhObjects_.clear();
+    bvhBounds_.clear();
+    bvh_.Clear();
+    useBvh_ = false;
+}
+
+void VisibilityCuller::Rebuild()
+{
+    unbounded_.clear();
+    bvhObjects_.clear();
+    bvhBounds_.clear();
+    for (u32 i = 0; i < bounds_.size(); i++)
+    {
+        if (bounds_[i].Valid())
+        {
+            bvhObjects_.push_back(i);
+            bvhBounds_.push_back(bounds_[i]);
+        }
+        else
+        {
+            unbounded_.push_back(i);
+        }
+    }
+
+    useBvh_ = bvhObjects_.size() >= MinBvhObjects;
+    if (useBvh_)
+        bvh_.Build(bvhBounds_);
+    else
+        bvh_.Clear();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "util/Geometry.h"
+#include "util/Bvh.h"
+#include <span>
+#include <vector>
+
+//Finds the objects in view of a camera from their world space bounds. Doesn't use the renderer so it can be tested and benchmarked on its own.
+//Small object counts are tested one by one. Larger ones go through a Bvh which is refit when bounds move and rebuilt when objects are added or removed.
+class VisibilityCuller
+{
+public:
+    //Set the bounds of each object. Cheap to call every frame if nothing changed. Objects with invalid bounds are never culled
+    void SetBounds(std::span<const Aabb> bounds);
+    //Get the objects that intersect the frustum, sorted by index. maxDistance is the furthest distance from the camera an object can be drawn at. <= 0 disables it
+    void Cull(const Frustum& frustum, const Vec3& cameraPosition, f32 maxDistance, std::vector<u32>& output) const;
+    void Clear();
+    u32 NumObjects() const { return (u32)bounds_.size(); }
+    bool UsingBvh() const { return useBvh_; }
+
+    //Below this many objects a linear scan is faster than walking the Bvh
+    static constexpr u32 MinBvhObjects = 64;
+
+private:
+    //Rebuild the Bvh over the objects with valid bounds
+    void Rebuild();
+
+    std::vector<Aabb> bounds_ = {};
+    //Objects with invalid bounds. Always in the output
+    std::vector<u32> unbounded_ = {};
+    //Object index of each Bvh primitive and the bounds passed to the Bvh
+    std::vector<u32> bvhObjects_ = {};
+    std::vector<Aabb> bvhBounds_ = {};
+    Bvh bvh_;
+    bool useBvh_ = false;
+};
@@ -0,0 +1,126 @@
+#include "rfg/TerrainGeometry.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+//Benchmarks GenerateTerrainNormals() on synthetic terrain grids and checks it against a plain scalar version.
+//Grids are laid out like low lod terrain meshes: one triangle strip with degenerate triangles joining each row
+
+struct TerrainGrid
+{
+    std::vector<LowLodTerrainVertex> Vertices = {};
+    std::vector<u16> Indices = {};
+};
+
+static TerrainGrid MakeGrid(u32 size)
+{
+    TerrainGrid grid;
+    const f32 spacing = 65535.0f / (f32)(size - 1);
+    for (u32 z = 0; z < size; z++)
+    {
+        for (u32 x = 0; x < size; x++)
+        {
+            f32 height = 4000.0f * std::sin(x * 0.11f) * std::cos(z * 0.07f) + 1500.0f * std::sin((x + z) * 0.31f);
+            grid.Vertices.push_back({ (i16)(-32768.0f + x * spacing), (i16)height, (i16)(-32768.0f + z * spacing), 0 });
+        }
+    }
+    for (u32 z = 0; z + 1 < size; z++)
+    {
+        //Repeat the last index of the previous row and the first of this one so the rows are joined by degenerate triangles
+        if (z > 0)
+            grid.Indices.push_back((u16)(z * size));
+        for (u32 x = 0; x < size; x++)
+        {
+            grid.Indices.push_back((u16)(z * size + x));
+            grid.Indices.push_back((u16)((z + 1) * size + x));
+        }
+        if (z + 2 < size)
+            grid.Indices.push_back((u16)((z + 1) * size + size - 1));
+    }
+    return grid;
+}
+
+//Straightforward version used as the reference. One triangle at a time reading vertices through the index buffer
+static void GenerateNormalsScalar(std::span<const u16> indices, std::span<LowLodTerrainVertex> vertices)
+{
+    std::vector<Vec3> sums(vertices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i++)
+    {
+        const LowLodTerrainVertex& a = vertices[indices[i]];
+        const LowLodTerrainVertex& b = vertices[indices[i + 1]];
+        const LowLodTerrainVertex& c = vertices[indices[i + 2]];
+        f32 e1x = (f32)b.x - a.x, e1y = (f32)b.y - a.y, e1z = (f32)b.z - a.z;
+        f32 e2x = (f32)c.x - b.x, e2y = (f32)c.y - b.y, e2z = (f32)c.z - b.z;
+        Vec3 normal = { e1y * e2z - e1z * e2y, e1z * e2x - e1x * e2z, e1x * e2y - e1y * e2x };
+        if (normal.y < 0.0f)
+            normal = { -normal.x, -normal.y, -normal.z };
+
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            Vec3& sum = sums[indices[i + corner]];
+            sum = { sum.x + normal.x, sum.y + normal.y, sum.z + normal.z };
+        }
+    }
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const Vec3& sum = sums[i];
+        f32 length = std::sqrt(sum.x * sum.x + sum.y * sum.y + sum.z * sum.z);
+        vertices[i].normal = length > 0.0f ? Vec3{ sum.x / length, sum.y / length, sum.z / length } : Vec3{ 0.0f, 1.0f, 0.0f };
+    }
+}
+
+using NormalsFunc = void(*)(std::span<const u16>, std::span<LowLodTerrainVertex>);
+
+//Run func on a copy of the grid vertices until at least minSeconds have passed. Returns the average milliseconds per call
+static f64 Time(NormalsFunc func, const TerrainGrid& grid, std::vector<LowLodTerrainVertex>& output, f64 minSeconds)
+{
+    using Clock = std::chrono::steady_clock;
+    u32 iterations = 0;
+    Clock::time_point start = Clock::now();
+    f64 elapsed = 0.0;
+    do
+    {
+        output = grid.Vertices;
+        func(grid.Indices, output);
+        iterations++;
+        elapsed = std::chrono::duration<f64>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+
+    return elapsed * 1000.0 / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    //Pass --quick to run each case once. Used to check results without waiting for stable timings
+    bool quick = argc > 1 && std::string_view(argv[1]) == "--quick";
+    const f64 minSeconds = quick ? 0.0 : 0.5;
+
+    bool passed = true;
+    printf("%-12s %12s %12s %12s %10s %12s\n", "Grid", "Vertices", "Scalar (ms)", "SSE (ms)", "Speedup", "Max error");
+    for (u32 size : { 33u, 65u, 129u, 181u })
+    {
+        TerrainGrid grid = MakeGrid(size);
+        std::vector<LowLodTerrainVertex> expected(grid.Vertices.size());
+        std::vector<LowLodTerrainVertex> actual(grid.Vertices.size());
+        f64 scalarMs = Time(&GenerateNormalsScalar, grid, expected, minSeconds);
+        f64 simdMs = Time(&GenerateTerrainNormals, grid, actual, minSeconds);
+
+        f32 maxError = 0.0f;
+        for (size_t i = 0; i < grid.Vertices.size(); i++)
+        {
+            maxError = std::max(maxError, std::abs(expected[i].normal.x - actual[i].normal.x));
+            maxError = std::max(maxError, std::abs(expected[i].normal.y - actual[i].normal.y));
+            maxError = std::max(maxError, std::abs(expected[i].normal.z - actual[i].normal.z));
+        }
+        passed &= maxError < 1e-4f;
+
+        string name = std::to_string(size) + "x" + std::to_string(size);
+        printf("%-12s %12zu %12.4f %12.4f %9.2fx %12g\n", name.c_str(), grid.Vertices.size(), scalarMs, simdMs, scalarMs / simdMs, maxError);
+    }
+
+    if (!passed)
+        printf("GenerateTerrainNormals() doesn't match the scalar reference\n");
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+#include "Test.h"
+#include "util/HeightfieldPyramid.h"
+#include <optional>
+#include <random>
+
+//Synthetic heightfield with hills and a few sharp spikes so rays can pass over, between, and into them
+struct TestHeightfield
+{
+    u32 Resolution = 0;
+    Vec3 Origin;
+    f32 Spacing = 0.0f;
+    std::vector<f32> Heights = {};
+
+    TestHeightfield(u32 resolution, const Vec3& origin, f32 spacing) : Resolution(resolution), Origin(origin), Spacing(spacing)
+    {
+        Heights.resize(resolution * resolution);
+        for (u32 z = 0; z < resolution; z++)
+        {
+            for (u32 x = 0; x < resolution; x++)
+            {
+                f32 height = 20.0f * std::sin(x * 0.21f) * std::cos(z * 0.13f) + 5.0f * std::sin((x + 2 * z) * 0.7f);
+                if (x % 17 == 5 && z % 13 == 7)
+                    height += 60.0f;
+
+                Heights[z * resolution + x] = height;
+            }
+        }
+    }
+
+    Vec3 Vertex(u32 x, u32 z) const { return { Origin.x + x * Spacing, Origin.y + Heights[z * Resolution + x], Origin.z + z * Spacing }; }
+};
+
+//Moller-Trumbore. Kept separate from the one in HeightfieldPyramid.cpp so the test doesn't share its bugs
+static std::optional<f32> RayTriangle(const Ray& ray, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+    Vec3 e1 = { b.x - a.x, b.y - a.y, b.z - a.z };
+    Vec3 e2 = { c.x - a.x, c.y - a.y, c.z - a.z };
+    const Vec3& d = ray.Direction;
+    Vec3 p = { d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x };
+    f64 determinant = (f64)e1.x * p.x + (f64)e1.y * p.y + (f64)e1.z * p.z;
+    if (std::abs(determinant) < 1e-12)
+        return {};
+
+    Vec3 s = { ray.Origin.x - a.x, ray.Origin.y - a.y, ray.Origin.z - a.z };
+    f64 u = ((f64)s.x * p.x + (f64)s.y * p.y + (f64)s.z * p.z) / determinant;
+    Vec3 q = { s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x };
+    f64 v = ((f64)d.x * q.x + (f64)d.y * q.y + (f64)d.z * q.z) / determinant;
+    f64 t = ((f64)e2.x * q.x + (f64)e2.y * q.y + (f64)e2.z * q.z) / determinant;
+    if (u < 0.0 || v < 0.0 || u + v > 1.0 || t < 0.0)
+        return {};
+
+    return (f32)t;
+}
+
+//Test the ray against both triangles of every cell. Cells are split the same way as the pyramid and the terrain LOD patches
+static std::optional<f32> RaycastBruteForce(const TestHeightfield& field, const Ray& ray, f32 maxDistance)
+{
+    std::optional<f32> closest = {};
+    for (u32 z = 0; z + 1 < field.Resolution; z++)
+    {
+        for (u32 x = 0; x + 1 < field.Resolution; x++)
+        {
+            Vec3 v00 = field.Vertex(x, z), v10 = field.Vertex(x + 1, z), v01 = field.Vertex(x, z + 1), v11 = field.Vertex(x + 1, z + 1);
+            for (std::optional<f32> hit : { RayTriangle(ray, v00, v01, v10), RayTriangle(ray, v10, v01, v11) })
+                if (hit && hit.value() <= maxDistance && (!closest || hit.value() < closest.value()))
+                    closest = hit;
+        }
+    }
+    return closest;
+}
+
+static Vec3 Normalized(const Vec3& v)
+{
+    f32 length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    return { v.x / length, v.y / length, v.z / length };
+}
+
+TEST(HeightfieldPyramidSampleHeight)
+{
+    TestHeightfield field(37, { -100.0f, 10.0f, 50.0f }, 4.0f);
+    HeightfieldPyramid pyramid;
+    pyramid.Build(field.Heights, field.Resolution, field.Origin, field.Spacing);
+    CHECK(!pyramid.Empty());
+
+    //Exact at samples and linear between them along an edge
+    for (u32 z = 0; z < field.Resolution; z += 5)
+    {
+        for (u32 x = 0; x < field.Resolution; x += 3)
+        {
+            Vec3 vertex = field.Vertex(x, z);
+            std::optional<f32> height = pyramid.SampleHeight(vertex.x, vertex.z);
+            CHECK(height.has_value());
+            CHECK_NEAR(height.value_or(0.0f), vertex.y, 1e-3f);
+        }
+    }
+    Vec3 a = field.Vertex(10, 10), b = field.Vertex(11, 10);
+    CHECK_NEAR(pyramid.SampleHeight((a.x + b.x) * 0.5f, a.z).value_or(0.0f), (a.y + b.y) * 0.5f, 1e-3f);
+
+    //Outside the grid
+    CHECK(!pyramid.SampleHeight(field.Origin.x - 1.0f, field.Origin.z + 10.0f).has_value());
+    CHECK(!pyramid.SampleHeight(field.Origin.x + 10.0f, field.Origin.z + field.Spacing * field.Resolution).has_value());
+}
+
+TEST(HeightfieldPyramidRaycastMatchesBruteForce)
+{
+    //Odd cell counts make the pyramid levels round up, which is where edge cells are easiest to miss
+    for (u32 resolution : { 2u, 9u, 38u, 65u })
+    {
+        TestHeightfield field(resolution, { -100.0f, 10.0f, 50.0f }, 4.0f);
+        HeightfieldPyramid pyramid;
+        pyramid.Build(field.Heights, field.Resolution, field.Origin, field.Spacing);
+        const Aabb bounds = pyramid.Bounds();
+        const Vec3 center = bounds.Center();
+        const Vec3 size = bounds.Size();
+
+        std::mt19937 random(resolution);
+        std::uniform_real_distribution<f32> unit(0.0f, 1.0f);
+        u32 hits = 0;
+        u32 mismatches = 0;
+        for (u32 i = 0; i < 400; i++)
+        {
+            //Rays from above and around the field aimed at random points in its bounds. Some graze it at low angles
+            Vec3 origin = { center.x + (unit(random) - 0.5f) * size.x * 2.0f, bounds.Max.y + unit(random) * 100.0f - 30.0f, center.z + (unit(random) - 0.5f) * size.z * 2.0f };
+            Vec3 target = { bounds.Min.x + unit(random) * size.x, bounds.Min.y + unit(random) * size.y, bounds.Min.z + unit(random) * size.z };
+            Ray ray = { origin, Normalized({ target.x - origin.x, target.y - origin.y, target.z - origin.z }) };
+            f32 maxDistance = i % 4 == 0 ? 50.0f + unit(random) * 200.0f : std::numeric_limits<f32>::max();
+
+            std::optional<f32> expected = RaycastBruteForce(field, ray, maxDistance);
+            std::optional<f32> actual = pyramid.Raycast(ray, maxDistance);
+            if (expected)
+                hits++;
+
+            //Hits right at maxDistance can go either way from rounding
+            bool nearLimit = expected && std::abs(expected.value() - maxDistance) < 1e-2f;
+            if (!nearLimit && (expected.has_value() != actual.has_value() || (expected && std::abs(expected.value() - actual.value()) > 1e-2f)))
+            {
+                mismatches++;
+                printf("    resolution %u ray %u: expected %g, got %g\n", resolution, i, expected.value_or(-1.0f), actual.value_or(-1.0f));
+            }
+        }
+        CHECK(mismatches == 0);
+        //Make sure the rays actually exercised the hit path
+        CHECK(hits > 50);
+    }
+}
+
+TEST(HeightfieldPyramidRaycastEdgeCases)
+{
+    TestHeightfield field(33, { 0.0f, 0.0f, 0.0f }, 2.0f);
+    HeightfieldPyramid pyramid;
+    CHECK(!pyramid.Raycast({ { 0.0f, 100.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } }).has_value());
+
+    pyramid.Build(field.Heights, field.Resolution, field.Origin, field.Spacing);
+
+    //Straight down onto a sample is the sample height
+    Vec3 vertex = field.Vertex(12, 20);
+    std::optional<f32> down = pyramid.Raycast({ { vertex.x, 500.0f, vertex.z }, { 0.0f, -1.0f, 0.0f } });
+    CHECK(down.has_value());
+    CHECK_NEAR(down.value_or(0.0f), 500.0f - vertex.y, 1e-3f);
+
+    //Pointing away or stopping short
+    CHECK(!pyramid.Raycast({ { vertex.x, 500.0f, vertex.z }, { 0.0f, 1.0f, 0.0f } }).has_value());
+    CHECK(!pyramid.Raycast({ { vertex.x, 500.0f, vertex.z }, { 0.0f, -1.0f, 0.0f } }, 100.0f).has_value());
+    //Outside the grid
+    CHECK(!pyramid.Raycast({ { -10.0f, 500.0f, -10.0f }, { 0.0f, -1.0f, 0.0f } }).has_value());
+
+    pyramid.Clear();
+    CHECK(pyramid.Empty());
+}
+
+TEST(HeightfieldPyramidLoadMatchesBuild)
+{
+    //Odd level sizes so the rounded up rows of the upper levels are covered
+    TestHeightfield field(44, { -30.0f, 5.0f, 12.0f }, 3.0f);
+    HeightfieldPyramid built;
+    built.Build(field.Heights, field.Resolution, field.Origin, field.Spacing);
+
+    std::vector<f32> levelBounds = built.LevelBounds();
+    HeightfieldPyramid loaded;
+    CHECK(loaded.Load(built.Heights(), built.Resolution(), built.Origin(), built.Spacing(), levelBounds));
+    CHECK(loaded.LevelBounds() == levelBounds);
+    CHECK(loaded.Bounds().Min.y == built.Bounds().Min.y && loaded.Bounds().Max.y == built.Bounds().Max.y);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<f32> position(-30.0f, 100.0f);
+    u32 mismatches = 0;
+    for (u32 i = 0; i < 200; i++)
+    {
+        Ray ray = { { position(rng), 200.0f, position(rng) + 40.0f }, Normalized({ position(rng) * 0.01f, -1.0f, position(rng) * 0.01f }) };
+        if (built.Raycast(ray) != loaded.Raycast(ray))
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    //Level data that doesn't match the resolution is rejected
+    levelBounds.pop_back();
+    CHECK(!loaded.Load(built.Heights(), built.Resolution(), built.Origin(), built.Spacing(), levelBounds));
+    CHECK(loaded.Empty());
+}
@@ -0,0 +1,160 @@
+#include "Test.h"
+#include "render/resources/Scene.h"
+#include "render/backend/NullRenderDevice.h"
+
+//Scenes drawn with NullRenderDevice. Checks what the scene submits and that it releases everything it creates
+
+//Layout of the vertices created by AddCube()
+static const std::vector<RenderVertexAttribute> TestVertexLayout =
+{
+    { "POSITION", 0, RenderVertexFormat::Float3, 0 },
+};
+
+//Add a unit cube render object at a position. Returns its index in scene.Objects
+static u32 AddCube(Scene& scene, const Vec3& position)
+{
+    std::vector<Vec3> vertices = {};
+    for (u32 i = 0; i < 8; i++)
+        vertices.push_back({ (i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f });
+    std::vector<u16> indices = { 0, 1, 2, 2, 1, 3, 4, 6, 5, 5, 6, 7, 0, 4, 1, 1, 4, 5, 2, 3, 6, 6, 3, 7, 0, 2, 4, 4, 2, 6, 1, 5, 3, 3, 5, 7 };
+
+    Mesh mesh;
+    mesh.Create(scene.Device.get(), std::span<u8>((u8*)vertices.data(), vertices.size() * sizeof(Vec3)),
+                std::span<u8>((u8*)indices.data(), indices.size() * sizeof(u16)), (u32)vertices.size(), RenderIndexFormat::U16, RenderTopology::TriangleList);
+
+    RenderObject& object = scene.Objects.emplace_back();
+    object.Create(mesh, position);
+    object.Bounds.Extend(Vec3(-0.5f, -0.5f, -0.5f));
+    object.Bounds.Extend(Vec3(0.5f, 0.5f, 0.5f));
+    return (u32)scene.Objects.size() - 1;
+}
+
+//Camera at (0, 0, -100) looking at the origin
+static void InitScene(Scene& scene, Handle<NullRenderDevice> device)
+{
+    scene.Init(device, nullptr);
+    scene.Cam.Init({ 0.0f, 0.0f, -100.0f }, 60.0f, { 200.0f, 200.0f }, 1.0f, 10000.0f);
+    scene.SetShader(terrainShaderPath_);
+    scene.SetVertexLayout(TestVertexLayout);
+}
+
+static u32 CountCommands(const NullRenderDevice& device, RenderCommandType type)
+{
+    u32 count = 0;
+    for (const RenderCommand& command : device.Commands())
+        if (command.Type == type)
+            count++;
+
+    return count;
+}
+
+TEST(SceneDrawsVisibleObjects)
+{
+    Handle<NullRenderDevice> device = CreateHandle<NullRenderDevice>();
+    {
+        Scene scene;
+        InitScene(scene, device);
+        AddCube(scene, { 0.0f, 0.0f, 0.0f }); //In view
+        AddCube(scene, { 10.0f, 0.0f, 20.0f }); //In view
+        AddCube(scene, { 0.0f, 0.0f, -300.0f }); //Behind the camera
+        u32 hidden = AddCube(scene, { 0.0f, 5.0f, 0.0f });
+        scene.Objects[hidden].Visible = false;
+
+        device->ClearCommands();
+        scene.Draw(0.016f);
+        CHECK(scene.NumObjectsDrawn == 2);
+        CHECK(scene.NumObjectsCulled == 1);
+        CHECK(CountCommands(*device, RenderCommandType::DrawIndexed) == 2);
+        CHECK(CountCommands(*device, RenderCommandType::BeginPass) == 1);
+        CHECK(CountCommands(*device, RenderCommandType::EndPass) == 1);
+        CHECK(device->Stats().IndicesDrawn == 2 * 36);
+
+        //Without culling every visible object is drawn
+        scene.CullObjects = false;
+        device->ClearCommands();
+        scene.Draw(0.016f);
+        CHECK(scene.NumObjectsDrawn == 3);
+        CHECK(scene.NumObjectsCulled == 0);
+        CHECK(CountCommands(*device, RenderCommandType::DrawIndexed) == 3);
+
+        //Distance limit
+        scene.CullObjects = true;
+        scene.MaxDrawDistance = 105.0f;
+        device->ClearCommands();
+        scene.Draw(0.016f);
+        CHECK(scene.NumObjectsDrawn == 1);
+        CHECK(CountCommands(*device, RenderCommandType::DrawIndexed) == 1);
+    }
+
+    //The scene frees every buffer, pipeline, and render target it created, including object meshes
+    RenderDeviceStats stats = device->Stats();
+    CHECK(stats.NumBuffers == 0);
+    CHECK(stats.BufferBytes == 0);
+    CHECK(stats.NumTextures == 0);
+}
+
+TEST(SceneSkipsDrawWithoutPipeline)
+{
+    Handle<NullRenderDevice> device = CreateHandle<NullRenderDevice>();
+    Scene scene;
+    scene.Init(device, nullptr);
+    scene.Cam.Init({ 0.0f, 0.0f, -100.0f }, 60.0f, { 200.0f, 200.0f }, 1.0f, 10000.0f);
+    AddCube(scene, { 0.0f, 0.0f, 0.0f });
+
+    device->ClearCommands();
+    scene.Draw(0.016f);
+    CHECK(device->Commands().size() == 0);
+}
+
+TEST(SceneMergesRetainedLineBatches)
+{
+    Handle<NullRenderDevice> device = CreateHandle<NullRenderDevice>();
+    Scene scene;
+    InitScene(scene, device);
+
+    //3 batches of one box each. Adjacent visible batches are drawn with one call
+    std::vector<Scene::ColoredVertex> vertices = {};
+    std::vector<Scene::LineBatch> batches = {};
+    for (u32 i = 0; i < 3; i++)
+    {
+        u32 first = (u32)vertices.size();
+        Scene::AppendBoxLines(vertices, { (f32)i, 0.0f, 0.0f }, { i + 0.5f, 0.5f, 0.5f });
+        batches.push_back({ first, (u32)vertices.size() - first, true });
+    }
+    const u32 verticesPerBox = 24;
+    CHECK(vertices.size() == 3 * verticesPerBox);
+    scene.SetRetainedLines(std::move(vertices), std::move(batches));
+
+    device->ClearCommands();
+    scene.Draw(0.016f);
+    CHECK(CountCommands(*device, RenderCommandType::Draw) == 1);
+    CHECK(device->Stats().VerticesDrawn == 3 * verticesPerBox);
+
+    //Hiding the middle batch splits the run
+    scene.SetLineBatchVisible(1, false);
+    device->ClearCommands();
+    scene.Draw(0.016f);
+    CHECK(CountCommands(*device, RenderCommandType::Draw) == 2);
+    CHECK(device->Stats().VerticesDrawn == 2 * verticesPerBox);
+
+    //Updating a batch only uploads its range
+    std::vector<Scene::ColoredVertex> update = {};
+    Scene::AppendBoxLines(update, { 5.0f, 0.0f, 0.0f }, { 6.0f, 1.0f, 1.0f });
+    scene.UpdateLineBatch(2, std::move(update));
+    device->ClearCommands();
+    scene.Draw(0.016f);
+    bool foundUpdate = false;
+    for (const RenderCommand& command : device->Commands())
+        if (command.Type == RenderCommandType::UpdateBuffer && command.Args[1] == 2 * verticesPerBox * sizeof(Scene::ColoredVertex))
+            foundUpdate = command.Args[2] == verticesPerBox * sizeof(Scene::ColoredVertex);
+    CHECK(foundUpdate);
+
+    //Per frame lines are drawn with one call after the retained lines are hidden
+    scene.DrawLine({ 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+    scene.SetLineBatchVisible(0, false);
+    scene.SetLineBatchVisible(2, false);
+    device->ClearCommands();
+    scene.Draw(0.016f);
+    CHECK(CountCommands(*device, RenderCommandType::Draw) == 1);
+    CHECK(device->Stats().VerticesDrawn == 2);
+}
@@ -0,0 +1,182 @@
+#include "Test.h"
+#include "TestTerrain.h"
+#include "rfg/TerrainLod.h"
+#include <numbers>
+
+//Hills over the whole tile so every level of the LOD tree has some error
+static f32 HillHeight(f32 x, f32 z)
+{
+    return 3000.0f * std::sin(x * 0.0003f) * std::cos(z * 0.0002f) + 500.0f * std::sin((x + z) * 0.001f);
+}
+
+//Check that the selected nodes cover every leaf of the tree exactly once
+static bool SelectionCoversTile(const TerrainLodTree& tree, const std::vector<u32>& selected)
+{
+    const u32 leavesPerSide = 1 << (tree.NumLevels - 1);
+    std::vector<u32> coverage(leavesPerSide * leavesPerSide, 0);
+    for (u32 index : selected)
+    {
+        const TerrainLodNode& node = tree.Nodes[index];
+        const u32 span = 1 << (tree.NumLevels - 1 - node.Level);
+        for (u32 z = node.Z * span; z < (node.Z + 1) * span; z++)
+            for (u32 x = node.X * span; x < (node.X + 1) * span; x++)
+                coverage[z * leavesPerSide + x]++;
+    }
+    return std::all_of(coverage.begin(), coverage.end(), [](u32 count) { return count == 1; });
+}
+
+TEST(TerrainHeightfieldMatchesSource)
+{
+    //A plane is reproduced exactly by linear interpolation, so the only error is vertex quantization
+    TestTerrain terrain(33, [](f32 x, f32 z) { return 0.05f * x - 0.02f * z + 100.0f; });
+    TerrainHeightfield heightfield;
+    heightfield.Build(terrain.Terrain, 65);
+    CHECK(heightfield.Resolution == 65);
+    CHECK(heightfield.Heights.size() == 65 * 65);
+    for (u32 z = 0; z < heightfield.Resolution; z += 8)
+    {
+        for (u32 x = 0; x < heightfield.Resolution; x += 8)
+        {
+            f32 expected = 0.05f * heightfield.SampleCoord(x) - 0.02f * heightfield.SampleCoord(z) + 100.0f;
+            CHECK_NEAR(heightfield.Height(x, z), expected, 2.0f);
+        }
+    }
+}
+
+TEST(TerrainLodTreeBuildsQuadtree)
+{
+    TestTerrain terrain(65, HillHeight);
+    const u32 resolution = TerrainLodTree::ChooseResolution(129 * 129);
+    CHECK(resolution == 129);
+
+    TerrainHeightfield heightfield;
+    heightfield.Build(terrain.Terrain, resolution);
+    TerrainLodTree tree;
+    tree.Build(heightfield);
+    CHECK(tree.NumLevels == 3);
+    CHECK(tree.Nodes.size() == 1 + 4 + 16);
+
+    //Surface vertices plus 4 skirts. Two triangles per cell and 2 double sided triangles per skirt segment
+    const u32 rowSize = TerrainLodTree::PatchSize + 1;
+    for (const TerrainLodNode& node : tree.Nodes)
+    {
+        CHECK(node.NumVertices == rowSize * rowSize + 4 * rowSize);
+        CHECK(node.NumIndices == TerrainLodTree::PatchSize * TerrainLodTree::PatchSize * 6 + 4 * TerrainLodTree::PatchSize * 12);
+        CHECK(node.FirstVertex + node.NumVertices <= tree.Vertices.size());
+        CHECK(node.FirstIndex + node.NumIndices <= tree.Indices.size());
+        CHECK(node.Leaf() == (node.Level == tree.NumLevels - 1));
+        if (node.Leaf())
+        {
+            CHECK(node.GeometricError == 0.0f);
+            continue;
+        }
+
+        //Selection stops refining once a node is accurate enough, which is only correct if parents are never more accurate than their children
+        for (u32 child = 0; child < 4; child++)
+        {
+            const TerrainLodNode& childNode = tree.Nodes[node.FirstChild + child];
+            CHECK(childNode.Level == node.Level + 1);
+            CHECK(node.GeometricError >= childNode.GeometricError);
+            CHECK(node.Bounds.Min.y <= childNode.Bounds.Min.y + 0.001f);
+            CHECK(node.Bounds.Max.y >= childNode.Bounds.Max.y - 0.001f);
+        }
+    }
+    CHECK(tree.Nodes[0].GeometricError > 0.0f);
+
+    //Patch indices must stay inside the patches own vertices
+    for (const TerrainLodNode& node : tree.Nodes)
+        for (u32 i = node.FirstIndex; i < node.FirstIndex + node.NumIndices; i++)
+            CHECK(tree.Indices[i] < node.NumVertices);
+
+    //Trees with ranges out of bounds are rejected when loaded from cache files
+    CHECK(tree.Valid());
+    TerrainLodTree broken = tree;
+    broken.Nodes[0].FirstChild = (u32)broken.Nodes.size() - 2;
+    CHECK(!broken.Valid());
+    broken = tree;
+    broken.Indices.pop_back();
+    CHECK(!broken.Valid());
+}
+
+TEST(TerrainLodSelectionCoversTile)
+{
+    TestTerrain terrain(65, HillHeight);
+    TerrainHeightfield heightfield;
+    heightfield.Build(terrain.Terrain, 129);
+    TerrainLodTree tree;
+    tree.Build(heightfield);
+
+    const f32 errorToPixels = TerrainLodTree::ErrorToPixels(std::numbers::pi_v<f32> / 3.0f, 1080.0f);
+    const u32 numLeaves = 16;
+    std::vector<u32> selected = {};
+
+    //Any error is too much, so every leaf is selected
+    tree.Select({ 0.0f, 100.0f, 0.0f }, errorToPixels, 0.0f, selected);
+    CHECK(selected.size() == numLeaves);
+    CHECK(SelectionCoversTile(tree, selected));
+
+    //Far enough away that the root is accurate enough
+    selected.clear();
+    tree.Select({ 0.0f, 1000000.0f, 0.0f }, errorToPixels, 2.0f, selected);
+    CHECK(selected.size() == 1);
+    CHECK(selected.size() == 1 && selected[0] == 0);
+
+    //Close to one corner the nearby patches are refined and the far ones aren't. The mix of levels still has to cover the tile without overlapping
+    for (Vec3 camera : { Vec3{ -250.0f, 20.0f, -250.0f }, Vec3{ 250.0f, 50.0f, -100.0f }, Vec3{ 0.0f, 10.0f, 0.0f }, Vec3{ 600.0f, 10.0f, 0.0f } })
+    {
+        selected.clear();
+        tree.Select(camera, errorToPixels, 2.0f, selected);
+        CHECK(selected.size() > 0);
+        CHECK(SelectionCoversTile(tree, selected));
+    }
+}
+
+TEST(TerrainLodSelectionReducesVertices)
+{
+    TestTerrain terrain(65, HillHeight);
+    TerrainHeightfield heightfield;
+    heightfield.Build(terrain.Terrain, 129);
+    TerrainLodTree tree;
+    tree.Build(heightfield);
+
+    //Vertices drawn from a few zones away compared to drawing every leaf
+    const f32 errorToPixels = TerrainLodTree::ErrorToPixels(std::numbers::pi_v<f32> / 3.0f, 1080.0f);
+    std::vector<u32> selected = {};
+    tree.Select({ 2000.0f, 100.0f, 0.0f }, errorToPixels, 2.0f, selected);
+    u32 selectedVertices = 0;
+    for (u32 node : selected)
+        selectedVertices += tree.Nodes[node].NumVertices;
+
+    u32 leafVertices = 0;
+    for (const TerrainLodNode& node : tree.Nodes)
+        if (node.Leaf())
+            leafVertices += node.NumVertices;
+
+    CHECK(selectedVertices * 4 <= leafVertices);
+}
+
+TEST(TerrainNormalsPointUp)
+{
+    //Flat terrain has up normals and sloped terrain has normals tilted away from the slope
+    TestTerrain flat(17, [](f32 x, f32 z) { return 0.0f; });
+    GenerateTerrainNormals(flat.Indices, flat.Vertices);
+    for (const LowLodTerrainVertex& vertex : flat.Vertices)
+    {
+        CHECK_NEAR(vertex.normal.x, 0.0f, 1e-5f);
+        CHECK_NEAR(vertex.normal.y, 1.0f, 1e-5f);
+        CHECK_NEAR(vertex.normal.z, 0.0f, 1e-5f);
+    }
+
+    TestTerrain slope(17, [](f32 x, f32 z) { return x * 0.25f; });
+    std::vector<LowLodTerrainVertex> before = slope.Vertices;
+    GenerateTerrainNormals(slope.Indices, slope.Vertices);
+    for (u32 i = 0; i < slope.Vertices.size(); i++)
+    {
+        const LowLodTerrainVertex& vertex = slope.Vertices[i];
+        CHECK(vertex.normal.x < 0.0f);
+        CHECK(vertex.normal.y > 0.0f);
+        CHECK_NEAR(vertex.normal.z, 0.0f, 1e-3f);
+        //Positions aren't touched
+        CHECK(vertex.x == before[i].x && vertex.y == before[i].y && vertex.z == before[i].z);
+    }
+}
@@ -0,0 +1,284 @@
+#include "Test.h"
+#include "rfg/TerrainLowLod.h"
+#include <cstring>
+#include <stdexcept>
+
+//Builds a cterrain_pc + gterrain_pc pair with known contents in the same layout as the game files.
+//Descriptors only have the fixed size part of a MeshDataBlock. They have no submeshes or render blocks
+struct TestTerrainFiles
+{
+    std::vector<u8> Cpu = {};
+    std::vector<u8> Gpu = {};
+    //Where each mesh was written. Checked against the parser output
+    std::vector<u64> DescriptorOffsets = {};
+    std::vector<u32> Hashes = {};
+
+    static constexpr u64 DescriptorSize = 48;
+
+    TestTerrainFiles(u32 version = TerrainLowLod::ExpectedVersion)
+    {
+        Write(Cpu, TerrainLowLod::ExpectedSignature);
+        Write(Cpu, version);
+    }
+
+    template<typename T>
+    static void Write(std::vector<u8>& file, const T& value)
+    {
+        const u8* bytes = (const u8*)&value;
+        file.insert(file.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void Align(std::vector<u8>& file, u64 alignment)
+    {
+        file.resize((file.size() + alignment - 1) / alignment * alignment, 0);
+    }
+
+    //Data the parser doesn't understand yet, such as materials and stitch pieces
+    void WriteUnknownData(u32 numWords, u32 value)
+    {
+        for (u32 i = 0; i < numWords; i++)
+            Write(Cpu, value + i);
+    }
+
+    //Write a mesh descriptor to the cpu file and its block to the gpu file
+    void WriteMesh(u32 hash, u32 numIndices, u32 numVertices)
+    {
+        DescriptorOffsets.push_back(Cpu.size());
+        Hashes.push_back(hash);
+        Write(Cpu, 0u);                              //Version
+        Write(Cpu, hash);                            //Verification hash
+        Write(Cpu, (u32)DescriptorSize);             //Cpu data size
+        Write(Cpu, numIndices * 2 + numVertices * 8); //Gpu data size
+        Write(Cpu, 0u);                              //Num submeshes
+        Write(Cpu, 0u);                              //Submeshes offset
+        Write(Cpu, numVertices);
+        Write(Cpu, (u8)sizeof(ShortVec4));           //Vertex stride 0
+        Write(Cpu, (u8)0);                           //Vertex format
+        Write(Cpu, (u8)0);                           //Num uv channels
+        Write(Cpu, (u8)0);                           //Vertex stride 1
+        Write(Cpu, 0u);                              //Vertex offset
+        Write(Cpu, numIndices);
+        Write(Cpu, 0u);                              //Indices offset
+        Write(Cpu, (u8)sizeof(u16));                 //Index size
+        Write(Cpu, (u8)0);                           //Primitive type
+        Write(Cpu, (u16)0);                          //Num render blocks
+        Align(Cpu, 16);
+
+        //Values are derived from the hash so each mesh has different data
+        Write(Gpu, hash);
+        Align(Gpu, TerrainLowLod::GpuDataAlignment);
+        for (u32 i = 0; i < numIndices; i++)
+            Write(Gpu, IndexValue(hash, i));
+        Align(Gpu, TerrainLowLod::GpuDataAlignment);
+        for (u32 i = 0; i < numVertices; i++)
+            Write(Gpu, VertexValue(hash, i));
+        Write(Gpu, hash);
+    }
+
+    static u16 IndexValue(u32 hash, u32 i) { return (u16)(hash * 3 + i); }
+    static ShortVec4 VertexValue(u32 hash, u32 i) { return { (i16)i, (i16)(hash & 0x7FFF), (i16)-(i16)i, 1 }; }
+};
+
+static bool ReadThrows(TestTerrainFiles& files)
+{
+    try
+    {
+        TerrainLowLod file;
+        file.Read(files.Cpu, files.Gpu, "test");
+        return false;
+    }
+    catch (std::exception&)
+    {
+        return true;
+    }
+}
+
+//Check that each mesh points at the data the builder wrote for it
+static void CheckMeshes(const TerrainLowLod& file, const TestTerrainFiles& files, u32 numMeshes)
+{
+    CHECK(file.Meshes.size() == numMeshes);
+    for (u32 i = 0; i < std::min((u32)file.Meshes.size(), numMeshes); i++)
+    {
+        const TerrainLowLodMesh& mesh = file.Meshes[i];
+        CHECK(mesh.Hash == files.Hashes[i]);
+        CHECK(mesh.DescriptorOffset == files.DescriptorOffsets[i]);
+        CHECK(mesh.DescriptorSize == TestTerrainFiles::DescriptorSize);
+        CHECK((u64)(mesh.Indices.data()) % TerrainLowLod::GpuDataAlignment == (u64)files.Gpu.data() % TerrainLowLod::GpuDataAlignment);
+        for (u32 j = 0; j < mesh.Indices.size(); j++)
+            CHECK(mesh.Indices[j] == TestTerrainFiles::IndexValue(mesh.Hash, j));
+        for (u32 j = 0; j < mesh.Vertices.size(); j++)
+        {
+            ShortVec4 expected = TestTerrainFiles::VertexValue(mesh.Hash, j);
+            CHECK(memcmp(&mesh.Vertices[j], &expected, sizeof(ShortVec4)) == 0);
+        }
+    }
+}
+
+//Read the u32 at offset bytes into a section. 0 if it's out of bounds
+static u32 SectionWord(const TerrainLowLodSection& section, u64 offset)
+{
+    u32 value = 0;
+    if (offset + sizeof(u32) <= section.Data.size())
+        memcpy(&value, section.Data.data() + offset, sizeof(u32));
+
+    return value;
+}
+
+TEST(TerrainLowLodReadsMeshes)
+{
+    //Same shape as the game files. 9 meshes after some unparsed data, with padding at the end of the gpu file
+    TestTerrainFiles files;
+    files.WriteUnknownData(10, 1000);
+    for (u32 i = 0; i < 9; i++)
+        files.WriteMesh(0xA1B2C300 + i, 30 + i * 7, 12 + i * 3);
+    files.WriteUnknownData(6, 2000);
+    TestTerrainFiles::Align(files.Gpu, 2048);
+
+    TerrainLowLod file;
+    file.Read(files.Cpu, files.Gpu, "test");
+    CHECK(file.Header.Signature == TerrainLowLod::ExpectedSignature);
+    CHECK(file.Header.Version == TerrainLowLod::ExpectedVersion);
+    CheckMeshes(file, files, 9);
+    if (file.Meshes.size() == 9)
+    {
+        CHECK(file.Meshes[4].Indices.size() == 58);
+        CHECK(file.Meshes[4].Vertices.size() == 24);
+    }
+    //Only the first descriptor is searched for
+    CHECK(file.DescriptorSearches == 1);
+
+    //Sections before the first descriptor and after the last one
+    CHECK(file.Sections.size() == 2);
+    if (file.Sections.size() == 2)
+    {
+        const TerrainLowLodSection& first = file.Sections[0];
+        CHECK(first.Offset == sizeof(TerrainLowLodHeader));
+        CHECK(first.Data.size() == 40);
+        CHECK(SectionWord(first, 0) == 1000 && SectionWord(first, 36) == 1009);
+
+        const TerrainLowLodSection& last = file.Sections[1];
+        CHECK(last.Offset == files.DescriptorOffsets.back() + TestTerrainFiles::DescriptorSize);
+        CHECK(last.Offset + last.Data.size() == files.Cpu.size());
+        CHECK(SectionWord(last, last.Data.size() - 24) == 2000 && SectionWord(last, last.Data.size() - 4) == 2005);
+    }
+}
+
+TEST(TerrainLowLodSkipsFalseDescriptors)
+{
+    //Unparsed data contains the first hash. It's rejected since the data after it isn't a valid descriptor
+    TestTerrainFiles files;
+    files.WriteUnknownData(3, 0);
+    TestTerrainFiles::Write(files.Cpu, 0x55667788u);
+    files.WriteUnknownData(16, 0);
+    files.WriteMesh(0x55667788, 40, 20);
+    files.WriteMesh(0x55667789, 40, 20);
+
+    TerrainLowLod file;
+    file.Read(files.Cpu, files.Gpu, "test");
+    CheckMeshes(file, files, 2);
+    CHECK(file.DescriptorSearches == 1);
+}
+
+TEST(TerrainLowLodSearchesMisplacedDescriptors)
+{
+    //Data between two descriptors means the next one isn't where it's expected. It's found by searching and the data becomes a section
+    TestTerrainFiles files;
+    files.WriteUnknownData(2, 0);
+    files.WriteMesh(0x11110000, 25, 10);
+    files.WriteMesh(0x11110001, 25, 10);
+    files.WriteUnknownData(32, 3000);
+    files.WriteMesh(0x11110002, 25, 10);
+
+    TerrainLowLod file;
+    file.Read(files.Cpu, files.Gpu, "test");
+    CheckMeshes(file, files, 3);
+    CHECK(file.DescriptorSearches == 2);
+    CHECK(file.Sections.size() == 2);
+    if (file.Sections.size() == 2)
+    {
+        CHECK(file.Sections[1].Offset == files.DescriptorOffsets[1] + TestTerrainFiles::DescriptorSize);
+        CHECK(file.Sections[1].Offset + file.Sections[1].Data.size() == files.DescriptorOffsets[2]);
+        CHECK(SectionWord(file.Sections[1], 0) == 3000);
+    }
+}
+
+TEST(TerrainLowLodRejectsMalformedFiles)
+{
+    TestTerrainFiles files;
+    files.WriteMesh(0x22220000, 25, 10);
+    files.WriteMesh(0x22220001, 25, 10);
+    CHECK(!ReadThrows(files));
+
+    //Wrong signature
+    TestTerrainFiles badSignature = files;
+    badSignature.Cpu[0] ^= 0xFF;
+    CHECK(ReadThrows(badSignature));
+
+    //Cpu file too small for a header
+    TestTerrainFiles noHeader = files;
+    noHeader.Cpu.resize(4);
+    CHECK(ReadThrows(noHeader));
+
+    //First gpu block is cut off so its descriptor can't match
+    TestTerrainFiles truncatedFirst = files;
+    truncatedFirst.Gpu.resize(40);
+    CHECK(ReadThrows(truncatedFirst));
+
+    //Last gpu block is cut off. The meshes before it are kept
+    TestTerrainFiles truncatedLast = files;
+    truncatedLast.Gpu.resize(truncatedLast.Gpu.size() - 8);
+    TerrainLowLod file;
+    file.Read(truncatedLast.Cpu, truncatedLast.Gpu, "test");
+    CheckMeshes(file, truncatedLast, 1);
+
+    //Unexpected versions are read anyway
+    TestTerrainFiles newVersion(TerrainLowLod::ExpectedVersion + 1);
+    newVersion.WriteMesh(0x22220000, 25, 10);
+    file.Read(newVersion.Cpu, newVersion.Gpu, "test");
+    CheckMeshes(file, newVersion, 1);
+    CHECK(file.Header.Version == TerrainLowLod::ExpectedVersion + 1);
+}
+
+TEST(TerrainLowLodReadsFixedBytes)
+{
+    //Written out by hand instead of with TestTerrainFiles so the expected values don't depend on the builder. One mesh after two words of unparsed data
+    std::vector<u8> cpu =
+    {
+        0x54, 0x45, 0x52, 0x52, 0x1F, 0x00, 0x00, 0x00, //Signature "TERR", version 31
+        0xEF, 0xBE, 0xAD, 0xDE, 0x07, 0x00, 0x00, 0x00, //Unparsed data
+        0x00, 0x00, 0x00, 0x00, 0x0D, 0xF0, 0xAD, 0x0B, //Descriptor version, hash
+        0x30, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00, //Cpu data size, gpu data size
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //Num submeshes, submeshes offset
+        0x02, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, //Num vertices, stride 0, format, uv channels, stride 1
+        0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, //Vertex offset, num indices
+        0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, //Indices offset, index size, primitive type, num render blocks
+    };
+    std::vector<u8> gpu =
+    {
+        0x0D, 0xF0, 0xAD, 0x0B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //Hash + padding
+        0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //Indices 0, 1, 0 + padding
+        0x64, 0x00, 0x38, 0xFF, 0x2C, 0x01, 0x01, 0x00, 0xFB, 0xFF, 0x07, 0x00, 0xFF, 0x7F, 0x00, 0x00, //Vertices (100, -200, 300, 1), (-5, 7, 32767, 0)
+        0x0D, 0xF0, 0xAD, 0x0B,                                                                         //Hash
+    };
+
+    TerrainLowLod file;
+    file.Read(cpu, gpu, "fixed");
+    CHECK(file.Header.Version == 31);
+    CHECK(file.Meshes.size() == 1);
+    if (file.Meshes.size() == 1)
+    {
+        const TerrainLowLodMesh& mesh = file.Meshes[0];
+        CHECK(mesh.Hash == 0x0BADF00D);
+        CHECK(mesh.DescriptorOffset == 16 && mesh.DescriptorSize == 48);
+        CHECK(mesh.Indices.size() == 3 && mesh.Indices[0] == 0 && mesh.Indices[1] == 1 && mesh.Indices[2] == 0);
+        CHECK(mesh.Vertices.size() == 2);
+        if (mesh.Vertices.size() == 2)
+        {
+            CHECK(mesh.Vertices[0].x == 100 && mesh.Vertices[0].y == -200 && mesh.Vertices[0].z == 300 && mesh.Vertices[0].w == 1);
+            CHECK(mesh.Vertices[1].x == -5 && mesh.Vertices[1].y == 7 && mesh.Vertices[1].z == 32767 && mesh.Vertices[1].w == 0);
+        }
+    }
+    CHECK(file.Sections.size() == 1);
+    if (file.Sections.size() == 1)
+        CHECK(file.Sections[0].Offset == 8 && file.Sections[0].Data.size() == 8 && SectionWord(file.Sections[0], 0) == 0xDEADBEEF);
+}
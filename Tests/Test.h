@@ -0,0 +1,48 @@
+#pragma once
+#include "common/Typedefs.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+//Minimal test runner for NanoforgeTests. Tests register themselves with TEST() and are run by TestMain.cpp.
+//Failed checks are logged and counted but don't stop the test, so one run shows every failure
+struct TestCase
+{
+    const char* Name = nullptr;
+    void(*Func)() = nullptr;
+};
+
+std::vector<TestCase>& GetTests();
+//Failed checks in the test that's running
+extern u32 TestFailures;
+
+struct TestRegistrar
+{
+    TestRegistrar(const char* name, void(*func)()) { GetTests().push_back({ name, func }); }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, &name); \
+    static void name()
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            TestFailures++; \
+            printf("    %s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+    do \
+    { \
+        double checkA = (double)(a), checkB = (double)(b); \
+        if (!(std::abs(checkA - checkB) <= (double)(tolerance))) \
+        { \
+            TestFailures++; \
+            printf("    %s(%d): CHECK_NEAR(%s, %s) failed. %g != %g\n", __FILE__, __LINE__, #a, #b, checkA, checkB); \
+        } \
+    } while (0)
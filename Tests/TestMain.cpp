@@ -0,0 +1,41 @@
+#include "Test.h"
+#include "Log.h"
+#include <string_view>
+
+u32 TestFailures = 0;
+
+std::vector<TestCase>& GetTests()
+{
+    //Function local so tests can register from any file during static initialization
+    static std::vector<TestCase> tests = {};
+    return tests;
+}
+
+int main(int argc, char** argv)
+{
+    //Code under test logs errors and THROW_EXCEPTION() logs before throwing
+    Log = std::make_shared<spdlog::logger>("Tests", std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+
+    //Pass part of a test name to only run matching tests
+    std::string_view filter = argc > 1 ? argv[1] : "";
+    u32 numRun = 0;
+    u32 numFailed = 0;
+    for (const TestCase& test : GetTests())
+    {
+        if (std::string_view(test.Name).find(filter) == std::string_view::npos)
+            continue;
+
+        TestFailures = 0;
+        printf("%s\n", test.Name);
+        test.Func();
+        numRun++;
+        if (TestFailures > 0)
+        {
+            numFailed++;
+            printf("    FAILED (%u checks)\n", TestFailures);
+        }
+    }
+
+    printf("%u/%u tests passed\n", numRun - numFailed, numRun);
+    return numFailed == 0 ? 0 : 1;
+}
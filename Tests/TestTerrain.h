@@ -0,0 +1,50 @@
+#pragma once
+#include "common/Typedefs.h"
+#include "rfg/TerrainGeometry.h"
+#include <functional>
+#include <vector>
+
+//Synthetic terrain tile laid out like low lod terrain meshes: one triangle strip with degenerate triangles joining each row.
+//Vertices cover the full terrain mesh coordinate range. Terrain points into the buffers owned by this so it can't be copied
+class TestTerrain
+{
+public:
+    //size x size vertices. height(x, z) is the height at terrain mesh coordinates, also in terrain mesh units
+    TestTerrain(u32 size, const std::function<f32(f32 x, f32 z)>& height, const Vec3& position = {})
+    {
+        const f32 spacing = 65535.0f / (f32)(size - 1);
+        for (u32 z = 0; z < size; z++)
+        {
+            for (u32 x = 0; x < size; x++)
+            {
+                f32 terrainX = -32768.0f + x * spacing;
+                f32 terrainZ = -32768.0f + z * spacing;
+                Vertices.push_back({ (i16)terrainX, (i16)height(terrainX, terrainZ), (i16)terrainZ, 0 });
+            }
+        }
+        for (u32 z = 0; z + 1 < size; z++)
+        {
+            //Repeat the last index of the previous row and the first of this one so the rows are joined by degenerate triangles
+            if (z > 0)
+                Indices.push_back((u16)(z * size));
+            for (u32 x = 0; x < size; x++)
+            {
+                Indices.push_back((u16)(z * size + x));
+                Indices.push_back((u16)((z + 1) * size + x));
+            }
+            if (z + 2 < size)
+                Indices.push_back((u16)((z + 1) * size + size - 1));
+        }
+
+        Terrain.Name = "test.cterrain_pc";
+        Terrain.Position = position;
+        Terrain.Indices.push_back(Indices);
+        Terrain.Vertices.push_back(Vertices);
+    }
+    TestTerrain(const TestTerrain&) = delete;
+    TestTerrain& operator=(const TestTerrain&) = delete;
+
+    std::vector<u16> Indices = {};
+    std::vector<LowLodTerrainVertex> Vertices = {};
+    TerrainGeometry Terrain;
+};
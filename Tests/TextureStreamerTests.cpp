@@ -0,0 +1,203 @@
+#include "Test.h"
+#include "util/TextureStreamer.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+//Square BC1 sized texture covering a 511 unit zone. Each mip is filled with its index so uploads can be checked. Decodes are counted
+static StreamedTextureDesc MakeTexture(u32 size, const Vec3& center, std::shared_ptr<std::atomic<u32>> decodes, bool fail = false)
+{
+    StreamedTextureDesc desc;
+    desc.Name = "test";
+    desc.Width = size;
+    desc.Height = size;
+    desc.Center = center;
+    desc.WorldSize = 511.0f;
+    for (u32 mipSize = size; ; mipSize = std::max(mipSize / 2, 1u))
+    {
+        desc.MipSizes.push_back((u64)std::max((mipSize + 3) / 4, 1u) * std::max((mipSize + 3) / 4, 1u) * 8);
+        if (mipSize == 1)
+            break;
+    }
+    desc.Decode = [decodes, fail, size, mipSizes = desc.MipSizes](u32 firstMip)
+    {
+        (*decodes)++;
+        if (fail)
+            throw std::runtime_error("Test decode failure");
+
+        std::vector<StreamedMip> mips = {};
+        for (u32 mip = firstMip; mip < mipSizes.size(); mip++)
+            mips.push_back({ std::max(size >> mip, 1u), std::max(size >> mip, 1u), std::vector<u8>(mipSizes[mip], (u8)mip) });
+
+        return mips;
+    };
+    return desc;
+}
+
+static u64 ChainSize(const StreamedTextureDesc& desc, u32 firstMip)
+{
+    u64 size = 0;
+    for (u32 mip = firstMip; mip < desc.MipSizes.size(); mip++)
+        size += desc.MipSizes[mip];
+
+    return size;
+}
+
+//Wait for the decode threads to make count updates or until the timeout passes. Returns the updates made in the meantime
+static std::vector<StreamedTextureUpdate> WaitForUpdates(TextureStreamer& streamer, u32 count, std::chrono::milliseconds wait = std::chrono::seconds(10))
+{
+    std::vector<StreamedTextureUpdate> updates = {};
+    auto timeout = std::chrono::steady_clock::now() + wait;
+    while (updates.size() < count && std::chrono::steady_clock::now() < timeout)
+    {
+        for (StreamedTextureUpdate& update : streamer.TakeUpdates())
+            updates.push_back(std::move(update));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return updates;
+}
+
+//Pixels per unit at distance 1 for a 1000 pixel tall view
+constexpr f32 TestPixelsPerUnit = 1000.0f;
+
+TEST(TextureStreamerChoosesMipByDistance)
+{
+    auto decodes = std::make_shared<std::atomic<u32>>(0);
+    StreamedTextureDesc desc = MakeTexture(1024, {}, decodes);
+    const u32 numMips = (u32)desc.MipSizes.size();
+    CHECK(numMips == 11);
+
+    //Close enough for a texel to cover a pixel or more
+    CHECK(TextureStreamer::ChooseMip(desc, 0.0f, TestPixelsPerUnit) == 0);
+    CHECK(TextureStreamer::ChooseMip(desc, 100.0f, TestPixelsPerUnit) == 0);
+    //About 20 texels per pixel. floor(log2(20)) = 4
+    CHECK(TextureStreamer::ChooseMip(desc, 10000.0f, TestPixelsPerUnit) == 4);
+    //Clamped to the smallest mip
+    CHECK(TextureStreamer::ChooseMip(desc, 1e9f, TestPixelsPerUnit) == numMips - 1);
+
+    u32 previous = 0;
+    bool monotonic = true;
+    for (f32 distance = 1.0f; distance < 1e7f; distance *= 1.5f)
+    {
+        u32 mip = TextureStreamer::ChooseMip(desc, distance, TestPixelsPerUnit);
+        monotonic &= mip >= previous;
+        previous = mip;
+    }
+    CHECK(monotonic);
+}
+
+TEST(TextureStreamerStreamsVisibleTextures)
+{
+    auto decodes = std::make_shared<std::atomic<u32>>(0);
+    TextureStreamer streamer(64 * 1024 * 1024, 1);
+    StreamedTextureDesc desc = MakeTexture(1024, {}, decodes);
+    const u32 numMips = (u32)desc.MipSizes.size();
+    u32 shown = streamer.Add(desc);
+    u32 hidden = streamer.Add(desc);
+
+    //Nothing is resident until a texture is visible. The first load is capped at the base mip
+    CHECK(streamer.ResidentMip(shown) == numMips);
+    const u32 visible[] = { shown };
+    Vec3 camera = { 0.0f, 10.0f, 0.0f };
+    streamer.Update(camera, TestPixelsPerUnit, visible);
+    std::vector<StreamedTextureUpdate> updates = WaitForUpdates(streamer, 1);
+    CHECK(updates.size() == 1);
+    const u32 baseMip = 4; //1024 >> 4 = TextureStreamer::BaseMipSize
+    CHECK(streamer.ResidentMip(shown) == baseMip);
+    CHECK(streamer.ResidentMip(hidden) == numMips);
+    if (updates.size() == 1)
+    {
+        CHECK(updates[0].Id == shown && updates[0].FirstMip == baseMip);
+        CHECK(updates[0].Mips.size() == numMips - baseMip);
+        CHECK(updates[0].Mips.size() > 0 && updates[0].Mips[0].Width == 64 && updates[0].Mips[0].Data[0] == baseMip);
+    }
+    CHECK(streamer.BytesUsed() == ChainSize(desc, baseMip));
+
+    //Refined to full resolution on the next update since the camera is on top of it
+    streamer.Update(camera, TestPixelsPerUnit, visible);
+    updates = WaitForUpdates(streamer, 1);
+    CHECK(updates.size() == 1 && updates[0].FirstMip == 0);
+    CHECK(streamer.ResidentMip(shown) == 0);
+    CHECK(streamer.BytesUsed() == ChainSize(desc, 0));
+
+    //Far away it drops back to coarser mips
+    Vec3 farCamera = { 0.0f, 20000.0f, 0.0f };
+    u32 farMip = TextureStreamer::ChooseMip(desc, 20000.0f, TestPixelsPerUnit);
+    CHECK(farMip > 1);
+    streamer.Update(farCamera, TestPixelsPerUnit, visible);
+    updates = WaitForUpdates(streamer, 1);
+    CHECK(updates.size() == 1);
+    CHECK(streamer.ResidentMip(shown) == farMip);
+    CHECK(streamer.BytesUsed() == ChainSize(desc, farMip));
+    CHECK(*decodes == 3);
+}
+
+TEST(TextureStreamerEvictsLeastRecentlyUsed)
+{
+    //64x64 textures are loaded at full resolution right away. The budget fits two
+    auto decodes = std::make_shared<std::atomic<u32>>(0);
+    StreamedTextureDesc desc = MakeTexture(64, {}, decodes);
+    const u32 numMips = (u32)desc.MipSizes.size();
+    const u64 budget = ChainSize(desc, 0) * 2;
+    TextureStreamer streamer(budget, 2);
+    u32 a = streamer.Add(desc);
+    u32 b = streamer.Add(desc);
+    u32 c = streamer.Add(desc);
+    Vec3 camera = { 0.0f, 10.0f, 0.0f };
+
+    for (u32 id : { a, b })
+    {
+        const u32 visible[] = { id };
+        streamer.Update(camera, TestPixelsPerUnit, visible);
+        CHECK(WaitForUpdates(streamer, 1).size() == 1);
+        CHECK(streamer.ResidentMip(id) == 0);
+    }
+    CHECK(streamer.BytesUsed() == budget);
+
+    //C needs room. A is evicted since it was used longest ago
+    const u32 onlyC[] = { c };
+    streamer.Update(camera, TestPixelsPerUnit, onlyC);
+    std::vector<StreamedTextureUpdate> updates = WaitForUpdates(streamer, 2);
+    CHECK(updates.size() == 2);
+    if (updates.size() == 2)
+    {
+        CHECK(updates[0].Id == a && updates[0].Mips.size() == 0);
+        CHECK(updates[1].Id == c && updates[1].FirstMip == 0);
+    }
+    CHECK(streamer.ResidentMip(a) == numMips);
+    CHECK(streamer.ResidentMip(b) == 0);
+    CHECK(streamer.ResidentMip(c) == 0);
+    CHECK(streamer.BytesUsed() <= budget);
+
+    //Textures in view are never evicted for each other. A gets nothing until B or C leaves the view
+    const u32 all[] = { a, b, c };
+    streamer.Update(camera, TestPixelsPerUnit, all);
+    CHECK(WaitForUpdates(streamer, 1, std::chrono::milliseconds(100)).size() == 0);
+    CHECK(streamer.ResidentMip(a) == numMips);
+    CHECK(streamer.BytesUsed() <= budget);
+    CHECK(*decodes == 3);
+}
+
+TEST(TextureStreamerStopsRequestingFailedTextures)
+{
+    auto decodes = std::make_shared<std::atomic<u32>>(0);
+    TextureStreamer streamer(1024 * 1024, 1);
+    StreamedTextureDesc desc = MakeTexture(64, {}, decodes, true);
+    u32 id = streamer.Add(desc);
+    const u32 visible[] = { id };
+    Vec3 camera = { 0.0f, 10.0f, 0.0f };
+
+    //Reserved bytes are released once the failed decode is handled
+    streamer.Update(camera, TestPixelsPerUnit, visible);
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((*decodes == 0 || streamer.BytesUsed() > 0) && std::chrono::steady_clock::now() < timeout)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    streamer.Update(camera, TestPixelsPerUnit, visible);
+    CHECK(WaitForUpdates(streamer, 1, std::chrono::milliseconds(100)).size() == 0);
+    CHECK(*decodes == 1);
+    CHECK(streamer.ResidentMip(id) == (u32)desc.MipSizes.size());
+    CHECK(streamer.BytesUsed() == 0);
+}
@@ -0,0 +1,175 @@
+#include "Test.h"
+#include "util/VisibilityCuller.h"
+#include <numbers>
+#include <random>
+
+static Vec3 Sub(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+static f32 Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+static Vec3 Normalized(const Vec3& v)
+{
+    f32 length = std::sqrt(Dot(v, v));
+    return { v.x / length, v.y / length, v.z / length };
+}
+
+//Left handed look to view matrix times a perspective projection with [0, 1] depth. Same layout as DirectX::XMMatrixLookToLH() * XMMatrixPerspectiveFovLH()
+struct TestCamera
+{
+    Vec3 Position;
+    f32 ViewProj[16] = {};
+
+    TestCamera(const Vec3& position, const Vec3& direction, f32 fovRadians, f32 aspect, f32 nearPlane, f32 farPlane) : Position(position)
+    {
+        Vec3 zAxis = Normalized(direction);
+        Vec3 xAxis = Normalized(Cross({ 0.0f, 1.0f, 0.0f }, zAxis));
+        Vec3 yAxis = Cross(zAxis, xAxis);
+        const f32 view[16] =
+        {
+            xAxis.x, yAxis.x, zAxis.x, 0.0f,
+            xAxis.y, yAxis.y, zAxis.y, 0.0f,
+            xAxis.z, yAxis.z, zAxis.z, 0.0f,
+            -Dot(xAxis, position), -Dot(yAxis, position), -Dot(zAxis, position), 1.0f
+        };
+
+        f32 h = 1.0f / std::tan(fovRadians * 0.5f);
+        f32 w = h / aspect;
+        f32 q = farPlane / (farPlane - nearPlane);
+        const f32 projection[16] =
+        {
+            w, 0.0f, 0.0f, 0.0f,
+            0.0f, h, 0.0f, 0.0f,
+            0.0f, 0.0f, q, 1.0f,
+            0.0f, 0.0f, -q * nearPlane, 0.0f
+        };
+
+        for (u32 row = 0; row < 4; row++)
+            for (u32 column = 0; column < 4; column++)
+                for (u32 i = 0; i < 4; i++)
+                    ViewProj[row * 4 + column] += view[row * 4 + i] * projection[i * 4 + column];
+    }
+
+    //True if the point projects inside the view volume
+    bool Sees(const Vec3& point) const
+    {
+        const f32* m = ViewProj;
+        f32 x = point.x * m[0] + point.y * m[4] + point.z * m[8] + m[12];
+        f32 y = point.x * m[1] + point.y * m[5] + point.z * m[9] + m[13];
+        f32 z = point.x * m[2] + point.y * m[6] + point.z * m[10] + m[14];
+        f32 w = point.x * m[3] + point.y * m[7] + point.z * m[11] + m[15];
+        return w > 0.0f && std::abs(x) < w && std::abs(y) < w && z > 0.0f && z < w;
+    }
+};
+
+//Random boxes spread over a few zones. Every 50th box has invalid bounds, which should never be culled
+static std::vector<Aabb> MakeBoxes(u32 count, std::mt19937& random)
+{
+    std::uniform_real_distribution<f32> position(-1500.0f, 1500.0f);
+    std::uniform_real_distribution<f32> size(0.5f, 40.0f);
+    std::vector<Aabb> boxes(count);
+    for (u32 i = 0; i < count; i++)
+    {
+        if (i % 50 == 49)
+            continue;
+
+        Vec3 center = { position(random), position(random) * 0.1f, position(random) };
+        Vec3 extent = { size(random), size(random), size(random) };
+        boxes[i].Extend(Sub(center, extent));
+        boxes[i].Extend(Vec3{ center.x + extent.x, center.y + extent.y, center.z + extent.z });
+    }
+    return boxes;
+}
+
+//Reference result. Tests every box against the frustum and distance limit
+static std::vector<u32> CullBruteForce(std::span<const Aabb> boxes, const Frustum& frustum, const Vec3& cameraPosition, f32 maxDistance)
+{
+    std::vector<u32> output = {};
+    for (u32 i = 0; i < boxes.size(); i++)
+    {
+        const Aabb& box = boxes[i];
+        if (!box.Valid() || ((maxDistance <= 0.0f || box.IntersectsSphere(cameraPosition, maxDistance)) && frustum.Intersects(box)))
+            output.push_back(i);
+    }
+    return output;
+}
+
+//Cull with several cameras and distance limits and compare with the brute force scan.
+//Also checks the culling is conservative: boxes with a corner or center the camera can see must never be culled
+static void CheckMatchesBruteForce(const VisibilityCuller& culler, std::span<const Aabb> boxes, std::mt19937& random)
+{
+    std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+    std::vector<u32> visible = {};
+    for (u32 i = 0; i < 24; i++)
+    {
+        Vec3 position = { unit(random) * 1000.0f, 50.0f + unit(random) * 40.0f, unit(random) * 1000.0f };
+        Vec3 direction = { unit(random), unit(random) * 0.3f, unit(random) };
+        TestCamera camera(position, direction, std::numbers::pi_v<f32> / 3.0f, 16.0f / 9.0f, 1.0f, 5000.0f);
+        Frustum frustum = Frustum::FromViewProjection(camera.ViewProj);
+        f32 maxDistance = i % 3 == 0 ? 0.0f : 300.0f + i * 40.0f;
+
+        culler.Cull(frustum, position, maxDistance, visible);
+        std::vector<u32> expected = CullBruteForce(boxes, frustum, position, maxDistance);
+        CHECK(visible == expected);
+
+        for (u32 box = 0; box < boxes.size(); box++)
+        {
+            if (!boxes[box].Valid() || (maxDistance > 0.0f && !boxes[box].IntersectsSphere(position, maxDistance)))
+                continue;
+
+            const Aabb& bounds = boxes[box];
+            bool seen = camera.Sees(bounds.Center()) || camera.Sees(bounds.Min) || camera.Sees(bounds.Max);
+            if (seen)
+                CHECK(std::binary_search(visible.begin(), visible.end(), box));
+        }
+    }
+}
+
+TEST(VisibilityCullerLinearMatchesBruteForce)
+{
+    std::mt19937 random(1);
+    std::vector<Aabb> boxes = MakeBoxes(VisibilityCuller::MinBvhObjects - 1, random);
+    VisibilityCuller culler;
+    culler.SetBounds(boxes);
+    CHECK(!culler.UsingBvh());
+    CHECK(culler.NumObjects() == boxes.size());
+    CheckMatchesBruteForce(culler, boxes, random);
+}
+
+TEST(VisibilityCullerBvhMatchesBruteForce)
+{
+    std::mt19937 random(2);
+    std::vector<Aabb> boxes = MakeBoxes(5000, random);
+    VisibilityCuller culler;
+    culler.SetBounds(boxes);
+    CHECK(culler.UsingBvh());
+    CheckMatchesBruteForce(culler, boxes, random);
+
+    //Move some boxes so the Bvh is refit instead of rebuilt
+    for (u32 i = 0; i < boxes.size(); i += 7)
+    {
+        if (!boxes[i].Valid())
+            continue;
+
+        boxes[i].Min.x += 300.0f;
+        boxes[i].Max.x += 300.0f;
+        boxes[i].Min.z -= 150.0f;
+        boxes[i].Max.z -= 150.0f;
+    }
+    culler.SetBounds(boxes);
+    CheckMatchesBruteForce(culler, boxes, random);
+
+    //Invalidating a box changes which objects are in the tree
+    boxes[10] = {};
+    culler.SetBounds(boxes);
+    CheckMatchesBruteForce(culler, boxes, random);
+
+    //Adding objects rebuilds it
+    std::vector<Aabb> more = MakeBoxes(700, random);
+    boxes.insert(boxes.end(), more.begin(), more.end());
+    culler.SetBounds(boxes);
+    CHECK(culler.NumObjects() == boxes.size());
+    CheckMatchesBruteForce(culler, boxes, random);
+
+    culler.Clear();
+    CHECK(culler.NumObjects() == 0);
+    CHECK(!culler.UsingBvh());
+}